@@ -0,0 +1,996 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Benchmark runner, renders a fixed set of scenes with fixed seed, sample
+ * and thread counts and reports timings and memory usage as JSON.
+ *
+ * The curated scenes are generated here rather than read from XML files, so
+ * they are identical on every machine and don't depend on image or hair
+ * assets. Additional XML scenes can be passed on the command line. */
+
+#include <stdio.h>
+
+#include "background.h"
+#include "buffers.h"
+#include "camera.h"
+#include "device.h"
+#include "graph.h"
+#include "image.h"
+#include "integrator.h"
+#include "light.h"
+#include "mesh.h"
+#include "nodes.h"
+#include "object.h"
+#include "scene.h"
+#include "session.h"
+#include "shader.h"
+#include "stats.h"
+
+#include "util_args.h"
+#include "util_foreach.h"
+#include "util_guarded_allocator.h"
+#include "util_hash.h"
+#include "util_logging.h"
+#include "util_math.h"
+#include "util_path.h"
+#include "util_string.h"
+#include "util_system.h"
+#include "util_time.h"
+#include "util_transform.h"
+#include "util_version.h"
+
+#include "cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+typedef void (*BenchmarkCreateFunc)(Scene *scene);
+
+struct BenchmarkScene {
+	string name;
+	string description;
+	/* Either a generated scene or an XML file. */
+	BenchmarkCreateFunc create;
+	string filepath;
+};
+
+struct BenchmarkResult {
+	BenchmarkResult()
+	: success(false),
+	  scene_create_time(0.0),
+	  kernel_load_time(0.0),
+	  scene_update_time(0.0),
+	  bvh_build_time(0.0),
+	  render_time(0.0),
+	  total_time(0.0),
+	  device_peak_memory(0),
+	  host_peak_memory(0)
+	{
+	}
+
+	string name;
+	bool success;
+	string error_message;
+
+	double scene_create_time;
+	double kernel_load_time;
+	double scene_update_time;
+	double bvh_build_time;
+	double render_time;
+	double total_time;
+
+	size_t device_peak_memory;
+	size_t host_peak_memory;
+};
+
+struct Options {
+	int width, height;
+	int seed;
+	string scene_names;
+	string output_path;
+	vector<string> filepaths;
+	SceneParams scene_params;
+	SessionParams session_params;
+	bool quiet;
+} options;
+
+/* Scene Building Utilities */
+
+static float benchmark_random(uint index, uint seed)
+{
+	return (float)hash_int_2d(index, seed) * (1.0f/(float)0xFFFFFFFF);
+}
+
+static Shader *benchmark_add_shader(Scene *scene, const char *name, ShaderGraph *graph)
+{
+	Shader *shader = new Shader();
+	shader->name = name;
+	shader->set_graph(graph);
+	shader->tag_update(scene);
+	scene->shaders.push_back(shader);
+
+	return shader;
+}
+
+static Shader *benchmark_add_diffuse_shader(Scene *scene, const char *name, float3 color)
+{
+	ShaderGraph *graph = new ShaderGraph();
+
+	DiffuseBsdfNode *diffuse = new DiffuseBsdfNode();
+	diffuse->color = color;
+	graph->add(diffuse);
+
+	graph->connect(diffuse->output("BSDF"), graph->output()->input("Surface"));
+
+	return benchmark_add_shader(scene, name, graph);
+}
+
+static Shader *benchmark_add_emission_shader(Scene *scene, const char *name, float3 color, float strength)
+{
+	ShaderGraph *graph = new ShaderGraph();
+
+	EmissionNode *emission = new EmissionNode();
+	emission->color = color;
+	emission->strength = strength;
+	graph->add(emission);
+
+	graph->connect(emission->output("Emission"), graph->output()->input("Surface"));
+
+	return benchmark_add_shader(scene, name, graph);
+}
+
+static void benchmark_set_background(Scene *scene, float3 color, float strength)
+{
+	ShaderGraph *graph = new ShaderGraph();
+
+	BackgroundNode *background = new BackgroundNode();
+	background->color = color;
+	background->strength = strength;
+	graph->add(background);
+
+	graph->connect(background->output("Background"), graph->output()->input("Surface"));
+
+	Shader *shader = scene->default_background;
+	shader->set_graph(graph);
+	shader->tag_update(scene);
+}
+
+static void benchmark_set_camera(Scene *scene, float3 co, float fov)
+{
+	/* Camera looks down the Z axis towards the origin. */
+	scene->camera->matrix = transform_translate(co);
+	scene->camera->fov = fov;
+}
+
+static void benchmark_add_point_light(Scene *scene, Shader *shader, float3 co, float size)
+{
+	Light *light = new Light();
+	light->type = LIGHT_POINT;
+	light->co = co;
+	light->size = size;
+	light->shader = shader;
+	scene->lights.push_back(light);
+}
+
+static Mesh *benchmark_add_mesh(Scene *scene, Shader *shader, const Transform& tfm)
+{
+	Mesh *mesh = new Mesh();
+	mesh->used_shaders.push_back(shader);
+	scene->meshes.push_back(mesh);
+
+	Object *object = new Object();
+	object->mesh = mesh;
+	object->tfm = tfm;
+	scene->objects.push_back(object);
+
+	return mesh;
+}
+
+static void benchmark_add_instance(Scene *scene, Mesh *mesh, const Transform& tfm)
+{
+	Object *object = new Object();
+	object->mesh = mesh;
+	object->tfm = tfm;
+	scene->objects.push_back(object);
+}
+
+/* Grid in the XY plane facing the camera, with optional height function and
+ * per corner UV coordinates. */
+static void benchmark_mesh_grid(Mesh *mesh,
+                                int resolution,
+                                float size,
+                                float displacement,
+                                bool uv)
+{
+	const int num_verts = (resolution + 1) * (resolution + 1);
+	const int num_triangles = resolution * resolution * 2;
+
+	mesh->reserve_mesh(num_verts, num_triangles);
+
+	for(int y = 0; y <= resolution; y++) {
+		for(int x = 0; x <= resolution; x++) {
+			float u = (float)x / resolution;
+			float v = (float)y / resolution;
+			float z = displacement * sinf(u * 37.0f) * cosf(v * 29.0f) +
+			          displacement * 0.25f * benchmark_random(y * (resolution + 1) + x, 1);
+
+			mesh->add_vertex(make_float3((u - 0.5f) * size, (v - 0.5f) * size, z));
+		}
+	}
+
+	for(int y = 0; y < resolution; y++) {
+		for(int x = 0; x < resolution; x++) {
+			int v0 = y * (resolution + 1) + x;
+			int v1 = v0 + 1;
+			int v2 = v0 + resolution + 2;
+			int v3 = v0 + resolution + 1;
+
+			mesh->add_triangle(v0, v1, v2, 0, true);
+			mesh->add_triangle(v0, v2, v3, 0, true);
+		}
+	}
+
+	if(uv) {
+		Attribute *attr = mesh->attributes.add(ATTR_STD_UV, ustring("UVMap"));
+		float3 *fdata = attr->data_float3();
+
+		for(int y = 0; y < resolution; y++) {
+			for(int x = 0; x < resolution; x++) {
+				float u0 = (float)x / resolution, u1 = (float)(x + 1) / resolution;
+				float v0 = (float)y / resolution, v1 = (float)(y + 1) / resolution;
+
+				*(fdata++) = make_float3(u0, v0, 0.0f);
+				*(fdata++) = make_float3(u1, v0, 0.0f);
+				*(fdata++) = make_float3(u1, v1, 0.0f);
+
+				*(fdata++) = make_float3(u0, v0, 0.0f);
+				*(fdata++) = make_float3(u1, v1, 0.0f);
+				*(fdata++) = make_float3(u0, v1, 0.0f);
+			}
+		}
+	}
+}
+
+static void benchmark_mesh_sphere(Mesh *mesh, int segments, int rings, float radius)
+{
+	const int num_verts = (rings - 1) * segments + 2;
+	const int num_triangles = segments * (rings - 1) * 2;
+
+	mesh->reserve_mesh(num_verts, num_triangles);
+
+	mesh->add_vertex(make_float3(0.0f, 0.0f, -radius));
+
+	for(int r = 1; r < rings; r++) {
+		float theta = M_PI_F * r / rings;
+
+		for(int s = 0; s < segments; s++) {
+			float phi = M_2PI_F * s / segments;
+
+			mesh->add_vertex(make_float3(radius * sinf(theta) * cosf(phi),
+			                             radius * sinf(theta) * sinf(phi),
+			                             -radius * cosf(theta)));
+		}
+	}
+
+	mesh->add_vertex(make_float3(0.0f, 0.0f, radius));
+
+	const int last = num_verts - 1;
+
+	for(int s = 0; s < segments; s++) {
+		int s1 = (s + 1) % segments;
+
+		mesh->add_triangle(0, 1 + s1, 1 + s, 0, true);
+
+		for(int r = 0; r < rings - 2; r++) {
+			int v0 = 1 + r * segments + s;
+			int v1 = 1 + r * segments + s1;
+			int v2 = v1 + segments;
+			int v3 = v0 + segments;
+
+			mesh->add_triangle(v0, v1, v2, 0, true);
+			mesh->add_triangle(v0, v2, v3, 0, true);
+		}
+
+		mesh->add_triangle(last, 1 + (rings - 2) * segments + s,
+		                   1 + (rings - 2) * segments + s1, 0, true);
+	}
+}
+
+static void benchmark_mesh_cube(Mesh *mesh, float size)
+{
+	static const int faces[6][4] = {
+		{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4},
+		{1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7},
+	};
+
+	float h = size * 0.5f;
+
+	mesh->reserve_mesh(8, 12);
+
+	mesh->add_vertex(make_float3(-h, -h, -h));
+	mesh->add_vertex(make_float3( h, -h, -h));
+	mesh->add_vertex(make_float3( h,  h, -h));
+	mesh->add_vertex(make_float3(-h,  h, -h));
+	mesh->add_vertex(make_float3(-h, -h,  h));
+	mesh->add_vertex(make_float3( h, -h,  h));
+	mesh->add_vertex(make_float3( h,  h,  h));
+	mesh->add_vertex(make_float3(-h,  h,  h));
+
+	for(int i = 0; i < 6; i++) {
+		mesh->add_triangle(faces[i][0], faces[i][1], faces[i][2], 0, false);
+		mesh->add_triangle(faces[i][0], faces[i][2], faces[i][3], 0, false);
+	}
+}
+
+/* Procedural Images
+ *
+ * Byte images generated through the builtin image callbacks, the builtin data
+ * pointer only encodes the image index so every texture is a unique slot. */
+
+static const int benchmark_image_size = 1024;
+
+static void benchmark_image_info(const string& /*filename*/,
+                                 void * /*data*/,
+                                 bool& is_float,
+                                 int& width,
+                                 int& height,
+                                 int& depth,
+                                 int& channels)
+{
+	is_float = false;
+	width = benchmark_image_size;
+	height = benchmark_image_size;
+	depth = 1;
+	channels = 4;
+}
+
+static bool benchmark_image_pixels(const string& /*filename*/,
+                                   void *data,
+                                   unsigned char *pixels)
+{
+	const uint index = (uint)(size_t)data;
+	const int checker = 8 << (index % 4);
+
+	for(int y = 0; y < benchmark_image_size; y++) {
+		for(int x = 0; x < benchmark_image_size; x++) {
+			uint noise = hash_int_2d(y * benchmark_image_size + x, index);
+			bool odd = ((x / checker) + (y / checker)) & 1;
+
+			pixels[0] = odd? (unsigned char)(noise & 0xFF): 32;
+			pixels[1] = (unsigned char)((x * 255) / benchmark_image_size);
+			pixels[2] = (unsigned char)((y * 255) / benchmark_image_size);
+			pixels[3] = 255;
+			pixels += 4;
+		}
+	}
+
+	return true;
+}
+
+/* Curated Scenes */
+
+static void benchmark_create_bvh(Scene *scene)
+{
+	/* Large displaced grid plus many instances of a sphere, to stress both
+	 * the object BVH build and the top level scene BVH. */
+	Shader *ground = benchmark_add_diffuse_shader(scene, "ground", make_float3(0.8f, 0.8f, 0.8f));
+	Shader *spheres = benchmark_add_diffuse_shader(scene, "spheres", make_float3(0.8f, 0.3f, 0.2f));
+
+	Mesh *grid = benchmark_add_mesh(scene, ground, transform_identity());
+	benchmark_mesh_grid(grid, 768, 8.0f, 0.15f, false);
+
+	Mesh *sphere = benchmark_add_mesh(scene, spheres, transform_translate(0.0f, 0.0f, -0.3f));
+	benchmark_mesh_sphere(sphere, 32, 16, 0.08f);
+
+	for(int i = 0; i < 2048; i++) {
+		float3 co = make_float3((benchmark_random(i, 2) - 0.5f) * 7.0f,
+		                        (benchmark_random(i, 3) - 0.5f) * 7.0f,
+		                        -0.2f - benchmark_random(i, 4) * 0.5f);
+		benchmark_add_instance(scene, sphere, transform_translate(co));
+	}
+
+	benchmark_set_background(scene, make_float3(0.6f, 0.7f, 0.9f), 1.0f);
+	benchmark_set_camera(scene, make_float3(0.0f, 0.0f, -9.0f), M_PI_4_F);
+}
+
+static void benchmark_create_textures(Scene *scene)
+{
+	/* Grid of planes each with its own high resolution image. */
+	scene->image_manager->builtin_image_info_cb = function_bind(&benchmark_image_info, _1, _2, _3, _4, _5, _6, _7);
+	scene->image_manager->builtin_image_pixels_cb = function_bind(&benchmark_image_pixels, _1, _2, _3);
+
+	const int num_planes = 4;
+	const float plane_size = 1.0f;
+
+	for(int i = 0; i < num_planes * num_planes; i++) {
+		ShaderGraph *graph = new ShaderGraph();
+
+		ImageTextureNode *image = new ImageTextureNode();
+		image->filename = ustring(string_printf("benchmark_image_%d", i));
+		image->builtin_data = (void*)(size_t)(i + 1);
+		graph->add(image);
+
+		DiffuseBsdfNode *diffuse = new DiffuseBsdfNode();
+		graph->add(diffuse);
+
+		graph->connect(image->output("Color"), diffuse->input("Color"));
+		graph->connect(diffuse->output("BSDF"), graph->output()->input("Surface"));
+
+		Shader *shader = benchmark_add_shader(scene, string_printf("image_%d", i).c_str(), graph);
+
+		float x = ((i % num_planes) - (num_planes - 1) * 0.5f) * plane_size;
+		float y = ((i / num_planes) - (num_planes - 1) * 0.5f) * plane_size;
+
+		Mesh *mesh = benchmark_add_mesh(scene, shader, transform_translate(x, y, 0.0f));
+		benchmark_mesh_grid(mesh, 16, plane_size * 0.95f, 0.0f, true);
+	}
+
+	benchmark_set_background(scene, make_float3(1.0f, 1.0f, 1.0f), 1.0f);
+	benchmark_set_camera(scene, make_float3(0.0f, 0.0f, -5.0f), M_PI_4_F);
+}
+
+static void benchmark_create_volume(Scene *scene)
+{
+	/* Scattering cube over a ground plane, lit by a point light. */
+	ShaderGraph *graph = new ShaderGraph();
+
+	ScatterVolumeNode *scatter = new ScatterVolumeNode();
+	scatter->color = make_float3(0.8f, 0.8f, 0.8f);
+	scatter->density = 2.0f;
+	scatter->anisotropy = 0.3f;
+	graph->add(scatter);
+
+	graph->connect(scatter->output("Volume"), graph->output()->input("Volume"));
+
+	Shader *volume = benchmark_add_shader(scene, "volume", graph);
+	Shader *ground = benchmark_add_diffuse_shader(scene, "ground", make_float3(0.8f, 0.8f, 0.8f));
+	Shader *light = benchmark_add_emission_shader(scene, "light", make_float3(1.0f, 1.0f, 1.0f), 200.0f);
+
+	Mesh *plane = benchmark_add_mesh(scene, ground, transform_translate(0.0f, 0.0f, 1.0f));
+	benchmark_mesh_grid(plane, 1, 10.0f, 0.0f, false);
+
+	Mesh *cube = benchmark_add_mesh(scene, volume, transform_identity());
+	benchmark_mesh_cube(cube, 1.5f);
+
+	benchmark_add_point_light(scene, light, make_float3(1.5f, -1.5f, -2.0f), 0.1f);
+	benchmark_set_background(scene, make_float3(0.6f, 0.7f, 0.9f), 0.2f);
+	benchmark_set_camera(scene, make_float3(0.0f, 0.0f, -5.0f), M_PI_4_F);
+}
+
+static void benchmark_create_hair(Scene *scene)
+{
+	/* Dense hair on a plane. */
+	ShaderGraph *graph = new ShaderGraph();
+
+	HairBsdfNode *hair_bsdf = new HairBsdfNode();
+	hair_bsdf->color = make_float3(0.6f, 0.4f, 0.2f);
+	graph->add(hair_bsdf);
+
+	graph->connect(hair_bsdf->output("BSDF"), graph->output()->input("Surface"));
+
+	Shader *hair = benchmark_add_shader(scene, "hair", graph);
+	Shader *skin = benchmark_add_diffuse_shader(scene, "skin", make_float3(0.8f, 0.6f, 0.5f));
+
+	Mesh *plane = benchmark_add_mesh(scene, skin, transform_identity());
+	benchmark_mesh_grid(plane, 1, 3.0f, 0.0f, false);
+
+	const int num_curves = 65536;
+	const int num_keys = 5;
+
+	Mesh *curves = benchmark_add_mesh(scene, hair, transform_identity());
+	curves->reserve_curves(num_curves, num_curves * num_keys);
+
+	for(int i = 0; i < num_curves; i++) {
+		float3 root = make_float3((benchmark_random(i, 5) - 0.5f) * 3.0f,
+		                          (benchmark_random(i, 6) - 0.5f) * 3.0f,
+		                          0.0f);
+		float3 bend = make_float3(benchmark_random(i, 7) - 0.5f,
+		                          benchmark_random(i, 8) - 0.5f,
+		                          0.0f) * 0.4f;
+		float length = 0.2f + benchmark_random(i, 9) * 0.2f;
+
+		int first_key = curves->curve_keys.size();
+
+		for(int k = 0; k < num_keys; k++) {
+			float t = (float)k / (num_keys - 1);
+			float3 co = root + bend * (t * t) - make_float3(0.0f, 0.0f, length * t);
+			curves->add_curve_key(co, 0.004f * (1.0f - 0.8f * t));
+		}
+
+		curves->add_curve(first_key, 0);
+	}
+
+	benchmark_set_background(scene, make_float3(0.9f, 0.9f, 1.0f), 1.0f);
+	benchmark_set_camera(scene, make_float3(0.0f, 0.0f, -4.0f), M_PI_4_F);
+}
+
+static void benchmark_create_lights(Scene *scene)
+{
+	/* Many small point lights with different colors over a ground plane. */
+	Shader *ground = benchmark_add_diffuse_shader(scene, "ground", make_float3(0.8f, 0.8f, 0.8f));
+
+	Mesh *plane = benchmark_add_mesh(scene, ground, transform_identity());
+	benchmark_mesh_grid(plane, 64, 8.0f, 0.1f, false);
+
+	const int num_shaders = 4;
+	Shader *shaders[num_shaders];
+
+	for(int i = 0; i < num_shaders; i++) {
+		float3 color = make_float3(benchmark_random(i, 10),
+		                           benchmark_random(i, 11),
+		                           benchmark_random(i, 12));
+		shaders[i] = benchmark_add_emission_shader(scene,
+		                                           string_printf("light_%d", i).c_str(),
+		                                           color,
+		                                           20.0f);
+	}
+
+	const int num_lights = 32;
+
+	for(int y = 0; y < num_lights; y++) {
+		for(int x = 0; x < num_lights; x++) {
+			int i = y * num_lights + x;
+			float3 co = make_float3(((x + 0.5f) / num_lights - 0.5f) * 7.5f,
+			                        ((y + 0.5f) / num_lights - 0.5f) * 7.5f,
+			                        -0.2f - benchmark_random(i, 13) * 0.3f);
+			benchmark_add_point_light(scene, shaders[i % num_shaders], co, 0.02f);
+		}
+	}
+
+	benchmark_set_camera(scene, make_float3(0.0f, 0.0f, -9.0f), M_PI_4_F);
+}
+
+static void benchmark_create_sss(Scene *scene)
+{
+	/* Subsurface scattering spheres of different sizes. */
+	ShaderGraph *graph = new ShaderGraph();
+
+	SubsurfaceScatteringNode *sss = new SubsurfaceScatteringNode();
+	sss->color = make_float3(0.9f, 0.6f, 0.5f);
+	sss->scale = 0.3f;
+	sss->radius = make_float3(1.0f, 0.5f, 0.25f);
+	graph->add(sss);
+
+	graph->connect(sss->output("BSSRDF"), graph->output()->input("Surface"));
+
+	Shader *skin = benchmark_add_shader(scene, "sss", graph);
+	Shader *ground = benchmark_add_diffuse_shader(scene, "ground", make_float3(0.8f, 0.8f, 0.8f));
+	Shader *light = benchmark_add_emission_shader(scene, "light", make_float3(1.0f, 1.0f, 1.0f), 300.0f);
+
+	Mesh *plane = benchmark_add_mesh(scene, ground, transform_translate(0.0f, 0.0f, 1.0f));
+	benchmark_mesh_grid(plane, 1, 10.0f, 0.0f, false);
+
+	Mesh *sphere = benchmark_add_mesh(scene, skin, transform_identity());
+	benchmark_mesh_sphere(sphere, 128, 64, 1.0f);
+
+	benchmark_add_instance(scene, sphere, transform_translate(-1.6f, 0.5f, 0.5f) * transform_scale(0.5f, 0.5f, 0.5f));
+	benchmark_add_instance(scene, sphere, transform_translate(1.6f, 0.5f, 0.5f) * transform_scale(0.5f, 0.5f, 0.5f));
+
+	benchmark_add_point_light(scene, light, make_float3(-2.0f, -2.0f, -3.0f), 0.25f);
+	benchmark_set_background(scene, make_float3(0.6f, 0.7f, 0.9f), 0.3f);
+	benchmark_set_camera(scene, make_float3(0.0f, 0.0f, -6.0f), M_PI_4_F);
+}
+
+static vector<BenchmarkScene> benchmark_curated_scenes()
+{
+	static const struct {
+		const char *name;
+		const char *description;
+		BenchmarkCreateFunc create;
+	} curated[] = {
+		{"bvh", "Displaced high resolution grid and many instances", benchmark_create_bvh},
+		{"textures", "Many high resolution image textures", benchmark_create_textures},
+		{"volume", "Scattering volume", benchmark_create_volume},
+		{"hair", "Dense hair curves", benchmark_create_hair},
+		{"lights", "Many point lights", benchmark_create_lights},
+		{"sss", "Subsurface scattering", benchmark_create_sss},
+	};
+
+	vector<BenchmarkScene> scenes;
+
+	for(size_t i = 0; i < sizeof(curated) / sizeof(*curated); i++) {
+		BenchmarkScene scene;
+		scene.name = curated[i].name;
+		scene.description = curated[i].description;
+		scene.create = curated[i].create;
+		scenes.push_back(scene);
+	}
+
+	return scenes;
+}
+
+/* Running */
+
+static Scene *benchmark_scene_create(const BenchmarkScene& bscene)
+{
+	Scene *scene = new Scene(options.scene_params, options.session_params.device);
+
+	if(bscene.create) {
+		bscene.create(scene);
+	}
+	else {
+		xml_read_file(scene, bscene.filepath.c_str());
+	}
+
+	/* Fixed resolution and seed so results are comparable between runs. */
+	scene->camera->width = options.width;
+	scene->camera->height = options.height;
+	scene->camera->compute_auto_viewplane();
+	scene->camera->need_update = true;
+
+	scene->integrator->seed = options.seed;
+	scene->integrator->tag_update(scene);
+
+	return scene;
+}
+
+static BenchmarkResult benchmark_run(const BenchmarkScene& bscene)
+{
+	BenchmarkResult result;
+	result.name = bscene.name;
+
+	/* Host memory peak is process wide, measure from here. */
+	util_guarded_reset_mem_peak();
+
+	double start_time = time_dt();
+	Scene *scene = benchmark_scene_create(bscene);
+	result.scene_create_time = time_dt() - start_time;
+
+	BufferParams buffer_params;
+	buffer_params.width = options.width;
+	buffer_params.height = options.height;
+	buffer_params.full_width = options.width;
+	buffer_params.full_height = options.height;
+
+	Session *session = new Session(options.session_params);
+	session->reset(buffer_params, options.session_params.samples);
+	session->scene = scene;
+
+	/* Load kernels before starting the session so compilation is not
+	 * counted as render time. */
+	start_time = time_dt();
+	session->load_kernels();
+	result.kernel_load_time = time_dt() - start_time;
+
+	if(!session->progress.get_error()) {
+		start_time = time_dt();
+		session->start();
+		session->wait();
+		result.total_time = time_dt() - start_time;
+	}
+
+	if(session->progress.get_error()) {
+		result.error_message = session->progress.get_error_message();
+	}
+	else {
+		result.success = true;
+		result.scene_update_time = scene->update_stats.device_update_time;
+		result.bvh_build_time = scene->update_stats.bvh_build_time;
+		result.render_time = max(result.total_time - result.scene_update_time, 0.0);
+	}
+
+	RenderStats stats;
+	session->collect_statistics(&stats);
+	result.device_peak_memory = stats.device.peak;
+	result.host_peak_memory = stats.host.peak;
+
+	/* Session owns the scene. */
+	delete session;
+
+	return result;
+}
+
+/* Reporting */
+
+static string benchmark_json_string(const string& str)
+{
+	string result = "\"";
+
+	foreach(char c, str) {
+		if(c == '"' || c == '\\')
+			result += '\\';
+		result += c;
+	}
+
+	return result + "\"";
+}
+
+static string benchmark_json_report(const vector<BenchmarkResult>& results)
+{
+	const DeviceInfo& device = options.session_params.device;
+	const int threads = (options.session_params.threads > 0)?
+		options.session_params.threads: system_cpu_thread_count();
+	const double pixels = (double)options.width * options.height;
+
+	string json = "{\n";
+	json += string_printf("  \"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+	json += "  \"device\": " + benchmark_json_string(Device::string_from_type(device.type)) + ",\n";
+	json += "  \"device_description\": " + benchmark_json_string(device.description) + ",\n";
+	json += string_printf("  \"threads\": %d,\n", threads);
+	json += string_printf("  \"samples\": %d,\n", options.session_params.samples);
+	json += string_printf("  \"seed\": %d,\n", options.seed);
+	json += string_printf("  \"width\": %d,\n", options.width);
+	json += string_printf("  \"height\": %d,\n", options.height);
+	json += "  \"scenes\": [\n";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+		const double samples_per_second = (result.render_time > 0.0)?
+			options.session_params.samples / result.render_time: 0.0;
+
+		json += "    {\n";
+		json += "      \"name\": " + benchmark_json_string(result.name) + ",\n";
+		json += string_printf("      \"success\": %s,\n", result.success? "true": "false");
+		if(!result.success)
+			json += "      \"error\": " + benchmark_json_string(result.error_message) + ",\n";
+		json += string_printf("      \"scene_create_time\": %f,\n", result.scene_create_time);
+		json += string_printf("      \"kernel_load_time\": %f,\n", result.kernel_load_time);
+		json += string_printf("      \"scene_update_time\": %f,\n", result.scene_update_time);
+		json += string_printf("      \"bvh_build_time\": %f,\n", result.bvh_build_time);
+		json += string_printf("      \"render_time\": %f,\n", result.render_time);
+		json += string_printf("      \"total_time\": %f,\n", result.total_time);
+		json += string_printf("      \"samples_per_second\": %f,\n", samples_per_second);
+		json += string_printf("      \"pixel_samples_per_second\": %f,\n", samples_per_second * pixels);
+		json += string_printf("      \"device_peak_memory\": %llu,\n", (unsigned long long)result.device_peak_memory);
+		json += string_printf("      \"host_peak_memory\": %llu\n", (unsigned long long)result.host_peak_memory);
+		json += (i + 1 < results.size())? "    },\n": "    }\n";
+	}
+
+	json += "  ]\n";
+	json += "}\n";
+
+	return json;
+}
+
+static void benchmark_print_result(const BenchmarkResult& result)
+{
+	if(options.quiet)
+		return;
+
+	if(!result.success) {
+		fprintf(stderr, "%-12s failed: %s\n", result.name.c_str(), result.error_message.c_str());
+		return;
+	}
+
+	fprintf(stderr, "%-12s update %8.3fs  bvh %8.3fs  render %8.3fs  peak %s\n",
+	        result.name.c_str(),
+	        result.scene_update_time,
+	        result.bvh_build_time,
+	        result.render_time,
+	        string_human_readable_size(result.device_peak_memory).c_str());
+}
+
+/* Options */
+
+static int files_parse(int argc, const char *argv[])
+{
+	for(int i = 0; i < argc; i++)
+		options.filepaths.push_back(argv[i]);
+
+	return 0;
+}
+
+static vector<BenchmarkScene> options_scenes(bool list)
+{
+	vector<BenchmarkScene> curated = benchmark_curated_scenes();
+	vector<BenchmarkScene> scenes;
+
+	if(list) {
+		foreach(BenchmarkScene& scene, curated)
+			printf("    %-12s%s\n", scene.name.c_str(), scene.description.c_str());
+
+		exit(EXIT_SUCCESS);
+	}
+
+	if(options.scene_names == "all") {
+		scenes = curated;
+	}
+	else if(options.scene_names != "") {
+		vector<string> names;
+		string_split(names, options.scene_names, ",");
+
+		foreach(const string& name, names) {
+			bool found = false;
+
+			foreach(BenchmarkScene& scene, curated) {
+				if(scene.name == name) {
+					scenes.push_back(scene);
+					found = true;
+					break;
+				}
+			}
+
+			if(!found) {
+				fprintf(stderr, "Unknown benchmark scene: %s\n", name.c_str());
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	foreach(const string& filepath, options.filepaths) {
+		BenchmarkScene scene;
+		scene.name = path_filename(filepath);
+		scene.description = filepath;
+		scene.create = NULL;
+		scene.filepath = filepath;
+		scenes.push_back(scene);
+	}
+
+	return scenes;
+}
+
+static vector<BenchmarkScene> options_parse(int argc, const char **argv)
+{
+	options.width = 960;
+	options.height = 540;
+	options.seed = 0;
+	options.scene_names = "all";
+	options.output_path = "";
+	options.quiet = false;
+	options.session_params.samples = 64;
+
+	/* device names */
+	string device_names = "";
+	string devicename = "cpu";
+	bool list = false, list_scenes = false;
+
+	vector<DeviceType>& types = Device::available_types();
+
+	foreach(DeviceType type, types) {
+		if(device_names != "")
+			device_names += ", ";
+
+		device_names += Device::string_from_type(type);
+	}
+
+	/* parse options */
+	ArgParse ap;
+	bool help = false, debug = false, version = false;
+	int verbosity = 1;
+
+	ap.options ("Usage: cycles_benchmark [options] [file.xml ...]",
+		"%*", files_parse, "",
+		"--device %s", &devicename, ("Devices to use: " + device_names).c_str(),
+		"--scenes %s", &options.scene_names, "Comma separated curated scenes to render, \"all\" or \"\" for none",
+		"--samples %d", &options.session_params.samples, "Number of samples to render",
+		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--seed %d", &options.seed, "Integrator seed",
+		"--width %d", &options.width, "Image width in pixels",
+		"--height %d", &options.height, "Image height in pixels",
+		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
+		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
+		"--output %s", &options.output_path, "File path to write JSON results, printed to stdout otherwise",
+		"--quiet", &options.quiet, "Don't print per scene results",
+		"--list-scenes", &list_scenes, "List curated benchmark scenes",
+		"--list-devices", &list, "List information about all available devices",
+#ifdef WITH_CYCLES_LOGGING
+		"--debug", &debug, "Enable debug logging",
+		"--verbose %d", &verbosity, "Set verbosity of the logger",
+#endif
+		"--help", &help, "Print help message",
+		"--version", &version, "Print version number",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if(debug) {
+		util_logging_start();
+		util_logging_verbosity_set(verbosity);
+	}
+
+	if(list) {
+		vector<DeviceInfo>& devices = Device::available_devices();
+		printf("Devices:\n");
+
+		foreach(DeviceInfo& info, devices) {
+			printf("    %-10s%s\n",
+				Device::string_from_type(info.type).c_str(),
+				info.description.c_str());
+		}
+
+		exit(EXIT_SUCCESS);
+	}
+	else if(version) {
+		printf("%s\n", CYCLES_VERSION_STRING);
+		exit(EXIT_SUCCESS);
+	}
+	else if(help) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+
+	/* Final render settings, no display and all samples per tile. */
+	options.session_params.background = true;
+	options.session_params.progressive = false;
+
+	/* find matching device */
+	DeviceType device_type = Device::type_from_string(devicename.c_str());
+	vector<DeviceInfo>& devices = Device::available_devices();
+	bool device_available = false;
+
+	foreach(DeviceInfo& device, devices) {
+		if(device_type == device.type) {
+			options.session_params.device = device;
+			device_available = true;
+			break;
+		}
+	}
+
+	/* handle invalid configurations */
+	if(options.session_params.device.type == DEVICE_NONE || !device_available) {
+		fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.session_params.samples <= 0) {
+		fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.width <= 0 || options.height <= 0) {
+		fprintf(stderr, "Invalid resolution: %dx%d\n", options.width, options.height);
+		exit(EXIT_FAILURE);
+	}
+
+	vector<BenchmarkScene> scenes = options_scenes(list_scenes);
+
+	if(scenes.empty()) {
+		fprintf(stderr, "No benchmark scenes specified\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return scenes;
+}
+
+static int benchmark_main(int argc, const char **argv)
+{
+	vector<BenchmarkScene> scenes = options_parse(argc, argv);
+	vector<BenchmarkResult> results;
+	bool success = true;
+
+	foreach(const BenchmarkScene& scene, scenes) {
+		BenchmarkResult result = benchmark_run(scene);
+		benchmark_print_result(result);
+
+		success &= result.success;
+		results.push_back(result);
+	}
+
+	string json = benchmark_json_report(results);
+
+	if(options.output_path == "") {
+		printf("%s", json.c_str());
+	}
+	else if(!path_write_text(options.output_path, json)) {
+		fprintf(stderr, "Failed to write benchmark results to %s\n", options.output_path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	return success? EXIT_SUCCESS: EXIT_FAILURE;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	util_logging_init(argv[0]);
+	path_init();
+
+	return benchmark_main(argc, argv);
+}
@@ -21,6 +21,7 @@
 #include "device.h"
 #include "scene.h"
 #include "session.h"
+#include "stats.h"
 #include "integrator.h"
 
 #include "util_args.h"
@@ -49,6 +50,7 @@ struct Options {
 	int width, height;
 	SceneParams scene_params;
 	SessionParams session_params;
+	string memory_stats_path;
 	bool quiet;
 	bool show_help, interactive, pause;
 } options;
@@ -139,9 +141,25 @@ static void scene_init()
 	options.scene->camera->compute_auto_viewplane();
 }
 
+static void session_write_memory_stats()
+{
+	RenderStats stats;
+	options.session->collect_statistics(&stats);
+
+	string json = stats.json_report();
+
+	if(!path_write_text(options.memory_stats_path, json)) {
+		fprintf(stderr, "Failed to write memory statistics to %s\n",
+		        options.memory_stats_path.c_str());
+	}
+}
+
 static void session_exit()
 {
 	if(options.session) {
+		if(options.memory_stats_path != "")
+			session_write_memory_stats();
+
 		delete options.session;
 		options.session = NULL;
 	}
@@ -377,6 +395,7 @@ static void options_parse(int argc, const char **argv)
 		"--height %d", &options.height, "Window height in pixel",
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
 		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
+		"--memory-stats %s", &options.memory_stats_path, "File path to write memory usage per category, mesh and image as JSON",
 		"--list-devices", &list, "List information about all available devices",
 #ifdef WITH_CYCLES_LOGGING
 		"--debug", &debug, "Enable debug logging",
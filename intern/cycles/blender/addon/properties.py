@@ -267,6 +267,35 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=True,
                 )
 
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop sampling pixels once their noise falls below the threshold "
+                            "(final CPU renders only)",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Noise Threshold",
+                description="Relative noise level below which a pixel is considered converged",
+                min=0.0001, max=1.0,
+                soft_min=0.001, soft_max=0.1,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Min Samples",
+                description="Number of samples to render before pixels may be considered converged",
+                min=2, max=4096,
+                default=16,
+                )
+
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lights by their estimated contribution to the shading point, "
+                            "which reduces noise in scenes with many lights "
+                            "(CPU only, not used when sampling all lights)",
+                default=False,
+                )
+
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
                 description="Use reflective caustics, resulting in a brighter image (more noise but added realism)",
@@ -385,6 +414,13 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0, max=16,
                 default=12,
                 )
+        cls.tessellation_cache_size = IntProperty(
+                name="Tessellation Cache Size",
+                description="Keep diced geometry of subdivided meshes in memory up to this size in megabytes, "
+                            "to reuse it while the mesh, dicing rate and camera don't change (0 to disable)",
+                min=0, max=1024 * 1024,
+                default=1024,
+                )
 
         cls.film_exposure = FloatProperty(
                 name="Exposure",
@@ -488,6 +524,34 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=1.0,
                 )
 
+        cls.texture_cache_size = IntProperty(
+                name="Texture Cache Size",
+                description="Read image textures on demand through a cache of this size in megabytes, "
+                            "instead of loading them fully into memory (CPU and SVM only, 0 disables the cache)",
+                min=0, max=1024 * 1024,
+                default=0,
+                )
+        cls.use_texture_auto_convert = BoolProperty(
+                name="Auto Convert Textures",
+                description="Convert image textures to tiled, mipmapped .tx files next to the originals "
+                            "when using the texture cache",
+                default=True,
+                )
+
+        cls.use_bvh_cache = BoolProperty(
+                name="Cache BVH",
+                description="Store BVHs on disk and reuse them when rendering the same geometry again, "
+                            "in later frames or other renders",
+                default=False,
+                )
+        cls.bvh_cache_size = IntProperty(
+                name="BVH Cache Size",
+                description="Remove the oldest cached BVHs when the cache grows beyond this size "
+                            "in megabytes (0 for no limit)",
+                min=0, max=1024 * 1024,
+                default=10240,
+                )
+
         cls.debug_bvh_type = EnumProperty(
                 name="Viewport BVH Type",
                 description="Choose between faster updates, or faster render",
@@ -511,6 +575,17 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default='HILBERT_SPIRAL',
                 options=set(),  # Not animatable!
                 )
+        cls.use_dynamic_tiles = BoolProperty(
+                name="Dynamic Tiles",
+                description="Split the remaining tiles near the end of the render, "
+                            "so all threads keep working until the last tile is done",
+                default=True,
+                )
+        cls.use_tile_spans = BoolProperty(
+                name="Split Into Rows",
+                description="Split remaining tiles into rows of pixels instead of smaller tiles",
+                default=False,
+                )
         cls.use_progressive_refine = BoolProperty(
                 name="Progressive Refine",
                 description="Instead of rendering each tile until it is finished, "
@@ -594,6 +669,7 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         cls.debug_use_cpu_sse3 = BoolProperty(name="SSE3", default=True)
         cls.debug_use_cpu_sse2 = BoolProperty(name="SSE2", default=True)
         cls.debug_use_qbvh = BoolProperty(name="QBVH", default=True)
+        cls.debug_use_cpu_packets = BoolProperty(name="Ray Packets", default=True)
 
         cls.debug_use_cuda_adaptive_compile = BoolProperty(name="Adaptive Compile", default=False)
 
@@ -199,6 +199,15 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         if not (use_opencl(context) and cscene.feature_set != 'EXPERIMENTAL'):
             layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
+        row = layout.row(align=True)
+        row.prop(cscene, "use_adaptive_sampling")
+        sub = row.row(align=True)
+        sub.active = cscene.use_adaptive_sampling
+        sub.prop(cscene, "adaptive_threshold", text="Threshold")
+        sub.prop(cscene, "adaptive_min_samples", text="Min")
+
+        layout.row().prop(cscene, "use_light_tree")
+
         for rl in scene.render.layers:
             if rl.samples > 0:
                 layout.separator()
@@ -236,6 +245,7 @@ class CyclesRender_PT_geometery(CyclesButtonsPanel, Panel):
             sub.prop(cscene, "preview_dicing_rate", text="Preview")
             sub.separator()
             sub.prop(cscene, "max_subdivisions")
+            sub.prop(cscene, "tessellation_cache_size", text="Cache Size")
         else:
             row = layout.row()
             row.label("Volume Sampling:")
@@ -380,6 +390,11 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         sub.prop(rd, "tile_x", text="X")
         sub.prop(rd, "tile_y", text="Y")
 
+        sub.prop(cscene, "use_dynamic_tiles")
+        subsub = sub.row(align=True)
+        subsub.active = cscene.use_dynamic_tiles
+        subsub.prop(cscene, "use_tile_spans")
+
         sub.prop(cscene, "use_progressive_refine")
 
         subsub = sub.column(align=True)
@@ -399,9 +414,21 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
 
         col.separator()
 
+        col.label(text="Textures:")
+        col.prop(cscene, "texture_cache_size", text="Cache Size")
+        sub = col.column()
+        sub.active = cscene.texture_cache_size > 0
+        sub.prop(cscene, "use_texture_auto_convert", text="Auto Convert")
+
+        col.separator()
+
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
         col.prop(cscene, "debug_use_hair_bvh")
+        col.prop(cscene, "use_bvh_cache")
+        sub = col.column()
+        sub.active = cscene.use_bvh_cache
+        sub.prop(cscene, "bvh_cache_size", text="Cache Size")
 
 
 class CyclesRender_PT_layer_options(CyclesButtonsPanel, Panel):
@@ -1516,6 +1543,7 @@ class CyclesRender_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx", toggle=True)
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_use_qbvh")
+        col.prop(cscene, "debug_use_cpu_packets")
 
         col = layout.column()
         col.label('CUDA Flags:')
@@ -30,9 +30,14 @@
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_math.h"
+#include "util_md5.h"
 
 #include "mikktspace.h"
 
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
 CCL_NAMESPACE_BEGIN
 
 /* Per-face bit flags. */
@@ -600,28 +605,33 @@ static void create_mesh(Scene *scene,
                         bool subdivision=false,
                         bool subdivide_uvs=true)
 {
+	/* Geometry is read directly from the mesh arrays, going through RNA for
+	 * every vertex and face is much slower. Normals are stored as shorts. */
+	const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
+	const MVert *mvert = me->mvert;
+	const MFace *mface = me->mface;
+	const MPoly *mpoly = me->mpoly;
+	const MLoop *mloop = me->mloop;
+	const float normal_scale = 1.0f/32767.0f;
+
 	/* count vertices and faces */
-	int numverts = b_mesh.vertices.length();
-	int numfaces = (!subdivision) ? b_mesh.tessfaces.length() : b_mesh.polygons.length();
+	int numverts = me->totvert;
+	int numfaces = (!subdivision) ? me->totface : me->totpoly;
 	int numtris = 0;
 	int numcorners = 0;
 	int numngons = 0;
 	bool use_loop_normals = b_mesh.use_auto_smooth() && (mesh->subdivision_type != Mesh::SUBDIVISION_CATMULL_CLARK);
 
 	BL::Mesh::vertices_iterator v;
-	BL::Mesh::tessfaces_iterator f;
-	BL::Mesh::polygons_iterator p;
 
 	if(!subdivision) {
-		for(b_mesh.tessfaces.begin(f); f != b_mesh.tessfaces.end(); ++f) {
-			int4 vi = get_int4(f->vertices_raw());
-			numtris += (vi[3] == 0)? 1: 2;
-		}
+		for(int i = 0; i < numfaces; i++)
+			numtris += (mface[i].v4 == 0)? 1: 2;
 	}
 	else {
-		for(b_mesh.polygons.begin(p); p != b_mesh.polygons.end(); ++p) {
-			numngons += (p->loop_total() == 4)? 0: 1;
-			numcorners += p->loop_total();
+		for(int i = 0; i < numfaces; i++) {
+			numngons += (mpoly[i].totloop == 4)? 0: 1;
+			numcorners += mpoly[i].totloop;
 		}
 	}
 
@@ -630,16 +640,15 @@ static void create_mesh(Scene *scene,
 	mesh->reserve_subd_faces(numfaces, numngons, numcorners);
 
 	/* create vertex coordinates and normals */
-	for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v)
-		mesh->add_vertex(get_float3(v->co()));
+	for(int i = 0; i < numverts; i++)
+		mesh->add_vertex(make_float3(mvert[i].co[0], mvert[i].co[1], mvert[i].co[2]));
 
 	AttributeSet& attributes = (subdivision)? mesh->subd_attributes: mesh->attributes;
 	Attribute *attr_N = attributes.add(ATTR_STD_VERTEX_NORMAL);
 	float3 *N = attr_N->data_float3();
 
-	for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v, ++N)
-		*N = get_float3(v->normal());
-	N = attr_N->data_float3();
+	for(int i = 0; i < numverts; i++)
+		N[i] = make_float3(mvert[i].no[0], mvert[i].no[1], mvert[i].no[2]) * normal_scale;
 
 	/* create generated coordinates from undeformed coordinates */
 	if(mesh->need_attribute(scene, ATTR_STD_GENERATED)) {
@@ -665,21 +674,28 @@ static void create_mesh(Scene *scene,
 	int fi = 0;
 
 	if(!subdivision) {
-		for(b_mesh.tessfaces.begin(f); f != b_mesh.tessfaces.end(); ++f, ++fi) {
-			int4 vi = get_int4(f->vertices_raw());
+		const short (*tess_loop_normals)[4][3] = (const short (*)[4][3])
+		        CustomData_get_layer(&me->fdata, CD_TESSLOOPNORMAL);
+
+		for(fi = 0; fi < numfaces; fi++) {
+			const MFace& face = mface[fi];
+			int4 vi = make_int4(face.v1, face.v2, face.v3, face.v4);
 			int n = (vi[3] == 0)? 3: 4;
-			int shader = clamp(f->material_index(), 0, used_shaders.size()-1);
-			bool smooth = f->use_smooth() || use_loop_normals;
+			int shader = clamp((int)face.mat_nr, 0, (int)used_shaders.size()-1);
+			bool smooth = (face.flag & ME_SMOOTH) || use_loop_normals;
 
 			/* split vertices if normal is different
 			 *
 			 * note all vertex attributes must have been set here so we can split
 			 * and copy attributes in split_vertex without remapping later */
 			if(use_loop_normals) {
-				BL::Array<float, 12> loop_normals = f->split_normals();
-
 				for(int i = 0; i < n; i++) {
-					float3 loop_N = make_float3(loop_normals[i * 3], loop_normals[i * 3 + 1], loop_normals[i * 3 + 2]);
+					float3 loop_N = make_float3(0.0f, 0.0f, 0.0f);
+
+					if(tess_loop_normals) {
+						const short *no = tess_loop_normals[fi][i];
+						loop_N = make_float3(no[0], no[1], no[2]) * normal_scale;
+					}
 
 					if(N[vi[i]] != loop_N) {
 						int new_vi = mesh->split_vertex(vi[i]);
@@ -715,23 +731,30 @@ static void create_mesh(Scene *scene,
 		}
 	}
 	else {
+		const float (*loop_normals)[3] = (const float (*)[3])
+		        CustomData_get_layer(&me->ldata, CD_NORMAL);
 		vector<int> vi;
 
-		for(b_mesh.polygons.begin(p); p != b_mesh.polygons.end(); ++p) {
-			int n = p->loop_total();
-			int shader = clamp(p->material_index(), 0, used_shaders.size()-1);
-			bool smooth = p->use_smooth() || use_loop_normals;
+		for(int pi = 0; pi < numfaces; pi++) {
+			const MPoly& poly = mpoly[pi];
+			int n = poly.totloop;
+			int shader = clamp((int)poly.mat_nr, 0, (int)used_shaders.size()-1);
+			bool smooth = (poly.flag & ME_SMOOTH) || use_loop_normals;
 
-			vi.reserve(n);
+			vi.resize(n);
 			for(int i = 0; i < n; i++) {
-				vi[i] = b_mesh.loops[p->loop_start() + i].vertex_index();
+				int loop = poly.loopstart + i;
+				vi[i] = mloop[loop].v;
 
 				/* split vertices if normal is different
 				 *
 				 * note all vertex attributes must have been set here so we can split
 				 * and copy attributes in split_vertex without remapping later */
 				if(use_loop_normals) {
-					float3 loop_N = get_float3(b_mesh.loops[p->loop_start() + i].normal());
+					float3 loop_N = make_float3(0.0f, 0.0f, 0.0f);
+
+					if(loop_normals)
+						loop_N = make_float3(loop_normals[loop][0], loop_normals[loop][1], loop_normals[loop][2]);
 
 					if(N[vi[i]] != loop_N) {
 						int new_vi = mesh->split_vertex(vi[i]);
@@ -771,23 +794,19 @@ static void create_mesh(Scene *scene,
 
 static void create_subd_mesh(Scene *scene,
                              Mesh *mesh,
-                             BL::Object& b_ob,
                              BL::Mesh& b_mesh,
                              const vector<Shader*>& used_shaders,
-                             float dicing_rate,
-                             int max_subdivisions)
+                             bool subdivide_uvs)
 {
-	BL::SubsurfModifier subsurf_mod(b_ob.modifiers[b_ob.modifiers.length()-1]);
-	bool subdivide_uvs = subsurf_mod.use_subsurf_uv();
-
 	create_mesh(scene, mesh, b_mesh, used_shaders, true, subdivide_uvs);
 
 	/* export creases */
+	const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
+	const MEdge *medge = me->medge;
 	size_t num_creases = 0;
-	BL::Mesh::edges_iterator e;
 
-	for(b_mesh.edges.begin(e); e != b_mesh.edges.end(); ++e) {
-		if(e->crease() != 0.0f) {
+	for(int i = 0; i < me->totedge; i++) {
+		if(medge[i].crease != 0) {
 			num_creases++;
 		}
 	}
@@ -795,16 +814,23 @@ static void create_subd_mesh(Scene *scene,
 	mesh->subd_creases.resize(num_creases);
 
 	Mesh::SubdEdgeCrease* crease = mesh->subd_creases.data();
-	for(b_mesh.edges.begin(e); e != b_mesh.edges.end(); ++e) {
-		if(e->crease() != 0.0f) {
-			crease->v[0] = e->vertices()[0];
-			crease->v[1] = e->vertices()[1];
-			crease->crease = e->crease();
+	for(int i = 0; i < me->totedge; i++) {
+		if(medge[i].crease != 0) {
+			crease->v[0] = medge[i].v1;
+			crease->v[1] = medge[i].v2;
+			crease->crease = medge[i].crease / 255.0f;
 
 			crease++;
 		}
 	}
+}
 
+static void sync_subd_params(Scene *scene,
+                             Mesh *mesh,
+                             BL::Object& b_ob,
+                             float dicing_rate,
+                             int max_subdivisions)
+{
 	/* set subd params */
 	if(!mesh->subd_params) {
 		mesh->subd_params = new SubdParams(mesh);
@@ -821,6 +847,79 @@ static void create_subd_mesh(Scene *scene,
 	sdparams.objecttoworld = get_transform(b_ob.matrix_world());
 }
 
+/* Hash of the evaluated mesh data converted into the Cycles mesh. Only plain
+ * data layers are included, layers holding pointers would never match. */
+
+static bool mesh_hash_layer_type(int type)
+{
+	switch(type) {
+		case CD_MVERT:
+		case CD_MEDGE:
+		case CD_MFACE:
+		case CD_MTFACE:
+		case CD_MCOL:
+		case CD_NORMAL:
+		case CD_ORCO:
+		case CD_MLOOPUV:
+		case CD_MLOOPCOL:
+		case CD_MPOLY:
+		case CD_MLOOP:
+		case CD_TESSLOOPNORMAL:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static void mesh_hash_append(MD5Hash& md5, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	/* MD5Hash takes int sizes, feed large arrays in pieces */
+	while(size > 0) {
+		int chunk = (size > (1 << 30))? (1 << 30): (int)size;
+		md5.append(bytes, chunk);
+		bytes += chunk;
+		size -= chunk;
+	}
+}
+
+static string mesh_data_hash_compute(BL::Mesh& b_mesh, int subdivision_type, bool hide_tris)
+{
+	const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
+	const CustomData *data[] = {&me->vdata, &me->edata, &me->fdata, &me->pdata, &me->ldata};
+	const int count[] = {me->totvert, me->totedge, me->totface, me->totpoly, me->totloop};
+	MD5Hash md5;
+
+	for(int i = 0; i < 5; i++) {
+		for(int l = 0; l < data[i]->totlayer; l++) {
+			const CustomDataLayer& layer = data[i]->layers[l];
+
+			if(!mesh_hash_layer_type(layer.type))
+				continue;
+
+			mesh_hash_append(md5, &layer.type, sizeof(layer.type));
+			mesh_hash_append(md5, layer.name, strlen(layer.name));
+			mesh_hash_append(md5, &count[i], sizeof(count[i]));
+
+			if(layer.data)
+				mesh_hash_append(md5, layer.data, (size_t)CustomData_sizeof(layer.type)*count[i]);
+		}
+	}
+
+	/* texture space and auto smooth */
+	mesh_hash_append(md5, me->loc, sizeof(me->loc));
+	mesh_hash_append(md5, me->size, sizeof(me->size));
+	mesh_hash_append(md5, &me->texflag, sizeof(me->texflag));
+	mesh_hash_append(md5, &me->flag, sizeof(me->flag));
+	mesh_hash_append(md5, &me->smoothresh, sizeof(me->smoothresh));
+
+	mesh_hash_append(md5, &subdivision_type, sizeof(subdivision_type));
+	mesh_hash_append(md5, &hide_tris, sizeof(hide_tris));
+
+	return md5.get_hex();
+}
+
 /* Sync */
 
 static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
@@ -908,26 +1007,24 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	}
 	Mesh *mesh;
 
-	if(!mesh_map.sync(&mesh, key)) {
-		/* if transform was applied to mesh, need full update */
-		if(object_updated && mesh->transform_applied);
-		/* test if shaders changed, these can be object level so mesh
-		 * does not get tagged for recalc */
-		else if(mesh->used_shaders != used_shaders);
-		else if(requested_geometry_flags != mesh->geometry_flags);
-		else {
-			/* even if not tagged for recalc, we may need to sync anyway
-			 * because the shader needs different mesh attributes */
-			bool attribute_recalc = false;
+	/* even if not tagged for recalc, we may need to sync anyway
+	 * because the shader needs different mesh attributes */
+	bool mesh_recalc = mesh_map.sync(&mesh, key);
+	bool attribute_recalc = false;
 
-			foreach(Shader *shader, mesh->used_shaders)
-				if(shader->need_update_attributes)
-					attribute_recalc = true;
+	foreach(Shader *shader, mesh->used_shaders)
+		if(shader->need_update_attributes)
+			attribute_recalc = true;
 
-			if(!attribute_recalc)
-				return mesh;
-		}
-	}
+	/* if only the mesh data was tagged for recalc, the evaluated data may
+	 * still be the same and the existing mesh can be kept */
+	bool settings_changed = (object_updated && mesh->transform_applied) ||
+	                        mesh->used_shaders != used_shaders ||
+	                        requested_geometry_flags != mesh->geometry_flags ||
+	                        attribute_recalc;
+
+	if(!mesh_recalc && !settings_changed)
+		return mesh;
 
 	/* ensure we only sync instanced meshes once */
 	if(mesh_synced.find(mesh) != mesh_synced.end())
@@ -936,16 +1033,9 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	mesh_synced.insert(mesh);
 
 	/* create derived mesh */
-	array<int> oldtriangle = mesh->triangles;
-	
-	/* compares curve_keys rather than strands in order to handle quick hair
-	 * adjustments in dynamic BVH - other methods could probably do this better*/
-	array<float3> oldcurve_keys = mesh->curve_keys;
-	array<float> oldcurve_radius = mesh->curve_radius;
-
-	mesh->clear();
-	mesh->used_shaders = used_shaders;
-	mesh->name = ustring(b_ob_data.name().c_str());
+	BL::Mesh b_mesh(PointerRNA_NULL);
+	Mesh::SubdivisionType subdivision_type = object_subdivision_type(b_ob, preview, experimental);
+	string data_hash;
 
 	if(requested_geometry_flags != Mesh::GEOMETRY_NONE) {
 		/* mesh objects does have special handle in the dependency graph,
@@ -957,25 +1047,32 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 		if(preview && b_ob.type() != BL::Object::type_MESH)
 			b_ob.update_from_editmode();
 
+		/* generated coordinates depend on the shaders the mesh will use */
+		vector<Shader*> old_shaders = mesh->used_shaders;
+		mesh->used_shaders = used_shaders;
 		bool need_undeformed = mesh->need_attribute(scene, ATTR_STD_GENERATED);
+		mesh->used_shaders = old_shaders;
+
+		b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed, subdivision_type);
+
+		/* particle hair, smoke and fluid motion depend on more than the
+		 * evaluated mesh, motion is exported from other frames */
+		if(b_mesh &&
+		   subdivision_type == Mesh::SUBDIVISION_NONE &&
+		   scene->need_motion() == Scene::MOTION_NONE &&
+		   b_ob.particle_systems.length() == 0 &&
+		   !object_smoke_domain_find(b_ob) &&
+		   !object_fluid_domain_find(b_ob))
+		{
+			data_hash = mesh_data_hash_compute(b_mesh, subdivision_type, hide_tris);
+		}
+	}
 
-		mesh->subdivision_type = object_subdivision_type(b_ob, preview, experimental);
-
-		BL::Mesh b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed, mesh->subdivision_type);
-
-		if(b_mesh) {
-			if(render_layer.use_surfaces && !hide_tris) {
-				if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
-					create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders,
-					                 dicing_rate, max_subdivisions);
-				else
-					create_mesh(scene, mesh, b_mesh, used_shaders, false);
-
-				create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
-			}
+	if(!settings_changed && !data_hash.empty()) {
+		map<Mesh*, string>::iterator it = mesh_data_hash.find(mesh);
 
-			if(render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
-				sync_curves(mesh, b_mesh, b_ob, false);
+		if(it != mesh_data_hash.end() && it->second == data_hash) {
+			VLOG(1) << "Mesh " << b_ob_data.name() << " data unchanged, skipping conversion.";
 
 			if(can_free_caches) {
 				b_ob.cache_release();
@@ -983,40 +1080,135 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 
 			/* free derived mesh */
 			b_data.meshes.remove(b_mesh, false);
+
+			return mesh;
 		}
 	}
+
+	if(data_hash.empty())
+		mesh_data_hash.erase(mesh);
+	else
+		mesh_data_hash[mesh] = data_hash;
+
+	MeshSync *mesh_sync = new MeshSync(mesh, b_ob, b_mesh);
+	mesh_sync->oldtriangle = mesh->triangles;
+	
+	/* compares curve_keys rather than strands in order to handle quick hair
+	 * adjustments in dynamic BVH - other methods could probably do this better*/
+	mesh_sync->oldcurve_keys = mesh->curve_keys;
+	mesh_sync->oldcurve_radius = mesh->curve_radius;
+
+	mesh->clear();
+	mesh->used_shaders = used_shaders;
+	mesh->name = ustring(b_ob_data.name().c_str());
+	mesh->subdivision_type = subdivision_type;
 	mesh->geometry_flags = requested_geometry_flags;
 
-	/* fluid motion */
-	sync_mesh_fluid_motion(b_ob, scene, mesh);
+	if(b_mesh) {
+		mesh_sync->sync_surface = render_layer.use_surfaces && !hide_tris;
+		mesh_sync->sync_hair = render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE;
 
-	/* tag update */
-	bool rebuild = false;
+		if(mesh_sync->sync_surface && mesh->subdivision_type != Mesh::SUBDIVISION_NONE) {
+			BL::SubsurfModifier subsurf_mod(b_ob.modifiers[b_ob.modifiers.length()-1]);
+			mesh_sync->subdivide_uvs = subsurf_mod.use_subsurf_uv();
 
-	if(oldtriangle.size() != mesh->triangles.size())
-		rebuild = true;
-	else if(oldtriangle.size()) {
-		if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(int)*oldtriangle.size()) != 0)
-			rebuild = true;
+			sync_subd_params(scene, mesh, b_ob, dicing_rate, max_subdivisions);
+		}
 	}
 
-	if(oldcurve_keys.size() != mesh->curve_keys.size())
-		rebuild = true;
-	else if(oldcurve_keys.size()) {
-		if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(float3)*oldcurve_keys.size()) != 0)
+	/* tag now so objects using the mesh are updated, the rebuild flag
+	 * is decided once conversion is done */
+	mesh->tag_update(scene, false);
+
+	mesh_sync_queue.push_back(mesh_sync);
+
+	if(mesh_sync->sync_surface)
+		mesh_sync_pool.push(function_bind(&BlenderSync::sync_mesh_convert, this, mesh_sync));
+
+	/* bound the number of evaluated meshes kept in memory */
+	if(mesh_sync_queue.size() >= (size_t)(2*max(TaskScheduler::num_threads(), 1)))
+		sync_mesh_finish();
+
+	return mesh;
+}
+
+void BlenderSync::sync_mesh_convert(MeshSync *mesh_sync)
+{
+	Mesh *mesh = mesh_sync->mesh;
+
+	if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+		create_subd_mesh(scene, mesh, mesh_sync->b_mesh, mesh->used_shaders, mesh_sync->subdivide_uvs);
+	else
+		create_mesh(scene, mesh, mesh_sync->b_mesh, mesh->used_shaders, false);
+}
+
+void BlenderSync::sync_mesh_finish()
+{
+	if(mesh_sync_queue.empty())
+		return;
+
+	mesh_sync_pool.wait_work();
+
+	const bool is_interface_locked = b_engine.render() &&
+	                                 b_engine.render().use_lock_interface();
+	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
+
+	/* finish in the order meshes were synced, volume attributes, hair and
+	 * freeing evaluated meshes are not thread safe */
+	foreach(MeshSync *mesh_sync, mesh_sync_queue) {
+		Mesh *mesh = mesh_sync->mesh;
+
+		if(mesh_sync->b_mesh) {
+			if(mesh_sync->sync_surface)
+				create_mesh_volume_attributes(scene, mesh_sync->b_ob, mesh, b_scene.frame_current());
+
+			if(mesh_sync->sync_hair)
+				sync_curves(mesh, mesh_sync->b_mesh, mesh_sync->b_ob, false);
+
+			if(can_free_caches) {
+				mesh_sync->b_ob.cache_release();
+			}
+
+			/* free derived mesh */
+			b_data.meshes.remove(mesh_sync->b_mesh, false);
+		}
+
+		/* fluid motion */
+		sync_mesh_fluid_motion(mesh_sync->b_ob, scene, mesh);
+
+		/* tag update */
+		const array<int>& oldtriangle = mesh_sync->oldtriangle;
+		const array<float3>& oldcurve_keys = mesh_sync->oldcurve_keys;
+		const array<float>& oldcurve_radius = mesh_sync->oldcurve_radius;
+		bool rebuild = false;
+
+		if(oldtriangle.size() != mesh->triangles.size())
 			rebuild = true;
-	}
+		else if(oldtriangle.size()) {
+			if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(int)*oldtriangle.size()) != 0)
+				rebuild = true;
+		}
+
+		if(oldcurve_keys.size() != mesh->curve_keys.size())
+			rebuild = true;
+		else if(oldcurve_keys.size()) {
+			if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(float3)*oldcurve_keys.size()) != 0)
+				rebuild = true;
+		}
 
-	if(oldcurve_radius.size() != mesh->curve_radius.size())
-		rebuild = true;
-	else if(oldcurve_radius.size()) {
-		if(memcmp(&oldcurve_radius[0], &mesh->curve_radius[0], sizeof(float)*oldcurve_radius.size()) != 0)
+		if(oldcurve_radius.size() != mesh->curve_radius.size())
 			rebuild = true;
+		else if(oldcurve_radius.size()) {
+			if(memcmp(&oldcurve_radius[0], &mesh->curve_radius[0], sizeof(float)*oldcurve_radius.size()) != 0)
+				rebuild = true;
+		}
+		
+		mesh->tag_update(scene, rebuild);
+
+		delete mesh_sync;
 	}
-	
-	mesh->tag_update(scene, rebuild);
 
-	return mesh;
+	mesh_sync_queue.clear();
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object& b_ob,
@@ -661,6 +661,9 @@ void BlenderSync::sync_objects(BL::SpaceView3D& b_v3d, float motion_time)
 		}
 	}
 
+	/* finish meshes still being converted */
+	sync_mesh_finish();
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
@@ -669,8 +672,20 @@ void BlenderSync::sync_objects(BL::SpaceView3D& b_v3d, float motion_time)
 		/* handle removed data and modified pointers */
 		if(light_map.post_sync())
 			scene->light_manager->tag_update(scene);
-		if(mesh_map.post_sync())
+		if(mesh_map.post_sync()) {
 			scene->mesh_manager->tag_update(scene);
+
+			/* forget data hashes of removed meshes */
+			set<Mesh*> meshes(scene->meshes.begin(), scene->meshes.end());
+			map<Mesh*, string>::iterator it = mesh_data_hash.begin();
+
+			while(it != mesh_data_hash.end()) {
+				if(meshes.find(it->first) == meshes.end())
+					mesh_data_hash.erase(it++);
+				else
+					++it;
+			}
+		}
 		if(object_map.post_sync())
 			scene->object_manager->tag_update(scene);
 		if(particle_system_map.post_sync())
@@ -21,6 +21,8 @@
 #include "blender_sync.h"
 #include "blender_session.h"
 
+#include "subd_cache.h"
+
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_md5.h"
@@ -70,6 +72,7 @@ bool debug_flags_sync_from_scene(BL::Scene b_scene)
 	flags.cpu.sse3 = get_boolean(cscene, "debug_use_cpu_sse3");
 	flags.cpu.sse2 = get_boolean(cscene, "debug_use_cpu_sse2");
 	flags.cpu.qbvh = get_boolean(cscene, "debug_use_qbvh");
+	flags.cpu.packets = get_boolean(cscene, "debug_use_cpu_packets");
 	/* Synchronize CUDA flags. */
 	flags.cuda.adaptive_compile = get_boolean(cscene, "debug_use_cuda_adaptive_compile");
 	/* Synchronize OpenCL kernel type. */
@@ -192,6 +195,7 @@ static PyObject *init_func(PyObject * /*self*/, PyObject *args)
 static PyObject *exit_func(PyObject * /*self*/, PyObject * /*args*/)
 {
 	ShaderManager::free_memory();
+	DiceCache::free_memory();
 	TaskScheduler::free_memory();
 	Device::free_memory();
 	device_list.free_memory();
@@ -199,11 +199,12 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	scene->reset();
 
 	session->tile_manager.set_tile_order(session_params.tile_order);
+	session->tile_manager.set_tile_split(session_params.dynamic_tiles, session_params.tile_spans);
 
 	/* peak memory usage should show current render peak, not peak for all renders
 	 * made by this render session
 	 */
-	session->stats.mem_peak = session->stats.mem_used;
+	session->stats.reset_peak();
 
 	/* sync object should be re-created */
 	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, is_cpu);
@@ -492,6 +493,11 @@ void BlenderSession::render()
 			}
 		}
 
+		/* internal pass used to estimate noise for adaptive sampling */
+		PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+		if(get_boolean(cscene, "use_adaptive_sampling"))
+			Pass::add(PASS_ADAPTIVE_AUX, passes);
+
 		buffer_params.passes = passes;
 		scene->film->pass_alpha_threshold = b_layer_iter->pass_alpha_threshold();
 		scene->film->tag_passes_update(scene, passes);
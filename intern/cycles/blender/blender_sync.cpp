@@ -285,6 +285,12 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 
+	integrator->use_adaptive_sampling = get_boolean(cscene, "use_adaptive_sampling");
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
 	int transmission_samples = get_int(cscene, "transmission_samples");
@@ -314,6 +320,16 @@ void BlenderSync::sync_integrator()
 
 	if(integrator->modified(previntegrator))
 		integrator->tag_update(scene);
+
+	/* The light manager decides whether the light tree can be used. */
+	if(integrator->use_light_tree != previntegrator.use_light_tree ||
+	   (integrator->use_light_tree &&
+	    (integrator->method != previntegrator.method ||
+	     integrator->sample_all_lights_direct != previntegrator.sample_all_lights_direct ||
+	     integrator->sample_all_lights_indirect != previntegrator.sample_all_lights_indirect)))
+	{
+		scene->light_manager->tag_update(scene);
+	}
 }
 
 /* Film */
@@ -489,6 +505,14 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
 	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
 
+	/* Geometry rarely stays the same between viewport updates. */
+	if(background) {
+		params.use_bvh_cache = RNA_boolean_get(&cscene, "use_bvh_cache");
+		params.bvh_cache_size = get_int(cscene, "bvh_cache_size");
+	}
+
+	params.tessellation_cache_size = get_int(cscene, "tessellation_cache_size");
+
 	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
 		params.persistent_data = r.use_persistent_data();
 	else
@@ -504,6 +528,13 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.use_qbvh = false;
 	}
 
+	/* OSL has its own texture system, other devices need images in memory. */
+	if(is_cpu && params.shadingsystem == SHADINGSYSTEM_SVM)
+		params.texture_cache_size = get_int(cscene, "texture_cache_size");
+	else
+		params.texture_cache_size = 0;
+	params.texture_auto_convert = get_boolean(cscene, "use_texture_auto_convert");
+
 	return params;
 }
 
@@ -615,6 +646,11 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine& b_engine,
 		params.tile_order = TILE_BOTTOM_TO_TOP;
 	}
 
+	/* with save buffers every tile written must match a render part */
+	params.dynamic_tiles = get_boolean(cscene, "use_dynamic_tiles") &&
+	                       !b_scene.render().use_save_buffers();
+	params.tile_spans = get_boolean(cscene, "use_tile_spans");
+
 	params.start_resolution = get_int(cscene, "preview_start_resolution");
 
 	/* other parameters */
@@ -29,6 +29,7 @@
 
 #include "util_map.h"
 #include "util_set.h"
+#include "util_task.h"
 #include "util_transform.h"
 #include "util_vector.h"
 
@@ -110,6 +111,7 @@ private:
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree& b_ntree);
 	Mesh *sync_mesh(BL::Object& b_ob, bool object_updated, bool hide_tris);
+	void sync_mesh_finish();
 	void sync_curves(Mesh *mesh,
 	                 BL::Mesh& b_mesh,
 	                 BL::Object& b_ob,
@@ -165,6 +167,37 @@ private:
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
+
+	/* Mesh conversion running in the mesh sync pool. Evaluating meshes
+	 * modifies the Blender database so that happens on the main thread,
+	 * which also frees the evaluated meshes once conversion is done. */
+	struct MeshSync {
+		MeshSync(Mesh *mesh_, BL::Object& b_ob_, BL::Mesh& b_mesh_)
+		: mesh(mesh_), b_ob(b_ob_), b_mesh(b_mesh_),
+		  sync_surface(false), sync_hair(false), subdivide_uvs(true)
+		{}
+
+		Mesh *mesh;
+		BL::Object b_ob;
+		BL::Mesh b_mesh;
+		bool sync_surface;
+		bool sync_hair;
+		bool subdivide_uvs;
+
+		/* data before the sync, to detect if the BVH needs a rebuild */
+		array<int> oldtriangle;
+		array<float3> oldcurve_keys;
+		array<float> oldcurve_radius;
+	};
+
+	void sync_mesh_convert(MeshSync *mesh_sync);
+
+	TaskPool mesh_sync_pool;
+	vector<MeshSync*> mesh_sync_queue;
+
+	/* hash of the evaluated Blender data each mesh was created from, to
+	 * skip converting meshes that were tagged for update but did not change */
+	map<Mesh*, string> mesh_data_hash;
 	std::set<float> motion_times;
 	void *world_map;
 	bool world_recalc;
@@ -35,6 +35,8 @@ void BKE_image_user_frame_calc(void *iuser, int cfra, int fieldnr);
 void BKE_image_user_file_path(void *iuser, void *ima, char *path);
 unsigned char *BKE_image_get_pixels_for_frame(void *image, int frame);
 float *BKE_image_get_float_pixels_for_frame(void *image, int frame);
+void *CustomData_get_layer(const struct CustomData *data, int type);
+int CustomData_sizeof(int type);
 }
 
 CCL_NAMESPACE_BEGIN
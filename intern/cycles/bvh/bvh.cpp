@@ -74,6 +74,19 @@ BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 
 void BVH::build(Progress& progress)
 {
+	cache_key = "";
+
+	if(params.use_cache) {
+		progress.set_substatus("Looking in BVH cache");
+
+		string key = compute_cache_key();
+		if(!key.empty() && cache_read(key)) {
+			cache_key = key;
+			return;
+		}
+		cache_key = key;
+	}
+
 	progress.set_substatus("Building BVH");
 
 	/* build nodes */
@@ -105,16 +118,28 @@ void BVH::build(Progress& progress)
 
 	/* free build nodes */
 	root->deleteSubtree();
+
+	if(!cache_key.empty()) {
+		progress.set_substatus("Writing BVH cache");
+		cache_write(cache_key);
+	}
 }
 
 /* Refitting */
 
 void BVH::refit(Progress& progress)
 {
-	progress.set_substatus("Packing BVH primitives");
-	pack_primitives();
+	/* Refitted nodes no longer match the cached ones. */
+	cache_key = "";
+
+	/* Primitives of the top level BVH include the merged instance BVHs and
+	 * don't change when only object bounds do. */
+	if(!params.top_level) {
+		progress.set_substatus("Packing BVH primitives");
+		pack_primitives();
 
-	if(progress.get_cancel()) return;
+		if(progress.get_cancel()) return;
+	}
 
 	progress.set_substatus("Refitting BVH nodes");
 	refit_nodes();
@@ -622,8 +647,6 @@ void RegularBVH::pack_nodes(const BVHNode *root)
 
 void RegularBVH::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -636,8 +659,11 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 		const int4 *data = &pack.leaf_nodes[idx];
 		const int c0 = data[0].x;
 		const int c1 = data[0].y;
+		/* object leaves of the top level BVH store ~prim */
+		const int prim_begin = (c0 < 0)? ~c0: c0;
+		const int prim_end = (c0 < 0)? ~c0 + 1: c1;
 		/* refit leaf node */
-		for(int prim = c0; prim < c1; prim++) {
+		for(int prim = prim_begin; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
 			Object *ob = objects[tob];
@@ -1033,8 +1059,6 @@ void QBVH::pack_nodes(const BVHNode *root)
 
 void QBVH::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -1045,8 +1069,11 @@ void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 	if(leaf) {
 		int4 *data = &pack.leaf_nodes[idx];
 		int4 c = data[0];
+		/* Object leaves of the top level BVH store ~prim. */
+		const int prim_begin = (c.x < 0)? ~c.x: c.x;
+		const int prim_end = (c.x < 0)? ~c.x + 1: c.y;
 		/* Refit leaf node. */
-		for(int prim = c.x; prim < c.y; prim++) {
+		for(int prim = prim_begin; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
 			Object *ob = objects[tob];
@@ -20,6 +20,7 @@
 
 #include "bvh_params.h"
 
+#include "util_string.h"
 #include "util_types.h"
 #include "util_vector.h"
 
@@ -75,6 +76,16 @@ struct PackedBVH {
 	PackedBVH()
 	{
 		root_index = 0;
+
+		nodes.set_mem_category(MEM_CATEGORY_BVH);
+		leaf_nodes.set_mem_category(MEM_CATEGORY_BVH);
+		object_node.set_mem_category(MEM_CATEGORY_BVH);
+		prim_tri_index.set_mem_category(MEM_CATEGORY_BVH);
+		prim_tri_verts.set_mem_category(MEM_CATEGORY_BVH);
+		prim_type.set_mem_category(MEM_CATEGORY_BVH);
+		prim_visibility.set_mem_category(MEM_CATEGORY_BVH);
+		prim_index.set_mem_category(MEM_CATEGORY_BVH);
+		prim_object.set_mem_category(MEM_CATEGORY_BVH);
 	}
 };
 
@@ -86,6 +97,8 @@ public:
 	PackedBVH pack;
 	BVHParams params;
 	vector<Object*> objects;
+	/* Key of the packed BVH in the disk cache, empty if not cached. */
+	string cache_key;
 
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
@@ -103,6 +116,11 @@ protected:
 	/* merge instance BVH's */
 	void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
 
+	/* disk cache */
+	string compute_cache_key();
+	bool cache_read(const string& key);
+	void cache_write(const string& key);
+
 	/* for subclasses to implement */
 	virtual void pack_nodes(const BVHNode *root) = 0;
 	virtual void refit_nodes() = 0;
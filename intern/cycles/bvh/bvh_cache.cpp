@@ -0,0 +1,399 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mesh.h"
+#include "object.h"
+
+#include "bvh.h"
+
+#include "util_logging.h"
+#include "util_map.h"
+#include "util_md5.h"
+#include "util_path.h"
+#include "util_thread.h"
+#include "util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* BVH Disk Cache
+ *
+ * Packed BVHs are stored in the user cache directory, in files named after a
+ * hash of the build parameters and of all geometry the BVH is built from. So
+ * the same geometry rendered again, in the next frame or another render job,
+ * skips the build entirely.
+ *
+ * Files end with a checksum of their contents and are written under a
+ * temporary name before being renamed into place, so interrupted or
+ * concurrent writes can't leave a damaged file behind. */
+
+#define BVH_CACHE_VERSION 1
+#define BVH_CACHE_PREFIX "bvh_"
+
+static const char bvh_cache_magic[8] = {'C', 'Y', 'C', 'L', 'E', 'S', 'B', 'V'};
+
+/* Hashing */
+
+static void bvh_cache_hash_data(MD5Hash& md5, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	/* MD5Hash only takes int sizes. */
+	while(size > 0) {
+		int chunk = (size > (1 << 30))? (1 << 30): (int)size;
+		md5.append(bytes, chunk);
+		bytes += chunk;
+		size -= chunk;
+	}
+}
+
+template<typename T>
+static void bvh_cache_hash_value(MD5Hash& md5, const T& value)
+{
+	md5.append((const uint8_t*)&value, sizeof(T));
+}
+
+template<typename T>
+static void bvh_cache_hash_array(MD5Hash& md5, const array<T>& data)
+{
+	bvh_cache_hash_value(md5, (uint64_t)data.size());
+	bvh_cache_hash_data(md5, data.data(), data.size()*sizeof(T));
+}
+
+/* Padding of float3 is not guaranteed to be initialized, only hash xyz. */
+static void bvh_cache_hash_float3(MD5Hash& md5, const float3 *data, size_t size)
+{
+	const size_t chunk_size = 1024;
+	float buffer[3*chunk_size];
+
+	bvh_cache_hash_value(md5, (uint64_t)size);
+
+	for(size_t i = 0; i < size; i += chunk_size) {
+		size_t num = (size - i < chunk_size)? size - i: chunk_size;
+
+		for(size_t j = 0; j < num; j++) {
+			buffer[j*3 + 0] = data[i + j].x;
+			buffer[j*3 + 1] = data[i + j].y;
+			buffer[j*3 + 2] = data[i + j].z;
+		}
+
+		md5.append((const uint8_t*)buffer, (int)(num*3*sizeof(float)));
+	}
+}
+
+static void bvh_cache_hash_motion(MD5Hash& md5, const Attribute *attr)
+{
+	if(attr) {
+		bvh_cache_hash_float3(md5,
+		                      attr->data_float3(),
+		                      attr->buffer.size()/sizeof(float3));
+	}
+	else {
+		bvh_cache_hash_value(md5, (uint64_t)0);
+	}
+}
+
+static void bvh_cache_hash_mesh(MD5Hash& md5, const Mesh *mesh)
+{
+	bvh_cache_hash_float3(md5, mesh->verts.data(), mesh->verts.size());
+	bvh_cache_hash_array(md5, mesh->triangles);
+
+	bvh_cache_hash_float3(md5, mesh->curve_keys.data(), mesh->curve_keys.size());
+	bvh_cache_hash_array(md5, mesh->curve_radius);
+	bvh_cache_hash_array(md5, mesh->curve_first_key);
+
+	bvh_cache_hash_value(md5, mesh->use_motion_blur);
+	bvh_cache_hash_value(md5, mesh->motion_steps);
+
+	if(mesh->use_motion_blur) {
+		bvh_cache_hash_motion(md5, mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION));
+		bvh_cache_hash_motion(md5, mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION));
+	}
+}
+
+static void bvh_cache_hash_bounds(MD5Hash& md5, const BoundBox& bounds)
+{
+	float3 data[2] = {bounds.min, bounds.max};
+	bvh_cache_hash_float3(md5, data, 2);
+}
+
+string BVH::compute_cache_key()
+{
+	MD5Hash md5;
+
+	bvh_cache_hash_value(md5, (int)BVH_CACHE_VERSION);
+
+	/* Build parameters, one by one since the struct has padding. */
+	bvh_cache_hash_value(md5, params.use_spatial_split);
+	bvh_cache_hash_value(md5, params.spatial_split_alpha);
+	bvh_cache_hash_value(md5, params.unaligned_split_threshold);
+	bvh_cache_hash_value(md5, params.sah_node_cost);
+	bvh_cache_hash_value(md5, params.sah_primitive_cost);
+	bvh_cache_hash_value(md5, params.min_leaf_size);
+	bvh_cache_hash_value(md5, params.max_triangle_leaf_size);
+	bvh_cache_hash_value(md5, params.max_curve_leaf_size);
+	bvh_cache_hash_value(md5, params.top_level);
+	bvh_cache_hash_value(md5, params.use_qbvh);
+	bvh_cache_hash_value(md5, params.primitive_mask);
+	bvh_cache_hash_value(md5, params.use_unaligned_nodes);
+
+	bvh_cache_hash_value(md5, (uint64_t)objects.size());
+
+	/* Instanced meshes are merged once, at the first object using them. */
+	map<Mesh*, int> mesh_map;
+
+	for(size_t i = 0; i < objects.size(); i++) {
+		Object *ob = objects[i];
+		Mesh *mesh = ob->mesh;
+
+		bvh_cache_hash_value(md5, ob->visibility);
+
+		if(params.top_level) {
+			bvh_cache_hash_value(md5, mesh->tri_offset);
+			bvh_cache_hash_value(md5, mesh->curve_offset);
+		}
+
+		if(params.top_level && mesh->need_build_bvh()) {
+			/* Instance, only its bounds and the packed mesh BVH matter. */
+			if(!mesh->bvh || mesh->bvh->cache_key.empty())
+				return "";
+
+			map<Mesh*, int>::iterator it = mesh_map.find(mesh);
+			int first_object = (it == mesh_map.end())? (int)i: it->second;
+			mesh_map[mesh] = first_object;
+
+			bvh_cache_hash_value(md5, first_object);
+			bvh_cache_hash_bounds(md5, ob->bounds);
+			md5.append((const uint8_t*)mesh->bvh->cache_key.c_str(),
+			           mesh->bvh->cache_key.size());
+		}
+		else {
+			bvh_cache_hash_mesh(md5, mesh);
+		}
+	}
+
+	return md5.get_hex();
+}
+
+/* File Reading and Writing */
+
+struct BVHCacheFile {
+	FILE *f;
+	MD5Hash md5;
+	bool ok;
+
+	explicit BVHCacheFile(FILE *f_)
+	: f(f_), ok(f_ != NULL)
+	{
+	}
+
+	~BVHCacheFile()
+	{
+		if(f)
+			fclose(f);
+	}
+
+	void write(const void *data, size_t size)
+	{
+		if(ok && size) {
+			ok = (fwrite(data, 1, size, f) == size);
+			bvh_cache_hash_data(md5, data, size);
+		}
+	}
+
+	void read(void *data, size_t size)
+	{
+		if(ok && size) {
+			ok = (fread(data, 1, size, f) == size);
+			if(ok)
+				bvh_cache_hash_data(md5, data, size);
+		}
+	}
+
+	template<typename T>
+	void write_array(const array<T>& data)
+	{
+		uint64_t size = data.size();
+		write(&size, sizeof(size));
+		write(data.data(), data.size()*sizeof(T));
+	}
+
+	template<typename T>
+	void read_array(array<T>& data, size_t file_size)
+	{
+		uint64_t size = 0;
+		read(&size, sizeof(size));
+
+		/* Don't trust sizes from a damaged file for allocation. */
+		if(!ok || size > file_size/sizeof(T)) {
+			ok = false;
+			return;
+		}
+
+		data.resize(size);
+		read(data.data(), size*sizeof(T));
+	}
+};
+
+static string bvh_cache_filepath(const string& key)
+{
+	return path_user_get(path_join("cache", BVH_CACHE_PREFIX + key));
+}
+
+bool BVH::cache_read(const string& key)
+{
+	string filepath = bvh_cache_filepath(key);
+
+	if(!path_exists(filepath))
+		return false;
+
+	size_t file_size = path_file_size(filepath);
+	BVHCacheFile file(path_fopen(filepath, "rb"));
+
+	char magic[sizeof(bvh_cache_magic)];
+	int version = 0;
+	char file_key[32];
+
+	file.read(magic, sizeof(magic));
+	file.read(&version, sizeof(version));
+	file.read(file_key, sizeof(file_key));
+
+	if(!file.ok ||
+	   memcmp(magic, bvh_cache_magic, sizeof(magic)) != 0 ||
+	   version != BVH_CACHE_VERSION ||
+	   key.size() != sizeof(file_key) ||
+	   memcmp(file_key, key.c_str(), sizeof(file_key)) != 0)
+	{
+		VLOG(1) << "Ignoring incompatible BVH cache file " << filepath << ".";
+		return false;
+	}
+
+	PackedBVH cached;
+
+	file.read_array(cached.nodes, file_size);
+	file.read_array(cached.leaf_nodes, file_size);
+	file.read_array(cached.object_node, file_size);
+	file.read_array(cached.prim_tri_index, file_size);
+	file.read_array(cached.prim_tri_verts, file_size);
+	file.read_array(cached.prim_type, file_size);
+	file.read_array(cached.prim_visibility, file_size);
+	file.read_array(cached.prim_index, file_size);
+	file.read_array(cached.prim_object, file_size);
+	file.read(&cached.root_index, sizeof(cached.root_index));
+
+	/* Checksum of everything before it. */
+	string checksum = file.md5.get_hex();
+	char file_checksum[32];
+	if(file.ok)
+		file.ok = (fread(file_checksum, 1, sizeof(file_checksum), file.f) == sizeof(file_checksum));
+
+	size_t num_prims = cached.prim_index.size();
+	size_t num_nodes = (cached.root_index == -1)? cached.leaf_nodes.size(): cached.nodes.size();
+
+	if(!file.ok ||
+	   checksum.size() != sizeof(file_checksum) ||
+	   memcmp(checksum.c_str(), file_checksum, sizeof(file_checksum)) != 0 ||
+	   cached.prim_type.size() != num_prims ||
+	   cached.prim_visibility.size() != num_prims ||
+	   cached.prim_object.size() != num_prims ||
+	   cached.prim_tri_index.size() != num_prims ||
+	   (params.top_level && cached.object_node.size() != objects.size()) ||
+	   num_nodes == 0)
+	{
+		VLOG(1) << "Ignoring damaged BVH cache file " << filepath << ".";
+		return false;
+	}
+
+	pack.nodes.steal_data(cached.nodes);
+	pack.leaf_nodes.steal_data(cached.leaf_nodes);
+	pack.object_node.steal_data(cached.object_node);
+	pack.prim_tri_index.steal_data(cached.prim_tri_index);
+	pack.prim_tri_verts.steal_data(cached.prim_tri_verts);
+	pack.prim_type.steal_data(cached.prim_type);
+	pack.prim_visibility.steal_data(cached.prim_visibility);
+	pack.prim_index.steal_data(cached.prim_index);
+	pack.prim_object.steal_data(cached.prim_object);
+	pack.root_index = cached.root_index;
+
+	/* Keep recently used files from being trimmed first. */
+	path_touch(filepath);
+
+	VLOG(1) << "Read BVH from cache file " << filepath << ".";
+
+	return true;
+}
+
+void BVH::cache_write(const string& key)
+{
+	string filepath = bvh_cache_filepath(key);
+	string tmp_filepath = filepath + string_printf(".%p.%x.tmp",
+	                                               (void*)this,
+	                                               (uint)(time_dt()*1e6));
+
+	path_create_directories(tmp_filepath);
+
+	{
+		BVHCacheFile file(path_fopen(tmp_filepath, "wb"));
+
+		int version = BVH_CACHE_VERSION;
+
+		file.write(bvh_cache_magic, sizeof(bvh_cache_magic));
+		file.write(&version, sizeof(version));
+		file.write(key.c_str(), key.size());
+
+		file.write_array(pack.nodes);
+		file.write_array(pack.leaf_nodes);
+		file.write_array(pack.object_node);
+		file.write_array(pack.prim_tri_index);
+		file.write_array(pack.prim_tri_verts);
+		file.write_array(pack.prim_type);
+		file.write_array(pack.prim_visibility);
+		file.write_array(pack.prim_index);
+		file.write_array(pack.prim_object);
+		file.write(&pack.root_index, sizeof(pack.root_index));
+
+		string checksum = file.md5.get_hex();
+		if(file.ok)
+			file.ok = (fwrite(checksum.c_str(), 1, checksum.size(), file.f) == checksum.size());
+
+		if(file.f) {
+			file.ok = (fclose(file.f) == 0) && file.ok;
+			file.f = NULL;
+		}
+
+		if(!file.ok) {
+			VLOG(1) << "Failed to write BVH cache file " << tmp_filepath << ".";
+			path_remove(tmp_filepath);
+			return;
+		}
+	}
+
+	if(!path_rename(tmp_filepath, filepath)) {
+		VLOG(1) << "Failed to move BVH cache file into place " << filepath << ".";
+		path_remove(tmp_filepath);
+		return;
+	}
+
+	VLOG(1) << "Wrote BVH to cache file " << filepath << ".";
+
+	/* Evict oldest files beyond the size limit. */
+	if(params.cache_size > 0) {
+		static thread_mutex trim_mutex;
+		thread_scoped_lock trim_lock(trim_mutex);
+		path_cache_trim(BVH_CACHE_PREFIX, (size_t)params.cache_size * 1024 * 1024);
+	}
+}
+
+CCL_NAMESPACE_END
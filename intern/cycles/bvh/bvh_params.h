@@ -59,6 +59,11 @@ public:
 	 */
 	bool use_unaligned_nodes;
 
+	/* Read and write packed BVHs from the disk cache, evicting the oldest
+	 * files when it grows beyond cache_size megabytes (0 for no limit). */
+	bool use_cache;
+	int cache_size;
+
 	/* fixed parameters */
 	enum {
 		MAX_DEPTH = 64,
@@ -86,6 +91,9 @@ public:
 		use_qbvh = false;
 		use_unaligned_nodes = false;
 
+		use_cache = false;
+		cache_size = 0;
+
 		primitive_mask = PRIMITIVE_ALL;
 	}
 
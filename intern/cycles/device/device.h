@@ -249,6 +249,9 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* texture cache for images streamed from disk, only for CPU device */
+	virtual void *texture_cache_memory() { return NULL; }
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(
 	        const DeviceRequestedFeatures& /*requested_features*/)
@@ -267,7 +270,7 @@ public:
 
 #ifdef WITH_NETWORK
 	/* networking */
-	void server_run();
+	void server_run(int port, size_t cache_size);
 #endif
 
 	/* multi device */
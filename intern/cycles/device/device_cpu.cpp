@@ -35,6 +35,8 @@
 #include "osl_shader.h"
 #include "osl_globals.h"
 
+#include "kernels/cpu/kernel_texture_cache.h"
+
 #include "buffers.h"
 
 #include "util_debug.h"
@@ -57,6 +59,8 @@ public:
 #ifdef WITH_OSL
 	OSLGlobals osl_globals;
 #endif
+
+	TextureCacheGlobals texture_cache_globals;
 	
 	CPUDevice(DeviceInfo& info, Stats &stats, bool background)
 	: Device(info, stats, background)
@@ -110,13 +114,17 @@ public:
 	~CPUDevice()
 	{
 		task_pool.stop();
+
+		if(texture_cache_globals.ts) {
+			OIIO::TextureSystem::destroy(texture_cache_globals.ts);
+		}
 	}
 
 	void mem_alloc(device_memory& mem, MemoryType /*type*/)
 	{
 		mem.device_pointer = mem.data_pointer;
 		mem.device_size = mem.memory_size();
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.mem_category);
 	}
 
 	void mem_copy_to(device_memory& /*mem*/)
@@ -140,7 +148,7 @@ public:
 	{
 		if(mem.device_pointer) {
 			mem.device_pointer = 0;
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.mem_category);
 			mem.device_size = 0;
 		}
 	}
@@ -168,14 +176,14 @@ public:
 		                extension);
 		mem.device_pointer = mem.data_pointer;
 		mem.device_size = mem.memory_size();
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.mem_category);
 	}
 
 	void tex_free(device_memory& mem)
 	{
 		if(mem.device_pointer) {
 			mem.device_pointer = 0;
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.mem_category);
 			mem.device_size = 0;
 		}
 	}
@@ -189,6 +197,11 @@ public:
 #endif
 	}
 
+	void *texture_cache_memory()
+	{
+		return &texture_cache_globals;
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::PATH_TRACE)
@@ -208,6 +221,101 @@ public:
 		}
 	};
 
+	/* Adaptive sampling: estimate the noise of every pixel which is still
+	 * being sampled from the combined and auxiliary pass, and mark it as
+	 * converged when it and its direct neighbours are below the threshold.
+	 * All pixels which are not converged have num_samples samples. */
+	void adaptive_sampling_converge(KernelGlobals *kg,
+	                                RenderTile& tile,
+	                                int num_samples,
+	                                float threshold,
+	                                vector<uchar>& converged,
+	                                vector<float>& error)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		const int pass_stride = kg->__data.film.pass_stride;
+		const int pass_combined = kg->__data.film.pass_combined;
+		const int pass_aux = kg->__data.film.pass_adaptive_aux;
+		const float inv_samples = 1.0f/num_samples;
+
+		for(int y = 0; y < tile.h; y++) {
+			for(int x = 0; x < tile.w; x++) {
+				int i = x + y*tile.w;
+
+				if(converged[i]) {
+					error[i] = 0.0f;
+					continue;
+				}
+
+				int index = tile.offset + tile.x + x + (tile.y + y)*tile.stride;
+				float *buffer = render_buffer + index*pass_stride;
+
+				float mean = (buffer[pass_combined] +
+				              buffer[pass_combined + 1] +
+				              buffer[pass_combined + 2]) * (1.0f/3.0f) * inv_samples;
+				float variance = max(buffer[pass_aux]*inv_samples - mean*mean, 0.0f);
+
+				/* Standard error of the mean, relative to the square root of
+				 * the mean so dark regions don't take excessive samples. */
+				error[i] = sqrtf(variance*inv_samples) / (sqrtf(fabsf(mean)) + 1e-4f);
+			}
+		}
+
+		for(int y = 0; y < tile.h; y++) {
+			for(int x = 0; x < tile.w; x++) {
+				int i = x + y*tile.w;
+
+				if(converged[i] || error[i] >= threshold)
+					continue;
+				if(x > 0 && error[i - 1] >= threshold)
+					continue;
+				if(x < tile.w - 1 && error[i + 1] >= threshold)
+					continue;
+				if(y > 0 && error[i - tile.w] >= threshold)
+					continue;
+				if(y < tile.h - 1 && error[i + tile.w] >= threshold)
+					continue;
+
+				converged[i] = 1;
+			}
+		}
+	}
+
+	/* Scale filtered passes of converged pixels from num_samples-1 to
+	 * num_samples samples, so they stay correctly normalized by the sample
+	 * count of the tile. The auxiliary pass is left as is. */
+	void adaptive_sampling_fill(KernelGlobals *kg,
+	                            RenderTile& tile,
+	                            int num_samples,
+	                            const vector<uchar>& converged)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		const array<Pass>& passes = tile.buffers->params.passes;
+		const int pass_stride = kg->__data.film.pass_stride;
+		const float scale = (float)num_samples / (float)(num_samples - 1);
+
+		for(int y = 0; y < tile.h; y++) {
+			for(int x = 0; x < tile.w; x++) {
+				if(!converged[x + y*tile.w])
+					continue;
+
+				int index = tile.offset + tile.x + x + (tile.y + y)*tile.stride;
+				float *buffer = render_buffer + index*pass_stride;
+
+				for(size_t j = 0; j < passes.size(); j++) {
+					const Pass& pass = passes[j];
+
+					if(pass.filter && pass.type != PASS_ADAPTIVE_AUX) {
+						for(int c = 0; c < pass.components; c++)
+							buffer[c] *= scale;
+					}
+
+					buffer += pass.components;
+				}
+			}
+		}
+	}
+
 	void thread_path_trace(DeviceTask& task)
 	{
 		if(task_pool.canceled()) {
@@ -219,63 +327,130 @@ public:
 		RenderTile tile;
 
 		void(*path_trace_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int);
+		void(*path_trace_packet_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int, int);
 
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
 		if(system_cpu_support_avx2()) {
 			path_trace_kernel = kernel_cpu_avx2_path_trace;
+			path_trace_packet_kernel = kernel_cpu_avx2_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
 		if(system_cpu_support_avx()) {
 			path_trace_kernel = kernel_cpu_avx_path_trace;
+			path_trace_packet_kernel = kernel_cpu_avx_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
 		if(system_cpu_support_sse41()) {
 			path_trace_kernel = kernel_cpu_sse41_path_trace;
+			path_trace_packet_kernel = kernel_cpu_sse41_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
 		if(system_cpu_support_sse3()) {
 			path_trace_kernel = kernel_cpu_sse3_path_trace;
+			path_trace_packet_kernel = kernel_cpu_sse3_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
 		if(system_cpu_support_sse2()) {
 			path_trace_kernel = kernel_cpu_sse2_path_trace;
+			path_trace_packet_kernel = kernel_cpu_sse2_path_trace_packet;
 		}
 		else
 #endif
 		{
 			path_trace_kernel = kernel_cpu_path_trace;
+			path_trace_packet_kernel = kernel_cpu_path_trace_packet;
 		}
-		
+
+		/* Camera rays of a tile row are traced as packets, which only pays
+		 * off when the kernel can use packet traversal for the scene. */
+		const bool use_packets = DebugFlags().cpu.packets &&
+		                         kernel_bvh_use_packets(&kg.__data.bvh);
+
+		/* Adaptive sampling needs the auxiliary pass for noise estimation. */
+		const bool use_adaptive = task.adaptive_threshold > 0.0f &&
+		                          (kg.__data.film.pass_flag & PASS_ADAPTIVE_AUX);
+		vector<uchar> converged;
+		vector<float> error;
+
 		while(task.acquire_tile(this, tile)) {
 			float *render_buffer = (float*)tile.buffer;
 			uint *rng_state = (uint*)tile.rng_state;
 			int start_sample = tile.start_sample;
 			int end_sample = tile.start_sample + tile.num_samples;
 
+			if(use_adaptive) {
+				converged.clear();
+				converged.resize(tile.w*tile.h, 0);
+				error.resize(tile.w*tile.h);
+			}
+
 			for(int sample = start_sample; sample < end_sample; sample++) {
 				if(task.get_cancel() || task_pool.canceled()) {
 					if(task.need_finish_queue == false)
 						break;
 				}
 
+				int pixel_samples = 0;
+
 				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					const uchar *row_converged = (use_adaptive)? &converged[(y - tile.y)*tile.w]: NULL;
+
+					if(use_packets) {
+						/* Trace spans of pixels which are still being sampled. */
+						for(int x = tile.x; x < tile.x + tile.w;) {
+							if(row_converged && row_converged[x - tile.x]) {
+								x++;
+								continue;
+							}
+
+							int span_end = x + 1;
+							while(span_end < tile.x + tile.w &&
+							      !(row_converged && row_converged[span_end - tile.x]))
+							{
+								span_end++;
+							}
+
+							path_trace_packet_kernel(&kg, render_buffer, rng_state,
+							                         sample, x, y, span_end - x,
+							                         tile.offset, tile.stride);
+							pixel_samples += span_end - x;
+							x = span_end;
+						}
+						continue;
+					}
+
 					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						if(row_converged && row_converged[x - tile.x])
+							continue;
+
 						path_trace_kernel(&kg, render_buffer, rng_state,
 						                  sample, x, y, tile.offset, tile.stride);
+						pixel_samples++;
 					}
 				}
 
+				if(use_adaptive) {
+					int num_samples = sample + 1 - start_sample;
+
+					if(num_samples > 1)
+						adaptive_sampling_fill(&kg, tile, num_samples, converged);
+					if(num_samples >= task.adaptive_min_samples)
+						adaptive_sampling_converge(&kg, tile, num_samples,
+						                           task.adaptive_threshold,
+						                           converged, error);
+				}
+
 				tile.sample = sample + 1;
 
-				task.update_progress(&tile);
+				task.update_progress(&tile, pixel_samples);
 			}
 
 			task.release_tile(tile);
@@ -381,6 +556,7 @@ public:
 	void thread_shader(DeviceTask& task)
 	{
 		KernelGlobals kg = kernel_globals;
+		kg.texture_cache = thread_texture_cache();
 
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
@@ -478,6 +654,12 @@ public:
 	}
 
 protected:
+	/* Only pay for the cache lookup when some image uses it. */
+	inline TextureCacheGlobals *thread_texture_cache()
+	{
+		return (texture_cache_globals.ts != NULL)? &texture_cache_globals: NULL;
+	}
+
 	inline KernelGlobals thread_kernel_globals_init()
 	{
 		KernelGlobals kg = kernel_globals;
@@ -488,6 +670,7 @@ protected:
 			kg.decoupled_volume_steps[i] = NULL;
 		}
 		kg.decoupled_volume_steps_index = 0;
+		kg.texture_cache = thread_texture_cache();
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
@@ -464,7 +464,7 @@ public:
 		cuda_assert(cuMemAlloc(&device_pointer, size));
 		mem.device_pointer = (device_ptr)device_pointer;
 		mem.device_size = size;
-		stats.mem_alloc(size);
+		stats.mem_alloc(size, mem.mem_category);
 		cuda_pop_context();
 	}
 
@@ -511,7 +511,7 @@ public:
 
 			mem.device_pointer = 0;
 
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.mem_category);
 			mem.device_size = 0;
 		}
 	}
@@ -712,7 +712,7 @@ public:
 			mem.device_pointer = (device_ptr)handle;
 			mem.device_size = size;
 
-			stats.mem_alloc(size);
+			stats.mem_alloc(size, mem.mem_category);
 
 			/* Bindless Textures - Kepler */
 			if(has_bindless_textures) {
@@ -806,7 +806,7 @@ public:
 				tex_interp_map.erase(tex_interp_map.find(mem.device_pointer));
 				mem.device_pointer = 0;
 
-				stats.mem_free(mem.device_size);
+				stats.mem_free(mem.device_size, mem.mem_category);
 				mem.device_size = 0;
 			}
 			else {
@@ -1067,7 +1067,7 @@ public:
 				pixel_mem_map[mem.device_pointer] = pmem;
 
 				mem.device_size = mem.memory_size();
-				stats.mem_alloc(mem.device_size);
+				stats.mem_alloc(mem.device_size, mem.mem_category);
 
 				return;
 			}
@@ -1124,7 +1124,7 @@ public:
 				pixel_mem_map.erase(pixel_mem_map.find(mem.device_pointer));
 				mem.device_pointer = 0;
 
-				stats.mem_free(mem.device_size);
+				stats.mem_free(mem.device_size, mem.mem_category);
 				mem.device_size = 0;
 
 				return;
@@ -180,6 +180,9 @@ public:
 	/* device pointer */
 	device_ptr device_pointer;
 
+	/* category for memory accounting */
+	MemoryCategory mem_category;
+
 protected:
 	device_memory() {}
 	virtual ~device_memory() { assert(!device_pointer); }
@@ -208,6 +211,7 @@ public:
 		assert(data_elements > 0);
 
 		device_pointer = 0;
+		mem_category = MEM_CATEGORY_OTHER;
 	}
 
 	virtual ~device_vector() {}
@@ -273,6 +277,14 @@ public:
 		return data.size();
 	}
 
+	/* account host and device memory to category */
+	void set_mem_category(MemoryCategory category)
+	{
+		assert(!device_pointer);
+		mem_category = category;
+		data.set_mem_category(category);
+	}
+
 	T* get_data()
 	{
 		return &data[0];
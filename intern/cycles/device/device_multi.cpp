@@ -107,7 +107,7 @@ public:
 		}
 
 		mem.device_pointer = unique_ptr++;
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.mem_category);
 	}
 
 	void mem_copy_to(device_memory& mem)
@@ -162,7 +162,7 @@ public:
 		}
 
 		mem.device_pointer = 0;
-		stats.mem_free(mem.device_size);
+		stats.mem_free(mem.device_size, mem.mem_category);
 	}
 
 	void const_copy_to(const char *name, void *host, size_t size)
@@ -188,7 +188,7 @@ public:
 		}
 
 		mem.device_pointer = unique_ptr++;
-		stats.mem_alloc(mem.device_size);
+		stats.mem_alloc(mem.device_size, mem.mem_category);
 	}
 
 	void tex_free(device_memory& mem)
@@ -202,7 +202,7 @@ public:
 		}
 
 		mem.device_pointer = 0;
-		stats.mem_free(mem.device_size);
+		stats.mem_free(mem.device_size, mem.mem_category);
 	}
 
 	void pixels_alloc(device_memory& mem)
@@ -331,8 +331,27 @@ public:
 
 	void task_wait()
 	{
+#ifdef WITH_NETWORK
+		/* network devices serve tile requests of their server from within
+		 * task_wait, wait for them concurrently so no server sits idle until
+		 * the devices before it are done */
+		vector<thread*> network_threads;
+
+		foreach(SubDevice& sub, devices)
+			if(sub.device->info.type == DEVICE_NETWORK)
+				network_threads.push_back(new thread(function_bind(&Device::task_wait, sub.device)));
+#endif
+
 		foreach(SubDevice& sub, devices)
-			sub.device->task_wait();
+			if(sub.device->info.type != DEVICE_NETWORK)
+				sub.device->task_wait();
+
+#ifdef WITH_NETWORK
+		foreach(thread *network_thread, network_threads) {
+			network_thread->join();
+			delete network_thread;
+		}
+#endif
 	}
 
 	void task_cancel()
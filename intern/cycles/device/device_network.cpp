@@ -26,7 +26,6 @@
 CCL_NAMESPACE_BEGIN
 
 typedef map<device_ptr, device_ptr> PtrMap;
-typedef vector<uint8_t> DataVector;
 typedef map<device_ptr, DataVector> DataMap;
 
 /* tile list */
@@ -41,6 +40,26 @@ static TileList::iterator tile_list_find(TileList& tile_list, RenderTile& tile)
 	return tile_list.end();
 }
 
+/* content hash of a buffer, empty for buffers too small to be cached */
+static string data_hash(const void *data, size_t size)
+{
+	if(size < CACHE_MIN_SIZE)
+		return "";
+
+	MD5Hash md5;
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	/* MD5Hash takes int sizes, feed large buffers in pieces */
+	while(size > 0) {
+		int chunk = (size > (1 << 30))? (1 << 30): (int)size;
+		md5.append(bytes, chunk);
+		bytes += chunk;
+		size -= chunk;
+	}
+
+	return md5.get_hex();
+}
+
 class NetworkDevice : public Device
 {
 public:
@@ -51,15 +70,26 @@ public:
 
 	thread_mutex rpc_lock;
 
-	NetworkDevice(DeviceInfo& info, Stats &stats, const char *address)
-	: Device(info, stats, true), socket(io_service)
+	/* content hashes of buffers the server holds in its data cache, and the
+	 * space it has left for new ones */
+	set<string> server_cache;
+	bool server_cache_enabled;
+	size_t server_cache_free;
+
+	/* tile buffers whose contents the server pushed along with release_tile */
+	set<device_ptr> pushed_buffers;
+
+	NetworkDevice(DeviceInfo& info, Stats &stats, const char *address_port)
+	: Device(info, stats, true), socket(io_service), server_cache_enabled(false), server_cache_free(0)
 	{
 		error_func = NetworkError();
-		stringstream portstr;
-		portstr << SERVER_PORT;
+		this->info.type = DEVICE_NETWORK;
+
+		string address, port;
+		network_address_split(address_port, address, port);
 
 		tcp::resolver resolver(io_service);
-		tcp::resolver::query query(address, portstr.str());
+		tcp::resolver::query query(address, port);
 		tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
 		tcp::resolver::iterator end;
 
@@ -74,6 +104,61 @@ public:
 			error_func.network_error(error.message());
 
 		mem_counter = 0;
+
+		if(!error_func.have_error())
+			receive_hello();
+	}
+
+	/* the server greets with its protocol version and the contents of its
+	 * data cache */
+	void receive_hello()
+	{
+		RPCReceive rcv(socket, &error_func);
+
+		if(rcv.name != "hello") {
+			error_func.network_error("Network error: unexpected server greeting");
+			return;
+		}
+
+		int version;
+		std::vector<string> hashes;
+
+		rcv.read(version);
+
+		if(version != PROTOCOL_VERSION) {
+			error_func.network_error("Network error: server protocol version mismatch");
+			return;
+		}
+
+		rcv.read(server_cache_enabled);
+		rcv.read(server_cache_free);
+		rcv.read(hashes);
+
+		server_cache.insert(hashes.begin(), hashes.end());
+
+		VLOG(1) << "Network server caches " << hashes.size() << " buffers.";
+	}
+
+	/* Send buffer contents after the RPC header, or only a reference to it
+	 * when the server has it cached already. Must be paired with a call to
+	 * DeviceServer::receive_data. */
+	void send_data(RPCSend& snd, const void *data, size_t size, const string& hash)
+	{
+		bool cached = (server_cache.find(hash) != server_cache.end());
+
+		snd.add(hash);
+		snd.add(cached);
+		snd.write();
+
+		if(!cached) {
+			snd.write_buffer_compressed(data, size);
+
+			/* same rule as NetworkDataCache::insert */
+			if(server_cache_enabled && hash != "" && size <= server_cache_free) {
+				server_cache.insert(hash);
+				server_cache_free -= size;
+			}
+		}
 	}
 
 	~NetworkDevice()
@@ -97,19 +182,29 @@ public:
 
 	void mem_copy_to(device_memory& mem)
 	{
+		string hash = (server_cache_enabled)? data_hash((void*)mem.data_pointer, mem.memory_size()): "";
+
 		thread_scoped_lock lock(rpc_lock);
 
+		pushed_buffers.erase(mem.device_pointer);
+
 		RPCSend snd(socket, &error_func, "mem_copy_to");
 
 		snd.add(mem);
-		snd.write();
-		snd.write_buffer((void*)mem.data_pointer, mem.memory_size());
+		send_data(snd, (void*)mem.data_pointer, mem.memory_size(), hash);
 	}
 
 	void mem_copy_from(device_memory& mem, int y, int w, int h, int elem)
 	{
 		thread_scoped_lock lock(rpc_lock);
 
+		/* buffer contents already arrived with the tile */
+		set<device_ptr>::iterator it = pushed_buffers.find(mem.device_pointer);
+		if(it != pushed_buffers.end()) {
+			pushed_buffers.erase(it);
+			return;
+		}
+
 		size_t data_size = mem.memory_size();
 
 		RPCSend snd(socket, &error_func, "mem_copy_from");
@@ -122,13 +217,15 @@ public:
 		snd.write();
 
 		RPCReceive rcv(socket, &error_func);
-		rcv.read_buffer((void*)mem.data_pointer, data_size);
+		rcv.read_buffer_compressed((void*)mem.data_pointer, data_size);
 	}
 
 	void mem_zero(device_memory& mem)
 	{
 		thread_scoped_lock lock(rpc_lock);
 
+		pushed_buffers.erase(mem.device_pointer);
+
 		RPCSend snd(socket, &error_func, "mem_zero");
 
 		snd.add(mem);
@@ -140,6 +237,8 @@ public:
 		if(mem.device_pointer) {
 			thread_scoped_lock lock(rpc_lock);
 
+			pushed_buffers.erase(mem.device_pointer);
+
 			RPCSend snd(socket, &error_func, "mem_free");
 
 			snd.add(mem);
@@ -160,7 +259,7 @@ public:
 		snd.add(name_string);
 		snd.add(size);
 		snd.write();
-		snd.write_buffer(host, size);
+		snd.write_buffer_compressed(host, size);
 	}
 
 	void tex_alloc(const char *name,
@@ -172,6 +271,8 @@ public:
 		        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 		        << string_human_readable_size(mem.memory_size()) << ")";
 
+		string hash = (server_cache_enabled)? data_hash((void*)mem.data_pointer, mem.memory_size()): "";
+
 		thread_scoped_lock lock(rpc_lock);
 
 		mem.device_pointer = ++mem_counter;
@@ -184,8 +285,7 @@ public:
 		snd.add(mem);
 		snd.add(interpolation);
 		snd.add(extension);
-		snd.write();
-		snd.write_buffer((void*)mem.data_pointer, mem.memory_size());
+		send_data(snd, (void*)mem.data_pointer, mem.memory_size(), hash);
 	}
 
 	void tex_free(device_memory& mem)
@@ -229,6 +329,9 @@ public:
 
 		the_task = task;
 
+		/* pushed contents are only valid until the device renders again */
+		pushed_buffers.clear();
+
 		RPCSend snd(socket, &error_func, "task_add");
 		snd.add(task);
 		snd.write();
@@ -276,8 +379,10 @@ public:
 				}
 			}
 			else if(rcv.name == "release_tile") {
+				bool pushed;
+
 				rcv.read(tile);
-				lock.unlock();
+				rcv.read(pushed);
 
 				TileList::iterator it = tile_list_find(the_tiles, tile);
 				if(it != the_tiles.end()) {
@@ -287,12 +392,20 @@ public:
 
 				assert(tile.buffers != NULL);
 
-				the_task.release_tile(tile);
+				/* the server sends the tile buffer contents along, so copying
+				 * them from the device needs no extra round trip */
+				if(pushed) {
+					device_vector<float>& buffer = tile.buffers->buffer;
+
+					rcv.read_buffer_compressed((void*)buffer.data_pointer, buffer.memory_size());
+					pushed_buffers.insert(buffer.device_pointer);
+				}
 
-				lock.lock();
-				RPCSend snd(socket, &error_func, "release_tile");
-				snd.write();
 				lock.unlock();
+
+				/* release is not acknowledged, the server continues rendering
+				 * while the tile is written */
+				the_task.release_tile(tile);
 			}
 			else if(rcv.name == "task_wait_done") {
 				lock.unlock();
@@ -301,6 +414,11 @@ public:
 			else
 				lock.unlock();
 		}
+
+		/* tiles the server requested ahead but never rendered, for example
+		 * after cancelling, still have to be released to free their buffers */
+		foreach(RenderTile& tile, the_tiles)
+			the_task.release_tile(tile);
 	}
 
 	void task_cancel()
@@ -348,14 +466,17 @@ public:
 
 	bool have_error() { return error_func.have_error(); }
 
-	DeviceServer(Device *device_, tcp::socket& socket_)
-	: device(device_), socket(socket_), stop(false), blocked_waiting(false)
+	DeviceServer(Device *device_, tcp::socket& socket_, NetworkDataCache *cache_)
+	: device(device_), socket(socket_), cache(cache_), tiles_requested(0), tiles_done(false),
+	  stop(false), blocked_waiting(false)
 	{
 		error_func = NetworkError();
 	}
 
 	void listen()
 	{
+		send_hello();
+
 		/* receive remote function calls */
 		for(;;) {
 			listen_step();
@@ -366,6 +487,47 @@ public:
 	}
 
 protected:
+	/* greet the client with the protocol version and the buffers it does not
+	 * need to upload again */
+	void send_hello()
+	{
+		int version = PROTOCOL_VERSION;
+		bool cache_enabled = cache->enabled();
+		std::vector<string> hashes = cache->trim();
+		size_t cache_free = cache->free_size();
+
+		thread_scoped_lock lock(rpc_lock);
+
+		RPCSend snd(socket, &error_func, "hello");
+		snd.add(version);
+		snd.add(cache_enabled);
+		snd.add(cache_free);
+		snd.add(hashes);
+		snd.write();
+	}
+
+	/* Counterpart of NetworkDevice::send_data, fills the buffer either from
+	 * the network or from the data cache. */
+	void receive_data(RPCReceive& rcv, uint8_t *data, size_t size)
+	{
+		string hash;
+		bool cached;
+
+		rcv.read(hash);
+		rcv.read(cached);
+
+		if(cached) {
+			if(!cache->find(hash, data, size))
+				network_error("Network error: buffer missing from data cache");
+		}
+		else {
+			rcv.read_buffer_compressed(data, size);
+
+			if(cache->enabled() && hash != "")
+				cache->insert(hash, data, size);
+		}
+	}
+
 	void listen_step()
 	{
 		thread_scoped_lock lock(rpc_lock);
@@ -485,7 +647,6 @@ protected:
 			network_device_memory mem;
 
 			rcv.read(mem);
-			lock.unlock();
 
 			device_ptr client_pointer = mem.device_pointer;
 
@@ -494,10 +655,11 @@ protected:
 			size_t data_size = mem.memory_size();
 
 			/* get pointer to memory buffer	for device buffer */
-			mem.data_pointer = (device_ptr)&data_v[0];
+			mem.data_pointer = (data_size)? (device_ptr)&data_v[0]: 0;
 
-			/* copy data from network into memory buffer */
-			rcv.read_buffer((uint8_t*)mem.data_pointer, data_size);
+			/* copy data from network or cache into memory buffer */
+			receive_data(rcv, (uint8_t*)mem.data_pointer, data_size);
+			lock.unlock();
 
 			/* translate the client pointer to a real device pointer */
 			mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
@@ -528,7 +690,7 @@ protected:
 
 			RPCSend snd(socket, &error_func, "mem_copy_from");
 			snd.write();
-			snd.write_buffer((uint8_t*)mem.data_pointer, data_size);
+			snd.write_buffer_compressed((uint8_t*)mem.data_pointer, data_size);
 			lock.unlock();
 		}
 		else if(rcv.name == "mem_zero") {
@@ -567,7 +729,7 @@ protected:
 			rcv.read(size);
 
 			vector<char> host_vector(size);
-			rcv.read_buffer(&host_vector[0], size);
+			rcv.read_buffer_compressed(&host_vector[0], size);
 			lock.unlock();
 
 			device->const_copy_to(name_string.c_str(), &host_vector[0], size);
@@ -583,7 +745,6 @@ protected:
 			rcv.read(mem);
 			rcv.read(interpolation);
 			rcv.read(extension_type);
-			lock.unlock();
 
 			client_pointer = mem.device_pointer;
 
@@ -596,7 +757,8 @@ protected:
 			else
 				mem.data_pointer = 0;
 
-			rcv.read_buffer((uint8_t*)mem.data_pointer, data_size);
+			receive_data(rcv, (uint8_t*)mem.data_pointer, data_size);
+			lock.unlock();
 
 			device->tex_alloc(name.c_str(), mem, interpolation, extension_type);
 
@@ -633,6 +795,13 @@ protected:
 			DeviceTask task;
 
 			rcv.read(task);
+
+			/* forget tiles left over from a cancelled previous task */
+			acquire_queue.clear();
+			tile_queue.clear();
+			tiles_requested = 0;
+			tiles_done = false;
+
 			lock.unlock();
 
 			if(task.buffer)
@@ -691,57 +860,65 @@ protected:
 			acquire_queue.push_back(entry);
 			lock.unlock();
 		}
-		else if(rcv.name == "release_tile") {
-			AcquireEntry entry;
-			entry.name = rcv.name;
-			acquire_queue.push_back(entry);
-			lock.unlock();
-		}
 		else {
 			cout << "Error: unexpected RPC receive call \"" + rcv.name + "\"\n";
 			lock.unlock();
 		}
 	}
 
+	/* request tiles from the client ahead of the render threads, so a few
+	 * tiles are always in flight. The acquire mutex must be locked. */
+	void request_tiles()
+	{
+		while(!tiles_done && tiles_requested + (int)tile_queue.size() < TILE_PREFETCH_COUNT) {
+			RPCSend snd(socket, &error_func, "acquire_tile");
+			snd.write();
+
+			tiles_requested++;
+		}
+	}
+
 	bool task_acquire_tile(Device *device, RenderTile& tile)
 	{
 		thread_scoped_lock acquire_lock(acquire_mutex);
 
-		bool result = false;
+		request_tiles();
 
-		RPCSend snd(socket, &error_func, "acquire_tile");
-		snd.write();
-
-		do {
+		while(tile_queue.empty() && tiles_requested > 0 && !stop && !have_error()) {
 			if(blocked_waiting)
 				listen_step();
 
 			/* todo: avoid busy wait loop */
 			thread_scoped_lock lock(rpc_lock);
 
-			if(!acquire_queue.empty()) {
+			while(!acquire_queue.empty()) {
 				AcquireEntry entry = acquire_queue.front();
 				acquire_queue.pop_front();
 
-				if(entry.name == "acquire_tile") {
-					tile = entry.tile;
+				tiles_requested--;
 
-					if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
-					if(tile.rng_state) tile.rng_state = ptr_map[tile.rng_state];
-
-					result = true;
-					break;
-				}
-				else if(entry.name == "acquire_tile_none") {
-					break;
-				}
-				else {
+				if(entry.name == "acquire_tile")
+					tile_queue.push_back(entry.tile);
+				else if(entry.name == "acquire_tile_none")
+					tiles_done = true;
+				else
 					cout << "Error: unexpected acquire RPC receive call \"" + entry.name + "\"\n";
-				}
 			}
-		} while(acquire_queue.empty() && !stop && !have_error());
+		}
 
-		return result;
+		if(tile_queue.empty())
+			return false;
+
+		tile = tile_queue.front();
+		tile_queue.pop_front();
+
+		if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
+		if(tile.rng_state) tile.rng_state = ptr_map[tile.rng_state];
+
+		/* replace the tile taken from the queue */
+		request_tiles();
+
+		return true;
 	}
 
 	void task_update_progress_sample()
@@ -758,37 +935,41 @@ protected:
 	{
 		thread_scoped_lock acquire_lock(acquire_mutex);
 
-		if(tile.buffer) tile.buffer = ptr_imap[tile.buffer];
-		if(tile.rng_state) tile.rng_state = ptr_imap[tile.rng_state];
+		/* when the tile has a buffer of its own, send its contents along so
+		 * the client doesn't need a mem_copy_from round trip for it */
+		DataVector *data_v = NULL;
 
-		{
-			thread_scoped_lock lock(rpc_lock);
-			RPCSend snd(socket, &error_func, "release_tile");
-			snd.add(tile);
-			snd.write();
-			lock.unlock();
-		}
+		if(tile.buffer && tile.stride == tile.w && tile.offset + tile.x + tile.y*tile.stride == 0) {
+			DataMap::iterator it = mem_data.find(ptr_imap[tile.buffer]);
+			size_t num_pixels = (size_t)tile.w*tile.h;
 
-		do {
-			if(blocked_waiting)
-				listen_step();
+			if(it != mem_data.end() && it->second.size() && it->second.size() % num_pixels == 0) {
+				network_device_memory mem;
 
-			/* todo: avoid busy wait loop */
-			thread_scoped_lock lock(rpc_lock);
+				mem.device_pointer = tile.buffer;
+				mem.data_pointer = (device_ptr)&it->second[0];
 
-			if(!acquire_queue.empty()) {
-				AcquireEntry entry = acquire_queue.front();
-				acquire_queue.pop_front();
+				device->mem_copy_from(mem, 0, tile.w, tile.h, it->second.size()/num_pixels);
 
-				if(entry.name == "release_tile") {
-					lock.unlock();
-					break;
-				}
-				else {
-					cout << "Error: unexpected release RPC receive call \"" + entry.name + "\"\n";
-				}
+				data_v = &it->second;
 			}
-		} while(acquire_queue.empty() && !stop);
+		}
+
+		if(tile.buffer) tile.buffer = ptr_imap[tile.buffer];
+		if(tile.rng_state) tile.rng_state = ptr_imap[tile.rng_state];
+
+		bool pushed = (data_v != NULL);
+
+		/* no acknowledgement is waited for, rendering continues right away */
+		thread_scoped_lock lock(rpc_lock);
+
+		RPCSend snd(socket, &error_func, "release_tile");
+		snd.add(tile);
+		snd.add(pushed);
+		snd.write();
+
+		if(pushed)
+			snd.write_buffer_compressed(&(*data_v)[0], data_v->size());
 	}
 
 	bool task_get_cancel()
@@ -799,6 +980,7 @@ protected:
 	/* properties */
 	Device *device;
 	tcp::socket& socket;
+	NetworkDataCache *cache;
 
 	/* mapping of remote to local pointer */
 	PtrMap ptr_map;
@@ -813,6 +995,12 @@ protected:
 	thread_mutex acquire_mutex;
 	list<AcquireEntry> acquire_queue;
 
+	/* tiles received from the client but not handed to a render thread yet,
+	 * and the number of requests still waiting for an answer */
+	list<RenderTile> tile_queue;
+	int tiles_requested;
+	bool tiles_done;
+
 	bool stop;
 	bool blocked_waiting;
 private:
@@ -822,16 +1010,19 @@ private:
 
 };
 
-void Device::server_run()
+void Device::server_run(int port, size_t cache_size)
 {
 	try {
 		/* starts thread that responds to discovery requests */
-		ServerDiscovery discovery;
+		ServerDiscovery discovery(false, port);
+
+		/* uploaded buffers, kept across connections */
+		NetworkDataCache cache(cache_size);
 
 		for(;;) {
 			/* accept connection */
 			boost::asio::io_service io_service;
-			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
 			tcp::socket socket(io_service);
 			acceptor.accept(socket);
@@ -839,7 +1030,7 @@ void Device::server_run()
 			string remote_address = socket.remote_endpoint().address().to_string();
 			printf("Connected to remote client at: %s\n", remote_address.c_str());
 
-			DeviceServer server(this, socket);
+			DeviceServer server(this, socket, &cache);
 			server.listen();
 
 			printf("Disconnected.\n");
@@ -26,6 +26,7 @@
 #include <boost/array.hpp>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/thread.hpp>
 
@@ -33,12 +34,17 @@
 #include <sstream>
 #include <deque>
 
+#include <zlib.h>
+
 #include "buffers.h"
 
 #include "util_foreach.h"
 #include "util_list.h"
 #include "util_map.h"
+#include "util_md5.h"
+#include "util_set.h"
 #include "util_string.h"
+#include "util_thread.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -55,6 +61,22 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Bumped whenever the RPC protocol changes, client and server must match. */
+static const int PROTOCOL_VERSION = 3;
+
+/* Buffers smaller than this are sent as is, compressing them is not worth
+ * the extra latency. */
+static const size_t COMPRESS_MIN_SIZE = 4096;
+
+/* Buffers smaller than this are not stored in the server side data cache. */
+static const size_t CACHE_MIN_SIZE = 65536;
+
+/* Number of tiles the server requests ahead of its render threads, hiding
+ * the round trip latency of tile acquisition. */
+static const int TILE_PREFETCH_COUNT = 2;
+
+typedef vector<uint8_t> DataVector;
+
 #if 0
 typedef boost::archive::text_oarchive o_archive;
 typedef boost::archive::text_iarchive i_archive;
@@ -68,7 +90,7 @@ typedef boost::archive::binary_iarchive i_archive;
 class network_device_memory : public device_memory
 {
 public:
-	network_device_memory() {}
+	network_device_memory() { mem_category = MEM_CATEGORY_OTHER; }
 	~network_device_memory() { device_pointer = 0; };
 
 	vector<char> local_data;
@@ -117,7 +139,7 @@ public:
 
 	void add(const device_memory& mem)
 	{
-		archive & mem.data_type & mem.data_elements & mem.data_size;
+		archive & mem.data_type & mem.data_elements & mem.data_size & mem.mem_category;
 		archive & mem.data_width & mem.data_height & mem.data_depth & mem.device_pointer;
 	}
 
@@ -175,7 +197,7 @@ public:
 		sent = true;
 	}
 
-	void write_buffer(void *buffer, size_t size)
+	void write_buffer(const void *buffer, size_t size)
 	{
 		boost::system::error_code error;
 
@@ -187,6 +209,37 @@ public:
 			error_func->network_error(error.message());
 	}
 
+	/* Send buffer compressed with zlib, preceded by a fixed size header with
+	 * the compressed size. A size of zero means the data did not compress and
+	 * follows uncompressed. */
+	void write_buffer_compressed(const void *buffer, size_t size)
+	{
+		DataVector compressed;
+		size_t compressed_size = 0;
+
+		if(size >= COMPRESS_MIN_SIZE) {
+			uLongf dest_size = compressBound(size);
+			compressed.resize(dest_size);
+
+			if(compress2(&compressed[0], &dest_size, (const Bytef*)buffer, size, Z_BEST_SPEED) == Z_OK &&
+			   dest_size < size)
+			{
+				compressed_size = dest_size;
+			}
+		}
+
+		ostringstream header_stream;
+		header_stream << setw(16) << hex << compressed_size;
+		string header_str = header_stream.str();
+
+		write_buffer(header_str.data(), header_str.size());
+
+		if(compressed_size)
+			write_buffer(&compressed[0], compressed_size);
+		else
+			write_buffer(buffer, size);
+	}
+
 protected:
 	string name;
 	tcp::socket& socket;
@@ -260,7 +313,7 @@ public:
 
 	void read(network_device_memory& mem)
 	{
-		*archive & mem.data_type & mem.data_elements & mem.data_size;
+		*archive & mem.data_type & mem.data_elements & mem.data_size & mem.mem_category;
 		*archive & mem.data_width & mem.data_height & mem.data_depth & mem.device_pointer;
 
 		mem.data_pointer = 0;
@@ -284,6 +337,38 @@ public:
 			cout << "Network receive error: buffer size doesn't match expected size\n";
 	}
 
+	/* Receive buffer sent with RPCSend::write_buffer_compressed. */
+	void read_buffer_compressed(void *buffer, size_t size)
+	{
+		char header[16];
+		read_buffer(header, sizeof(header));
+
+		string header_str(header, sizeof(header));
+		istringstream header_stream(header_str);
+		size_t compressed_size;
+
+		if(!(header_stream >> hex >> compressed_size)) {
+			error_func->network_error("Network receive error: can't decode compressed buffer header");
+			return;
+		}
+
+		if(compressed_size == 0) {
+			read_buffer(buffer, size);
+			return;
+		}
+
+		DataVector compressed(compressed_size);
+		read_buffer(&compressed[0], compressed_size);
+
+		uLongf dest_size = size;
+
+		if(uncompress((Bytef*)buffer, &dest_size, &compressed[0], compressed_size) != Z_OK ||
+		   dest_size != size)
+		{
+			error_func->network_error("Network receive error: failed to decompress buffer");
+		}
+	}
+
 	void read(DeviceTask& task)
 	{
 		int type;
@@ -318,12 +403,138 @@ protected:
 	NetworkError *error_func;
 };
 
+/* Server side cache of uploaded buffers indexed by content hash.
+ *
+ * Kept alive across client connections, so that re-rendering a scene only
+ * transfers buffers that actually changed. The client receives the list of
+ * cached hashes on connect and assumes every buffer it uploads afterwards is
+ * cached as well, so entries are only evicted in between connections. */
+
+class NetworkDataCache {
+public:
+	explicit NetworkDataCache(size_t max_size_)
+	: max_size(max_size_), total_size(0), use_counter(0)
+	{
+	}
+
+	bool enabled()
+	{
+		return max_size > 0;
+	}
+
+	bool find(const string& hash, uint8_t *data, size_t size)
+	{
+		thread_scoped_lock lock(cache_mutex);
+
+		map<string, Entry>::iterator it = entries.find(hash);
+
+		if(it == entries.end() || it->second.data.size() != size)
+			return false;
+
+		it->second.last_used = ++use_counter;
+
+		if(size)
+			memcpy(data, &it->second.data[0], size);
+
+		return true;
+	}
+
+	/* Store a buffer unless it does not fit in the free space, entries are
+	 * never evicted here since the connected client assumes they stay. The
+	 * client applies the same rule to know what the server caches. */
+	bool insert(const string& hash, const uint8_t *data, size_t size)
+	{
+		thread_scoped_lock lock(cache_mutex);
+
+		map<string, Entry>::iterator it = entries.find(hash);
+
+		if(it != entries.end()) {
+			it->second.last_used = ++use_counter;
+			return true;
+		}
+
+		if(size > max_size - total_size)
+			return false;
+
+		Entry& entry = entries[hash];
+		entry.data = DataVector(data, data + size);
+		entry.last_used = ++use_counter;
+		total_size += size;
+
+		return true;
+	}
+
+	/* Space left for new entries. */
+	size_t free_size()
+	{
+		thread_scoped_lock lock(cache_mutex);
+		return max_size - total_size;
+	}
+
+	/* Evict least recently used entries until the cache fits in its size
+	 * limit, and return the hashes that remain. */
+	std::vector<string> trim()
+	{
+		thread_scoped_lock lock(cache_mutex);
+
+		while(total_size > max_size) {
+			map<string, Entry>::iterator oldest = entries.begin();
+
+			for(map<string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+				if(it->second.last_used < oldest->second.last_used)
+					oldest = it;
+
+			total_size -= oldest->second.data.size();
+			entries.erase(oldest);
+		}
+
+		std::vector<string> hashes;
+
+		for(map<string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+			hashes.push_back(it->first);
+
+		return hashes;
+	}
+
+protected:
+	struct Entry {
+		DataVector data;
+		uint64_t last_used;
+	};
+
+	thread_mutex cache_mutex;
+	map<string, Entry> entries;
+	size_t max_size;
+	size_t total_size;
+	uint64_t use_counter;
+};
+
+/* Split "address:port" into its parts, using the default server port when
+ * none is given. */
+
+static inline void network_address_split(const string& address_port, string& address, string& port)
+{
+	size_t pos = address_port.rfind(':');
+
+	if(pos == string::npos) {
+		stringstream portstr;
+		portstr << SERVER_PORT;
+
+		address = address_port;
+		port = portstr.str();
+	}
+	else {
+		address = address_port.substr(0, pos);
+		port = address_port.substr(pos + 1);
+	}
+}
+
 /* Server auto discovery */
 
 class ServerDiscovery {
 public:
-	explicit ServerDiscovery(bool discover = false)
-	: listen_socket(io_service), collect_servers(false)
+	explicit ServerDiscovery(bool discover = false, int server_port_ = SERVER_PORT)
+	: listen_socket(io_service), collect_servers(false), server_port(server_port_)
 	{
 		/* setup listen socket */
 		listen_endpoint.address(boost::asio::ip::address_v4::any());
@@ -384,9 +595,14 @@ private:
 
 			/* handle incoming message */
 			if(collect_servers) {
-				if(msg == DISCOVER_REPLY_MSG) {
+				/* replies carry the port of the server, so multiple servers
+				 * can run on the same host */
+				if(msg.compare(0, DISCOVER_REPLY_MSG.size(), DISCOVER_REPLY_MSG) == 0) {
 					string address = receive_endpoint.address().to_string();
 
+					if(msg.size() > DISCOVER_REPLY_MSG.size())
+						address += msg.substr(DISCOVER_REPLY_MSG.size());
+
 					mutex.lock();
 
 					/* add address if it's not already in the list */
@@ -401,8 +617,11 @@ private:
 			}
 			else {
 				/* reply to request */
-				if(msg == DISCOVER_REQUEST_MSG)
-					broadcast_message(DISCOVER_REPLY_MSG);
+				if(msg == DISCOVER_REQUEST_MSG) {
+					stringstream reply;
+					reply << DISCOVER_REPLY_MSG << ":" << server_port;
+					broadcast_message(reply.str());
+				}
 			}
 		}
 
@@ -462,6 +681,9 @@ private:
 	/* collection of server addresses in list */
 	bool collect_servers;
 	vector<string> servers;
+
+	/* port the server accepts connections on */
+	int server_port;
 };
 
 CCL_NAMESPACE_END
@@ -1118,7 +1118,7 @@ public:
 			mem.device_pointer = null_mem;
 		}
 
-		stats.mem_alloc(size);
+		stats.mem_alloc(size, mem.mem_category);
 		mem.device_size = size;
 	}
 
@@ -1169,7 +1169,7 @@ public:
 			}
 			mem.device_pointer = 0;
 
-			stats.mem_free(mem.device_size);
+			stats.mem_free(mem.device_size, mem.mem_category);
 			mem.device_size = 0;
 		}
 	}
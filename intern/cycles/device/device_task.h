@@ -56,10 +56,10 @@ public:
 	int get_subtask_count(int num, int max_size = 0);
 	void split(list<DeviceTask>& tasks, int num, int max_size = 0);
 
-	void update_progress(RenderTile *rtile);
+	void update_progress(RenderTile *rtile, int pixel_samples = -1);
 
 	function<bool(Device *device, RenderTile&)> acquire_tile;
-	function<void(void)> update_progress_sample;
+	function<void(int, int)> update_progress_sample;
 	function<void(RenderTile&)> update_tile_sample;
 	function<void(RenderTile&)> release_tile;
 	function<bool(void)> get_cancel;
@@ -67,6 +67,12 @@ public:
 	bool need_finish_queue;
 	bool integrator_branched;
 	int2 requested_tile_size;
+
+	/* Adaptive sampling, disabled when threshold is zero. Pixels whose
+	 * relative noise is below the threshold stop receiving samples once
+	 * at least adaptive_min_samples were rendered. */
+	float adaptive_threshold;
+	int adaptive_min_samples;
 protected:
 	double last_update_time;
 };
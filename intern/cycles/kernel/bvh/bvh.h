@@ -42,6 +42,9 @@ CCL_NAMESPACE_BEGIN
 #define BVH_STACK_SIZE 192
 #define BVH_QSTACK_SIZE 384
 
+/* Maximum number of rays in a packet, limited by the width of the ray mask */
+#define BVH_PACKET_SIZE 8
+
 /* BVH intersection function variations */
 
 #define BVH_INSTANCING			1
@@ -80,6 +83,9 @@ CCL_NAMESPACE_BEGIN
 /* Common QBVH functions. */
 #ifdef __QBVH__
 #  include "qbvh_nodes.h"
+#  ifdef __KERNEL_CPU__
+#    include "qbvh_packet.h"
+#  endif
 #endif
 
 /* Regular BVH traversal */
@@ -248,6 +254,35 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __KERNEL_CPU__
+/* Whether rays can be intersected as a packet, see kernel_bvh_use_packets(). */
+ccl_device_inline bool scene_intersect_packet_supported(KernelGlobals *kg)
+{
+#  ifdef __QBVH__
+	return kernel_bvh_use_packets(&kernel_data.bvh);
+#  else
+	(void)kg;
+	return false;
+#  endif
+}
+
+#  ifdef __QBVH__
+/* Intersect a packet of up to BVH_PACKET_SIZE rays, returns a bit mask of
+ * the rays which hit something. Only valid when
+ * scene_intersect_packet_supported() is true.
+ */
+ccl_device_intersect uint scene_intersect_packet(KernelGlobals *kg,
+                                                 const Ray *rays,
+                                                 const uint visibility,
+                                                 Intersection *isects,
+                                                 int num_rays)
+{
+	kernel_assert(scene_intersect_packet_supported(kg));
+	return qbvh_intersect_packet(kg, rays, isects, num_rays, visibility);
+}
+#  endif /* __QBVH__ */
+#endif /* __KERNEL_CPU__ */
+
 #ifdef __SUBSURFACE__
 ccl_device_intersect void scene_intersect_subsurface(KernelGlobals *kg,
                                                      const Ray *ray,
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Packet traversal of the QBVH, CPU only.
+ *
+ * A small group of coherent rays (typically camera rays of neighbouring
+ * pixels) walks the tree together. Every stack entry carries a mask of the
+ * rays which are still interested in the node, so the node data is fetched
+ * once per packet and rays which missed a node are dropped from its subtree.
+ *
+ * Only the simplest scene layout is supported: a single triangle QBVH with
+ * aligned nodes, no instancing, no motion blur and no hair. Callers are
+ * expected to check scene_intersect_packet_supported() and to trace per
+ * pixel otherwise.
+ */
+
+struct QBVHPacketStackItem {
+	int addr;
+	uint ray_mask;
+};
+
+ccl_device uint qbvh_intersect_packet(KernelGlobals *kg,
+                                      const Ray *rays,
+                                      Intersection *isects,
+                                      const int num_rays,
+                                      const uint visibility)
+{
+	kernel_assert(num_rays <= BVH_PACKET_SIZE);
+
+	/* Per-ray parameters. */
+	float3 P[BVH_PACKET_SIZE];
+	ssef tfar[BVH_PACKET_SIZE];
+	sse3f idir4[BVH_PACKET_SIZE];
+#ifdef __KERNEL_AVX2__
+	sse3f P_idir4[BVH_PACKET_SIZE];
+#else
+	sse3f org4[BVH_PACKET_SIZE];
+#endif
+	int near_x[BVH_PACKET_SIZE], near_y[BVH_PACKET_SIZE], near_z[BVH_PACKET_SIZE];
+	int far_x[BVH_PACKET_SIZE], far_y[BVH_PACKET_SIZE], far_z[BVH_PACKET_SIZE];
+	IsectPrecalc isect_precalc[BVH_PACKET_SIZE];
+
+	uint active_mask = 0;
+	for(int i = 0; i < num_rays; i++) {
+		Intersection *isect = &isects[i];
+		isect->t = rays[i].t;
+		isect->u = 0.0f;
+		isect->v = 0.0f;
+		isect->prim = PRIM_NONE;
+		isect->object = OBJECT_NONE;
+
+		BVH_DEBUG_INIT();
+
+		P[i] = rays[i].P;
+#ifndef __KERNEL_SSE41__
+		if(!isfinite(P[i].x)) {
+			continue;
+		}
+#endif
+
+		float3 dir = bvh_clamp_direction(rays[i].D);
+		float3 idir = bvh_inverse_direction(dir);
+
+		tfar[i] = ssef(rays[i].t);
+		idir4[i] = sse3f(ssef(idir.x), ssef(idir.y), ssef(idir.z));
+#ifdef __KERNEL_AVX2__
+		float3 P_idir = P[i]*idir;
+		P_idir4[i] = sse3f(P_idir.x, P_idir.y, P_idir.z);
+#else
+		org4[i] = sse3f(ssef(P[i].x), ssef(P[i].y), ssef(P[i].z));
+#endif
+
+		if(idir.x >= 0.0f) { near_x[i] = 0; far_x[i] = 1; } else { near_x[i] = 1; far_x[i] = 0; }
+		if(idir.y >= 0.0f) { near_y[i] = 2; far_y[i] = 3; } else { near_y[i] = 3; far_y[i] = 2; }
+		if(idir.z >= 0.0f) { near_z[i] = 4; far_z[i] = 5; } else { near_z[i] = 5; far_z[i] = 4; }
+
+		triangle_intersect_precalc(dir, &isect_precalc[i]);
+
+		active_mask |= (1u << i);
+	}
+
+	if(active_mask == 0) {
+		return 0;
+	}
+
+	/* Traversal stack. */
+	QBVHPacketStackItem traversal_stack[BVH_QSTACK_SIZE];
+	traversal_stack[0].addr = ENTRYPOINT_SENTINEL;
+	traversal_stack[0].ray_mask = 0;
+
+	/* Traversal variables. */
+	int stack_ptr = 0;
+	int node_addr = kernel_data.bvh.root;
+	uint ray_mask = active_mask;
+	uint hit_mask = 0;
+	const ssef tnear(0.0f);
+
+	while(node_addr != ENTRYPOINT_SENTINEL) {
+		if(node_addr >= 0) {
+			/* Internal node, intersect children with every ray of the packet. */
+			float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
+
+#ifdef __VISIBILITY_FLAG__
+			if((__float_as_uint(inodes.x) & visibility) == 0) {
+				/* Pop. */
+				node_addr = traversal_stack[stack_ptr].addr;
+				ray_mask = traversal_stack[stack_ptr].ray_mask;
+				--stack_ptr;
+				continue;
+			}
+#else
+			(void)inodes;
+#endif
+
+			uint child_rays[4] = {0, 0, 0, 0};
+			float child_dist[4] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+
+			uint rays_left = ray_mask;
+			while(rays_left != 0) {
+				const int i = __bscf(rays_left);
+				ssef dist;
+
+#ifdef __KERNEL_DEBUG__
+				Intersection *isect = &isects[i];
+				BVH_DEBUG_NEXT_STEP();
+#endif
+
+				int child_mask = qbvh_aligned_node_intersect(kg,
+				                                             tnear,
+				                                             tfar[i],
+#ifdef __KERNEL_AVX2__
+				                                             P_idir4[i],
+#else
+				                                             org4[i],
+#endif
+				                                             idir4[i],
+				                                             near_x[i], near_y[i], near_z[i],
+				                                             far_x[i], far_y[i], far_z[i],
+				                                             node_addr,
+				                                             &dist);
+
+				while(child_mask != 0) {
+					const int c = __bscf(child_mask);
+					child_rays[c] |= (1u << i);
+					child_dist[c] = min(child_dist[c], ((float*)&dist)[c]);
+				}
+			}
+
+			/* Order hit children by the nearest entry distance of any ray. */
+			int order[4];
+			int num_children = 0;
+			for(int c = 0; c < 4; c++) {
+				if(child_rays[c] == 0) {
+					continue;
+				}
+				int k = num_children++;
+				while(k > 0 && child_dist[order[k - 1]] > child_dist[c]) {
+					order[k] = order[k - 1];
+					--k;
+				}
+				order[k] = c;
+			}
+
+			if(num_children == 0) {
+				/* Pop. */
+				node_addr = traversal_stack[stack_ptr].addr;
+				ray_mask = traversal_stack[stack_ptr].ray_mask;
+				--stack_ptr;
+				continue;
+			}
+
+			/* Push far children, continue with the closest one. */
+			float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+			for(int k = num_children - 1; k > 0; k--) {
+				++stack_ptr;
+				kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+				traversal_stack[stack_ptr].addr = __float_as_int(cnodes[order[k]]);
+				traversal_stack[stack_ptr].ray_mask = child_rays[order[k]];
+			}
+			node_addr = __float_as_int(cnodes[order[0]]);
+			ray_mask = child_rays[order[0]];
+			continue;
+		}
+
+		/* Leaf node, intersect triangles with every ray of the packet. */
+		float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr-1));
+
+#ifdef __VISIBILITY_FLAG__
+		if((__float_as_uint(leaf.z) & visibility) != 0)
+#endif
+		{
+			int prim_addr = __float_as_int(leaf.x);
+			int prim_addr2 = __float_as_int(leaf.y);
+			const uint type = __float_as_int(leaf.w);
+
+			/* Instances and non-triangle primitives are excluded by
+			 * scene_intersect_packet_supported().
+			 */
+			kernel_assert(prim_addr >= 0);
+			kernel_assert((type & PRIMITIVE_ALL) == PRIMITIVE_TRIANGLE);
+			(void)type;
+
+			uint rays_left = ray_mask;
+			while(rays_left != 0) {
+				const int i = __bscf(rays_left);
+				Intersection *isect = &isects[i];
+
+				for(int prim = prim_addr; prim < prim_addr2; prim++) {
+					BVH_DEBUG_NEXT_STEP();
+					if(triangle_intersect(kg,
+					                      &isect_precalc[i],
+					                      isect,
+					                      P[i],
+					                      visibility,
+					                      OBJECT_NONE,
+					                      prim)) {
+						tfar[i] = ssef(isect->t);
+						hit_mask |= (1u << i);
+					}
+				}
+			}
+		}
+
+		/* Pop. */
+		node_addr = traversal_stack[stack_ptr].addr;
+		ray_mask = traversal_stack[stack_ptr].ray_mask;
+		--stack_ptr;
+	}
+
+	return hit_mask;
+}
@@ -189,6 +189,13 @@ ccl_device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, Shader
 		/* multiple importance sampling, get triangle light pdf,
 		 * and compute weight with respect to BSDF pdf */
 		float pdf = triangle_light_pdf(kg, ccl_fetch(sd, Ng), ccl_fetch(sd, I), t);
+#ifdef __LIGHT_TREE__
+		if(kernel_data.integrator.use_light_tree) {
+			/* Selection depends on the point the ray was traced from. */
+			float3 P = ccl_fetch(sd, P) + ccl_fetch(sd, I)*t;
+			pdf *= light_tree_triangle_pdf(kg, ccl_fetch(sd, object), ccl_fetch(sd, prim), P);
+		}
+#endif
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
@@ -31,6 +31,10 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #  endif
 
+#  ifdef __TEXTURE_CACHE__
+struct TextureCacheGlobals;
+#  endif
+
 struct Intersection;
 struct VolumeStep;
 
@@ -56,6 +60,11 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #  endif
 
+#  ifdef __TEXTURE_CACHE__
+	/* Images looked up through the texture cache, NULL when none is used. */
+	TextureCacheGlobals *texture_cache;
+#  endif
+
 	/* **** Run-time data ****  */
 
 	/* Heap-allocated storage for transparent shadows intersections. */
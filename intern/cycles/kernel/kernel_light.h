@@ -828,6 +828,159 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
 }
 
+/* Light Tree
+ *
+ * Binary tree over emissive triangles and point, spot and area lamps, built
+ * by the light manager. Every node holds the bounds, the total energy and an
+ * orientation cone of the emitters below it, and traversal picks a child with
+ * probability proportional to its estimated contribution to the shading point.
+ * Distant and background lamps are kept outside of the tree and picked
+ * uniformly. Leaves refer to entries of the light distribution, so the rest of
+ * the light code does not need to know about the tree.
+ */
+
+#ifdef __LIGHT_TREE__
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+
+	float energy = data0.w;
+	if(energy == 0.0f)
+		return 0.0f;
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float3 V = P - 0.5f*(bbox_min + bbox_max);
+	float dist2 = len_squared(V);
+	float radius2 = 0.25f*len_squared(bbox_max - bbox_min);
+
+	/* Bound the angle between the emission cone and the shading point, points
+	 * inside the bounding sphere may receive light from any direction. */
+	float cos_theta_prime = 1.0f;
+	float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+	float theta_o = data2.w;
+
+	if(theta_o < M_PI_F && dist2 > radius2) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		float3 axis = make_float3(data2.x, data2.y, data2.z);
+		float theta_e = data3.x;
+		float dist = sqrtf(dist2);
+
+		float theta = safe_acosf(dot(axis, V)/dist);
+		float theta_u = safe_asinf(sqrtf(radius2/dist2));
+		float theta_prime = max(theta - theta_o - theta_u, 0.0f);
+
+		if(theta_prime >= theta_e)
+			return 0.0f;
+
+		cos_theta_prime = cosf(theta_prime);
+	}
+
+	return energy*cos_theta_prime/max(max(dist2, radius2), 1e-12f);
+}
+
+/* Probability of descending into the left child of an inner node. */
+ccl_device float light_tree_left_probability(KernelGlobals *kg, int node, int right, float3 P)
+{
+	float importance_left = light_tree_node_importance(kg, node + 1, P);
+	float importance_right = light_tree_node_importance(kg, right, P);
+	float importance = importance_left + importance_right;
+
+	return (importance > 0.0f)? importance_left/importance: 0.5f;
+}
+
+/* Pick an entry of the light distribution, returning its selection pdf. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float randt, float3 P, float *pdf)
+{
+	float tree_pdf = kernel_data.integrator.light_tree_pdf;
+	int infinite_offset = kernel_data.integrator.light_tree_infinite_offset;
+
+	if(randt >= tree_pdf) {
+		int num_infinite = kernel_data.integrator.num_distribution - infinite_offset;
+		randt = (randt - tree_pdf)/(1.0f - tree_pdf);
+		*pdf = kernel_data.integrator.pdf_lights;
+		return infinite_offset + clamp((int)(randt*num_infinite), 0, num_infinite - 1);
+	}
+
+	randt /= tree_pdf;
+
+	int node = 0;
+	float node_pdf = tree_pdf;
+
+	for(;;) {
+		float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+		int child = __float_as_int(data1.w);
+
+		if(child < 0) {
+			*pdf = node_pdf;
+			return ~child;
+		}
+
+		/* Left child directly follows its parent, reuse randt for the next level. */
+		float prob_left = light_tree_left_probability(kg, node, child, P);
+
+		if(randt < prob_left) {
+			randt /= prob_left;
+			node_pdf *= prob_left;
+			node = node + 1;
+		}
+		else {
+			randt = (randt - prob_left)/(1.0f - prob_left);
+			node_pdf *= 1.0f - prob_left;
+			node = child;
+		}
+	}
+}
+
+/* Selection pdf of a tree emitter, following the path stored for it. */
+ccl_device float light_tree_emitter_pdf(KernelGlobals *kg, float4 emitter, float3 P)
+{
+	uint bits = __float_as_uint(emitter.x);
+	int depth = __float_as_int(emitter.y);
+
+	int node = 0;
+	float pdf = kernel_data.integrator.light_tree_pdf;
+
+	for(int i = 0; i < depth; i++) {
+		float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+		int right = __float_as_int(data1.w);
+		float prob_left = light_tree_left_probability(kg, node, right, P);
+
+		if(bits & (1u << i)) {
+			pdf *= 1.0f - prob_left;
+			node = right;
+		}
+		else {
+			pdf *= prob_left;
+			node = node + 1;
+		}
+	}
+
+	return pdf;
+}
+
+/* Area pdf of an emissive triangle hit from P, replacing pdf_triangles. */
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg, int object, int prim, float3 P)
+{
+	float2 data = kernel_tex_fetch(__light_tree_objects, object);
+	int offset = __float_as_int(data.y);
+
+	if(offset < 0)
+		return 0.0f;
+
+	uint index = kernel_tex_fetch(__light_tree_triangles, offset + prim - __float_as_int(data.x));
+
+	if(index == LIGHT_TREE_NONE)
+		return 0.0f;
+
+	float4 emitter = kernel_tex_fetch(__light_tree_emitters, index);
+	return light_tree_emitter_pdf(kg, emitter, P)*emitter.z;
+}
+
+#endif  /* __LIGHT_TREE__ */
+
 /* Generic Light */
 
 ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, int bounce)
@@ -846,7 +999,15 @@ ccl_device_noinline void light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, randt);
+	int index;
+	float pdf_select = 1.0f;
+
+#ifdef __LIGHT_TREE__
+	if(kernel_data.integrator.use_light_tree)
+		index = light_tree_sample(kg, randt, P, &pdf_select);
+	else
+#endif
+		index = light_distribution_sample(kg, randt);
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -862,6 +1023,13 @@ ccl_device_noinline void light_sample(KernelGlobals *kg,
 		ls->D = normalize_len(ls->P - P, &ls->t);
 		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
 		ls->shader |= shader_flag;
+
+#ifdef __LIGHT_TREE__
+		if(kernel_data.integrator.use_light_tree) {
+			float4 emitter = kernel_tex_fetch(__light_tree_emitters, index);
+			ls->pdf *= pdf_select*emitter.z;
+		}
+#endif
 	}
 	else {
 		int lamp = -prim-1;
@@ -872,6 +1040,15 @@ ccl_device_noinline void light_sample(KernelGlobals *kg,
 		}
 
 		lamp_light_sample(kg, lamp, randu, randv, P, ls);
+
+#ifdef __LIGHT_TREE__
+		/* Lamps in the tree are not picked with the uniform lamp probability. */
+		if(kernel_data.integrator.use_light_tree &&
+		   index < kernel_data.integrator.light_tree_infinite_offset)
+		{
+			ls->eval_fac *= kernel_data.integrator.pdf_lights/pdf_select;
+		}
+#endif
 	}
 }
 
@@ -199,5 +199,17 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+/* Accumulate the squared sample value next to the combined pass, so the
+ * device can estimate per-pixel variance for adaptive sampling. */
+ccl_device_inline void kernel_write_adaptive_aux_pass(KernelGlobals *kg, ccl_global float *buffer, int sample, float4 L)
+{
+#ifdef __PASSES__
+	if(kernel_data.film.pass_flag & PASS_ADAPTIVE_AUX) {
+		float value = average(make_float3(L.x, L.y, L.z));
+		kernel_write_pass_float(buffer + kernel_data.film.pass_adaptive_aux, sample, value*value);
+	}
+#endif
+}
+
 CCL_NAMESPACE_END
 
@@ -605,7 +605,8 @@ ccl_device_inline float4 kernel_path_integrate(KernelGlobals *kg,
                                                RNG *rng,
                                                int sample,
                                                Ray ray,
-                                               ccl_global float *buffer)
+                                               ccl_global float *buffer,
+                                               const Intersection *primary_isect)
 {
 	/* initialize */
 	PathRadiance L;
@@ -639,26 +640,36 @@ ccl_device_inline float4 kernel_path_integrate(KernelGlobals *kg,
 		/* intersect scene */
 		Intersection isect;
 		uint visibility = path_state_ray_visibility(kg, &state);
-
+		bool hit;
+
+		if(primary_isect != NULL) {
+			/* camera ray was already intersected as part of a packet */
+			kernel_assert(visibility == PATH_RAY_CAMERA);
+			isect = *primary_isect;
+			hit = (isect.prim != PRIM_NONE);
+			primary_isect = NULL;
+		}
+		else {
 #ifdef __HAIR__
-		float difl = 0.0f, extmax = 0.0f;
-		uint lcg_state = 0;
-
-		if(kernel_data.bvh.have_curves) {
-			if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
-				float3 pixdiff = ray.dD.dx + ray.dD.dy;
-				/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
-				difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
-			}
+			float difl = 0.0f, extmax = 0.0f;
+			uint lcg_state = 0;
+
+			if(kernel_data.bvh.have_curves) {
+				if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
+					float3 pixdiff = ray.dD.dx + ray.dD.dy;
+					/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
+					difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
+				}
 
-			extmax = kernel_data.curve.maximum_width;
-			lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
-		}
+				extmax = kernel_data.curve.maximum_width;
+				lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
+			}
 
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
+			hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
 #else
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
+			hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
 #endif
+		}
 
 #ifdef __KERNEL_DEBUG__
 		if(state.flag & PATH_RAY_CAMERA) {
@@ -944,15 +955,78 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	float4 L;
 
 	if(ray.t != 0.0f)
-		L = kernel_path_integrate(kg, &rng, sample, ray, buffer);
+		L = kernel_path_integrate(kg, &rng, sample, ray, buffer, NULL);
 	else
 		L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_adaptive_aux_pass(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
 
+#ifdef __KERNEL_CPU__
+
+/* Path trace a row of w pixels starting at x, intersecting the camera rays
+ * as packets so coherent rays share the BVH traversal. Secondary bounces
+ * are traced per pixel as usual.
+ */
+ccl_device void kernel_path_trace_packet(KernelGlobals *kg,
+	ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, int x, int y, int w, int offset, int stride)
+{
+#ifdef __QBVH__
+	if(!scene_intersect_packet_supported(kg))
+#endif
+	{
+		/* The host only dispatches packets for supported scenes, trace per
+		 * pixel otherwise so hair and instances keep their full traversal. */
+		for(int px = x; px < x + w; px++)
+			kernel_path_trace(kg, buffer, rng_state, sample, px, y, offset, stride);
+		return;
+	}
+
+#ifdef __QBVH__
+	int pass_stride = kernel_data.film.pass_stride;
+
+	for(int packet_x = x; packet_x < x + w; packet_x += BVH_PACKET_SIZE) {
+		int num_rays = min(BVH_PACKET_SIZE, x + w - packet_x);
+
+		RNG rng[BVH_PACKET_SIZE];
+		Ray rays[BVH_PACKET_SIZE];
+		Intersection isects[BVH_PACKET_SIZE];
+
+		/* initialize random numbers and rays */
+		for(int i = 0; i < num_rays; i++) {
+			int index = offset + packet_x + i + y*stride;
+			kernel_path_trace_setup(kg, rng_state + index, sample, packet_x + i, y, &rng[i], &rays[i]);
+		}
+
+		scene_intersect_packet(kg, rays, PATH_RAY_CAMERA, isects, num_rays);
+
+		/* integrate */
+		for(int i = 0; i < num_rays; i++) {
+			int index = offset + packet_x + i + y*stride;
+			ccl_global float *pixel_buffer = buffer + index*pass_stride;
+			float4 L;
+
+			if(rays[i].t != 0.0f)
+				L = kernel_path_integrate(kg, &rng[i], sample, rays[i], pixel_buffer, &isects[i]);
+			else
+				L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+			/* accumulate result in output buffer */
+			kernel_write_pass_float4(pixel_buffer, sample, L);
+			kernel_write_adaptive_aux_pass(kg, pixel_buffer, sample, L);
+
+			path_rng_end(kg, rng_state + index, rng[i]);
+		}
+	}
+#endif  /* __QBVH__ */
+}
+
+#endif  /* __KERNEL_CPU__ */
+
 CCL_NAMESPACE_END
 
@@ -42,6 +42,7 @@ CCL_NAMESPACE_BEGIN
 #define RAMP_TABLE_SIZE		256
 #define SHUTTER_TABLE_SIZE		256
 #define PARTICLE_SIZE 		5
+#define LIGHT_TREE_NODE_SIZE	4
 
 #define BSSRDF_MIN_RADIUS			1e-8f
 #define BSSRDF_MAX_HITS				4
@@ -52,6 +53,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_NONE				(~0)
 #define PRIM_NONE				(~0)
 #define LAMP_NONE				(~0)
+#define LIGHT_TREE_NONE			(~0u)
 
 #define VOLUME_STACK_SIZE		16
 
@@ -73,6 +75,8 @@ CCL_NAMESPACE_BEGIN
 #  define __VOLUME_SCATTER__
 #  define __SHADOW_RECORD_ALL__
 #  define __VOLUME_RECORD_ALL__
+#  define __LIGHT_TREE__
+#  define __TEXTURE_CACHE__
 #endif  /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -340,10 +344,11 @@ typedef enum PassType {
 	PASS_SUBSURFACE_INDIRECT = (1 << 23),
 	PASS_SUBSURFACE_COLOR = (1 << 24),
 	PASS_LIGHT = (1 << 25), /* no real pass, used to force use_light_pass */
+	PASS_ADAPTIVE_AUX = (1 << 26), /* internal, squared samples for adaptive sampling */
 #ifdef __KERNEL_DEBUG__
-	PASS_BVH_TRAVERSAL_STEPS = (1 << 26),
-	PASS_BVH_TRAVERSED_INSTANCES = (1 << 27),
-	PASS_RAY_BOUNCES = (1 << 28),
+	PASS_BVH_TRAVERSAL_STEPS = (1 << 27),
+	PASS_BVH_TRAVERSED_INSTANCES = (1 << 28),
+	PASS_RAY_BOUNCES = (1 << 29),
 #endif
 } PassType;
 
@@ -1023,7 +1028,7 @@ typedef struct KernelFilm {
 	int pass_shadow;
 	float pass_shadow_scale;
 	int filter_table_offset;
-	int pass_pad2;
+	int pass_adaptive_aux;
 
 	int pass_mist;
 	float mist_start;
@@ -1119,8 +1124,11 @@ typedef struct KernelIntegrator {
 	float volume_step_size;
 	int volume_samples;
 
-	int pad1;
-	int pad2;
+	/* light tree */
+	int use_light_tree;
+	float light_tree_pdf;
+	int light_tree_infinite_offset;
+	int pad1, pad2, pad3;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1136,6 +1144,20 @@ typedef struct KernelBVH {
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
+#ifdef __KERNEL_CPU__
+/* Whether camera rays can be intersected as packets. Shared by the host and
+ * the kernel, packet traversal is only implemented for QBVH without
+ * instancing, motion blur and hair.
+ */
+ccl_device_inline bool kernel_bvh_use_packets(const KernelBVH *bvh)
+{
+	return bvh->use_qbvh &&
+	       !bvh->have_motion &&
+	       !bvh->have_curves &&
+	       !bvh->have_instancing;
+}
+#endif
+
 typedef enum CurveFlag {
 	/* runtime flags */
 	CURVE_KN_BACKFACING = 1,				/* backside of cylinder? */
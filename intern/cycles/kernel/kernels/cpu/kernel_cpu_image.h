@@ -70,6 +70,16 @@ ccl_device float4 kernel_tex_image_interp_3d_ex_impl(KernelGlobals *kg, int tex,
 		return kg->texture_float4_images[tex].interp_3d_ex(x, y, z, interpolation);
 }
 
+#ifdef __TEXTURE_CACHE__
+/* Defined in kernel_texture_cache.cpp, returns false for images which are
+ * held in memory. */
+bool kernel_tex_image_cache_lookup(KernelGlobals *kg,
+                                   int tex,
+                                   float x, float y,
+                                   float2 duv_dx, float2 duv_dy,
+                                   float4 *r);
+#endif
+
 CCL_NAMESPACE_END
 
 #endif  // __KERNEL_CPU__
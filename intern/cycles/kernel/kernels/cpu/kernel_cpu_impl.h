@@ -59,6 +59,34 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 	}
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_packet)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  unsigned int *rng_state,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int w,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int px = x; px < x + w; px++) {
+			kernel_branched_path_trace(kg,
+			                           buffer,
+			                           rng_state,
+			                           sample,
+			                           px, y,
+			                           offset,
+			                           stride);
+		}
+	}
+	else
+#endif
+	{
+		kernel_path_trace_packet(kg, buffer, rng_state, sample, x, y, w, offset, stride);
+	}
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Texture cache lookups, shared by all CPU kernel architectures. */
+
+#include "kernel_compat_cpu.h"
+#include "kernel_types.h"
+#include "kernel_globals.h"
+#include "kernels/cpu/kernel_cpu_image.h"
+#include "kernels/cpu/kernel_texture_cache.h"
+
+CCL_NAMESPACE_BEGIN
+
+bool kernel_tex_image_cache_lookup(KernelGlobals *kg,
+                                   int tex,
+                                   float x, float y,
+                                   float2 duv_dx, float2 duv_dy,
+                                   float4 *r)
+{
+	TextureCacheGlobals *tcg = kg->texture_cache;
+
+	if(tex < 0 || tex >= tcg->images.size())
+		return false;
+
+	const TextureCacheGlobals::Image& image = tcg->images[tex];
+
+	if(image.handle == NULL)
+		return false;
+
+	OIIO::TextureOpt options;
+	options.interpmode = image.interpolation;
+	options.swrap = image.wrap;
+	options.twrap = image.wrap;
+
+	/* Image rows are stored bottom to top in Cycles. */
+	float result[4];
+	bool ok = tcg->ts->texture(image.handle, NULL, options,
+	                           x, 1.0f - y,
+	                           duv_dx.x, -duv_dx.y,
+	                           duv_dy.x, -duv_dy.y,
+	                           min(image.channels, 4), result);
+
+	if(!ok) {
+		*r = make_float4(TEX_IMAGE_MISSING_R,
+		                 TEX_IMAGE_MISSING_G,
+		                 TEX_IMAGE_MISSING_B,
+		                 TEX_IMAGE_MISSING_A);
+	}
+	else if(image.channels == 1) {
+		*r = make_float4(result[0], result[0], result[0], 1.0f);
+	}
+	else if(image.channels == 2) {
+		*r = make_float4(result[0], result[0], result[0], result[1]);
+	}
+	else if(image.channels == 3) {
+		*r = make_float4(result[0], result[1], result[2], 1.0f);
+	}
+	else {
+		*r = make_float4(result[0], result[1], result[2], result[3]);
+	}
+
+	return true;
+}
+
+CCL_NAMESPACE_END
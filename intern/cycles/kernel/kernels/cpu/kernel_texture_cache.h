@@ -0,0 +1,61 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_TEXTURE_CACHE_H__
+#define __KERNEL_TEXTURE_CACHE_H__
+
+#include <OpenImageIO/texture.h>
+
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Images which are not loaded into memory, but looked up through the
+ * OpenImageIO texture system. Tiles of tiled, mip-mapped files are read on
+ * demand and kept in a cache of limited size, so scenes with more texture
+ * data than fits in memory can still be rendered on the CPU. */
+
+struct TextureCacheGlobals {
+	TextureCacheGlobals()
+	{
+		ts = NULL;
+	}
+
+	struct Image {
+		Image()
+		{
+			handle = NULL;
+			interpolation = OIIO::TextureOpt::InterpBilinear;
+			wrap = OIIO::TextureOpt::WrapPeriodic;
+			channels = 4;
+		}
+
+		OIIO::ustring filename;
+		OIIO::TextureSystem::TextureHandle *handle;
+		OIIO::TextureOpt::InterpMode interpolation;
+		OIIO::TextureOpt::Wrap wrap;
+		int channels;
+	};
+
+	OIIO::TextureSystem *ts;
+
+	/* Indexed by image slot, images without a handle are held in memory. */
+	vector<Image> images;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_TEXTURE_CACHE_H__ */
@@ -79,7 +79,7 @@ ccl_device_inline float svm_image_texture_frac(float x, int *ix)
 	return x - (float)i;
 }
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float2 duv_dx, float2 duv_dy, uint srgb, uint use_alpha)
 {
 	uint4 info = kernel_tex_fetch(__tex_image_packed_info, id);
 	uint width = info.x;
@@ -170,16 +170,24 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 
 #else
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+/* Texture coordinate derivatives are only used for mip-mapping by the texture
+ * cache, images in memory are not filtered. */
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float2 duv_dx, float2 duv_dy, uint srgb, uint use_alpha)
 {
 #ifdef __KERNEL_CPU__
 #  ifdef __KERNEL_SSE2__
 	ssef r_ssef;
 	float4 &r = (float4 &)r_ssef;
-	r = kernel_tex_image_interp(id, x, y);
 #  else
-	float4 r = kernel_tex_image_interp(id, x, y);
+	float4 r;
+#  endif
+#  ifdef __TEXTURE_CACHE__
+	if(kg->texture_cache == NULL ||
+	   !kernel_tex_image_cache_lookup(kg, id, x, y, duv_dx, duv_dy, &r))
 #  endif
+	{
+		r = kernel_tex_image_interp(id, x, y);
+	}
 #else
 	float4 r;
 
@@ -341,6 +349,22 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 
 #endif
 
+#ifdef __TEXTURE_CACHE__
+/* Screen space derivatives of the default UV map, exact for images mapped
+ * with it and an estimate of the footprint otherwise. */
+ccl_device void svm_image_texture_uv_derivatives(KernelGlobals *kg, ShaderData *sd, float2 *duv_dx, float2 *duv_dy)
+{
+	AttributeDescriptor desc = find_attribute(kg, sd, ATTR_STD_UV);
+
+	if(desc.offset != ATTR_STD_NOT_FOUND) {
+		float3 dx, dy;
+		primitive_attribute_float3(kg, sd, desc, &dx, &dy);
+		*duv_dx = make_float2(dx.x, dx.y);
+		*duv_dy = make_float2(dy.x, dy.y);
+	}
+}
+#endif
+
 /* Remap coordnate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
@@ -368,7 +392,15 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
 	else {
 		tex_co = make_float2(co.x, co.y);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+
+	float2 duv_dx = make_float2(0.0f, 0.0f);
+	float2 duv_dy = make_float2(0.0f, 0.0f);
+#ifdef __TEXTURE_CACHE__
+	if(kg->texture_cache != NULL && node.w == NODE_IMAGE_PROJ_FLAT)
+		svm_image_texture_uv_derivatives(kg, sd, &duv_dx, &duv_dy);
+#endif
+
+	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, duv_dx, duv_dy, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -453,14 +485,15 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
 	uint id = node.y;
 
 	float4 f = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+	float2 duv = make_float2(0.0f, 0.0f);
 	uint use_alpha = stack_valid(alpha_offset);
 
 	if(weight.x > 0.0f)
-		f += weight.x*svm_image_texture(kg, id, co.y, co.z, srgb, use_alpha);
+		f += weight.x*svm_image_texture(kg, id, co.y, co.z, duv, duv, srgb, use_alpha);
 	if(weight.y > 0.0f)
-		f += weight.y*svm_image_texture(kg, id, co.x, co.z, srgb, use_alpha);
+		f += weight.y*svm_image_texture(kg, id, co.x, co.z, duv, duv, srgb, use_alpha);
 	if(weight.z > 0.0f)
-		f += weight.z*svm_image_texture(kg, id, co.y, co.x, srgb, use_alpha);
+		f += weight.z*svm_image_texture(kg, id, co.y, co.x, duv, duv, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -487,7 +520,8 @@ ccl_device void svm_node_tex_environment(KernelGlobals *kg, ShaderData *sd, floa
 		uv = direction_to_mirrorball(co);
 
 	uint use_alpha = stack_valid(alpha_offset);
-	float4 f = svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+	float2 duv = make_float2(0.0f, 0.0f);
+	float4 f = svm_image_texture(kg, id, uv.x, uv.y, duv, duv, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
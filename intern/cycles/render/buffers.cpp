@@ -100,6 +100,9 @@ RenderTile::RenderTile()
 RenderBuffers::RenderBuffers(Device *device_)
 {
 	device = device_;
+
+	buffer.set_mem_category(MEM_CATEGORY_RENDER_BUFFERS);
+	rng_state.set_mem_category(MEM_CATEGORY_RENDER_BUFFERS);
 }
 
 RenderBuffers::~RenderBuffers()
@@ -328,6 +331,9 @@ DisplayBuffer::DisplayBuffer(Device *device_, bool linear)
 	draw_height = 0;
 	transparent = true; /* todo: determine from background */
 	half_float = linear;
+
+	rgba_byte.set_mem_category(MEM_CATEGORY_RENDER_BUFFERS);
+	rgba_half.set_mem_category(MEM_CATEGORY_RENDER_BUFFERS);
 }
 
 DisplayBuffer::~DisplayBuffer()
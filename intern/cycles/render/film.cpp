@@ -153,6 +153,10 @@ void Pass::add(PassType type, array<Pass>& passes)
 			 */
 			pass.components = 0;
 			break;
+		case PASS_ADAPTIVE_AUX:
+			pass.components = 1;
+			pass.exposure = false;
+			break;
 #ifdef WITH_CYCLES_DEBUG
 		case PASS_BVH_TRAVERSAL_STEPS:
 			pass.components = 1;
@@ -419,6 +423,9 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 			case PASS_LIGHT:
 				kfilm->use_light_pass = 1;
 				break;
+			case PASS_ADAPTIVE_AUX:
+				kfilm->pass_adaptive_aux = kfilm->pass_stride;
+				break;
 
 #ifdef WITH_CYCLES_DEBUG
 			case PASS_BVH_TRAVERSAL_STEPS:
@@ -17,8 +17,12 @@
 #include "device.h"
 #include "image.h"
 #include "scene.h"
+#include "stats.h"
+
+#include "kernels/cpu/kernel_texture_cache.h"
 
 #include "util_foreach.h"
+#include "util_logging.h"
 #include "util_path.h"
 #include "util_progress.h"
 #include "util_texture.h"
@@ -27,6 +31,8 @@
 #include <OSL/oslexec.h>
 #endif
 
+#include <OpenImageIO/imagebufalgo.h>
+
 CCL_NAMESPACE_BEGIN
 
 ImageManager::ImageManager(const DeviceInfo& info)
@@ -34,6 +40,8 @@ ImageManager::ImageManager(const DeviceInfo& info)
 	need_update = true;
 	pack_images = false;
 	osl_texture_system = NULL;
+	texture_cache_size = 0;
+	texture_auto_convert = true;
 	animation_frame = 0;
 
 	/* In case of multiple devices used we need to know type of an actual
@@ -111,6 +119,15 @@ void ImageManager::set_pack_images(bool pack_images_)
 	pack_images = pack_images_;
 }
 
+void ImageManager::set_texture_cache(int size_mb, bool auto_convert)
+{
+	if(size_mb != texture_cache_size || auto_convert != texture_auto_convert) {
+		texture_cache_size = size_mb;
+		texture_auto_convert = auto_convert;
+		need_update = true;
+	}
+}
+
 void ImageManager::set_osl_texture_system(void *texture_system)
 {
 	osl_texture_system = texture_system;
@@ -768,6 +785,118 @@ bool ImageManager::file_load_half_image(Image *img, ImageDataType type, device_v
 	return true;
 }
 
+string ImageManager::texture_cache_filename(const string& filename, Progress *progress)
+{
+	if(string_endswith(filename, ".tx"))
+		return filename;
+
+	/* Prefer a tiled, mip-mapped copy next to the original image, converting
+	 * it once when it is missing or older than the original. The full name is
+	 * kept so images differing only in extension get their own copy. */
+	string tx_filename = filename + ".tx";
+
+	if(path_exists(tx_filename) &&
+	   path_modified_time(tx_filename) >= path_modified_time(filename))
+	{
+		return tx_filename;
+	}
+
+	if(!texture_auto_convert)
+		return filename;
+
+	progress->set_status("Updating Images", "Converting " + path_filename(filename));
+
+	ImageSpec config;
+	config.tile_width = 64;
+	config.tile_height = 64;
+	config.attribute("maketx:filtername", "box");
+
+	if(!ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, filename, tx_filename, config)) {
+		VLOG(1) << "Failed to convert " << filename << " to a tiled texture.";
+		return filename;
+	}
+
+	return tx_filename;
+}
+
+bool ImageManager::device_load_image_cached(Device *device, ImageDataType type, int slot, Progress *progress)
+{
+	Image *img = images[type][slot];
+	TextureCacheGlobals *tcg = (TextureCacheGlobals*)device->texture_cache_memory();
+
+	/* Generated, packed and straight alpha images are loaded into memory. */
+	if(texture_cache_size <= 0 || !tcg || img->builtin_data || !img->use_alpha || pack_images)
+		return false;
+
+	if(!path_exists(img->filename))
+		return false;
+
+	string filename = texture_cache_filename(img->filename, progress);
+
+	thread_scoped_lock device_lock(device_mutex);
+
+	if(!tcg->ts) {
+		tcg->ts = OIIO::TextureSystem::create(false);
+		tcg->ts->attribute("automip", 1);
+		tcg->ts->attribute("autotile", 64);
+	}
+	tcg->ts->attribute("max_memory_MB", (float)texture_cache_size);
+
+	ustring ufilename(filename);
+	ImageSpec spec;
+
+	if(!tcg->ts->get_imagespec(ufilename, 0, spec) ||
+	   spec.depth > 1 || spec.nchannels < 1 || spec.nchannels > 4)
+	{
+		return false;
+	}
+
+	OIIO::TextureSystem::TextureHandle *handle = tcg->ts->get_texture_handle(ufilename);
+	if(!handle)
+		return false;
+
+	int flat_slot = type_index_to_flattened_slot(slot, type);
+	if(flat_slot >= tcg->images.size())
+		tcg->images.resize(flat_slot + 1);
+
+	TextureCacheGlobals::Image& cached = tcg->images[flat_slot];
+	cached.handle = handle;
+	cached.filename = ufilename;
+	cached.channels = spec.nchannels;
+
+	switch(img->interpolation) {
+		case INTERPOLATION_CLOSEST:
+			cached.interpolation = OIIO::TextureOpt::InterpClosest;
+			break;
+		case INTERPOLATION_CUBIC:
+			cached.interpolation = OIIO::TextureOpt::InterpBicubic;
+			break;
+		case INTERPOLATION_SMART:
+			cached.interpolation = OIIO::TextureOpt::InterpSmartBicubic;
+			break;
+		default:
+			cached.interpolation = OIIO::TextureOpt::InterpBilinear;
+			break;
+	}
+
+	switch(img->extension) {
+		case EXTENSION_EXTEND:
+			cached.wrap = OIIO::TextureOpt::WrapClamp;
+			break;
+		case EXTENSION_CLIP:
+			cached.wrap = OIIO::TextureOpt::WrapBlack;
+			break;
+		default:
+			cached.wrap = OIIO::TextureOpt::WrapPeriodic;
+			break;
+	}
+
+	VLOG(1) << "Image " << img->filename << " is read through the texture cache from "
+	        << filename << ".";
+
+	return true;
+}
+
 void ImageManager::device_load_image(Device *device, DeviceScene *dscene, ImageDataType type, int slot, Progress *progress)
 {
 	if(progress->get_cancel())
@@ -781,6 +910,11 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, ImageD
 	string filename = path_filename(images[type][slot]->filename);
 	progress->set_status("Updating Images", "Loading " + filename);
 
+	if(device_load_image_cached(device, type, slot, progress)) {
+		img->need_load = false;
+		return;
+	}
+
 	/* Slot assignment */
 	int flat_slot = type_index_to_flattened_slot(slot, type);
 
@@ -948,6 +1082,16 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, ImageD
 	Image *img = images[type][slot];
 
 	if(img) {
+		TextureCacheGlobals *tcg = (TextureCacheGlobals*)device->texture_cache_memory();
+		int flat_slot = type_index_to_flattened_slot(slot, type);
+
+		if(tcg && flat_slot < tcg->images.size() && tcg->images[flat_slot].handle) {
+			/* Drop cached pages, the file might have changed on disk. */
+			thread_scoped_lock device_lock(device_mutex);
+			tcg->ts->invalidate(tcg->images[flat_slot].filename);
+			tcg->images[flat_slot] = TextureCacheGlobals::Image();
+		}
+
 		if(osl_texture_system && !img->builtin_data) {
 #ifdef WITH_OSL
 			ustring filename(images[type][slot]->filename);
@@ -1269,6 +1413,11 @@ void ImageManager::device_free_builtin(Device *device, DeviceScene *dscene)
 
 void ImageManager::device_free(Device *device, DeviceScene *dscene)
 {
+	TextureCacheGlobals *tcg = (TextureCacheGlobals*)device->texture_cache_memory();
+	if(tcg && tcg->ts) {
+		VLOG(2) << "Texture cache statistics:\n" << tcg->ts->getstats();
+	}
+
 	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		for(size_t slot = 0; slot < images[type].size(); slot++) {
 			device_free_image(device, dscene, (ImageDataType)type, slot);
@@ -1289,5 +1438,44 @@ void ImageManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->tex_image_packed_info.clear();
 }
 
+static size_t image_memory_size(DeviceScene *dscene, ImageManager::ImageDataType type, int slot)
+{
+	switch(type) {
+		case ImageManager::IMAGE_DATA_TYPE_FLOAT4:
+			return dscene->tex_float4_image[slot].memory_size();
+		case ImageManager::IMAGE_DATA_TYPE_BYTE4:
+			return dscene->tex_byte4_image[slot].memory_size();
+		case ImageManager::IMAGE_DATA_TYPE_HALF4:
+			return dscene->tex_half4_image[slot].memory_size();
+		case ImageManager::IMAGE_DATA_TYPE_FLOAT:
+			return dscene->tex_float_image[slot].memory_size();
+		case ImageManager::IMAGE_DATA_TYPE_BYTE:
+			return dscene->tex_byte_image[slot].memory_size();
+		case ImageManager::IMAGE_DATA_TYPE_HALF:
+			return dscene->tex_half_image[slot].memory_size();
+		default:
+			return 0;
+	}
+}
+
+void ImageManager::collect_statistics(DeviceScene *dscene, RenderStats *stats)
+{
+	/* images read through the texture cache have no memory of their own,
+	 * the cache size limits their memory usage */
+	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
+		for(size_t slot = 0; slot < images[type].size(); slot++) {
+			Image *img = images[type][slot];
+
+			if(!img)
+				continue;
+
+			string name = (img->builtin_data)? img->filename: path_filename(img->filename);
+			size_t size = image_memory_size(dscene, (ImageDataType)type, slot);
+
+			stats->images.add_entry(NamedSizeEntry(name, size));
+		}
+	}
+}
+
 CCL_NAMESPACE_END
 
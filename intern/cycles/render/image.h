@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class Progress;
+class RenderStats;
 
 class ImageManager {
 public:
@@ -72,8 +73,11 @@ public:
 	void device_free(Device *device, DeviceScene *dscene);
 	void device_free_builtin(Device *device, DeviceScene *dscene);
 
+	void collect_statistics(DeviceScene *dscene, RenderStats *stats);
+
 	void set_osl_texture_system(void *texture_system);
 	void set_pack_images(bool pack_images_);
+	void set_texture_cache(int size_mb, bool auto_convert);
 	bool set_animation_frame_update(int frame);
 
 	bool need_update;
@@ -106,6 +110,8 @@ private:
 	vector<Image*> images[IMAGE_DATA_NUM_TYPES];
 	void *osl_texture_system;
 	bool pack_images;
+	int texture_cache_size;
+	bool texture_auto_convert;
 
 	bool file_load_image_generic(Image *img, ImageInput **in, int &width, int &height, int &depth, int &components);
 
@@ -125,6 +131,8 @@ private:
 	uint8_t pack_image_options(ImageDataType type, size_t slot);
 
 	void device_load_image(Device *device, DeviceScene *dscene, ImageDataType type, int slot, Progress *progess);
+	bool device_load_image_cached(Device *device, ImageDataType type, int slot, Progress *progress);
+	string texture_cache_filename(const string& filename, Progress *progress);
 	void device_free_image(Device *device, DeviceScene *dscene, ImageDataType type, int slot);
 
 	void device_pack_images(Device *device, DeviceScene *dscene, Progress& progess);
@@ -66,6 +66,12 @@ NODE_DEFINE(Integrator)
 	SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 
+	SOCKET_BOOLEAN(use_adaptive_sampling, "Use Adaptive Sampling", false);
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 16);
+
+	SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
 	method_enum.insert("branched_path", BRANCHED_PATH);
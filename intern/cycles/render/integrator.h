@@ -67,6 +67,12 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 
+	bool use_adaptive_sampling;
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
+	bool use_light_tree;
+
 	enum Method {
 		BRANCHED_PATH = 0,
 		PATH = 1,
@@ -24,6 +24,8 @@
 #include "scene.h"
 #include "shader.h"
 
+#include "util_algorithm.h"
+#include "util_boundbox.h"
 #include "util_foreach.h"
 #include "util_progress.h"
 #include "util_logging.h"
@@ -165,6 +167,164 @@ bool Light::has_contribution(Scene *scene)
 	return (shader) ? shader->has_surface_emission : scene->default_light->has_surface_emission;
 }
 
+/* Light Tree */
+
+struct LightTreeEmitter {
+	int distribution_index;
+	BoundBox bounds;
+	float3 centroid;
+	float energy;
+	float inv_area;
+
+	/* Orientation cone: emission directions lie within theta_o of the axis,
+	 * and light leaves the surface at most theta_e away from them. */
+	float3 axis;
+	float theta_o;
+	float theta_e;
+};
+
+static void light_tree_cone_merge(float3& axis, float& theta_o, float& theta_e,
+                                  float3 axis_b, float theta_o_b, float theta_e_b)
+{
+	theta_e = max(theta_e, theta_e_b);
+
+	if(theta_o < theta_o_b) {
+		swap(axis, axis_b);
+		swap(theta_o, theta_o_b);
+	}
+	if(theta_o >= M_PI_F) {
+		return;
+	}
+
+	/* Cone b fits inside cone a. */
+	float theta_d = safe_acosf(dot(axis, axis_b));
+	if(min(theta_d + theta_o_b, M_PI_F) <= theta_o) {
+		return;
+	}
+
+	/* Smallest cone enclosing both, rotating the axis of a towards b. */
+	float theta_new = 0.5f*(theta_o + theta_d + theta_o_b);
+	float3 ortho = axis_b - axis*dot(axis, axis_b);
+	if(theta_new >= M_PI_F || len_squared(ortho) == 0.0f) {
+		theta_o = M_PI_F;
+		return;
+	}
+
+	float theta_r = theta_new - theta_o;
+	axis = normalize(axis*cosf(theta_r) + normalize(ortho)*sinf(theta_r));
+	theta_o = theta_new;
+}
+
+struct LightTreeCentroidCompare {
+	int dim;
+
+	bool operator()(const LightTreeEmitter& a, const LightTreeEmitter& b) const
+	{
+		return a.centroid[dim] < b.centroid[dim];
+	}
+};
+
+/* Build the subtree of emitters [start, end) in depth first order, so the left
+ * child of a node always follows it. Splitting at the median keeps the depth
+ * within the 32 bits used to store the path to every emitter. */
+static int light_tree_build_recursive(LightTreeEmitter *emitters,
+                                      int start,
+                                      int end,
+                                      int depth,
+                                      uint bits,
+                                      vector<float4>& nodes,
+                                      float4 *emitter_data)
+{
+	int node = nodes.size()/LIGHT_TREE_NODE_SIZE;
+	nodes.resize(nodes.size() + LIGHT_TREE_NODE_SIZE);
+
+	BoundBox bounds = BoundBox::empty;
+	BoundBox centroid_bounds = BoundBox::empty;
+	float energy = 0.0f;
+	float3 axis = emitters[start].axis;
+	float theta_o = emitters[start].theta_o;
+	float theta_e = emitters[start].theta_e;
+
+	for(int i = start; i < end; i++) {
+		bounds.grow(emitters[i].bounds);
+		centroid_bounds.grow(emitters[i].centroid);
+		energy += emitters[i].energy;
+		light_tree_cone_merge(axis, theta_o, theta_e,
+		                      emitters[i].axis, emitters[i].theta_o, emitters[i].theta_e);
+	}
+
+	int child;
+
+	if(end - start == 1) {
+		const LightTreeEmitter& emitter = emitters[start];
+		child = ~emitter.distribution_index;
+		emitter_data[emitter.distribution_index] = make_float4(__uint_as_float(bits),
+		                                                       __int_as_float(depth),
+		                                                       emitter.inv_area,
+		                                                       0.0f);
+	}
+	else {
+		float3 size = centroid_bounds.size();
+		LightTreeCentroidCompare compare;
+		compare.dim = (size.x > size.y)? ((size.x > size.z)? 0: 2): ((size.y > size.z)? 1: 2);
+
+		int mid = (start + end)/2;
+		nth_element(emitters + start, emitters + mid, emitters + end, compare);
+
+		light_tree_build_recursive(emitters, start, mid, depth + 1, bits, nodes, emitter_data);
+		child = light_tree_build_recursive(emitters, mid, end, depth + 1, bits | (1u << depth),
+		                                   nodes, emitter_data);
+	}
+
+	float4 *data = &nodes[node*LIGHT_TREE_NODE_SIZE];
+	data[0] = make_float4(bounds.min.x, bounds.min.y, bounds.min.z, energy);
+	data[1] = make_float4(bounds.max.x, bounds.max.y, bounds.max.z, __int_as_float(child));
+	data[2] = make_float4(axis.x, axis.y, axis.z, theta_o);
+	data[3] = make_float4(theta_e, 0.0f, 0.0f, 0.0f);
+
+	return node;
+}
+
+static bool light_is_infinite(const Light *light)
+{
+	return light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND;
+}
+
+static LightTreeEmitter light_tree_lamp_emitter(const Light *light, int distribution_index, float energy)
+{
+	LightTreeEmitter emitter;
+	emitter.distribution_index = distribution_index;
+	emitter.energy = energy;
+	emitter.inv_area = 0.0f;
+	emitter.bounds = BoundBox::empty;
+	emitter.axis = safe_normalize(light->dir);
+	emitter.theta_e = M_PI_2_F;
+
+	if(light->type == LIGHT_AREA) {
+		float3 axisu = light->axisu*(light->sizeu*light->size);
+		float3 axisv = light->axisv*(light->sizev*light->size);
+		float3 corner = light->co - 0.5f*(axisu + axisv);
+
+		emitter.bounds.grow(corner);
+		emitter.bounds.grow(corner + axisu);
+		emitter.bounds.grow(corner + axisv);
+		emitter.bounds.grow(corner + axisu + axisv);
+		emitter.theta_o = 0.0f;
+	}
+	else {
+		emitter.bounds.grow(light->co, light->size);
+		emitter.theta_o = (light->type == LIGHT_SPOT)? 0.5f*light->spot_angle: M_PI_F;
+	}
+
+	if(len_squared(emitter.axis) == 0.0f) {
+		emitter.axis = make_float3(0.0f, 0.0f, 1.0f);
+		emitter.theta_o = M_PI_F;
+	}
+
+	emitter.centroid = emitter.bounds.center();
+	return emitter;
+}
+
 /* Light Manager */
 
 LightManager::LightManager()
@@ -242,6 +402,23 @@ bool LightManager::object_usable_as_light(Object *object) {
 	return false;
 }
 
+bool LightManager::use_light_tree(Device *device, Scene *scene)
+{
+	Integrator *integrator = scene->integrator;
+
+	if(!integrator->use_light_tree || device->info.type != DEVICE_CPU) {
+		return false;
+	}
+	/* Sampling all lights iterates the lamps and relies on the flat
+	 * distribution for the mesh lights. */
+	if(integrator->method == Integrator::BRANCHED_PATH &&
+	   (integrator->sample_all_lights_direct || integrator->sample_all_lights_indirect))
+	{
+		return false;
+	}
+	return true;
+}
+
 void LightManager::device_update_distribution(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Lights", "Computing distribution");
@@ -253,9 +430,13 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	size_t num_triangles = 0;
 
 	bool background_mis = false;
+	bool use_tree = use_light_tree(device, scene);
+	vector<LightTreeEmitter> tree_emitters;
 
+	vector<Light*> lamps;
 	foreach(Light *light, scene->lights) {
 		if(light->is_enabled) {
+			lamps.push_back(light);
 			num_lights++;
 		}
 		if(light->is_portal) {
@@ -295,10 +476,22 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	size_t offset = 0;
 	int j = 0;
 
+	/* Lookup from hit triangles to their distribution entry, for the light
+	 * tree pdf of emission hits. */
+	float2 *tree_objects = NULL;
+	vector<uint> tree_triangles;
+
+	if(use_tree) {
+		tree_objects = dscene->light_tree_objects.resize(scene->objects.size());
+	}
+
 	foreach(Object *object, scene->objects) {
 		if(progress.get_cancel()) return;
 
 		if(!object_usable_as_light(object)) {
+			if(use_tree) {
+				tree_objects[j] = make_float2(__int_as_float(0), __int_as_float(-1));
+			}
 			j++;
 			continue;
 		}
@@ -327,6 +520,14 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		}
 
 		size_t mesh_num_triangles = mesh->num_triangles();
+		size_t tree_triangles_offset = tree_triangles.size();
+
+		if(use_tree) {
+			tree_objects[j] = make_float2(__int_as_float(mesh->tri_offset),
+			                              __int_as_float(tree_triangles_offset));
+			tree_triangles.resize(tree_triangles_offset + mesh_num_triangles, LIGHT_TREE_NONE);
+		}
+
 		for(size_t i = 0; i < mesh_num_triangles; i++) {
 			int shader_index = mesh->shader[i];
 			Shader *shader = (shader_index < mesh->used_shaders.size())
@@ -351,7 +552,29 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 					p3 = transform_point(&tfm, p3);
 				}
 
-				totarea += triangle_area(p1, p2, p3);
+				float area = triangle_area(p1, p2, p3);
+				totarea += area;
+
+				if(use_tree) {
+					LightTreeEmitter emitter;
+					emitter.distribution_index = offset - 1;
+					emitter.bounds = BoundBox::empty;
+					emitter.bounds.grow(p1);
+					emitter.bounds.grow(p2);
+					emitter.bounds.grow(p3);
+					emitter.centroid = (p1 + p2 + p3)*(1.0f/3.0f);
+					/* Emission strength is not known before shading, so
+					 * weight by area like the distribution does. */
+					emitter.energy = area;
+					emitter.inv_area = (area > 0.0f)? 1.0f/area: 0.0f;
+					/* Mesh lights emit from both sides. */
+					emitter.axis = make_float3(0.0f, 0.0f, 1.0f);
+					emitter.theta_o = M_PI_F;
+					emitter.theta_e = M_PI_2_F;
+					tree_emitters.push_back(emitter);
+
+					tree_triangles[tree_triangles_offset + i] = offset - 1;
+				}
 			}
 		}
 
@@ -364,10 +587,25 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float lightarea = (totarea > 0.0f) ? totarea / num_lights : 1.0f;
 	bool use_lamp_mis = false;
 
-	int light_index = 0;
-	foreach(Light *light, scene->lights) {
-		if(!light->is_enabled)
-			continue;
+	/* Distant and background lamps are picked outside of the light tree,
+	 * keep them at the end of the distribution. */
+	vector<int> lamp_order;
+	for(size_t i = 0; i < lamps.size(); i++) {
+		if(!(use_tree && light_is_infinite(lamps[i]))) {
+			lamp_order.push_back(i);
+		}
+	}
+
+	size_t infinite_offset = offset + lamp_order.size();
+
+	for(size_t i = 0; use_tree && i < lamps.size(); i++) {
+		if(light_is_infinite(lamps[i])) {
+			lamp_order.push_back(i);
+		}
+	}
+
+	foreach(int light_index, lamp_order) {
+		Light *light = lamps[light_index];
 
 		distribution[offset].x = totarea;
 		distribution[offset].y = __int_as_float(~light_index);
@@ -375,6 +613,10 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		distribution[offset].w = light->size;
 		totarea += lightarea;
 
+		if(use_tree && offset < infinite_offset) {
+			tree_emitters.push_back(light_tree_lamp_emitter(light, offset, lightarea));
+		}
+
 		if(light->size > 0.0f && light->use_mis)
 			use_lamp_mis = true;
 		if(light->type == LIGHT_BACKGROUND) {
@@ -382,7 +624,6 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 			background_mis = light->use_mis;
 		}
 
-		light_index++;
 		offset++;
 	}
 
@@ -443,12 +684,41 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		if(num_background_lights < num_lights)
 			kfilm->pass_shadow_scale *= (float)(num_lights - num_background_lights)/(float)num_lights;
 
+		/* Light tree */
+		kintegrator->use_light_tree = use_tree && !tree_emitters.empty();
+
+		if(kintegrator->use_light_tree) {
+			size_t num_infinite = num_distribution - infinite_offset;
+
+			/* Tree emitters carry their own selection pdf, distant and
+			 * background lamps share the remaining probability uniformly. */
+			kintegrator->light_tree_pdf = (num_infinite > 0)? 0.5f: 1.0f;
+			kintegrator->light_tree_infinite_offset = infinite_offset;
+			kintegrator->pdf_triangles = 1.0f;
+			kintegrator->pdf_lights = (num_infinite > 0)? 0.5f/num_infinite: 1.0f;
+			kintegrator->inv_pdf_lights = 1.0f/kintegrator->pdf_lights;
+
+			device_update_tree(device, dscene, tree_emitters, num_distribution);
+
+			if(tree_triangles.empty()) {
+				tree_triangles.push_back(LIGHT_TREE_NONE);
+			}
+			dscene->light_tree_triangles.copy(&tree_triangles[0], tree_triangles.size());
+			device->tex_alloc("__light_tree_objects", dscene->light_tree_objects);
+			device->tex_alloc("__light_tree_triangles", dscene->light_tree_triangles);
+		}
+		else {
+			dscene->light_tree_objects.clear();
+			kintegrator->light_tree_pdf = 0.0f;
+			kintegrator->light_tree_infinite_offset = num_distribution;
+		}
+
 		/* CDF */
 		device->tex_alloc("__light_distribution", dscene->light_distribution);
 
 		/* Portals */
 		if(num_portals > 0) {
-			kintegrator->portal_offset = light_index;
+			kintegrator->portal_offset = num_lights;
 			kintegrator->num_portals = num_portals;
 			kintegrator->portal_pdf = background_mis? 0.5f: 1.0f;
 		}
@@ -460,6 +730,7 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	}
 	else {
 		dscene->light_distribution.clear();
+		dscene->light_tree_objects.clear();
 
 		kintegrator->num_distribution = 0;
 		kintegrator->num_all_lights = 0;
@@ -470,11 +741,35 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
+		kintegrator->use_light_tree = false;
+		kintegrator->light_tree_pdf = 0.0f;
+		kintegrator->light_tree_infinite_offset = 0;
 
 		kfilm->pass_shadow_scale = 1.0f;
 	}
 }
 
+void LightManager::device_update_tree(Device *device,
+                                      DeviceScene *dscene,
+                                      vector<LightTreeEmitter>& emitters,
+                                      size_t num_distribution)
+{
+	float4 *emitter_data = dscene->light_tree_emitters.resize(num_distribution);
+	memset(emitter_data, 0, sizeof(float4)*num_distribution);
+
+	vector<float4> nodes;
+	nodes.reserve((2*emitters.size() - 1)*LIGHT_TREE_NODE_SIZE);
+	light_tree_build_recursive(&emitters[0], 0, emitters.size(), 0, 0, nodes, emitter_data);
+
+	VLOG(1) << "Light tree built with " << emitters.size() << " emitters and "
+	        << nodes.size()/LIGHT_TREE_NODE_SIZE << " nodes.";
+
+	dscene->light_tree_nodes.copy(&nodes[0], nodes.size());
+
+	device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+	device->tex_alloc("__light_tree_emitters", dscene->light_tree_emitters);
+}
+
 static void background_cdf(int start,
                            int end,
                            int res,
@@ -838,11 +1133,19 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->light_data);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_emitters);
+	device->tex_free(dscene->light_tree_objects);
+	device->tex_free(dscene->light_tree_triangles);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_emitters.clear();
+	dscene->light_tree_objects.clear();
+	dscene->light_tree_triangles.clear();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
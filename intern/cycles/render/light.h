@@ -28,6 +28,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceScene;
+struct LightTreeEmitter;
 class Object;
 class Progress;
 class Scene;
@@ -112,9 +113,16 @@ protected:
 	                              DeviceScene *dscene,
 	                              Scene *scene,
 	                              Progress& progress);
+	void device_update_tree(Device *device,
+	                        DeviceScene *dscene,
+	                        vector<LightTreeEmitter>& emitters,
+	                        size_t num_distribution);
 
 	/* Check whether light manager can use the object as a light-emissive. */
 	bool object_usable_as_light(Object *object);
+
+	/* Check whether the light tree can be used for the current settings. */
+	bool use_light_tree(Device *device, Scene *scene);
 };
 
 CCL_NAMESPACE_END
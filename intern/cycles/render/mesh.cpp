@@ -27,6 +27,7 @@
 #include "nodes.h"
 #include "object.h"
 #include "scene.h"
+#include "stats.h"
 
 #include "osl_globals.h"
 
@@ -37,6 +38,7 @@
 #include "util_logging.h"
 #include "util_progress.h"
 #include "util_set.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -176,6 +178,20 @@ Mesh::Mesh()
 	subd_params = NULL;
 
 	patch_table = NULL;
+
+	triangles.set_mem_category(MEM_CATEGORY_MESH);
+	verts.set_mem_category(MEM_CATEGORY_MESH);
+	shader.set_mem_category(MEM_CATEGORY_MESH);
+	smooth.set_mem_category(MEM_CATEGORY_MESH);
+	triangle_patch.set_mem_category(MEM_CATEGORY_MESH);
+	vert_patch_uv.set_mem_category(MEM_CATEGORY_MESH);
+	curve_keys.set_mem_category(MEM_CATEGORY_MESH);
+	curve_radius.set_mem_category(MEM_CATEGORY_MESH);
+	curve_first_key.set_mem_category(MEM_CATEGORY_MESH);
+	curve_shader.set_mem_category(MEM_CATEGORY_MESH);
+	subd_faces.set_mem_category(MEM_CATEGORY_MESH);
+	subd_face_corners.set_mem_category(MEM_CATEGORY_MESH);
+	subd_creases.set_mem_category(MEM_CATEGORY_MESH);
 }
 
 Mesh::~Mesh()
@@ -796,6 +812,8 @@ void Mesh::compute_bvh(DeviceScene *dscene,
 			bparams.use_qbvh = params->use_qbvh;
 			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 			                              params->use_bvh_unaligned_nodes;
+			bparams.use_cache = params->use_bvh_cache;
+			bparams.cache_size = params->bvh_cache_size;
 
 			delete bvh;
 			bvh = BVH::create(bparams, objects);
@@ -858,6 +876,65 @@ bool Mesh::is_instanced() const
 	return !transform_applied || has_surface_bssrdf;
 }
 
+template<typename T>
+static size_t array_size_in_bytes(const array<T>& data)
+{
+	return data.size()*sizeof(T);
+}
+
+static size_t attributes_size_in_bytes(const AttributeSet& attributes)
+{
+	size_t size = 0;
+
+	foreach(const Attribute& attr, attributes.attributes)
+		size += attr.buffer.size();
+
+	return size;
+}
+
+size_t Mesh::get_total_size_in_bytes() const
+{
+	size_t size = array_size_in_bytes(verts) +
+	              array_size_in_bytes(triangles) +
+	              array_size_in_bytes(shader) +
+	              array_size_in_bytes(smooth) +
+	              array_size_in_bytes(triangle_patch) +
+	              array_size_in_bytes(vert_patch_uv);
+
+	size += array_size_in_bytes(curve_keys) +
+	        array_size_in_bytes(curve_radius) +
+	        array_size_in_bytes(curve_first_key) +
+	        array_size_in_bytes(curve_shader);
+
+	size += array_size_in_bytes(subd_faces) +
+	        array_size_in_bytes(subd_face_corners) +
+	        array_size_in_bytes(subd_creases);
+
+	size += attributes_size_in_bytes(attributes) +
+	        attributes_size_in_bytes(curve_attributes) +
+	        attributes_size_in_bytes(subd_attributes);
+
+	if(patch_table) {
+		size += array_size_in_bytes(patch_table->table);
+	}
+
+	if(bvh) {
+		const PackedBVH& pack = bvh->pack;
+
+		size += array_size_in_bytes(pack.nodes) +
+		        array_size_in_bytes(pack.leaf_nodes) +
+		        array_size_in_bytes(pack.object_node) +
+		        array_size_in_bytes(pack.prim_tri_index) +
+		        array_size_in_bytes(pack.prim_tri_verts) +
+		        array_size_in_bytes(pack.prim_type) +
+		        array_size_in_bytes(pack.prim_visibility) +
+		        array_size_in_bytes(pack.prim_index) +
+		        array_size_in_bytes(pack.prim_object);
+	}
+
+	return size;
+}
+
 /* Mesh Manager */
 
 MeshManager::MeshManager()
@@ -865,6 +942,7 @@ MeshManager::MeshManager()
 	bvh = NULL;
 	need_update = true;
 	need_flags_update = true;
+	need_update_rebuild = true;
 }
 
 MeshManager::~MeshManager()
@@ -1415,6 +1493,8 @@ void MeshManager::device_update_mesh(Device *device,
                                      DeviceScene *dscene,
                                      Scene *scene,
                                      bool for_displacement,
+                                     const vector<bool>& mesh_modified,
+                                     bool pack_modified_only,
                                      Progress& progress)
 {
 	/* Count. */
@@ -1479,10 +1559,15 @@ void MeshManager::device_update_mesh(Device *device,
 		uint *tri_patch = dscene->tri_patch.resize(tri_size);
 		float2 *tri_patch_uv = dscene->tri_patch_uv.resize(vert_size);
 
-		foreach(Mesh *mesh, scene->meshes) {
-			mesh->pack_normals(scene,
-			                   &tri_shader[mesh->tri_offset],
-			                   &vnormal[mesh->vert_offset]);
+		for(size_t i = 0; i < scene->meshes.size(); i++) {
+			Mesh *mesh = scene->meshes[i];
+
+			if(!pack_modified_only || mesh_modified[i]) {
+				mesh->pack_normals(scene,
+				                   &tri_shader[mesh->tri_offset],
+				                   &vnormal[mesh->vert_offset]);
+			}
+			/* Depends on the scene BVH, which is always rebuilt. */
 			mesh->pack_verts(tri_prim_index,
 			                 &tri_vindex[mesh->tri_offset],
 			                 &tri_patch[mesh->tri_offset],
@@ -1508,8 +1593,11 @@ void MeshManager::device_update_mesh(Device *device,
 		float4 *curve_keys = dscene->curve_keys.resize(curve_key_size);
 		float4 *curves = dscene->curves.resize(curve_size);
 
-		foreach(Mesh *mesh, scene->meshes) {
-			mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
+		for(size_t i = 0; i < scene->meshes.size(); i++) {
+			Mesh *mesh = scene->meshes[i];
+
+			if(!pack_modified_only || mesh_modified[i])
+				mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
 			if(progress.get_cancel()) return;
 		}
 
@@ -1522,7 +1610,12 @@ void MeshManager::device_update_mesh(Device *device,
 
 		uint *patch_data = dscene->patches.resize(patch_size);
 
-		foreach(Mesh *mesh, scene->meshes) {
+		for(size_t i = 0; i < scene->meshes.size(); i++) {
+			Mesh *mesh = scene->meshes[i];
+
+			if(pack_modified_only && !mesh_modified[i])
+				continue;
+
 			mesh->pack_patches(&patch_data[mesh->patch_offset], mesh->vert_offset, mesh->face_offset, mesh->corner_offset);
 
 			if(mesh->patch_table) {
@@ -1564,6 +1657,8 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 	                              scene->params.use_bvh_unaligned_nodes;
+	bparams.use_cache = scene->params.use_bvh_cache;
+	bparams.cache_size = scene->params.bvh_cache_size;
 
 	delete bvh;
 	bvh = BVH::create(bparams, scene->objects);
@@ -1617,6 +1712,60 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
 }
 
+bool MeshManager::need_update_transforms_only(Scene *scene)
+{
+	if(need_update_rebuild || !bvh || bvh->objects != scene->objects)
+		return false;
+
+	/* Packed shader indices change when shaders are added or removed. */
+	if(scene->shaders != packed_shaders)
+		return false;
+
+	foreach(Shader *shader, scene->shaders) {
+		if(shader->need_update_attributes)
+			return false;
+	}
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update)
+			return false;
+	}
+
+	/* Objects may have switched to another, unmodified mesh. */
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		if(scene->objects[i]->mesh != bvh_object_meshes[i])
+			return false;
+	}
+
+	return true;
+}
+
+void MeshManager::device_refit_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+{
+	progress.set_status("Updating Scene BVH", "Refitting");
+
+	bvh->refit(progress);
+
+	if(progress.get_cancel()) return;
+
+	/* Node bounds were updated in place, upload them again. */
+	PackedBVH& pack = bvh->pack;
+
+	if(pack.nodes.size()) {
+		device->tex_free(dscene->bvh_nodes);
+		dscene->bvh_nodes.reference((float4*)&pack.nodes[0], pack.nodes.size());
+		device->tex_alloc("__bvh_nodes", dscene->bvh_nodes);
+	}
+	if(pack.leaf_nodes.size()) {
+		device->tex_free(dscene->bvh_leaf_nodes);
+		dscene->bvh_leaf_nodes.reference((float4*)&pack.leaf_nodes[0], pack.leaf_nodes.size());
+		device->tex_alloc("__bvh_leaf_nodes", dscene->bvh_leaf_nodes);
+	}
+
+	/* Object data was packed again by the object manager. */
+	scene->object_manager->device_update_patch_map_offsets(device, dscene, scene);
+}
+
 void MeshManager::device_update_flags(Device * /*device*/,
                                       DeviceScene * /*dscene*/,
                                       Scene * scene,
@@ -1695,6 +1844,32 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	VLOG(1) << "Total " << scene->meshes.size() << " meshes.";
 
+#ifdef __OBJECT_MOTION__
+	Scene::MotionType need_motion = scene->need_motion(device->info.advanced_shading);
+	bool motion_blur = need_motion == Scene::MOTION_BLUR;
+#else
+	bool motion_blur = false;
+#endif
+
+	/* Only object transforms changed, keep mesh data on the device and
+	 * refit the scene BVH to the new object bounds. */
+	if(need_update_transforms_only(scene)) {
+		VLOG(1) << "Refitting scene BVH for transform only update.";
+
+		foreach(Object *object, scene->objects) {
+			object->compute_bounds(motion_blur);
+		}
+
+		{
+			scoped_timer timer(&scene->update_stats.bvh_build_time);
+			device_refit_bvh(device, dscene, scene, progress);
+		}
+		if(progress.get_cancel()) return;
+
+		need_update = false;
+		return;
+	}
+
 	/* Update normals. */
 	foreach(Mesh *mesh, scene->meshes) {
 		foreach(Shader *shader, mesh->used_shaders) {
@@ -1714,6 +1889,26 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		}
 	}
 
+	/* Meshes which only had their vertices moved keep their place in the
+	 * packed arrays, so when no mesh was added or removed only modified
+	 * meshes are packed again. */
+	bool pack_modified_only = !need_update_rebuild &&
+	                          scene->meshes == packed_meshes &&
+	                          scene->shaders == packed_shaders;
+	vector<bool> mesh_modified;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		mesh_modified.push_back(mesh->need_update);
+
+		if(mesh->need_update &&
+		   (mesh->need_update_rebuild ||
+		    mesh->subdivision_type != Mesh::SUBDIVISION_NONE ||
+		    mesh->has_true_displacement()))
+		{
+			pack_modified_only = false;
+		}
+	}
+
 	/* Tessellate meshes that are using subdivision */
 	size_t total_tess_needed = 0;
 	foreach(Mesh *mesh, scene->meshes) {
@@ -1741,8 +1936,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 			progress.set_status("Updating Mesh", msg);
 
-			DiagSplit dsplit(*mesh->subd_params);
-			mesh->tessellate(&dsplit);
+			mesh->tessellate(*mesh->subd_params, scene->params.tessellation_cache_size);
 
 			i++;
 
@@ -1773,11 +1967,11 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 
 	/* Device update. */
-	device_free(device, dscene);
+	device_free(device, dscene, pack_modified_only);
 
 	mesh_calc_offset(scene);
 	if(true_displacement_used) {
-		device_update_mesh(device, dscene, scene, true, progress);
+		device_update_mesh(device, dscene, scene, true, mesh_modified, false, progress);
 	}
 	if(progress.get_cancel()) return;
 
@@ -1817,6 +2011,8 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		}
 	}
 
+	double bvh_start_time = time_dt();
+
 	TaskPool pool;
 
 	i = 0;
@@ -1840,17 +2036,12 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	VLOG(2) << "Objects BVH build pool statistics:\n"
 	        << summary.full_report();
 
+	scene->update_stats.bvh_build_time += time_dt() - bvh_start_time;
+
 	foreach(Shader *shader, scene->shaders) {
 		shader->need_update_attributes = false;
 	}
 
-#ifdef __OBJECT_MOTION__
-	Scene::MotionType need_motion = scene->need_motion(device->info.advanced_shading);
-	bool motion_blur = need_motion == Scene::MOTION_BLUR;
-#else
-	bool motion_blur = false;
-#endif
-
 	/* Update objects. */
 	vector<Object *> volume_objects;
 	foreach(Object *object, scene->objects) {
@@ -1859,13 +2050,24 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
+	bvh_start_time = time_dt();
 	device_update_bvh(device, dscene, scene, progress);
+	scene->update_stats.bvh_build_time += time_dt() - bvh_start_time;
 	if(progress.get_cancel()) return;
 
-	device_update_mesh(device, dscene, scene, false, progress);
+	device_update_mesh(device, dscene, scene, false, mesh_modified, pack_modified_only, progress);
 	if(progress.get_cancel()) return;
 
+	packed_meshes = scene->meshes;
+	packed_shaders = scene->shaders;
+
+	bvh_object_meshes.clear();
+	foreach(Object *object, scene->objects) {
+		bvh_object_meshes.push_back(object->mesh);
+	}
+
 	need_update = false;
+	need_update_rebuild = false;
 
 	if(true_displacement_used) {
 		/* Re-tag flags for update, so they're re-evaluated
@@ -1878,7 +2080,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 }
 
-void MeshManager::device_free(Device *device, DeviceScene *dscene)
+void MeshManager::device_free(Device *device, DeviceScene *dscene, bool keep_mesh_data)
 {
 	device->tex_free(dscene->bvh_nodes);
 	device->tex_free(dscene->bvh_leaf_nodes);
@@ -1902,6 +2104,8 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->attributes_float3);
 	device->tex_free(dscene->attributes_uchar4);
 
+	need_update_rebuild = true;
+
 	dscene->bvh_nodes.clear();
 	dscene->object_node.clear();
 	dscene->prim_tri_verts.clear();
@@ -1910,14 +2114,19 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->prim_visibility.clear();
 	dscene->prim_index.clear();
 	dscene->prim_object.clear();
-	dscene->tri_shader.clear();
-	dscene->tri_vnormal.clear();
 	dscene->tri_vindex.clear();
 	dscene->tri_patch.clear();
 	dscene->tri_patch_uv.clear();
-	dscene->curves.clear();
-	dscene->curve_keys.clear();
-	dscene->patches.clear();
+
+	/* Host copies of unmodified meshes are reused by the next update. */
+	if(!keep_mesh_data) {
+		dscene->tri_shader.clear();
+		dscene->tri_vnormal.clear();
+		dscene->curves.clear();
+		dscene->curve_keys.clear();
+		dscene->patches.clear();
+	}
+
 	dscene->attributes_map.clear();
 	dscene->attributes_float.clear();
 	dscene->attributes_float3.clear();
@@ -1937,9 +2146,18 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 void MeshManager::tag_update(Scene *scene)
 {
 	need_update = true;
+	need_update_rebuild = true;
 	scene->object_manager->need_update = true;
 }
 
+void MeshManager::collect_statistics(const Scene *scene, RenderStats *stats)
+{
+	foreach(Mesh *mesh, scene->meshes) {
+		stats->meshes.add_entry(NamedSizeEntry(string(mesh->name.c_str()),
+		                                       mesh->get_total_size_in_bytes()));
+	}
+}
+
 bool Mesh::need_attribute(Scene *scene, AttributeStandard std)
 {
 	if(std == ATTR_STD_NONE)
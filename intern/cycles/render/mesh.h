@@ -36,11 +36,11 @@ class Device;
 class DeviceScene;
 class Mesh;
 class Progress;
+class RenderStats;
 class Scene;
 class SceneParams;
 class AttributeRequest;
 struct SubdParams;
-class DiagSplit;
 struct PackedPatchTable;
 
 /* Mesh */
@@ -254,7 +254,10 @@ public:
 	/* Check if the mesh should be treated as instanced. */
 	bool is_instanced() const;
 
-	void tessellate(DiagSplit *split);
+	/* Memory used by the mesh data, attributes and BVH. */
+	size_t get_total_size_in_bytes() const;
+
+	void tessellate(const SubdParams& params, int cache_size);
 };
 
 /* Mesh Manager */
@@ -265,6 +268,10 @@ public:
 
 	bool need_update;
 	bool need_flags_update;
+	/* Mesh data on the device can not be reused and has to be packed again,
+	 * otherwise updates where only object transforms changed just refit
+	 * the scene BVH. */
+	bool need_update_rebuild;
 
 	MeshManager();
 	~MeshManager();
@@ -278,10 +285,12 @@ public:
 	void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_flags(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 
-	void device_free(Device *device, DeviceScene *dscene);
+	void device_free(Device *device, DeviceScene *dscene, bool keep_mesh_data = false);
 
 	void tag_update(Scene *scene);
 
+	void collect_statistics(const Scene *scene, RenderStats *stats);
+
 protected:
 	/* Calculate verts/triangles/curves offsets in global arrays. */
 	void mesh_calc_offset(Scene *scene);
@@ -295,6 +304,8 @@ protected:
 	                        DeviceScene *dscene,
 	                        Scene *scene,
 	                        bool for_displacement,
+	                        const vector<bool>& mesh_modified,
+	                        bool pack_modified_only,
 	                        Progress& progress);
 
 	void device_update_attributes(Device *device,
@@ -307,10 +318,23 @@ protected:
 	                       Scene *scene,
 	                       Progress& progress);
 
+	bool need_update_transforms_only(Scene *scene);
+
+	void device_refit_bvh(Device *device,
+	                      DeviceScene *dscene,
+	                      Scene *scene,
+	                      Progress& progress);
+
 	void device_update_displacement_images(Device *device,
 	                                       DeviceScene *dscene,
 	                                       Scene *scene,
 	                                       Progress& progress);
+
+	/* Meshes of the objects the scene BVH was built for. */
+	vector<Mesh*> bvh_object_meshes;
+	/* Meshes and shaders packed into the device arrays, in order. */
+	vector<Mesh*> packed_meshes;
+	vector<Shader*> packed_shaders;
 };
 
 CCL_NAMESPACE_END
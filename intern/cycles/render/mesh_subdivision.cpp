@@ -18,12 +18,16 @@
 #include "attribute.h"
 #include "camera.h"
 
+#include "subd_cache.h"
 #include "subd_split.h"
 #include "subd_patch.h"
 #include "subd_patch_table.h"
 
 #include "util_foreach.h"
 #include "util_algorithm.h"
+#include "util_logging.h"
+#include "util_md5.h"
+#include "util_task.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -335,38 +339,26 @@ struct OsdPatch : Patch {
 
 #endif
 
-void Mesh::tessellate(DiagSplit *split)
-{
-#ifdef WITH_OPENSUBDIV
-	OsdData osd_data;
-	bool need_packed_patch_table = false;
-
-	if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-		if(subd_faces.size()) {
-			osd_data.build_from_mesh(this);
-		}
-	}
-	else
+#ifndef WITH_OPENSUBDIV
+class OsdData;
 #endif
-	{
-		/* force linear subdivision if OpenSubdiv is unavailable to avoid
-		 * falling into catmull-clark code paths by accident
-		 */
-		subdivision_type = SUBDIVISION_LINEAR;
 
-		/* force disable attribute subdivision for same reason as above */
-		foreach(Attribute& attr, subd_attributes.attributes) {
-			attr.flags &= ~ATTR_SUBDIVIDED;
-		}
-	}
+/* Dicing of a range of faces into a buffer, runs from multiple threads. */
 
-	int num_faces = subd_faces.size();
+static void tessellate_faces(Mesh *mesh,
+                             OsdData *osd_data,
+                             const SubdParams *params,
+                             int start,
+                             int end,
+                             DiceBuffer *buffer)
+{
+	DiagSplit split(*params, buffer);
 
-	Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+	Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
 	float3* vN = attr_vN->data_float3();
 
-	for(int f = 0; f < num_faces; f++) {
-		SubdFace& face = subd_faces[f];
+	for(int f = start; f < end; f++) {
+		Mesh::SubdFace& face = mesh->subd_faces[f];
 
 		if(face.is_quad()) {
 			/* quad */
@@ -374,9 +366,9 @@ void Mesh::tessellate(DiagSplit *split)
 
 			LinearQuadPatch quad_patch;
 #ifdef WITH_OPENSUBDIV
-			OsdPatch osd_patch(&osd_data);
+			OsdPatch osd_patch(osd_data);
 
-			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
+			if(mesh->subdivision_type == Mesh::SUBDIVISION_CATMULL_CLARK) {
 				osd_patch.patch_index = face.ptex_offset;
 
 				subpatch.patch = &osd_patch;
@@ -390,16 +382,16 @@ void Mesh::tessellate(DiagSplit *split)
 				quad_patch.patch_index = face.ptex_offset;
 
 				for(int i = 0; i < 4; i++) {
-					hull[i] = verts[subd_face_corners[face.start_corner+i]];
+					hull[i] = mesh->verts[mesh->subd_face_corners[face.start_corner+i]];
 				}
 
 				if(face.smooth) {
 					for(int i = 0; i < 4; i++) {
-						normals[i] = vN[subd_face_corners[face.start_corner+i]];
+						normals[i] = vN[mesh->subd_face_corners[face.start_corner+i]];
 					}
 				}
 				else {
-					float3 N = face.normal(this);
+					float3 N = face.normal(mesh);
 					for(int i = 0; i < 4; i++) {
 						normals[i] = N;
 					}
@@ -420,38 +412,38 @@ void Mesh::tessellate(DiagSplit *split)
 			subpatch.P10 = make_float2(0.5f, 0.0f);
 			subpatch.P01 = make_float2(0.0f, 0.5f);
 			subpatch.P11 = make_float2(0.5f, 0.5f);
-			split->split_quad(subpatch.patch, &subpatch);
+			split.split_quad(subpatch.patch, &subpatch);
 
 			subpatch.P00 = make_float2(0.5f, 0.0f);
 			subpatch.P10 = make_float2(1.0f, 0.0f);
 			subpatch.P01 = make_float2(0.5f, 0.5f);
 			subpatch.P11 = make_float2(1.0f, 0.5f);
-			split->split_quad(subpatch.patch, &subpatch);
+			split.split_quad(subpatch.patch, &subpatch);
 
 			subpatch.P00 = make_float2(0.0f, 0.5f);
 			subpatch.P10 = make_float2(0.5f, 0.5f);
 			subpatch.P01 = make_float2(0.0f, 1.0f);
 			subpatch.P11 = make_float2(0.5f, 1.0f);
-			split->split_quad(subpatch.patch, &subpatch);
+			split.split_quad(subpatch.patch, &subpatch);
 
 			subpatch.P00 = make_float2(0.5f, 0.5f);
 			subpatch.P10 = make_float2(1.0f, 0.5f);
 			subpatch.P01 = make_float2(0.5f, 1.0f);
 			subpatch.P11 = make_float2(1.0f, 1.0f);
-			split->split_quad(subpatch.patch, &subpatch);
+			split.split_quad(subpatch.patch, &subpatch);
 		}
 		else {
 			/* ngon */
 #ifdef WITH_OPENSUBDIV
-			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-				OsdPatch patch(&osd_data);
+			if(mesh->subdivision_type == Mesh::SUBDIVISION_CATMULL_CLARK) {
+				OsdPatch patch(osd_data);
 
 				patch.shader = face.shader;
 
 				for(int corner = 0; corner < face.num_corners; corner++) {
 					patch.patch_index = face.ptex_offset + corner;
 
-					split->split_quad(&patch);
+					split.split_quad(&patch);
 				}
 			}
 			else
@@ -462,8 +454,8 @@ void Mesh::tessellate(DiagSplit *split)
 
 				float inv_num_corners = 1.0f/float(face.num_corners);
 				for(int corner = 0; corner < face.num_corners; corner++) {
-					center_vert += verts[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
-					center_normal += vN[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
+					center_vert += mesh->verts[mesh->subd_face_corners[face.start_corner + corner]] * inv_num_corners;
+					center_normal += vN[mesh->subd_face_corners[face.start_corner + corner]] * inv_num_corners;
 				}
 
 				for(int corner = 0; corner < face.num_corners; corner++) {
@@ -475,35 +467,266 @@ void Mesh::tessellate(DiagSplit *split)
 
 					patch.shader = face.shader;
 
-					hull[0] = verts[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
-					hull[1] = verts[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
-					hull[2] = verts[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
+					hull[0] = mesh->verts[mesh->subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
+					hull[1] = mesh->verts[mesh->subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
+					hull[2] = mesh->verts[mesh->subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
 					hull[3] = center_vert;
 
 					hull[1] = (hull[1] + hull[0]) * 0.5;
 					hull[2] = (hull[2] + hull[0]) * 0.5;
 
 					if(face.smooth) {
-						normals[0] = vN[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
-						normals[1] = vN[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
-						normals[2] = vN[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
+						normals[0] = vN[mesh->subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
+						normals[1] = vN[mesh->subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
+						normals[2] = vN[mesh->subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
 						normals[3] = center_normal;
 
 						normals[1] = (normals[1] + normals[0]) * 0.5;
 						normals[2] = (normals[2] + normals[0]) * 0.5;
 					}
 					else {
-						float3 N = face.normal(this);
+						float3 N = face.normal(mesh);
 						for(int i = 0; i < 4; i++) {
 							normals[i] = N;
 						}
 					}
 
-					split->split_quad(&patch);
+					split.split_quad(&patch);
 				}
 			}
 		}
 	}
+}
+
+/* Append diced geometry to the mesh, after the control vertices. */
+
+static void tessellate_append(Mesh *mesh, const DiceBuffer& diced, bool ptex)
+{
+	const size_t vert_offset = mesh->verts.size();
+	const size_t tri_offset = mesh->num_triangles();
+	const size_t num_verts = diced.num_verts();
+	const size_t num_triangles = diced.num_triangles();
+
+	Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+	Attribute *attr_ptex_uv = NULL;
+	Attribute *attr_ptex_face_id = NULL;
+
+	if(ptex) {
+		attr_ptex_uv = mesh->attributes.add(ATTR_STD_PTEX_UV);
+		attr_ptex_face_id = mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
+	}
+
+	mesh->resize_mesh(vert_offset + num_verts, tri_offset + num_triangles);
+
+	float3 *vN = attr_vN->data_float3();
+
+	for(size_t i = 0; i < num_verts; i++) {
+		mesh->verts[vert_offset + i] = diced.P[i];
+		vN[vert_offset + i] = diced.N[i];
+		mesh->vert_patch_uv[vert_offset + i] = diced.patch_uv[i];
+	}
+
+	for(size_t i = 0; i < num_triangles; i++) {
+		for(int j = 0; j < 3; j++)
+			mesh->triangles[(tri_offset + i)*3 + j] = diced.triangles[i*3 + j] + vert_offset;
+
+		mesh->shader[tri_offset + i] = diced.shader[i];
+		mesh->smooth[tri_offset + i] = true;
+		mesh->triangle_patch[tri_offset + i] = diced.patch_index[i];
+	}
+
+	if(ptex) {
+		float3 *ptex_uv = attr_ptex_uv->data_float3();
+		float *ptex_face_id = attr_ptex_face_id->data_float();
+
+		for(size_t i = 0; i < num_verts; i++)
+			ptex_uv[vert_offset + i] = make_float3(diced.patch_uv[i].x, diced.patch_uv[i].y, 0.0f);
+
+		for(size_t i = 0; i < num_triangles; i++)
+			ptex_face_id[tri_offset + i] = (float)diced.ptex_face_id[i];
+	}
+
+	mesh->num_subd_verts += num_verts;
+}
+
+/* Dice cache key, a hash of everything the diced geometry depends on. */
+
+static void tessellate_hash_data(MD5Hash& md5, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	/* MD5Hash only takes int sizes. */
+	while(size > 0) {
+		int chunk = (size > (1 << 30))? (1 << 30): (int)size;
+		md5.append(bytes, chunk);
+		bytes += chunk;
+		size -= chunk;
+	}
+}
+
+template<typename T>
+static void tessellate_hash_value(MD5Hash& md5, const T& value)
+{
+	md5.append((const uint8_t*)&value, sizeof(T));
+}
+
+/* Padding of float3 is not guaranteed to be initialized, only hash xyz. */
+static void tessellate_hash_float3(MD5Hash& md5, const float3 *data, size_t size)
+{
+	for(size_t i = 0; i < size; i++) {
+		float xyz[3] = {data[i].x, data[i].y, data[i].z};
+		md5.append((const uint8_t*)xyz, sizeof(xyz));
+	}
+}
+
+static string tessellate_cache_key(Mesh *mesh, const SubdParams& params)
+{
+	MD5Hash md5;
+
+	/* Control mesh. */
+	tessellate_hash_value(md5, (int)mesh->subdivision_type);
+	tessellate_hash_value(md5, (uint64_t)mesh->verts.size());
+	tessellate_hash_float3(md5, mesh->verts.data(), mesh->verts.size());
+
+	tessellate_hash_value(md5, (uint64_t)mesh->subd_faces.size());
+	for(size_t i = 0; i < mesh->subd_faces.size(); i++) {
+		const Mesh::SubdFace& face = mesh->subd_faces[i];
+
+		tessellate_hash_value(md5, face.start_corner);
+		tessellate_hash_value(md5, face.num_corners);
+		tessellate_hash_value(md5, face.shader);
+		tessellate_hash_value(md5, (int)face.smooth);
+		tessellate_hash_value(md5, face.ptex_offset);
+	}
+
+	tessellate_hash_value(md5, (uint64_t)mesh->subd_face_corners.size());
+	tessellate_hash_data(md5, mesh->subd_face_corners.data(), mesh->subd_face_corners.size()*sizeof(int));
+	tessellate_hash_value(md5, (uint64_t)mesh->subd_creases.size());
+	tessellate_hash_data(md5, mesh->subd_creases.data(), mesh->subd_creases.size()*sizeof(Mesh::SubdEdgeCrease));
+
+	Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+	if(attr_vN) {
+		tessellate_hash_float3(md5, attr_vN->data_float3(), attr_vN->buffer.size()/sizeof(float3));
+	}
+
+	/* Dicing parameters. */
+	tessellate_hash_value(md5, (int)params.ptex);
+	tessellate_hash_value(md5, params.test_steps);
+	tessellate_hash_value(md5, params.split_threshold);
+	tessellate_hash_value(md5, params.dicing_rate);
+	tessellate_hash_value(md5, params.max_level);
+	tessellate_hash_value(md5, params.objecttoworld);
+
+	/* Dicing camera, as far as Camera::world_to_raster_size() uses it. */
+	Camera *cam = params.camera;
+	tessellate_hash_value(md5, (int)(cam != NULL));
+	if(cam) {
+		tessellate_hash_value(md5, (int)cam->type);
+		tessellate_hash_value(md5, cam->width);
+		tessellate_hash_value(md5, cam->height);
+		tessellate_hash_value(md5, cam->cameratoworld);
+		tessellate_hash_value(md5, cam->worldtocamera);
+		tessellate_hash_value(md5, cam->rastertocamera);
+		tessellate_hash_float3(md5, &cam->full_dx, 1);
+		tessellate_hash_float3(md5, &cam->full_dy, 1);
+	}
+
+	return md5.get_hex();
+}
+
+void Mesh::tessellate(const SubdParams& params, int cache_size)
+{
+#ifdef WITH_OPENSUBDIV
+	OsdData osd_data;
+	OsdData *osd_data_ptr = &osd_data;
+	bool need_packed_patch_table = false;
+
+	if(subdivision_type != SUBDIVISION_CATMULL_CLARK)
+#else
+	OsdData *osd_data_ptr = NULL;
+#endif
+	{
+		/* force linear subdivision if OpenSubdiv is unavailable to avoid
+		 * falling into catmull-clark code paths by accident
+		 */
+		subdivision_type = SUBDIVISION_LINEAR;
+
+		/* force disable attribute subdivision for same reason as above */
+		foreach(Attribute& attr, subd_attributes.attributes) {
+			attr.flags &= ~ATTR_SUBDIVIDED;
+		}
+	}
+
+	int num_faces = subd_faces.size();
+
+	/* Look up previously diced geometry. */
+	string cache_key;
+	DiceBuffer diced;
+	bool diced_from_cache = false;
+
+	if(cache_size > 0) {
+		cache_key = tessellate_cache_key(this, params);
+		diced_from_cache = DiceCache::find(cache_key, &diced);
+
+		VLOG(1) << "Dice cache " << (diced_from_cache? "hit": "miss")
+		        << " for mesh " << name.c_str() << ".";
+	}
+
+#ifdef WITH_OPENSUBDIV
+	if(subdivision_type == SUBDIVISION_CATMULL_CLARK && num_faces) {
+		/* With cached geometry patches are only needed to subdivide attributes. */
+		bool need_patches = !diced_from_cache;
+
+		foreach(Attribute& attr, subd_attributes.attributes) {
+			if((attr.flags & ATTR_SUBDIVIDED) &&
+			   attr.element != ATTR_ELEMENT_CORNER &&
+			   attr.element != ATTR_ELEMENT_CORNER_BYTE)
+			{
+				need_patches = true;
+			}
+		}
+
+		if(need_patches) {
+			osd_data.build_from_mesh(this);
+		}
+	}
+#endif
+
+	if(!diced_from_cache) {
+		/* Dice ranges of faces in parallel, each into its own buffer. Buffers
+		 * are appended in order, so the result is the same as dicing serially. */
+		const int num_tasks = max(TaskScheduler::num_threads(), 1) * 8;
+		const int faces_per_task = max((num_faces + num_tasks - 1) / num_tasks, 1);
+		const int num_buffers = (num_faces + faces_per_task - 1) / faces_per_task;
+
+		vector<DiceBuffer> buffers(num_buffers);
+		TaskPool pool;
+
+		for(int i = 0; i < num_buffers; i++) {
+			int start = i * faces_per_task;
+			int end = min(start + faces_per_task, num_faces);
+
+			pool.push(function_bind(&tessellate_faces,
+			                        this,
+			                        osd_data_ptr,
+			                        &params,
+			                        start,
+			                        end,
+			                        &buffers[i]));
+		}
+
+		pool.wait_work();
+
+		foreach(const DiceBuffer& buffer, buffers) {
+			diced.append(buffer);
+		}
+
+		if(cache_size > 0) {
+			DiceCache::add(cache_key, diced, (size_t)cache_size * 1024 * 1024);
+		}
+	}
+
+	tessellate_append(this, diced, params.ptex);
 
 	/* interpolate center points for attributes */
 	foreach(Attribute& attr, subd_attributes.attributes) {
@@ -30,6 +30,7 @@
 #include "particles.h"
 #include "scene.h"
 #include "shader.h"
+#include "stats.h"
 #include "svm.h"
 #include "tables.h"
 
@@ -37,9 +38,78 @@
 #include "util_guarded_allocator.h"
 #include "util_logging.h"
 #include "util_progress.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+DeviceScene::DeviceScene()
+{
+	/* categories for memory accounting */
+	bvh_nodes.set_mem_category(MEM_CATEGORY_BVH);
+	bvh_leaf_nodes.set_mem_category(MEM_CATEGORY_BVH);
+	object_node.set_mem_category(MEM_CATEGORY_BVH);
+	prim_tri_index.set_mem_category(MEM_CATEGORY_BVH);
+	prim_tri_verts.set_mem_category(MEM_CATEGORY_BVH);
+	prim_type.set_mem_category(MEM_CATEGORY_BVH);
+	prim_visibility.set_mem_category(MEM_CATEGORY_BVH);
+	prim_index.set_mem_category(MEM_CATEGORY_BVH);
+	prim_object.set_mem_category(MEM_CATEGORY_BVH);
+
+	tri_shader.set_mem_category(MEM_CATEGORY_MESH);
+	tri_vnormal.set_mem_category(MEM_CATEGORY_MESH);
+	tri_vindex.set_mem_category(MEM_CATEGORY_MESH);
+	tri_patch.set_mem_category(MEM_CATEGORY_MESH);
+	tri_patch_uv.set_mem_category(MEM_CATEGORY_MESH);
+	curves.set_mem_category(MEM_CATEGORY_MESH);
+	curve_keys.set_mem_category(MEM_CATEGORY_MESH);
+	patches.set_mem_category(MEM_CATEGORY_MESH);
+
+	objects.set_mem_category(MEM_CATEGORY_OBJECTS);
+	objects_vector.set_mem_category(MEM_CATEGORY_OBJECTS);
+	object_flag.set_mem_category(MEM_CATEGORY_OBJECTS);
+
+	attributes_map.set_mem_category(MEM_CATEGORY_ATTRIBUTES);
+	attributes_float.set_mem_category(MEM_CATEGORY_ATTRIBUTES);
+	attributes_float3.set_mem_category(MEM_CATEGORY_ATTRIBUTES);
+	attributes_uchar4.set_mem_category(MEM_CATEGORY_ATTRIBUTES);
+
+	light_distribution.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_data.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_background_marginal_cdf.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_background_conditional_cdf.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_tree_nodes.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_tree_emitters.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_tree_objects.set_mem_category(MEM_CATEGORY_LIGHTS);
+	light_tree_triangles.set_mem_category(MEM_CATEGORY_LIGHTS);
+
+	particles.set_mem_category(MEM_CATEGORY_PARTICLES);
+
+	svm_nodes.set_mem_category(MEM_CATEGORY_SHADERS);
+	shader_flag.set_mem_category(MEM_CATEGORY_SHADERS);
+
+	lookup_table.set_mem_category(MEM_CATEGORY_TABLES);
+	sobol_directions.set_mem_category(MEM_CATEGORY_TABLES);
+
+	for(int i = 0; i < TEX_NUM_BYTE4_CPU; i++)
+		tex_byte4_image[i].set_mem_category(MEM_CATEGORY_IMAGES);
+	for(int i = 0; i < TEX_NUM_FLOAT4_CPU; i++)
+		tex_float4_image[i].set_mem_category(MEM_CATEGORY_IMAGES);
+	for(int i = 0; i < TEX_NUM_FLOAT_CPU; i++)
+		tex_float_image[i].set_mem_category(MEM_CATEGORY_IMAGES);
+	for(int i = 0; i < TEX_NUM_BYTE_CPU; i++)
+		tex_byte_image[i].set_mem_category(MEM_CATEGORY_IMAGES);
+	for(int i = 0; i < TEX_NUM_HALF4_CPU; i++)
+		tex_half4_image[i].set_mem_category(MEM_CATEGORY_IMAGES);
+	for(int i = 0; i < TEX_NUM_HALF_CPU; i++)
+		tex_half_image[i].set_mem_category(MEM_CATEGORY_IMAGES);
+
+	tex_image_byte4_packed.set_mem_category(MEM_CATEGORY_IMAGES);
+	tex_image_float4_packed.set_mem_category(MEM_CATEGORY_IMAGES);
+	tex_image_byte_packed.set_mem_category(MEM_CATEGORY_IMAGES);
+	tex_image_float_packed.set_mem_category(MEM_CATEGORY_IMAGES);
+	tex_image_packed_info.set_mem_category(MEM_CATEGORY_IMAGES);
+}
+
 Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 : params(params_)
 {
@@ -138,6 +208,9 @@ void Scene::device_update(Device *device_, Progress& progress)
 
 	bool print_stats = need_data_update();
 
+	update_stats = SceneUpdateStats();
+	scoped_timer update_timer(&update_stats.device_update_time);
+
 	/* The order of updates is important, because there's dependencies between
 	 * the different managers, using data computed by previous managers.
 	 *
@@ -150,6 +223,7 @@ void Scene::device_update(Device *device_, Progress& progress)
 	 */
 	
 	image_manager->set_pack_images(device->info.pack_images);
+	image_manager->set_texture_cache(params.texture_cache_size, params.texture_auto_convert);
 
 	progress.set_status("Updating Shaders");
 	shader_manager->device_update(device, &dscene, this, progress);
@@ -250,6 +324,13 @@ void Scene::device_update(Device *device_, Progress& progress)
 		        << " (" << string_human_readable_size(mem_used) << ")\n"
 		        << "  Peak: " << string_human_readable_number(mem_peak)
 		        << " (" << string_human_readable_size(mem_peak) << ")";
+
+		RenderStats stats;
+		collect_statistics(&stats);
+		stats.collect_memory(device->stats);
+
+		VLOG(2) << "Memory statistics after full device sync:\n"
+		        << stats.full_report();
 	}
 }
 
@@ -338,5 +419,11 @@ void Scene::device_free()
 	free_memory(false);
 }
 
+void Scene::collect_statistics(RenderStats *stats)
+{
+	mesh_manager->collect_statistics(this, stats);
+	image_manager->collect_statistics(&dscene, stats);
+}
+
 CCL_NAMESPACE_END
 
@@ -19,6 +19,7 @@
 
 #include "image.h"
 #include "shader.h"
+#include "stats.h"
 
 #include "device_memory.h"
 
@@ -52,6 +53,7 @@ class CurveSystemManager;
 class Shader;
 class ShaderManager;
 class Progress;
+class RenderStats;
 class BakeManager;
 class BakeData;
 
@@ -97,6 +99,10 @@ public:
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<float4> light_tree_nodes;
+	device_vector<float4> light_tree_emitters;
+	device_vector<float2> light_tree_objects;
+	device_vector<uint> light_tree_triangles;
 
 	/* particles */
 	device_vector<float4> particles;
@@ -128,6 +134,8 @@ public:
 	device_vector<uint4> tex_image_packed_info;
 
 	KernelData data;
+
+	DeviceScene();
 };
 
 /* Scene Parameters */
@@ -145,6 +153,11 @@ public:
 	bool use_bvh_unaligned_nodes;
 	bool use_qbvh;
 	bool persistent_data;
+	int texture_cache_size;
+	bool texture_auto_convert;
+	bool use_bvh_cache;
+	int bvh_cache_size;
+	int tessellation_cache_size;
 
 	SceneParams()
 	{
@@ -154,6 +167,11 @@ public:
 		use_bvh_unaligned_nodes = true;
 		use_qbvh = false;
 		persistent_data = false;
+		texture_cache_size = 0;
+		texture_auto_convert = true;
+		use_bvh_cache = false;
+		bvh_cache_size = 0;
+		tessellation_cache_size = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -162,7 +180,12 @@ public:
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& use_qbvh == params.use_qbvh
-		&& persistent_data == params.persistent_data); }
+		&& persistent_data == params.persistent_data
+		&& texture_cache_size == params.texture_cache_size
+		&& texture_auto_convert == params.texture_auto_convert
+		&& use_bvh_cache == params.use_bvh_cache
+		&& bvh_cache_size == params.bvh_cache_size
+		&& tessellation_cache_size == params.tessellation_cache_size); }
 };
 
 /* Scene */
@@ -206,6 +229,9 @@ public:
 	/* parameters */
 	SceneParams params;
 
+	/* timings of the last device update */
+	SceneUpdateStats update_stats;
+
 	/* mutex must be locked manually by callers */
 	thread_mutex mutex;
 
@@ -227,6 +253,8 @@ public:
 	void reset();
 	void device_free();
 
+	void collect_statistics(RenderStats *stats);
+
 protected:
 	/* Check if some heavy data worth logging was updated.
 	 * Mainly used to suppress extra annoying logging.
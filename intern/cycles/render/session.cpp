@@ -26,6 +26,7 @@
 #include "object.h"
 #include "scene.h"
 #include "session.h"
+#include "stats.h"
 #include "bake.h"
 
 #include "util_foreach.h"
@@ -51,6 +52,8 @@ Session::Session(const SessionParams& params_)
 {
 	device_use_gl = ((params.device.type != DEVICE_CPU) && !params.background);
 
+	tile_manager.set_tile_split(params.dynamic_tiles, params.tile_spans);
+
 	TaskScheduler::init(params.threads);
 
 	device = Device::create(params.device, stats, params.background);
@@ -875,6 +878,13 @@ void Session::update_status_time(bool show_pause, bool show_done)
 
 			substatus += string_printf(", Sample %d/%d", status_sample, num_samples);
 		}
+
+		if(scene->integrator->use_adaptive_sampling) {
+			/* average number of samples per pixel, as if the whole image
+			 * was converging at the same rate as the rendered tiles */
+			substatus += string_printf(", Effective Samples %.1f",
+			                           (double)(progress.get_effective_sample_ratio() * num_samples));
+		}
 	}
 	else if(tile_manager.num_samples == INT_MAX)
 		substatus = string_printf("Path Tracing Sample %d", sample+1);
@@ -908,9 +918,9 @@ void Session::update_status_time(bool show_pause, bool show_done)
 	progress.set_tile(tile, tile_time);
 }
 
-void Session::update_progress_sample()
+void Session::update_progress_sample(int pixel_samples, int tile_pixels)
 {
-	progress.increment_sample();
+	progress.add_samples(pixel_samples, tile_pixels);
 }
 
 void Session::path_trace()
@@ -922,11 +932,21 @@ void Session::path_trace()
 	task.release_tile = function_bind(&Session::release_tile, this, _1);
 	task.get_cancel = function_bind(&Progress::get_cancel, &this->progress);
 	task.update_tile_sample = function_bind(&Session::update_tile_sample, this, _1);
-	task.update_progress_sample = function_bind(&Session::update_progress_sample, this);
+	task.update_progress_sample = function_bind(&Session::update_progress_sample, this, _1, _2);
 	task.need_finish_queue = params.progressive_refine;
 	task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
 	task.requested_tile_size = params.tile_size;
 
+	/* adaptive sampling needs all samples of a tile rendered in one go */
+	if(scene->integrator->use_adaptive_sampling &&
+	   !params.progressive && !params.progressive_refine)
+	{
+		task.adaptive_threshold = scene->integrator->adaptive_threshold;
+		task.adaptive_min_samples = scene->integrator->adaptive_min_samples;
+	}
+
+	tile_manager.set_num_workers(device->get_split_task_count(task));
+
 	device->task_add(task);
 }
 
@@ -1005,6 +1025,15 @@ void Session::device_free()
 	 */
 }
 
+void Session::collect_statistics(RenderStats *stats)
+{
+	scene->mutex.lock();
+	scene->collect_statistics(stats);
+	scene->mutex.unlock();
+
+	stats->collect_memory(this->stats);
+}
+
 int Session::get_max_closure_count()
 {
 	int max_closures = 0;
@@ -36,6 +36,7 @@ class DeviceRequestedFeatures;
 class DisplayBuffer;
 class Progress;
 class RenderBuffers;
+class RenderStats;
 class Scene;
 
 /* Session Parameters */
@@ -52,6 +53,8 @@ public:
 	int samples;
 	int2 tile_size;
 	TileOrder tile_order;
+	bool dynamic_tiles;
+	bool tile_spans;
 	int start_resolution;
 	int threads;
 
@@ -86,6 +89,8 @@ public:
 
 		shadingsystem = SHADINGSYSTEM_SVM;
 		tile_order = TILE_CENTER;
+		dynamic_tiles = false;
+		tile_spans = false;
 	}
 
 	bool modified(const SessionParams& params)
@@ -106,6 +111,8 @@ public:
 		&& text_timeout == params.text_timeout
 		&& progressive_update_timeout == params.progressive_update_timeout
 		&& tile_order == params.tile_order
+		&& dynamic_tiles == params.dynamic_tiles
+		&& tile_spans == params.tile_spans
 		&& shadingsystem == params.shadingsystem); }
 
 };
@@ -146,6 +153,9 @@ public:
 
 	void device_free();
 
+	/* Memory usage per category, mesh and image. */
+	void collect_statistics(RenderStats *stats);
+
 protected:
 	struct DelayedReset {
 		thread_mutex mutex;
@@ -174,7 +184,7 @@ protected:
 	void update_tile_sample(RenderTile& tile);
 	void release_tile(RenderTile& tile);
 
-	void update_progress_sample();
+	void update_progress_sample(int pixel_samples, int tile_pixels);
 
 	bool device_use_gl;
 
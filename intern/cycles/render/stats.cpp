@@ -0,0 +1,236 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats.h"
+
+#include "util_algorithm.h"
+#include "util_foreach.h"
+#include "util_guarded_allocator.h"
+
+CCL_NAMESPACE_BEGIN
+
+static string json_escape(const string& str)
+{
+	string result;
+
+	foreach(char c, str) {
+		switch(c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if((unsigned char)c < 0x20)
+					result += string_printf("\\u%04x", (int)c);
+				else
+					result += c;
+				break;
+		}
+	}
+
+	return result;
+}
+
+static string json_size(size_t size)
+{
+	return string_printf("%llu", (unsigned long long)size);
+}
+
+static bool namedSizeEntryComparator(const NamedSizeEntry& a, const NamedSizeEntry& b)
+{
+	/* We sort in descending order. */
+	return a.size > b.size;
+}
+
+/* Named Size Entry */
+
+NamedSizeEntry::NamedSizeEntry()
+: name(""),
+  size(0)
+{
+}
+
+NamedSizeEntry::NamedSizeEntry(const string& name, size_t size)
+: name(name),
+  size(size)
+{
+}
+
+/* Named Size Stats */
+
+NamedSizeStats::NamedSizeStats()
+: total_size(0)
+{
+}
+
+void NamedSizeStats::add_entry(const NamedSizeEntry& entry)
+{
+	total_size += entry.size;
+	entries.push_back(entry);
+}
+
+string NamedSizeStats::full_report(int indent_level)
+{
+	const string indent(indent_level * 2, ' ');
+	const string double_indent = indent + indent;
+	string result = "";
+
+	result += string_printf("%sTotal memory: %s (%s)\n",
+	                        indent.c_str(),
+	                        string_human_readable_size(total_size).c_str(),
+	                        string_human_readable_number(total_size).c_str());
+
+	sort(entries.begin(), entries.end(), namedSizeEntryComparator);
+
+	foreach(const NamedSizeEntry& entry, entries) {
+		result += string_printf("%s%-32s %s (%s)\n",
+		                        double_indent.c_str(),
+		                        entry.name.c_str(),
+		                        string_human_readable_size(entry.size).c_str(),
+		                        string_human_readable_number(entry.size).c_str());
+	}
+
+	return result;
+}
+
+string NamedSizeStats::json_report()
+{
+	string result = "{\"total\": " + json_size(total_size) + ", \"entries\": [";
+
+	sort(entries.begin(), entries.end(), namedSizeEntryComparator);
+
+	for(size_t i = 0; i < entries.size(); i++) {
+		if(i > 0)
+			result += ", ";
+
+		result += "{\"name\": \"" + json_escape(entries[i].name) + "\", ";
+		result += "\"size\": " + json_size(entries[i].size) + "}";
+	}
+
+	result += "]}";
+
+	return result;
+}
+
+/* Memory Category Stats */
+
+MemoryCategoryStats::MemoryCategoryStats()
+: used(0),
+  peak(0)
+{
+	for(int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		category_used[i] = 0;
+		category_peak[i] = 0;
+	}
+}
+
+void MemoryCategoryStats::collect(const Stats& stats)
+{
+	used = stats.mem_used;
+	peak = stats.mem_peak;
+
+	for(int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		category_used[i] = stats.category_used[i];
+		category_peak[i] = stats.category_peak[i];
+	}
+}
+
+string MemoryCategoryStats::full_report(int indent_level)
+{
+	const string indent(indent_level * 2, ' ');
+	const string double_indent = indent + indent;
+	string result = "";
+
+	result += string_printf("%sUsage: %s, peak: %s\n",
+	                        indent.c_str(),
+	                        string_human_readable_size(used).c_str(),
+	                        string_human_readable_size(peak).c_str());
+
+	for(int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		if(category_peak[i] == 0)
+			continue;
+
+		result += string_printf("%s%-16s %s, peak: %s\n",
+		                        double_indent.c_str(),
+		                        memory_category_name((MemoryCategory)i),
+		                        string_human_readable_size(category_used[i]).c_str(),
+		                        string_human_readable_size(category_peak[i]).c_str());
+	}
+
+	return result;
+}
+
+string MemoryCategoryStats::json_report()
+{
+	string result = "{\"used\": " + json_size(used) + ", ";
+	result += "\"peak\": " + json_size(peak) + ", ";
+	result += "\"categories\": {";
+
+	for(int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		if(i > 0)
+			result += ", ";
+
+		result += string_printf("\"%s\": ", memory_category_name((MemoryCategory)i));
+		result += "{\"used\": " + json_size(category_used[i]) + ", ";
+		result += "\"peak\": " + json_size(category_peak[i]) + "}";
+	}
+
+	result += "}}";
+
+	return result;
+}
+
+/* Render Stats */
+
+void RenderStats::collect_memory(const Stats& device_stats)
+{
+	device.collect(device_stats);
+
+	host.used = util_guarded_get_mem_used();
+	host.peak = util_guarded_get_mem_peak();
+
+	for(int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+		host.category_used[i] = util_guarded_get_mem_used((MemoryCategory)i);
+		host.category_peak[i] = util_guarded_get_mem_peak((MemoryCategory)i);
+	}
+}
+
+string RenderStats::full_report()
+{
+	string result = "";
+
+	result += "Device memory:\n" + device.full_report(1);
+	result += "Host memory:\n" + host.full_report(1);
+	result += "Meshes:\n" + meshes.full_report(1);
+	result += "Images:\n" + images.full_report(1);
+
+	return result;
+}
+
+string RenderStats::json_report()
+{
+	string result = "{\n";
+
+	result += "  \"device\": " + device.json_report() + ",\n";
+	result += "  \"host\": " + host.json_report() + ",\n";
+	result += "  \"meshes\": " + meshes.json_report() + ",\n";
+	result += "  \"images\": " + images.json_report() + "\n";
+	result += "}\n";
+
+	return result;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RENDER_STATS_H__
+#define __RENDER_STATS_H__
+
+#include "util_stats.h"
+#include "util_string.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Named memory size, used to attribute memory to meshes and images. */
+
+class NamedSizeEntry {
+public:
+	NamedSizeEntry();
+	NamedSizeEntry(const string& name, size_t size);
+
+	string name;
+	size_t size;
+};
+
+/* List of named memory sizes and their total. */
+
+class NamedSizeStats {
+public:
+	NamedSizeStats();
+
+	void add_entry(const NamedSizeEntry& entry);
+
+	/* Entries are reported sorted by size, largest first. */
+	string full_report(int indent_level = 0);
+	string json_report();
+
+	size_t total_size;
+	vector<NamedSizeEntry> entries;
+};
+
+/* Memory usage per category, with the peak of each category. */
+
+class MemoryCategoryStats {
+public:
+	MemoryCategoryStats();
+
+	void collect(const Stats& stats);
+
+	string full_report(int indent_level = 0);
+	string json_report();
+
+	size_t used, peak;
+	size_t category_used[MEM_NUM_CATEGORIES];
+	size_t category_peak[MEM_NUM_CATEGORIES];
+};
+
+/* Memory statistics of a render, device memory per category as well as
+ * host memory allocated through the guarded allocator. */
+
+class RenderStats {
+public:
+	/* Fill device and host memory usage, device usage is taken from
+	 * given device stats. */
+	void collect_memory(const Stats& device_stats);
+
+	string full_report();
+	string json_report();
+
+	MemoryCategoryStats device;
+	MemoryCategoryStats host;
+
+	/* Memory of the mesh data, attributes and BVH owned by each mesh. */
+	NamedSizeStats meshes;
+	/* Memory of each loaded image. */
+	NamedSizeStats images;
+};
+
+/* Time spent in the last scene device update. */
+
+class SceneUpdateStats {
+public:
+	SceneUpdateStats()
+	: device_update_time(0.0),
+	  bvh_build_time(0.0)
+	{
+	}
+
+	/* Whole device update, including the BVH build. */
+	double device_update_time;
+	/* Building or refitting the object and scene BVHs. */
+	double bvh_build_time;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __RENDER_STATS_H__ */
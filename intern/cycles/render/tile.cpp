@@ -97,6 +97,10 @@ TileManager::TileManager(bool progressive_, int num_samples_, int2 tile_size_, i
 	preserve_tile_device = preserve_tile_device_;
 	background = background_;
 
+	dynamic_tiles = false;
+	tile_spans = false;
+	num_workers = 1;
+
 	range_start_sample = 0;
 	range_num_samples = -1;
 
@@ -313,6 +317,49 @@ void TileManager::set_tiles()
 	state.buffer.full_height = max(1, params.full_height/resolution);
 }
 
+void TileManager::split_tile(Tile& tile, list<Tile>& tiles)
+{
+	/* Smallest size of a piece, rectangles are kept large enough for
+	 * coherent rendering while spans go down to single rows. */
+	const int min_size = tile_spans? 1: 8;
+
+	if(tiles.size() + 1 >= num_workers)
+		return;
+
+	/* Guided scheduling: aim for every thread getting an equal share of the
+	 * remaining pixels, so pieces get smaller as the frame nears its end. */
+	int64_t remaining = (int64_t)tile.w*tile.h;
+
+	for(list<Tile>::iterator it = tiles.begin(); it != tiles.end(); it++)
+		remaining += (int64_t)it->w*it->h;
+
+	int64_t target = max(remaining/num_workers, (int64_t)1);
+
+	while((int64_t)tile.w*tile.h > target) {
+		Tile rest = tile;
+
+		if(tile_spans || tile.h > tile.w) {
+			if(tile.h < 2*min_size)
+				break;
+
+			tile.h /= 2;
+			rest.y += tile.h;
+			rest.h -= tile.h;
+		}
+		else {
+			if(tile.w < 2*min_size)
+				break;
+
+			tile.w /= 2;
+			rest.x += tile.w;
+			rest.w -= tile.w;
+		}
+
+		rest.index = state.num_tiles++;
+		tiles.push_front(rest);
+	}
+}
+
 bool TileManager::next_tile(Tile& tile, int device)
 {
 	int logical_device = preserve_tile_device? device: 0;
@@ -322,6 +369,11 @@ bool TileManager::next_tile(Tile& tile, int device)
 
 	tile = Tile(state.tiles[logical_device].front());
 	state.tiles[logical_device].pop_front();
+
+	/* tiles pinned to a device keep their buffers there and can't be split */
+	if(dynamic_tiles && !preserve_tile_device)
+		split_tile(tile, state.tiles[logical_device]);
+
 	state.num_rendered_tiles++;
 	return true;
 }
@@ -83,6 +83,18 @@ public:
 
 	void set_tile_order(TileOrder tile_order_) { tile_order = tile_order_; }
 
+	/* Split the remaining tiles near the end of the frame, so that all
+	 * render threads have work until the last tile is done. With spans
+	 * enabled tiles are split into strips of rows instead of rectangles. */
+	void set_tile_split(bool dynamic_tiles_, bool tile_spans_)
+	{
+		dynamic_tiles = dynamic_tiles_;
+		tile_spans = tile_spans_;
+	}
+
+	/* Number of threads across all devices that acquire tiles. */
+	void set_num_workers(int num_workers_) { num_workers = num_workers_; }
+
 	/* ** Sample range rendering. ** */
 
 	/* Start sample in the range. */
@@ -103,6 +115,10 @@ protected:
 	int start_resolution;
 	int num_devices;
 
+	bool dynamic_tiles;
+	bool tile_spans;
+	int num_workers;
+
 	/* in some cases it is important that the same tile will be returned for the same
 	 * device it was originally generated for (i.e. viewport rendering when buffer is
 	 * allocating once for tile and then always used by it)
@@ -124,6 +140,10 @@ protected:
 
 	/* Generate tile list, return number of tiles. */
 	int gen_tiles(bool sliced);
+
+	/* Split tile taken from the list when less work remains than there are
+	 * threads to render it, pieces are put back at the front of the list. */
+	void split_tile(Tile& tile, list<Tile>& tiles);
 };
 
 CCL_NAMESPACE_END
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "subd_cache.h"
+
+#include "util_logging.h"
+
+CCL_NAMESPACE_BEGIN
+
+thread_mutex DiceCache::mutex;
+map<string, DiceCache::Entry> DiceCache::entries;
+size_t DiceCache::total_size = 0;
+uint64_t DiceCache::use_counter = 0;
+
+bool DiceCache::find(const string& key, DiceBuffer *buffer)
+{
+	thread_scoped_lock lock(mutex);
+
+	map<string, Entry>::iterator it = entries.find(key);
+
+	if(it == entries.end())
+		return false;
+
+	it->second.last_used = ++use_counter;
+	*buffer = it->second.buffer;
+
+	return true;
+}
+
+void DiceCache::add(const string& key, const DiceBuffer& buffer, size_t max_size)
+{
+	const size_t size = buffer.memory_size();
+
+	/* Don't flush the whole cache for a mesh which wouldn't fit anyway. */
+	if(size > max_size)
+		return;
+
+	thread_scoped_lock lock(mutex);
+
+	map<string, Entry>::iterator it = entries.find(key);
+
+	if(it != entries.end()) {
+		total_size -= it->second.buffer.memory_size();
+		entries.erase(it);
+	}
+
+	evict(max_size - size);
+
+	Entry& entry = entries[key];
+	entry.buffer = buffer;
+	entry.last_used = ++use_counter;
+	total_size += size;
+
+	VLOG(2) << "Dice cache holds " << entries.size() << " meshes, "
+	        << string_human_readable_size(total_size) << ".";
+}
+
+void DiceCache::evict(size_t max_size)
+{
+	while(total_size > max_size && !entries.empty()) {
+		map<string, Entry>::iterator oldest = entries.begin();
+
+		for(map<string, Entry>::iterator it = entries.begin(); it != entries.end(); it++) {
+			if(it->second.last_used < oldest->second.last_used)
+				oldest = it;
+		}
+
+		total_size -= oldest->second.buffer.memory_size();
+		entries.erase(oldest);
+	}
+}
+
+size_t DiceCache::memory_size()
+{
+	thread_scoped_lock lock(mutex);
+	return total_size;
+}
+
+void DiceCache::free_memory()
+{
+	thread_scoped_lock lock(mutex);
+
+	map<string, Entry> empty_entries;
+	entries.swap(empty_entries);
+	total_size = 0;
+}
+
+CCL_NAMESPACE_END
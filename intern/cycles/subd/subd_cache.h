@@ -0,0 +1,64 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SUBD_CACHE_H__
+#define __SUBD_CACHE_H__
+
+/* Dice Cache
+ *
+ * Diced geometry of subdivision meshes, kept in memory across scene updates
+ * and renders. Entries are keyed by a hash of the control mesh and the dicing
+ * parameters, so as long as neither changes, for example for a static mesh
+ * and camera over an animation, dicing is replaced by a copy. */
+
+#include "subd_dice.h"
+
+#include "util_map.h"
+#include "util_string.h"
+#include "util_thread.h"
+#include "util_types.h"
+
+CCL_NAMESPACE_BEGIN
+
+class DiceCache {
+public:
+	/* Copy cached geometry for key into buffer, false if there is none. */
+	static bool find(const string& key, DiceBuffer *buffer);
+
+	/* Add geometry for key, evicting the least recently used entries when
+	 * the cache grows beyond max_size bytes. */
+	static void add(const string& key, const DiceBuffer& buffer, size_t max_size);
+
+	static size_t memory_size();
+	static void free_memory();
+
+protected:
+	struct Entry {
+		DiceBuffer buffer;
+		uint64_t last_used;
+	};
+
+	static thread_mutex mutex;
+	static map<string, Entry> entries;
+	static size_t total_size;
+	static uint64_t use_counter;
+
+	static void evict(size_t max_size);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __SUBD_CACHE_H__ */
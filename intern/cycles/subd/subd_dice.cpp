@@ -21,44 +21,67 @@
 #include "subd_patch.h"
 
 #include "util_debug.h"
+#include "util_foreach.h"
 
 CCL_NAMESPACE_BEGIN
 
-/* EdgeDice Base */
+/* Dice Buffer */
 
-EdgeDice::EdgeDice(const SubdParams& params_)
-: params(params_)
+size_t DiceBuffer::memory_size() const
 {
-	mesh_P = NULL;
-	mesh_N = NULL;
-	vert_offset = 0;
+	return P.size()*sizeof(float3) +
+	       N.size()*sizeof(float3) +
+	       patch_uv.size()*sizeof(float2) +
+	       triangles.size()*sizeof(int) +
+	       shader.size()*sizeof(int) +
+	       patch_index.size()*sizeof(int) +
+	       ptex_face_id.size()*sizeof(int);
+}
 
-	params.mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+void DiceBuffer::append(const DiceBuffer& other)
+{
+	const int vert_offset = P.size();
 
-	if(params.ptex) {
-		params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-	}
+	P.insert(P.end(), other.P.begin(), other.P.end());
+	N.insert(N.end(), other.N.begin(), other.N.end());
+	patch_uv.insert(patch_uv.end(), other.patch_uv.begin(), other.patch_uv.end());
+
+	triangles.reserve(triangles.size() + other.triangles.size());
+	foreach(int v, other.triangles)
+		triangles.push_back(v + vert_offset);
+
+	shader.insert(shader.end(), other.shader.begin(), other.shader.end());
+	patch_index.insert(patch_index.end(), other.patch_index.begin(), other.patch_index.end());
+	ptex_face_id.insert(ptex_face_id.end(), other.ptex_face_id.begin(), other.ptex_face_id.end());
 }
 
-void EdgeDice::reserve(int num_verts)
+void DiceBuffer::clear()
 {
-	Mesh *mesh = params.mesh;
-
-	vert_offset = mesh->verts.size();
-	tri_offset = mesh->num_triangles();
+	P.clear();
+	N.clear();
+	patch_uv.clear();
+	triangles.clear();
+	shader.clear();
+	patch_index.clear();
+	ptex_face_id.clear();
+}
 
-	/* todo: optimize so we can reserve in advance, this is like push_back_slow() */
-	if(vert_offset + num_verts > mesh->verts.capacity()) {
-		mesh->reserve_mesh(size_t((vert_offset + num_verts) * 1.2), mesh->num_triangles());
-	}
+/* EdgeDice Base */
 
-	mesh->resize_mesh(vert_offset + num_verts, tri_offset);
+EdgeDice::EdgeDice(const SubdParams& params_, DiceBuffer *buffer_)
+: params(params_),
+  buffer(buffer_)
+{
+	vert_offset = 0;
+}
 
-	Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+void EdgeDice::reserve(int num_verts)
+{
+	vert_offset = buffer->num_verts();
 
-	mesh_P = mesh->verts.data();
-	mesh_N = attr_vN->data_float3();
+	buffer->P.resize(vert_offset + num_verts);
+	buffer->N.resize(vert_offset + num_verts);
+	buffer->patch_uv.resize(vert_offset + num_verts);
 }
 
 int EdgeDice::add_vert(Patch *patch, float2 uv)
@@ -67,45 +90,25 @@ int EdgeDice::add_vert(Patch *patch, float2 uv)
 
 	patch->eval(&P, NULL, NULL, &N, uv.x, uv.y);
 
-	assert(vert_offset < params.mesh->verts.size());
-
-	mesh_P[vert_offset] = P;
-	mesh_N[vert_offset] = N;
-	params.mesh->vert_patch_uv[vert_offset] = make_float2(uv.x, uv.y);
-
-	if(params.ptex) {
-		Attribute *attr_ptex_uv = params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.resize();
-
-		float3 *ptex_uv = attr_ptex_uv->data_float3();
-		ptex_uv[vert_offset] = make_float3(uv.x, uv.y, 0.0f);
-	}
+	assert(vert_offset < buffer->num_verts());
 
-	params.mesh->num_subd_verts++;
+	buffer->P[vert_offset] = P;
+	buffer->N[vert_offset] = N;
+	buffer->patch_uv[vert_offset] = make_float2(uv.x, uv.y);
 
 	return vert_offset++;
 }
 
 void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
 {
-	Mesh *mesh = params.mesh;
-
-	/* todo: optimize so we can reserve in advance, this is like push_back_slow() */
-	if(mesh->triangles.size() == mesh->triangles.capacity())
-		mesh->reserve_mesh(mesh->verts.size(), size_t(max(mesh->num_triangles() + 1, 1) * 1.2));
-
-	mesh->add_triangle(v0, v1, v2, patch->shader, true);
-	params.mesh->triangle_patch[params.mesh->num_triangles()-1] = patch->patch_index;
-
-	if(params.ptex) {
-		Attribute *attr_ptex_face_id = params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-		params.mesh->attributes.resize();
-
-		float *ptex_face_id = attr_ptex_face_id->data_float();
-		ptex_face_id[tri_offset] = (float)patch->ptex_face_id();
-	}
-
-	tri_offset++;
+	buffer->triangles.push_back(v0);
+	buffer->triangles.push_back(v1);
+	buffer->triangles.push_back(v2);
+	buffer->shader.push_back(patch->shader);
+	buffer->patch_index.push_back(patch->patch_index);
+
+	if(params.ptex)
+		buffer->ptex_face_id.push_back(patch->ptex_face_id());
 }
 
 void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& inner)
@@ -131,8 +134,8 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 		}
 		else {
 			/* length of diagonals */
-			float len1 = len_squared(mesh_P[inner[i]] - mesh_P[outer[j+1]]);
-			float len2 = len_squared(mesh_P[outer[j]] - mesh_P[inner[i+1]]);
+			float len1 = len_squared(buffer->P[inner[i]] - buffer->P[outer[j+1]]);
+			float len2 = len_squared(buffer->P[outer[j]] - buffer->P[inner[i+1]]);
 
 			/* use smallest diagonal */
 			if(len1 < len2)
@@ -147,8 +150,8 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 
 /* QuadDice */
 
-QuadDice::QuadDice(const SubdParams& params_)
-: EdgeDice(params_)
+QuadDice::QuadDice(const SubdParams& params_, DiceBuffer *buffer_)
+: EdgeDice(params_, buffer_)
 {
 }
 
@@ -321,7 +324,7 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	Mv = max((int)ceil(S*Mv), 2); // XXX handle 0 & 1?
 
 	/* reserve space for new verts */
-	int offset = params.mesh->verts.size();
+	int offset = buffer->num_verts();
 	reserve(ef, Mu, Mv);
 
 	/* corners and inner grid */
@@ -346,7 +349,7 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	add_side_v(sub, outer, inner, Mu, Mv, ef.tv1, 1, offset);
 	stitch_triangles(sub.patch, outer, inner);
 
-	assert(vert_offset == params.mesh->verts.size());
+	assert(vert_offset == buffer->num_verts());
 }
 
 CCL_NAMESPACE_END
@@ -22,6 +22,7 @@
  * DiagSplit. For more algorithm details, see the DiagSplit paper or the
  * ARB_tessellation_shader OpenGL extension, Section 2.X.2. */
 
+#include "util_transform.h"
 #include "util_types.h"
 #include "util_vector.h"
 
@@ -56,17 +57,40 @@ struct SubdParams {
 
 };
 
+/* Dice Buffer
+ *
+ * Vertices and triangles diced from one or more patches. Patches are diced
+ * into separate buffers from multiple threads, which are appended to the
+ * mesh afterwards. Triangle vertex indices are relative to the start of the
+ * buffer. */
+
+struct DiceBuffer {
+	vector<float3> P;
+	vector<float3> N;
+	vector<float2> patch_uv;
+
+	vector<int> triangles;
+	vector<int> shader;
+	vector<int> patch_index;
+	vector<int> ptex_face_id;
+
+	size_t num_verts() const { return P.size(); }
+	size_t num_triangles() const { return shader.size(); }
+	size_t memory_size() const;
+
+	void append(const DiceBuffer& other);
+	void clear();
+};
+
 /* EdgeDice Base */
 
 class EdgeDice {
 public:
 	SubdParams params;
-	float3 *mesh_P;
-	float3 *mesh_N;
+	DiceBuffer *buffer;
 	size_t vert_offset;
-	size_t tri_offset;
 
-	explicit EdgeDice(const SubdParams& params);
+	EdgeDice(const SubdParams& params, DiceBuffer *buffer);
 
 	void reserve(int num_verts);
 
@@ -107,7 +131,7 @@ public:
 		int tv1;
 	};
 
-	explicit QuadDice(const SubdParams& params);
+	QuadDice(const SubdParams& params, DiceBuffer *buffer);
 
 	void reserve(EdgeFactors& ef, int Mu, int Mv);
 	float3 eval_projected(SubPatch& sub, float u, float v);
@@ -29,8 +29,9 @@ CCL_NAMESPACE_BEGIN
 
 /* DiagSplit */
 
-DiagSplit::DiagSplit(const SubdParams& params_)
-: params(params_)
+DiagSplit::DiagSplit(const SubdParams& params_, DiceBuffer *buffer_)
+: params(params_),
+  buffer(buffer_)
 {
 }
 
@@ -240,7 +241,7 @@ void DiagSplit::split_quad(Patch *patch, QuadDice::SubPatch *subpatch)
 
 	split(sub_split, ef_split);
 
-	QuadDice dice(params);
+	QuadDice dice(params, buffer);
 
 	for(size_t i = 0; i < subpatches_quad.size(); i++) {
 		QuadDice::SubPatch& sub = subpatches_quad[i];
@@ -40,8 +40,9 @@ public:
 	vector<QuadDice::EdgeFactors> edgefactors_quad;
 
 	SubdParams params;
+	DiceBuffer *buffer;
 
-	explicit DiagSplit(const SubdParams& params);
+	DiagSplit(const SubdParams& params, DiceBuffer *buffer);
 
 	float3 to_world(Patch *patch, float2 uv);
 	int T(Patch *patch, float2 Pstart, float2 Pend);
@@ -46,6 +46,9 @@ public:
 
 		/* Whether QBVH usage is allowed or not. */
 		bool qbvh;
+
+		/* Whether camera rays are allowed to be traced in packets. */
+		bool packets;
 	};
 
 	/* Descriptor of CUDA feature-set to be used. */
@@ -23,14 +23,14 @@ static Stats global_stats;
 
 /* Internal API. */
 
-void util_guarded_mem_alloc(size_t n)
+void util_guarded_mem_alloc(size_t n, MemoryCategory category)
 {
-	global_stats.mem_alloc(n);
+	global_stats.mem_alloc(n, category);
 }
 
-void util_guarded_mem_free(size_t n)
+void util_guarded_mem_free(size_t n, MemoryCategory category)
 {
-	global_stats.mem_free(n);
+	global_stats.mem_free(n, category);
 }
 
 /* Public API. */
@@ -45,5 +45,20 @@ size_t util_guarded_get_mem_peak(void)
 	return global_stats.mem_peak;
 }
 
+size_t util_guarded_get_mem_used(MemoryCategory category)
+{
+	return global_stats.category_used[category];
+}
+
+size_t util_guarded_get_mem_peak(MemoryCategory category)
+{
+	return global_stats.category_peak[category];
+}
+
+void util_guarded_reset_mem_peak(void)
+{
+	global_stats.reset_peak();
+}
+
 
 CCL_NAMESPACE_END
@@ -21,6 +21,7 @@
 #include <memory>
 
 #include "util_debug.h"
+#include "util_stats.h"
 #include "util_types.h"
 
 #ifdef WITH_BLENDER_GUARDEDALLOC
@@ -30,8 +31,8 @@
 CCL_NAMESPACE_BEGIN
 
 /* Internal use only. */
-void util_guarded_mem_alloc(size_t n);
-void util_guarded_mem_free(size_t n);
+void util_guarded_mem_alloc(size_t n, MemoryCategory category = MEM_CATEGORY_OTHER);
+void util_guarded_mem_free(size_t n, MemoryCategory category = MEM_CATEGORY_OTHER);
 
 /* Guarded allocator for the use with STL. */
 template <typename T>
@@ -164,6 +165,15 @@ public:
 size_t util_guarded_get_mem_used(void);
 size_t util_guarded_get_mem_peak(void);
 
+/* Same for a single category, STL containers are all accounted as other,
+ * arrays can be given a category. */
+size_t util_guarded_get_mem_used(MemoryCategory category);
+size_t util_guarded_get_mem_peak(MemoryCategory category);
+
+/* Reset peak usage to the current usage, so the peak of a single render
+ * can be measured when several renders run in the same process. */
+void util_guarded_reset_mem_peak(void);
+
 /* Call given function and keep track if it runs out of memory.
  *
  * If it does run out f memory, stop execution and set progress
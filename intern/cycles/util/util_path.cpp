@@ -15,6 +15,7 @@
  */
 
 #include "util_debug.h"
+#include "util_map.h"
 #include "util_md5.h"
 #include "util_path.h"
 #include "util_string.h"
@@ -26,6 +27,7 @@
 OIIO_NAMESPACE_USING
 
 #include <stdio.h>
+#include <algorithm>
 
 #include <sys/stat.h>
 
@@ -33,9 +35,11 @@ OIIO_NAMESPACE_USING
 #  define DIR_SEP '\\'
 #  define DIR_SEP_ALT '/'
 #  include <direct.h>
+#  include <sys/utime.h>
 #else
 #  define DIR_SEP '/'
 #  include <dirent.h>
+#  include <utime.h>
 #endif
 
 #ifdef HAVE_SHLWAPI_H
@@ -717,7 +721,7 @@ bool path_read_text(const string& path, string& text)
 uint64_t path_modified_time(const string& path)
 {
 	path_stat_t st;
-	if(path_stat(path, &st) != 0) {
+	if(path_stat(path, &st) == 0) {
 		return st.st_mtime;
 	}
 	return 0;
@@ -728,6 +732,25 @@ bool path_remove(const string& path)
 	return remove(path.c_str()) == 0;
 }
 
+bool path_rename(const string& from, const string& to)
+{
+#ifdef _WIN32
+	/* Existing files are not replaced on Windows. */
+	path_remove(to);
+#endif
+	return rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool path_touch(const string& path)
+{
+	/* NULL sets access and modification time to the current time. */
+#ifdef _WIN32
+	return _utime(path.c_str(), NULL) == 0;
+#else
+	return utime(path.c_str(), NULL) == 0;
+#endif
+}
+
 static string line_directive(const string& path, int line)
 {
 	string escaped_path = path;
@@ -813,5 +836,43 @@ void path_cache_clear_except(const string& name, const set<string>& except)
 
 }
 
+void path_cache_trim(const string& name, size_t max_size)
+{
+	string dir = path_user_get("cache");
+
+	if(!path_exists(dir))
+		return;
+
+	/* Least recently used files first, reads refresh the time with path_touch(). */
+	vector<pair<uint64_t, string> > files;
+	size_t total_size = 0;
+
+	directory_iterator it(dir), it_end;
+
+	for(; it != it_end; ++it) {
+		string filename = path_filename(it->path());
+
+		/* Skip temporary files still being written by another process. */
+		if(string_endswith(filename, ".tmp"))
+			continue;
+
+		if(string_startswith(filename, name.c_str())) {
+			string filepath = it->path();
+			files.push_back(std::make_pair(path_modified_time(filepath), filepath));
+			total_size += path_file_size(filepath);
+		}
+	}
+
+	std::sort(files.begin(), files.end());
+
+	for(size_t i = 0; i < files.size() && total_size > max_size; i++) {
+		size_t size = path_file_size(files[i].second);
+
+		/* Files still open by another process may fail to be removed. */
+		if(path_remove(files[i].second))
+			total_size -= size;
+	}
+}
+
 CCL_NAMESPACE_END
 
@@ -63,12 +63,15 @@ bool path_read_text(const string& path, string& text);
 
 /* File manipulation. */
 bool path_remove(const string& path);
+bool path_rename(const string& from, const string& to);
+bool path_touch(const string& path);
 
 /* source code utility */
 string path_source_replace_includes(const string& source, const string& path);
 
 /* cache utility */
 void path_cache_clear_except(const string& name, const set<string>& except);
+void path_cache_trim(const string& name, size_t max_size);
 
 CCL_NAMESPACE_END
 
@@ -36,6 +36,8 @@ public:
 	{
 		tile = 0;
 		sample = 0;
+		pixel_samples = 0;
+		tile_pixel_samples = 0;
 		start_time = time_dt();
 		total_time = 0.0;
 		render_time = 0.0;
@@ -65,6 +67,8 @@ public:
 		progress.get_tile(tile, total_time, render_time, tile_time);
 
 		sample = progress.get_sample();
+		pixel_samples = progress.pixel_samples;
+		tile_pixel_samples = progress.tile_pixel_samples;
 
 		return *this;
 	}
@@ -73,6 +77,8 @@ public:
 	{
 		tile = 0;
 		sample = 0;
+		pixel_samples = 0;
+		tile_pixel_samples = 0;
 		start_time = time_dt();
 		render_start_time = time_dt();
 		total_time = 0.0;
@@ -184,6 +190,8 @@ public:
 		thread_scoped_lock lock(progress_mutex);
 
 		sample = 0;
+		pixel_samples = 0;
+		tile_pixel_samples = 0;
 	}
 
 	void increment_sample()
@@ -193,6 +201,29 @@ public:
 		sample++;
 	}
 
+	/* Count one sample of a tile with tile_pixels pixels, of which only
+	 * pixel_samples_ were actually traced (adaptive sampling). */
+	void add_samples(int pixel_samples_, int tile_pixels)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		pixel_samples += pixel_samples_;
+		tile_pixel_samples += tile_pixels;
+		sample++;
+	}
+
+	/* Fraction of pixel samples which were traced, 1.0 without adaptive
+	 * sampling. */
+	float get_effective_sample_ratio()
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		if(tile_pixel_samples == 0)
+			return 1.0f;
+
+		return (float)((double)pixel_samples / (double)tile_pixel_samples);
+	}
+
 	void increment_sample_update()
 	{
 		increment_sample();
@@ -294,6 +325,8 @@ protected:
 
 	int tile;    /* counter for rendered tiles */
 	int sample;  /* counter of rendered samples, global for all tiles */
+	uint64_t pixel_samples;       /* counter of traced pixel samples */
+	uint64_t tile_pixel_samples;  /* counter of pixel samples without adaptive sampling */
 
 	double start_time, render_start_time;
 	double total_time, render_time;
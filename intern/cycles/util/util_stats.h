@@ -21,22 +21,83 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Categories for memory accounting, to find out what memory is used for
+ * when a render runs out of memory or to plan memory budgets. */
+
+enum MemoryCategory {
+	MEM_CATEGORY_OTHER = 0,
+	MEM_CATEGORY_BVH,
+	MEM_CATEGORY_MESH,
+	MEM_CATEGORY_ATTRIBUTES,
+	MEM_CATEGORY_OBJECTS,
+	MEM_CATEGORY_LIGHTS,
+	MEM_CATEGORY_PARTICLES,
+	MEM_CATEGORY_SHADERS,
+	MEM_CATEGORY_IMAGES,
+	MEM_CATEGORY_TABLES,
+	MEM_CATEGORY_RENDER_BUFFERS,
+
+	MEM_NUM_CATEGORIES
+};
+
+static inline const char *memory_category_name(MemoryCategory category)
+{
+	switch(category) {
+		case MEM_CATEGORY_OTHER: return "other";
+		case MEM_CATEGORY_BVH: return "bvh";
+		case MEM_CATEGORY_MESH: return "mesh";
+		case MEM_CATEGORY_ATTRIBUTES: return "attributes";
+		case MEM_CATEGORY_OBJECTS: return "objects";
+		case MEM_CATEGORY_LIGHTS: return "lights";
+		case MEM_CATEGORY_PARTICLES: return "particles";
+		case MEM_CATEGORY_SHADERS: return "shaders";
+		case MEM_CATEGORY_IMAGES: return "images";
+		case MEM_CATEGORY_TABLES: return "tables";
+		case MEM_CATEGORY_RENDER_BUFFERS: return "render_buffers";
+		case MEM_NUM_CATEGORIES: break;
+	}
+	return "unknown";
+}
+
 class Stats {
 public:
-	Stats() : mem_used(0), mem_peak(0) {}
+	Stats() : mem_used(0), mem_peak(0)
+	{
+		for(int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+			category_used[i] = 0;
+			category_peak[i] = 0;
+		}
+	}
 
-	void mem_alloc(size_t size) {
+	void mem_alloc(size_t size, MemoryCategory category = MEM_CATEGORY_OTHER) {
 		atomic_add_z(&mem_used, size);
 		atomic_update_max_z(&mem_peak, mem_used);
+
+		atomic_add_z(&category_used[category], size);
+		atomic_update_max_z(&category_peak[category], category_used[category]);
 	}
 
-	void mem_free(size_t size) {
+	void mem_free(size_t size, MemoryCategory category = MEM_CATEGORY_OTHER) {
 		assert(mem_used >= size);
+		assert(category_used[category] >= size);
 		atomic_sub_z(&mem_used, size);
+		atomic_sub_z(&category_used[category], size);
+	}
+
+	/* measure peaks again starting from the current usage */
+	void reset_peak() {
+		mem_peak = mem_used;
+		for(int i = 0; i < MEM_NUM_CATEGORIES; i++)
+			category_peak[i] = category_used[i];
 	}
 
 	size_t mem_used;
 	size_t mem_peak;
+
+	/* per category usage and peak, peaks of different categories need not
+	 * happen at the same time so they don't add up to mem_peak */
+	size_t category_used[MEM_NUM_CATEGORIES];
+	size_t category_peak[MEM_NUM_CATEGORIES];
 };
 
 CCL_NAMESPACE_END
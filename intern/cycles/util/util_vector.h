@@ -86,7 +86,8 @@ public:
  *   this was actually showing up in profiles quite significantly. it
  *   also does not run any constructors/destructors
  * - if this is used, we are not tempted to use inefficient operations
- * - aligned allocation for SSE data types */
+ * - aligned allocation for SSE data types
+ * - memory is accounted to a category, to find out what uses memory */
 
 template<typename T, size_t alignment = 16>
 class array
@@ -95,10 +96,12 @@ public:
 	array()
 	: data_(NULL),
 	  datasize_(0),
-	  capacity_(0)
+	  capacity_(0),
+	  category_(MEM_CATEGORY_OTHER)
 	{}
 
 	explicit array(size_t newsize)
+	: category_(MEM_CATEGORY_OTHER)
 	{
 		if(newsize == 0) {
 			data_ = NULL;
@@ -113,6 +116,7 @@ public:
 	}
 
 	array(const array& from)
+	: category_(from.category_)
 	{
 		if(from.datasize_ == 0) {
 			data_ = NULL;
@@ -167,6 +171,12 @@ public:
 		if(this != &from) {
 			clear();
 
+			/* memory was accounted to the other array */
+			if(from.category_ != category_ && from.capacity_ > 0) {
+				util_guarded_mem_free(from.capacity_*sizeof(T), from.category_);
+				util_guarded_mem_alloc(from.capacity_*sizeof(T), category_);
+			}
+
 			data_ = from.data_;
 			datasize_ = from.datasize_;
 			capacity_ = from.capacity_;
@@ -256,6 +266,20 @@ public:
 		return capacity_;
 	}
 
+	void set_mem_category(MemoryCategory category)
+	{
+		if(category != category_ && capacity_ > 0) {
+			util_guarded_mem_free(capacity_*sizeof(T), category_);
+			util_guarded_mem_alloc(capacity_*sizeof(T), category);
+		}
+		category_ = category;
+	}
+
+	MemoryCategory mem_category() const
+	{
+		return category_;
+	}
+
 	// do not use this method unless you are sure the code is not performance critical
 	void push_back_slow(const T& t)
 	{
@@ -281,7 +305,7 @@ protected:
 		}
 		T *mem = (T*)util_aligned_malloc(sizeof(T)*N, alignment);
 		if(mem != NULL) {
-			util_guarded_mem_alloc(sizeof(T)*N);
+			util_guarded_mem_alloc(sizeof(T)*N, category_);
 		}
 		else {
 			throw std::bad_alloc();
@@ -292,7 +316,7 @@ protected:
 	inline void mem_free(T *mem, size_t N)
 	{
 		if(mem != NULL) {
-			util_guarded_mem_free(sizeof(T)*N);
+			util_guarded_mem_free(sizeof(T)*N, category_);
 			util_aligned_free(mem);
 		}
 	}
@@ -300,6 +324,7 @@ protected:
 	T *data_;
 	size_t datasize_;
 	size_t capacity_;
+	MemoryCategory category_;
 };
 
 CCL_NAMESPACE_END
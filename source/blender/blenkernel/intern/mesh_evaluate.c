@@ -254,6 +254,12 @@ void BKE_mesh_calc_normals_poly(
 	bool free_vnors = false;
 	int i;
 
+	/* Cheap iterations of varying cost (polygon sizes), let chunk sizes follow the measured cost. */
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (numPolys > BKE_MESH_OMP_LIMIT);
+	settings.scheduling_mode = TASK_SCHEDULING_ADAPTIVE;
+
 	if (only_face_normals) {
 		BLI_assert((pnors != NULL) || (numPolys == 0));
 		BLI_assert(r_vertnors == NULL);
@@ -262,7 +268,7 @@ void BKE_mesh_calc_normals_poly(
 		    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = pnors,
 		};
 
-		BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_task_cb, (numPolys > BKE_MESH_OMP_LIMIT));
+		BLI_task_parallel_range_with_settings(0, numPolys, &data, mesh_calc_normals_poly_task_cb, &settings);
 		return;
 	}
 
@@ -279,7 +285,7 @@ void BKE_mesh_calc_normals_poly(
 	    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = pnors, .vnors = vnors,
 	};
 
-	BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_accum_task_cb, (numPolys > BKE_MESH_OMP_LIMIT));
+	BLI_task_parallel_range_with_settings(0, numPolys, &data, mesh_calc_normals_poly_accum_task_cb, &settings);
 
 	for (i = 0; i < numVerts; i++) {
 		MVert *mv = &mverts[i];
@@ -144,6 +144,47 @@ void BLI_task_parallel_range_finalize(
         const bool use_threading,
         const bool use_dynamic_scheduling);
 
+/* How iterations of a parallel range are handed out to the tasks. */
+typedef enum eTaskSchedulingMode {
+	/* A few big chunks of equal size (num_threads * 2 chunks). */
+	TASK_SCHEDULING_STATIC = 0,
+	/* Small chunks of fixed size (min_iter_per_chunk, 32 by default). */
+	TASK_SCHEDULING_DYNAMIC = 1,
+	/* Chunks proportional to the remaining iterations, shrinking down to min_iter_per_chunk. */
+	TASK_SCHEDULING_GUIDED = 2,
+	/* Like guided, but each task sizes its chunks from the measured time per iteration,
+	 * best for cheap iterations of unknown or varying cost. */
+	TASK_SCHEDULING_ADAPTIVE = 3,
+} eTaskSchedulingMode;
+
+typedef struct ParallelRangeSettings {
+	/* If false, just do a sequential forloop in the calling thread. */
+	bool use_threading;
+	eTaskSchedulingMode scheduling_mode;
+	/* Grain size hint, smallest number of iterations handed out at once (0 for the mode's default).
+	 * Ranges not bigger than this are not threaded at all. */
+	int min_iter_per_chunk;
+} ParallelRangeSettings;
+
+typedef void (*TaskParallelRangeFuncReduce)(void *userdata, void *userdata_chunk_join, void *userdata_chunk);
+
+void BLI_parallel_range_settings_defaults(ParallelRangeSettings *settings);
+
+void BLI_task_parallel_range_with_settings(
+        int start, int stop,
+        void *userdata,
+        TaskParallelRangeFunc func,
+        const ParallelRangeSettings *settings);
+
+void BLI_task_parallel_reduce(
+        int start, int stop,
+        void *userdata,
+        void *userdata_chunk,
+        const size_t userdata_chunk_size,
+        TaskParallelRangeFuncEx func_ex,
+        TaskParallelRangeFuncReduce func_reduce,
+        const ParallelRangeSettings *settings);
+
 typedef void (*TaskParallelListbaseFunc)(void *userdata,
                                          struct Link *iter,
                                          int index);
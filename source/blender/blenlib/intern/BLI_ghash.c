@@ -39,6 +39,10 @@
 #include <stdarg.h>
 #include <limits.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_sys_types.h"  /* for intptr_t support */
@@ -97,6 +101,20 @@ typedef Entry GSetEntry;
 #define GHASH_ENTRY_SIZE(_is_gset) \
 	((_is_gset) ? sizeof(GSetEntry) : sizeof(GHashEntry))
 
+/* Entries of flat storage (see #GHASH_FLAG_FLAT), the full hash takes the place of 'next'.
+ * WARNING! Keep in sync with ugly _gh_Entry in header too, iterators use it for both storages. */
+typedef struct FlatEntry {
+	uintptr_t hash;
+
+	void *key;
+} FlatEntry;
+
+typedef struct GHashFlatEntry {
+	FlatEntry e;
+
+	void *val;
+} GHashFlatEntry;
+
 struct GHash {
 	GHashHashFP hashfp;
 	GHashCmpFP cmpfp;
@@ -111,6 +129,11 @@ struct GHash {
 	unsigned int bucket_mask, bucket_bit, bucket_bit_min;
 #endif
 
+	/* Flat storage (buckets and entrypool are unused then), nbuckets is the number of slots. */
+	void *slots;
+	unsigned char *ctrl;
+	unsigned int growth_left;
+
 	unsigned int nentries;
 	unsigned int flag;
 };
@@ -132,6 +155,431 @@ BLI_INLINE void ghash_entry_copy(
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/* Flat Storage */
+
+/** \name Flat Storage Internal API
+ *
+ * Open addressing storage, used instead of buckets when #GHASH_FLAG_FLAT is set.
+ * Entries live directly in a power of two sized array of slots, which avoids an allocation per insertion
+ * and chasing 'next' pointers on lookups.
+ *
+ * Each slot has a control byte, either #GHASH_FLAT_CTRL_EMPTY, #GHASH_FLAT_CTRL_DELETED,
+ * or the 7 highest bits of the hash of its entry. Lookups compare a whole group of control bytes at once
+ * (using SSE2 when available), and only call the comparison callback for the few matching slots.
+ * Control bytes of the first group are cloned after the last slot, so a group can start at any slot.
+ *
+ * \note Unlike with buckets, entries move when the table grows, so pointers returned by
+ * #BLI_ghash_lookup_p, #BLI_ghash_ensure_p and co are only valid until the next insertion.
+ * \{ */
+
+#define GHASH_FLAT_GROUP_SIZE 16
+#define GHASH_FLAT_GROUP_MASK 0xffffu
+
+#define GHASH_FLAT_CTRL_EMPTY   0x80
+#define GHASH_FLAT_CTRL_DELETED 0xfe
+/* Used slots have the high bit cleared. */
+#define GHASH_FLAT_CTRL_IS_USED(_c) (((_c) & 0x80) == 0)
+#define GHASH_FLAT_CTRL_FROM_HASH(_hash) ((unsigned char)((_hash) >> 25))
+
+#define GHASH_FLAT_SLOTS_MIN GHASH_FLAT_GROUP_SIZE
+#define GHASH_FLAT_SLOTS_MAX (1u << 31)
+
+/**
+ * Max load is 7/8, group probing stays quick up to much higher loads than chaining.
+ */
+#define GHASH_FLAT_LIMIT_GROW(_nslots) ((_nslots) - ((_nslots) / 8))
+
+#define GHASH_FLAT_ENTRY_SIZE(_is_gset) \
+	((_is_gset) ? sizeof(FlatEntry) : sizeof(GHashFlatEntry))
+
+BLI_INLINE size_t ghash_flat_entry_size(GHash *gh)
+{
+	return GHASH_FLAT_ENTRY_SIZE(gh->flag & GHASH_FLAG_IS_GSET);
+}
+
+BLI_INLINE FlatEntry *ghash_flat_entry(GHash *gh, const unsigned int index)
+{
+	return (FlatEntry *)((char *)gh->slots + (size_t)index * ghash_flat_entry_size(gh));
+}
+
+/**
+ * Get the full hash for a key, mixed since callbacks like #BLI_ghashutil_ptrhash
+ * only have good entropy in some of their bits (MurmurHash3 finalizer).
+ */
+BLI_INLINE unsigned int ghash_flat_keyhash(GHash *gh, const void *key)
+{
+	unsigned int hash = gh->hashfp(key);
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+BLI_INLINE unsigned int ghash_flat_bitscan_forward(const unsigned int mask)
+{
+	BLI_assert(mask != 0);
+#ifdef __GNUC__
+	return (unsigned int)__builtin_ctz(mask);
+#else
+	unsigned int i = 0;
+	while ((mask & (1u << i)) == 0) {
+		i++;
+	}
+	return i;
+#endif
+}
+
+BLI_INLINE unsigned int ghash_flat_bitscan_reverse(const unsigned int mask)
+{
+	BLI_assert(mask != 0);
+#ifdef __GNUC__
+	return 31u - (unsigned int)__builtin_clz(mask);
+#else
+	unsigned int i = 31;
+	while ((mask & (1u << i)) == 0) {
+		i--;
+	}
+	return i;
+#endif
+}
+
+/**
+ * Bit mask of the slots of the group starting at \a ctrl having control byte \a c.
+ */
+BLI_INLINE unsigned int ghash_flat_group_match(const unsigned char *ctrl, const unsigned char c)
+{
+#ifdef __SSE2__
+	const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+	unsigned int mask = 0, i;
+	for (i = 0; i < GHASH_FLAT_GROUP_SIZE; i++) {
+		mask |= (unsigned int)(ctrl[i] == c) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * Bit mask of the empty or deleted slots of the group starting at \a ctrl.
+ */
+BLI_INLINE unsigned int ghash_flat_group_match_free(const unsigned char *ctrl)
+{
+#ifdef __SSE2__
+	return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+	unsigned int mask = 0, i;
+	for (i = 0; i < GHASH_FLAT_GROUP_SIZE; i++) {
+		mask |= (unsigned int)(!GHASH_FLAT_CTRL_IS_USED(ctrl[i])) << i;
+	}
+	return mask;
+#endif
+}
+
+BLI_INLINE void ghash_flat_ctrl_set(GHash *gh, const unsigned int index, const unsigned char c)
+{
+	gh->ctrl[index] = c;
+	/* Keep the clone of the first group in sync. */
+	if (index < GHASH_FLAT_GROUP_SIZE - 1) {
+		gh->ctrl[gh->nbuckets + index] = c;
+	}
+}
+
+/**
+ * Number of slots needed to hold \a nentries without growing.
+ */
+static unsigned int ghash_flat_nslots_for(const unsigned int nentries)
+{
+	unsigned int nslots = GHASH_FLAT_SLOTS_MIN;
+
+	while ((GHASH_FLAT_LIMIT_GROW(nslots) < nentries) && (nslots < GHASH_FLAT_SLOTS_MAX)) {
+		nslots <<= 1;
+	}
+	return nslots;
+}
+
+/**
+ * Find the first empty or deleted slot along the probing sequence of \a hash.
+ *
+ * Groups are probed in triangular steps, which visits all groups of a power of two sized table.
+ */
+BLI_INLINE unsigned int ghash_flat_find_free_index(GHash *gh, const unsigned int hash)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	unsigned int pos = hash & mask, step = 0;
+
+	while (true) {
+		const unsigned int match = ghash_flat_group_match_free(gh->ctrl + pos);
+		if (match) {
+			return (pos + ghash_flat_bitscan_forward(match)) & mask;
+		}
+		step += GHASH_FLAT_GROUP_SIZE;
+		pos = (pos + step) & mask;
+	}
+}
+
+/**
+ * Find the slot holding \a key, or UINT_MAX.
+ */
+BLI_INLINE unsigned int ghash_flat_lookup_index(GHash *gh, const void *key, const unsigned int hash)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	const unsigned char c = GHASH_FLAT_CTRL_FROM_HASH(hash);
+	unsigned int pos = hash & mask, step = 0;
+
+	while (true) {
+		const unsigned char *ctrl = gh->ctrl + pos;
+		unsigned int match;
+
+		for (match = ghash_flat_group_match(ctrl, c); match; match &= match - 1) {
+			const unsigned int index = (pos + ghash_flat_bitscan_forward(match)) & mask;
+			const FlatEntry *e = ghash_flat_entry(gh, index);
+			if ((e->hash == hash) && (gh->cmpfp(key, e->key) == false)) {
+				return index;
+			}
+		}
+		/* Insertion stops at the first empty slot, so the key can't be further. */
+		if (ghash_flat_group_match(ctrl, GHASH_FLAT_CTRL_EMPTY)) {
+			return UINT_MAX;
+		}
+		step += GHASH_FLAT_GROUP_SIZE;
+		pos = (pos + step) & mask;
+	}
+}
+
+BLI_INLINE FlatEntry *ghash_flat_lookup_entry(GHash *gh, const void *key)
+{
+	const unsigned int index = ghash_flat_lookup_index(gh, key, ghash_flat_keyhash(gh, key));
+	return (index != UINT_MAX) ? ghash_flat_entry(gh, index) : NULL;
+}
+
+/**
+ * Find the index of next used slot, starting from \a index, or nbuckets when there is none.
+ */
+BLI_INLINE unsigned int ghash_flat_find_next_index(GHash *gh, unsigned int index)
+{
+	while (index < gh->nbuckets) {
+		const unsigned int match = ~ghash_flat_group_match_free(gh->ctrl + index) & GHASH_FLAT_GROUP_MASK;
+		if (match) {
+			/* Matches in the cloned group past the last slot are not new entries. */
+			return MIN2(index + ghash_flat_bitscan_forward(match), gh->nbuckets);
+		}
+		index += GHASH_FLAT_GROUP_SIZE;
+	}
+	return gh->nbuckets;
+}
+
+/**
+ * Move all entries to a new slots array of \a nslots, dropping deleted slots.
+ */
+static void ghash_flat_resize(GHash *gh, const unsigned int nslots)
+{
+	const size_t entry_size = ghash_flat_entry_size(gh);
+	const unsigned int nslots_old = gh->nbuckets;
+	void *slots_old = gh->slots;
+	unsigned char *ctrl_old = gh->ctrl;
+	unsigned int i;
+
+	BLI_assert(GHASH_FLAT_LIMIT_GROW(nslots) >= gh->nentries);
+
+	gh->nbuckets = nslots;
+	gh->growth_left = GHASH_FLAT_LIMIT_GROW(nslots) - gh->nentries;
+	gh->slots = MEM_mallocN(entry_size * nslots + nslots + GHASH_FLAT_GROUP_SIZE, __func__);
+	gh->ctrl = (unsigned char *)gh->slots + entry_size * nslots;
+	memset(gh->ctrl, GHASH_FLAT_CTRL_EMPTY, nslots + GHASH_FLAT_GROUP_SIZE);
+
+	if (slots_old) {
+		for (i = 0; i < nslots_old; i++) {
+			if (GHASH_FLAT_CTRL_IS_USED(ctrl_old[i])) {
+				const FlatEntry *e_old = (const FlatEntry *)((char *)slots_old + entry_size * i);
+				const unsigned int hash = (unsigned int)e_old->hash;
+				const unsigned int index = ghash_flat_find_free_index(gh, hash);
+
+				ghash_flat_ctrl_set(gh, index, GHASH_FLAT_CTRL_FROM_HASH(hash));
+				memcpy(ghash_flat_entry(gh, index), e_old, entry_size);
+			}
+		}
+		MEM_freeN(slots_old);
+	}
+}
+
+/**
+ * Clear and reset \a gh slots, reserve again slots for given number of entries.
+ */
+static void ghash_flat_reset(GHash *gh, const unsigned int nentries)
+{
+	MEM_SAFE_FREE(gh->slots);
+	gh->ctrl = NULL;
+	gh->nbuckets = 0;
+	gh->nentries = 0;
+
+	ghash_flat_resize(gh, ghash_flat_nslots_for(nentries));
+}
+
+/**
+ * Add a new entry for \a hash (existing keys are not checked), the caller must set its key and value.
+ */
+static FlatEntry *ghash_flat_insert_entry(GHash *gh, const unsigned int hash)
+{
+	unsigned int index = ghash_flat_find_free_index(gh, hash);
+	FlatEntry *e;
+
+	if (UNLIKELY((gh->growth_left == 0) && (gh->ctrl[index] == GHASH_FLAT_CTRL_EMPTY))) {
+		/* When many slots are just deleted, dropping them is enough. */
+		if ((gh->nentries < GHASH_FLAT_LIMIT_GROW(gh->nbuckets) / 2) || (gh->nbuckets == GHASH_FLAT_SLOTS_MAX)) {
+			ghash_flat_resize(gh, gh->nbuckets);
+		}
+		else {
+			ghash_flat_resize(gh, gh->nbuckets * 2);
+		}
+		index = ghash_flat_find_free_index(gh, hash);
+	}
+
+	if (gh->ctrl[index] == GHASH_FLAT_CTRL_EMPTY) {
+		gh->growth_left--;
+	}
+	ghash_flat_ctrl_set(gh, index, GHASH_FLAT_CTRL_FROM_HASH(hash));
+	gh->nentries++;
+
+	e = ghash_flat_entry(gh, index);
+	e->hash = hash;
+	return e;
+}
+
+/**
+ * Lookup \a key, adding a new entry for it if needed (the caller must then set its value).
+ */
+BLI_INLINE FlatEntry *ghash_flat_ensure_entry(GHash *gh, const void *key, bool *r_haskey)
+{
+	const unsigned int hash = ghash_flat_keyhash(gh, key);
+	const unsigned int index = ghash_flat_lookup_index(gh, key, hash);
+	FlatEntry *e;
+
+	if (index != UINT_MAX) {
+		*r_haskey = true;
+		return ghash_flat_entry(gh, index);
+	}
+
+	e = ghash_flat_insert_entry(gh, hash);
+	e->key = (void *)key;
+	*r_haskey = false;
+	return e;
+}
+
+/**
+ * Remove the entry in slot \a index, its key and value must have been freed by the caller if needed.
+ */
+static void ghash_flat_remove_index(GHash *gh, const unsigned int index)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	const unsigned int empty_after = ghash_flat_group_match(gh->ctrl + index, GHASH_FLAT_CTRL_EMPTY);
+	const unsigned int empty_before = ghash_flat_group_match(
+	        gh->ctrl + ((index - GHASH_FLAT_GROUP_SIZE) & mask), GHASH_FLAT_CTRL_EMPTY);
+
+	BLI_assert(GHASH_FLAT_CTRL_IS_USED(gh->ctrl[index]));
+
+	/* If the run of used slots around this one is shorter than a group, no lookup ever probed past it,
+	 * so it can be empty again. Otherwise it has to stay a 'deleted' marker, which lookups step over. */
+	if (empty_before && empty_after &&
+	    (ghash_flat_bitscan_forward(empty_after) +
+	     (GHASH_FLAT_GROUP_SIZE - 1 - ghash_flat_bitscan_reverse(empty_before))) < GHASH_FLAT_GROUP_SIZE)
+	{
+		ghash_flat_ctrl_set(gh, index, GHASH_FLAT_CTRL_EMPTY);
+		gh->growth_left++;
+	}
+	else {
+		ghash_flat_ctrl_set(gh, index, GHASH_FLAT_CTRL_DELETED);
+	}
+
+	gh->nentries--;
+}
+
+/**
+ * Remove \a key, returning its entry (only valid until next insertion) or NULL.
+ */
+static FlatEntry *ghash_flat_remove(
+        GHash *gh, const void *key,
+        GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const unsigned int index = ghash_flat_lookup_index(gh, key, ghash_flat_keyhash(gh, key));
+	FlatEntry *e;
+
+	BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
+
+	if (index == UINT_MAX) {
+		return NULL;
+	}
+
+	e = ghash_flat_entry(gh, index);
+	if (keyfreefp) {
+		keyfreefp(e->key);
+	}
+	if (valfreefp) {
+		valfreefp(((GHashFlatEntry *)e)->val);
+	}
+
+	ghash_flat_remove_index(gh, index);
+	return e;
+}
+
+/**
+ * Remove a random entry and return it (only valid until next insertion) or NULL if empty.
+ */
+static FlatEntry *ghash_flat_pop(GHash *gh, GHashIterState *state)
+{
+	unsigned int index;
+	FlatEntry *e;
+
+	if (gh->nentries == 0) {
+		return NULL;
+	}
+
+	index = ghash_flat_find_next_index(gh, state->curr_bucket);
+	if (index == gh->nbuckets) {
+		index = ghash_flat_find_next_index(gh, 0);
+	}
+
+	e = ghash_flat_entry(gh, index);
+	ghash_flat_remove_index(gh, index);
+
+	state->curr_bucket = index;
+	return e;
+}
+
+/**
+ * Run free callbacks for freeing entries.
+ */
+static void ghash_flat_free_cb(
+        GHash *gh,
+        GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	unsigned int i;
+
+	BLI_assert(keyfreefp  || valfreefp);
+	BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
+
+	for (i = 0; i < gh->nbuckets; i++) {
+		if (GHASH_FLAT_CTRL_IS_USED(gh->ctrl[i])) {
+			FlatEntry *e = ghash_flat_entry(gh, i);
+
+			if (keyfreefp) {
+				keyfreefp(e->key);
+			}
+			if (valfreefp) {
+				valfreefp(((GHashFlatEntry *)e)->val);
+			}
+		}
+	}
+}
+
+/** \} */
+
+
 /* -------------------------------------------------------------------- */
 /* GHash API */
 
@@ -424,6 +872,10 @@ BLI_INLINE Entry *ghash_lookup_entry_prev_ex(
  */
 BLI_INLINE Entry *ghash_lookup_entry(GHash *gh, const void *key)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		return (Entry *)ghash_flat_lookup_entry(gh, key);
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	return ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -438,10 +890,18 @@ static GHash *ghash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
 	gh->cmpfp = cmpfp;
 
 	gh->buckets = NULL;
+	gh->slots = NULL;
+	gh->ctrl = NULL;
 	gh->flag = flag;
 
-	ghash_buckets_reset(gh, nentries_reserve);
-	gh->entrypool = BLI_mempool_create(GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET), 64, 64, BLI_MEMPOOL_NOP);
+	if (flag & GHASH_FLAG_FLAT) {
+		gh->entrypool = NULL;
+		ghash_flat_reset(gh, nentries_reserve);
+	}
+	else {
+		ghash_buckets_reset(gh, nentries_reserve);
+		gh->entrypool = BLI_mempool_create(GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET), 64, 64, BLI_MEMPOOL_NOP);
+	}
 
 	return gh;
 }
@@ -502,6 +962,18 @@ BLI_INLINE void ghash_insert_ex_keyonly(
 
 BLI_INLINE void ghash_insert(GHash *gh, void *key, void *val)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		GHashFlatEntry *e;
+
+		BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
+		BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+
+		e = (GHashFlatEntry *)ghash_flat_insert_entry(gh, ghash_flat_keyhash(gh, key));
+		e->e.key = key;
+		e->val = val;
+		return;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 
@@ -512,12 +984,31 @@ BLI_INLINE bool ghash_insert_safe(
         GHash *gh, void *key, void *val, const bool override,
         GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
+	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		bool haskey;
+		GHashFlatEntry *e = (GHashFlatEntry *)ghash_flat_ensure_entry(gh, key, &haskey);
+
+		if (haskey && override) {
+			if (keyfreefp) {
+				keyfreefp(e->e.key);
+			}
+			if (valfreefp) {
+				valfreefp(e->val);
+			}
+		}
+		if (!haskey || override) {
+			e->e.key = key;
+			e->val = val;
+		}
+		return !haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
 
-	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
-
 	if (e) {
 		if (override) {
 			if (keyfreefp) {
@@ -541,12 +1032,25 @@ BLI_INLINE bool ghash_insert_safe_keyonly(
         GHash *gh, void *key, const bool override,
         GHashKeyFreeFP keyfreefp)
 {
+	BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
+
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		bool haskey;
+		FlatEntry *e = ghash_flat_ensure_entry(gh, key, &haskey);
+
+		if (haskey && override) {
+			if (keyfreefp) {
+				keyfreefp(e->key);
+			}
+			e->key = key;
+		}
+		return !haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	Entry *e = ghash_lookup_entry_ex(gh, key, bucket_index);
 
-	BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
-
 	if (e) {
 		if (override) {
 			if (keyfreefp) {
@@ -631,6 +1135,11 @@ static void ghash_free_cb(
 	BLI_assert(keyfreefp  || valfreefp);
 	BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		ghash_flat_free_cb(gh, keyfreefp, valfreefp);
+		return;
+	}
+
 	for (i = 0; i < gh->nbuckets; i++) {
 		Entry *e;
 
@@ -645,6 +1154,35 @@ static void ghash_free_cb(
 	}
 }
 
+/**
+ * Copy the flat GHash.
+ */
+static GHash *ghash_flat_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcopyfp)
+{
+	GHash *gh_new = ghash_new(gh->hashfp, gh->cmpfp, __func__, 0, gh->flag);
+	unsigned int i;
+
+	BLI_assert(!valcopyfp || !(gh->flag & GHASH_FLAG_IS_GSET));
+
+	/* Same slots, so entries can be copied in place. */
+	ghash_flat_resize(gh_new, gh->nbuckets);
+	memcpy(gh_new->slots, gh->slots,
+	       ghash_flat_entry_size(gh) * gh->nbuckets + gh->nbuckets + GHASH_FLAT_GROUP_SIZE);
+	gh_new->nentries = gh->nentries;
+	gh_new->growth_left = gh->growth_left;
+
+	if (keycopyfp || valcopyfp) {
+		for (i = 0; i < gh->nbuckets; i++) {
+			if (GHASH_FLAT_CTRL_IS_USED(gh->ctrl[i])) {
+				ghash_entry_copy(gh_new, (Entry *)ghash_flat_entry(gh_new, i),
+				                 gh, (Entry *)ghash_flat_entry(gh, i), keycopyfp, valcopyfp);
+			}
+		}
+	}
+
+	return gh_new;
+}
+
 /**
  * Copy the GHash.
  */
@@ -657,6 +1195,10 @@ static GHash *ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP val
 
 	BLI_assert(!valcopyfp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		return ghash_flat_copy(gh, keycopyfp, valcopyfp);
+	}
+
 	gh_new = ghash_new(gh->hashfp, gh->cmpfp, __func__, 0, gh->flag);
 	ghash_buckets_expand(gh_new, reserve_nentries_new, false);
 
@@ -713,6 +1255,25 @@ GHash *BLI_ghash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
 	return BLI_ghash_new_ex(hashfp, cmpfp, info, 0);
 }
 
+/**
+ * Creates a new, empty GHash using flat storage (see #GHASH_FLAG_FLAT).
+ *
+ * Same parameters as #BLI_ghash_new_ex.
+ */
+GHash *BLI_ghash_flat_new_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                             const unsigned int nentries_reserve)
+{
+	return ghash_new(hashfp, cmpfp, info, nentries_reserve, GHASH_FLAG_FLAT);
+}
+
+/**
+ * Wraps #BLI_ghash_flat_new_ex with zero entries reserved.
+ */
+GHash *BLI_ghash_flat_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
+{
+	return BLI_ghash_flat_new_ex(hashfp, cmpfp, info, 0);
+}
+
 /**
  * Copy given GHash. Keys and values are also copied if relevant callback is provided, else pointers remain the same.
  */
@@ -726,6 +1287,14 @@ GHash *BLI_ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcop
  */
 void BLI_ghash_reserve(GHash *gh, const unsigned int nentries_reserve)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		const unsigned int nslots = ghash_flat_nslots_for(nentries_reserve);
+		if (nslots > gh->nbuckets) {
+			ghash_flat_resize(gh, nslots);
+		}
+		return;
+	}
+
 	ghash_buckets_expand(gh, nentries_reserve, true);
 	ghash_buckets_contract(gh, nentries_reserve, true, false);
 }
@@ -821,6 +1390,13 @@ void **BLI_ghash_lookup_p(GHash *gh, const void *key)
  */
 bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		bool haskey;
+		GHashFlatEntry *e = (GHashFlatEntry *)ghash_flat_ensure_entry(gh, key, &haskey);
+		*r_val = &e->val;
+		return haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -844,6 +1420,17 @@ bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 bool BLI_ghash_ensure_p_ex(
         GHash *gh, const void *key, void ***r_key, void ***r_val)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		bool haskey;
+		GHashFlatEntry *e = (GHashFlatEntry *)ghash_flat_ensure_entry(gh, key, &haskey);
+		if (!haskey) {
+			e->e.key = NULL;  /* caller must re-assign */
+		}
+		*r_key = &e->e.key;
+		*r_val = &e->val;
+		return haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -871,6 +1458,10 @@ bool BLI_ghash_ensure_p_ex(
  */
 bool BLI_ghash_remove(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		return (ghash_flat_remove(gh, key, keyfreefp, valfreefp) != NULL);
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	Entry *e = ghash_remove_ex(gh, key, keyfreefp, valfreefp, bucket_index);
@@ -894,6 +1485,12 @@ bool BLI_ghash_remove(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp, GHas
  */
 void *BLI_ghash_popkey(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp)
 {
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		GHashFlatEntry *e = (GHashFlatEntry *)ghash_flat_remove(gh, key, keyfreefp, NULL);
+		BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+		return e ? e->val : NULL;
+	}
+
 	const unsigned int hash = ghash_keyhash(gh, key);
 	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_remove_ex(gh, key, keyfreefp, NULL, bucket_index);
@@ -928,10 +1525,21 @@ bool BLI_ghash_pop(
         GHash *gh, GHashIterState *state,
         void **r_key, void **r_val)
 {
-	GHashEntry *e = (GHashEntry *)ghash_pop(gh, state);
-
 	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
 
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		GHashFlatEntry *e = (GHashFlatEntry *)ghash_flat_pop(gh, state);
+		if (e) {
+			*r_key = e->e.key;
+			*r_val = e->val;
+			return true;
+		}
+		*r_key = *r_val = NULL;
+		return false;
+	}
+
+	GHashEntry *e = (GHashEntry *)ghash_pop(gh, state);
+
 	if (e) {
 		*r_key = e->e.key;
 		*r_val = e->val;
@@ -958,6 +1566,11 @@ void BLI_ghash_clear_ex(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valf
 	if (keyfreefp || valfreefp)
 		ghash_free_cb(gh, keyfreefp, valfreefp);
 
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		ghash_flat_reset(gh, nentries_reserve);
+		return;
+	}
+
 	ghash_buckets_reset(gh, nentries_reserve);
 	BLI_mempool_clear_ex(gh->entrypool, nentries_reserve ? (int)nentries_reserve : -1);
 }
@@ -979,12 +1592,17 @@ void BLI_ghash_clear(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfree
  */
 void BLI_ghash_free(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
-	BLI_assert((int)gh->nentries == BLI_mempool_count(gh->entrypool));
+	BLI_assert((gh->flag & GHASH_FLAG_FLAT) || ((int)gh->nentries == BLI_mempool_count(gh->entrypool)));
 	if (keyfreefp || valfreefp)
 		ghash_free_cb(gh, keyfreefp, valfreefp);
 
-	MEM_freeN(gh->buckets);
-	BLI_mempool_destroy(gh->entrypool);
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		MEM_freeN(gh->slots);
+	}
+	else {
+		MEM_freeN(gh->buckets);
+		BLI_mempool_destroy(gh->entrypool);
+	}
 	MEM_freeN(gh);
 }
 
@@ -993,6 +1611,8 @@ void BLI_ghash_free(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreef
  */
 void BLI_ghash_flag_set(GHash *gh, unsigned int flag)
 {
+	/* Storage can only be chosen on creation. */
+	BLI_assert((flag & GHASH_FLAG_FLAT) == 0);
 	gh->flag |= flag;
 }
 
@@ -1001,6 +1621,7 @@ void BLI_ghash_flag_set(GHash *gh, unsigned int flag)
  */
 void BLI_ghash_flag_clear(GHash *gh, unsigned int flag)
 {
+	BLI_assert((flag & GHASH_FLAG_FLAT) == 0);
 	gh->flag &= ~flag;
 }
 
@@ -1040,6 +1661,13 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
 {
 	ghi->gh = gh;
 	ghi->curEntry = NULL;
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		ghi->curBucket = ghash_flat_find_next_index(gh, 0);
+		if (ghi->curBucket != gh->nbuckets) {
+			ghi->curEntry = (Entry *)ghash_flat_entry(gh, ghi->curBucket);
+		}
+		return;
+	}
 	ghi->curBucket = UINT_MAX;  /* wraps to zero */
 	if (gh->nentries) {
 		do {
@@ -1058,7 +1686,12 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
  */
 void BLI_ghashIterator_step(GHashIterator *ghi)
 {
-	if (ghi->curEntry) {
+	if (ghi->curEntry && (ghi->gh->flag & GHASH_FLAG_FLAT)) {
+		ghi->curBucket = ghash_flat_find_next_index(ghi->gh, ghi->curBucket + 1);
+		ghi->curEntry = (ghi->curBucket != ghi->gh->nbuckets) ?
+		                (Entry *)ghash_flat_entry(ghi->gh, ghi->curBucket) : NULL;
+	}
+	else if (ghi->curEntry) {
 		ghi->curEntry = ghi->curEntry->next;
 		while (!ghi->curEntry) {
 			ghi->curBucket++;
@@ -1359,6 +1992,20 @@ GSet *BLI_gset_new(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info)
 	return BLI_gset_new_ex(hashfp, cmpfp, info, 0);
 }
 
+/**
+ * GSet counterpart to #BLI_ghash_flat_new_ex.
+ */
+GSet *BLI_gset_flat_new_ex(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info,
+                           const unsigned int nentries_reserve)
+{
+	return (GSet *)ghash_new(hashfp, cmpfp, info, nentries_reserve, GHASH_FLAG_IS_GSET | GHASH_FLAG_FLAT);
+}
+
+GSet *BLI_gset_flat_new(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info)
+{
+	return BLI_gset_flat_new_ex(hashfp, cmpfp, info, 0);
+}
+
 /**
  * Copy given GSet. Keys are also copied if callback is provided, else pointers remain the same.
  */
@@ -1378,6 +2025,12 @@ unsigned int BLI_gset_size(GSet *gs)
  */
 void BLI_gset_insert(GSet *gs, void *key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_FLAT) {
+		BLI_assert((((GHash *)gs)->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_gset_haskey(gs, key) == 0));
+		ghash_flat_insert_entry((GHash *)gs, ghash_flat_keyhash((GHash *)gs, key))->key = key;
+		return;
+	}
+
 	const unsigned int hash = ghash_keyhash((GHash *)gs, key);
 	const unsigned int bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	ghash_insert_ex_keyonly((GHash *)gs, key, bucket_index);
@@ -1402,6 +2055,16 @@ bool BLI_gset_add(GSet *gs, void *key)
  */
 bool BLI_gset_ensure_p_ex(GSet *gs, const void *key, void ***r_key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_FLAT) {
+		bool haskey;
+		FlatEntry *e = ghash_flat_ensure_entry((GHash *)gs, key, &haskey);
+		if (!haskey) {
+			e->key = NULL;  /* caller must re-assign */
+		}
+		*r_key = &e->key;
+		return haskey;
+	}
+
 	const unsigned int hash = ghash_keyhash((GHash *)gs, key);
 	const unsigned int bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	GSetEntry *e = (GSetEntry *)ghash_lookup_entry_ex((GHash *)gs, key, bucket_index);
@@ -1451,6 +2114,12 @@ bool BLI_gset_pop(
         GSet *gs, GSetIterState *state,
         void **r_key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_FLAT) {
+		FlatEntry *e = ghash_flat_pop((GHash *)gs, (GHashIterState *)state);
+		*r_key = e ? e->key : NULL;
+		return (e != NULL);
+	}
+
 	GSetEntry *e = (GSetEntry *)ghash_pop((GHash *)gs, (GHashIterState *)state);
 
 	if (e) {
@@ -1484,12 +2153,12 @@ void BLI_gset_free(GSet *gs, GSetKeyFreeFP keyfreefp)
 
 void BLI_gset_flag_set(GSet *gs, unsigned int flag)
 {
-	((GHash *)gs)->flag |= flag;
+	BLI_ghash_flag_set((GHash *)gs, flag);
 }
 
 void BLI_gset_flag_clear(GSet *gs, unsigned int flag)
 {
-	((GHash *)gs)->flag &= ~flag;
+	BLI_ghash_flag_clear((GHash *)gs, flag);
 }
 
 /** \} */
@@ -1545,6 +2214,58 @@ int BLI_gset_buckets_size(GSet *gs)
 	return BLI_ghash_buckets_size((GHash *)gs);
 }
 
+/**
+ * Flat storage has no buckets, measure the number of groups lookups have to probe instead
+ * (1.0 is best, an 'overloaded bucket' is an entry not found in its first group).
+ */
+static double ghash_flat_calc_quality_ex(
+        GHash *gh, double *r_load, double *r_variance,
+        double *r_prop_empty_buckets, double *r_prop_overloaded_buckets, int *r_biggest_bucket)
+{
+	const unsigned int mask = gh->nbuckets - 1;
+	uint64_t sum = 0, sum_sq = 0, sum_overloaded = 0;
+	unsigned int i, probes_max = 0;
+	double mean;
+
+	for (i = 0; i < gh->nbuckets; i++) {
+		if (GHASH_FLAT_CTRL_IS_USED(gh->ctrl[i])) {
+			const unsigned int hash = (unsigned int)ghash_flat_entry(gh, i)->hash;
+			unsigned int pos = hash & mask, step = 0, probes = 1;
+
+			/* Follow the probing sequence until the group holding this slot. */
+			while (((i - pos) & mask) >= GHASH_FLAT_GROUP_SIZE) {
+				step += GHASH_FLAT_GROUP_SIZE;
+				pos = (pos + step) & mask;
+				probes++;
+			}
+
+			sum += probes;
+			sum_sq += (uint64_t)probes * probes;
+			sum_overloaded += (probes > 1);
+			probes_max = MAX2(probes_max, probes);
+		}
+	}
+
+	mean = (double)sum / (double)gh->nentries;
+	if (r_load) {
+		*r_load = (double)gh->nentries / (double)gh->nbuckets;
+	}
+	if (r_variance) {
+		*r_variance = (double)sum_sq / (double)gh->nentries - mean * mean;
+	}
+	if (r_prop_empty_buckets) {
+		*r_prop_empty_buckets = (double)(gh->nbuckets - gh->nentries) / (double)gh->nbuckets;
+	}
+	if (r_prop_overloaded_buckets) {
+		*r_prop_overloaded_buckets = (double)sum_overloaded / (double)gh->nentries;
+	}
+	if (r_biggest_bucket) {
+		*r_biggest_bucket = (int)probes_max;
+	}
+
+	return mean;
+}
+
 /**
  * Measure how well the hash function performs (1.0 is approx as good as random distribution),
  * and return a few other stats like load, variance of the distribution of the entries in the buckets, etc.
@@ -1578,6 +2299,11 @@ double BLI_ghash_calc_quality_ex(
 		return 0.0;
 	}
 
+	if (gh->flag & GHASH_FLAG_FLAT) {
+		return ghash_flat_calc_quality_ex(
+		        gh, r_load, r_variance, r_prop_empty_buckets, r_prop_overloaded_buckets, r_biggest_bucket);
+	}
+
 	mean = (double)gh->nentries / (double)gh->nbuckets;
 	if (r_load) {
 		*r_load = mean;
@@ -24,6 +24,7 @@
  * A generic task system which can be used for any task based subsystem.
  */
 
+#include <limits.h>
 #include <stdlib.h>
 
 #include "MEM_guardedalloc.h"
@@ -35,6 +36,8 @@
 #include "BLI_task.h"
 #include "BLI_threads.h"
 
+#include "PIL_time.h"
+
 #include "atomic_ops.h"
 
 /* Define this to enable some detailed statistic print. */
@@ -105,10 +108,18 @@ typedef struct TaskMemPoolStats {
 struct TaskPool {
 	TaskScheduler *scheduler;
 
+	/* Counters are only modified atomically. */
 	volatile size_t num;
 	volatile size_t done;
 	size_t num_threads;
 	size_t currently_running_tasks;
+
+	/* Incremented whenever a task of this pool is pushed or finished, threads waiting
+	 * for the pool only sleep while it didn't change. The mutex is only locked when
+	 * there are waiters, and when the last task finishes.
+	 */
+	volatile unsigned int num_gen;
+	volatile unsigned int num_waiters;
 	ThreadMutex num_mutex;
 	ThreadCondition num_cond;
 
@@ -139,6 +150,17 @@ struct TaskPool {
 #endif
 };
 
+/* Tasks are queued per thread, so pushing and taking tasks mostly goes through a lock
+ * no other thread is using. Threads take tasks from their own queue first, and steal
+ * from the other queues when it's empty.
+ */
+typedef struct TaskQueue {
+	ListBase list;
+	SpinLock lock;
+	/* Number of tasks in the list, read without the lock to skip empty queues. */
+	volatile unsigned int num;
+} TaskQueue;
+
 struct TaskScheduler {
 	pthread_t *threads;
 	struct TaskThread *task_threads;
@@ -146,7 +168,15 @@ struct TaskScheduler {
 	int num_threads;
 	bool background_thread_only;
 
-	ListBase queue;
+	/* Queue of each worker thread, and queue 0 for the main and all other threads. */
+	TaskQueue *queues;
+	int num_queues;
+	/* Tasks pushed without a thread ID are spread over all queues. */
+	unsigned int push_queue_next;
+
+	/* Incremented whenever a task is pushed, idle threads only sleep while it didn't change. */
+	volatile unsigned int queue_gen;
+	volatile unsigned int num_sleeping;
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
 
@@ -230,85 +260,179 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
 
 /* Task Scheduler */
 
-static void task_pool_num_decrease(TaskPool *pool, size_t done)
+/* Read a counter with a full memory barrier, so it's read before following loads. */
+BLI_INLINE unsigned int task_atomic_get_u(volatile unsigned int *value)
 {
-	BLI_mutex_lock(&pool->num_mutex);
+	return atomic_add_u((unsigned int *)value, 0);
+}
+
+/* Wake up idle worker threads after new tasks were queued. */
+static void task_scheduler_notify(TaskScheduler *scheduler)
+{
+	atomic_add_u((unsigned int *)&scheduler->queue_gen, 1);
 
-	BLI_assert(pool->num >= done);
+	if (task_atomic_get_u(&scheduler->num_sleeping) != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+}
 
-	pool->num -= done;
-	atomic_sub_z(&pool->currently_running_tasks, done);
-	pool->done += done;
+/* Wake up threads waiting in BLI_task_pool_work_and_wait(). */
+static void task_pool_notify(TaskPool *pool)
+{
+	atomic_add_u((unsigned int *)&pool->num_gen, 1);
 
-	if (pool->num == 0)
+	if (task_atomic_get_u(&pool->num_waiters) != 0) {
+		BLI_mutex_lock(&pool->num_mutex);
 		BLI_condition_notify_all(&pool->num_cond);
+		BLI_mutex_unlock(&pool->num_mutex);
+	}
+}
 
-	BLI_mutex_unlock(&pool->num_mutex);
+static void task_pool_num_decrease(TaskPool *pool, size_t done)
+{
+	if (done == 0) {
+		return;
+	}
+
+	atomic_add_z((size_t *)&pool->done, done);
+
+	/* Finished tasks may let a waiting thread run tasks limited by num_threads. */
+	task_pool_notify(pool);
+	if (pool->num_threads != 0) {
+		task_scheduler_notify(pool->scheduler);
+	}
+
+	/* Decreasing num must be the last access to the pool, once it reaches zero the pool may be freed.
+	 * The last decrease is done with the mutex locked, so waiters can't free it before it's unlocked.
+	 */
+	while (true) {
+		const size_t num = pool->num;
+
+		BLI_assert(num >= done);
+
+		if (num == done) {
+			BLI_mutex_lock(&pool->num_mutex);
+			if (atomic_sub_z((size_t *)&pool->num, done) == 0) {
+				BLI_condition_notify_all(&pool->num_cond);
+			}
+			BLI_mutex_unlock(&pool->num_mutex);
+			break;
+		}
+		else if (atomic_cas_z((size_t *)&pool->num, num, num - done) == num) {
+			break;
+		}
+	}
 }
 
 static void task_pool_num_increase(TaskPool *pool)
 {
-	BLI_mutex_lock(&pool->num_mutex);
+	atomic_add_z((size_t *)&pool->num, 1);
+	task_pool_notify(pool);
+}
+
+/* Count a task of the pool as running, unless the pool already uses all threads it may use. */
+static bool task_pool_running_tasks_increase(TaskPool *pool)
+{
+	if (pool->num_threads == 0) {
+		atomic_add_z(&pool->currently_running_tasks, 1);
+		return true;
+	}
 
-	pool->num++;
-	BLI_condition_notify_all(&pool->num_cond);
+	while (true) {
+		const size_t running = pool->currently_running_tasks;
 
-	BLI_mutex_unlock(&pool->num_mutex);
+		if (running >= pool->num_threads) {
+			return false;
+		}
+		else if (atomic_cas_z(&pool->currently_running_tasks, running, running + 1) == running) {
+			return true;
+		}
+	}
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Take the first task which may run now from the queue,
+ * only from \a only_pool when given. */
+static Task *task_queue_pop(TaskScheduler *scheduler, TaskQueue *queue, TaskPool *only_pool, const bool is_worker)
 {
-	bool found_task = false;
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	Task *task;
 
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+	if (queue->num == 0) {
+		return NULL;
+	}
 
-	do {
-		Task *current_task;
+	BLI_spin_lock(&queue->lock);
+
+	for (task = queue->list.first; task; task = task->next) {
+		TaskPool *pool = task->pool;
+
+		if (only_pool != NULL && pool != only_pool) {
+			continue;
+		}
+
+		if (is_worker && scheduler->background_thread_only && !pool->run_in_background) {
+			continue;
+		}
+
+		if (task_pool_running_tasks_increase(pool)) {
+			BLI_remlink(&queue->list, task);
+			atomic_sub_u((unsigned int *)&queue->num, 1);
+			break;
+		}
+	}
+
+	BLI_spin_unlock(&queue->lock);
+
+	return task;
+}
+
+/* Find a task in the queue of the thread first, then steal from the other queues. */
+static Task *task_scheduler_pop(TaskScheduler *scheduler, int queue_index, TaskPool *only_pool, const bool is_worker)
+{
+	int i;
+
+	for (i = 0; i < scheduler->num_queues; i++) {
+		TaskQueue *queue = &scheduler->queues[(queue_index + i) % scheduler->num_queues];
+		Task *task = task_queue_pop(scheduler, queue, only_pool, is_worker);
+
+		if (task) {
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, int thread_id, Task **task)
+{
+	while (true) {
+		/* Read before looking for tasks, anything pushed afterwards changes it. */
+		const unsigned int queue_gen = task_atomic_get_u(&scheduler->queue_gen);
 
-		/* Assuming we can only have a void queue in 'exit' case here seems logical (we should only be here after
-		 * our worker thread has been woken up from a condition_wait(), which only happens after a new task was
-		 * added to the queue), but it is wrong.
-		 * Waiting on condition may wake up the thread even if condition is not signaled (spurious wake-ups), and some
-		 * race condition may also empty the queue **after** condition has been signaled, but **before** awoken thread
-		 * reaches this point...
-		 * See http://stackoverflow.com/questions/8594591
-		 *
-		 * So we only abort here if do_exit is set.
-		 */
 		if (scheduler->do_exit) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
 			return false;
 		}
 
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
-
-			if (scheduler->background_thread_only && !pool->run_in_background) {
-				continue;
-			}
+		*task = task_scheduler_pop(scheduler, thread_id, NULL, true);
 
-			if (pool->num_threads == 0 ||
-			    pool->currently_running_tasks < pool->num_threads)
-			{
-				*task = current_task;
-				found_task = true;
-				atomic_add_z(&pool->currently_running_tasks, 1);
-				BLI_remlink(&scheduler->queue, *task);
-				break;
-			}
+		if (*task) {
+			return true;
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+		/* Nothing to do, sleep until new tasks are pushed.
+		 * Waiting on condition may wake up the thread even if condition is not signaled
+		 * (spurious wake-ups), so check the generation again. */
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		atomic_add_u((unsigned int *)&scheduler->num_sleeping, 1);
 
-	return true;
+		while ((task_atomic_get_u(&scheduler->queue_gen) == queue_gen) && !scheduler->do_exit) {
+			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		}
+
+		atomic_sub_u((unsigned int *)&scheduler->num_sleeping, 1);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
 }
 
 static void *task_scheduler_thread_run(void *thread_p)
@@ -319,7 +443,7 @@ static void *task_scheduler_thread_run(void *thread_p)
 	Task *task;
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+	while (task_scheduler_thread_wait_pop(scheduler, thread_id, &task)) {
 		TaskPool *pool = task->pool;
 
 		/* run task */
@@ -329,6 +453,7 @@ static void *task_scheduler_thread_run(void *thread_p)
 		task_free(pool, task, thread_id);
 
 		/* notify pool task was done */
+		atomic_sub_z(&pool->currently_running_tasks, 1);
 		task_pool_num_decrease(pool, 1);
 	}
 
@@ -343,7 +468,6 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	 * threads, so we keep track of the number of users. */
 	scheduler->do_exit = false;
 
-	BLI_listbase_clear(&scheduler->queue);
 	BLI_mutex_init(&scheduler->queue_mutex);
 	BLI_condition_init(&scheduler->queue_cond);
 
@@ -361,6 +485,15 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	    num_threads = 1;
 	}
 
+	/* one queue for each worker thread, and one for all other threads */
+	scheduler->num_queues = num_threads + 1;
+	scheduler->queues = MEM_callocN(sizeof(*scheduler->queues) * scheduler->num_queues, "TaskScheduler queues");
+
+	for (int i = 0; i < scheduler->num_queues; i++) {
+		BLI_listbase_clear(&scheduler->queues[i].list);
+		BLI_spin_init(&scheduler->queues[i].lock);
+	}
+
 	/* launch threads that will be waiting for work */
 	if (num_threads > 0) {
 		int i;
@@ -388,7 +521,6 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 
 void BLI_task_scheduler_free(TaskScheduler *scheduler)
 {
-	Task *task;
 
 	/* stop all waiting threads */
 	BLI_mutex_lock(&scheduler->queue_mutex);
@@ -424,10 +556,16 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 	}
 
 	/* delete leftover tasks */
-	for (task = scheduler->queue.first; task; task = task->next) {
-		task_data_free(task, 0);
+	for (int i = 0; i < scheduler->num_queues; i++) {
+		TaskQueue *queue = &scheduler->queues[i];
+
+		for (Task *task = queue->list.first; task; task = task->next) {
+			task_data_free(task, 0);
+		}
+		BLI_freelistN(&queue->list);
+		BLI_spin_end(&queue->lock);
 	}
-	BLI_freelistN(&scheduler->queue);
+	MEM_freeN(scheduler->queues);
 
 	/* delete mutex/condition */
 	BLI_mutex_end(&scheduler->queue_mutex);
@@ -441,42 +579,65 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 	return scheduler->num_threads + 1;
 }
 
-static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
+static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority, int thread_id)
 {
+	TaskQueue *queue;
+
 	task_pool_num_increase(task->pool);
 
+	/* worker threads push to their own queue, others spread their tasks over all queues,
+	 * threads without work steal them from there */
+	if (thread_id > 0 && thread_id < scheduler->num_queues) {
+		queue = &scheduler->queues[thread_id];
+	}
+	else {
+		queue = &scheduler->queues[atomic_fetch_and_add_uint32(&scheduler->push_queue_next, 1) % scheduler->num_queues];
+	}
+
 	/* add task to queue */
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	BLI_spin_lock(&queue->lock);
 
 	if (priority == TASK_PRIORITY_HIGH)
-		BLI_addhead(&scheduler->queue, task);
+		BLI_addhead(&queue->list, task);
 	else
-		BLI_addtail(&scheduler->queue, task);
+		BLI_addtail(&queue->list, task);
 
-	BLI_condition_notify_one(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	atomic_add_u((unsigned int *)&queue->num, 1);
+	BLI_spin_unlock(&queue->lock);
+
+	task_scheduler_notify(scheduler);
 }
 
 static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 {
 	Task *task, *nexttask;
 	size_t done = 0;
+	int i;
 
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	/* free all tasks from this pool from the queues */
+	for (i = 0; i < scheduler->num_queues; i++) {
+		TaskQueue *queue = &scheduler->queues[i];
+
+		if (queue->num == 0) {
+			continue;
+		}
 
-	/* free all tasks from this pool from the queue */
-	for (task = scheduler->queue.first; task; task = nexttask) {
-		nexttask = task->next;
+		BLI_spin_lock(&queue->lock);
 
-		if (task->pool == pool) {
-			task_data_free(task, 0);
-			BLI_freelinkN(&scheduler->queue, task);
+		for (task = queue->list.first; task; task = nexttask) {
+			nexttask = task->next;
 
-			done++;
+			if (task->pool == pool) {
+				task_data_free(task, 0);
+				BLI_freelinkN(&queue->list, task);
+				atomic_sub_u((unsigned int *)&queue->num, 1);
+
+				done++;
+			}
 		}
-	}
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+		BLI_spin_unlock(&queue->lock);
+	}
 
 	/* notify done */
 	task_pool_num_decrease(pool, done);
@@ -505,6 +666,8 @@ static TaskPool *task_pool_create_ex(TaskScheduler *scheduler, void *userdata, c
 	pool->done = 0;
 	pool->num_threads = 0;
 	pool->currently_running_tasks = 0;
+	pool->num_gen = 0;
+	pool->num_waiters = 0;
 	pool->do_cancel = false;
 	pool->run_in_background = is_background;
 
@@ -610,7 +773,7 @@ static void task_pool_push(
 	task->freedata = freedata;
 	task->pool = pool;
 
-	task_scheduler_push(pool->scheduler, task, priority);
+	task_scheduler_push(pool->scheduler, task, priority, thread_id);
 }
 
 void BLI_task_pool_push_ex(
@@ -636,55 +799,47 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
 	TaskScheduler *scheduler = pool->scheduler;
 
-	BLI_mutex_lock(&pool->num_mutex);
-
-	while (pool->num != 0) {
-		Task *task, *work_task = NULL;
-		bool found_task = false;
+	while (true) {
+		/* Read before looking for tasks, pushed and finished tasks change it. */
+		const unsigned int num_gen = task_atomic_get_u(&pool->num_gen);
+		Task *task;
 
-		BLI_mutex_unlock(&pool->num_mutex);
-
-		BLI_mutex_lock(&scheduler->queue_mutex);
+		if (pool->num == 0) {
+			break;
+		}
 
 		/* find task from this pool. if we get a task from another pool,
 		 * we can get into deadlock */
+		task = task_scheduler_pop(scheduler, 0, pool, false);
 
-		if (pool->num_threads == 0 ||
-		    pool->currently_running_tasks < pool->num_threads)
-		{
-			for (task = scheduler->queue.first; task; task = task->next) {
-				if (task->pool == pool) {
-					work_task = task;
-					found_task = true;
-					BLI_remlink(&scheduler->queue, task);
-					break;
-				}
-			}
-		}
-
-		BLI_mutex_unlock(&scheduler->queue_mutex);
-
-		/* if found task, do it, otherwise wait until other tasks are done */
-		if (found_task) {
+		/* if found task, do it inline, otherwise wait until other tasks are done */
+		if (task) {
 			/* run task */
-			atomic_add_z(&pool->currently_running_tasks, 1);
-			work_task->run(pool, work_task->taskdata, 0);
+			task->run(pool, task->taskdata, 0);
 
 			/* delete task */
 			task_free(pool, task, 0);
 
 			/* notify pool task was done */
+			atomic_sub_z(&pool->currently_running_tasks, 1);
 			task_pool_num_decrease(pool, 1);
+			continue;
 		}
 
 		BLI_mutex_lock(&pool->num_mutex);
-		if (pool->num == 0)
-			break;
+		atomic_add_u((unsigned int *)&pool->num_waiters, 1);
 
-		if (!found_task)
+		while ((pool->num != 0) && (task_atomic_get_u(&pool->num_gen) == num_gen)) {
 			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
+		}
+
+		atomic_sub_u((unsigned int *)&pool->num_waiters, 1);
+		BLI_mutex_unlock(&pool->num_mutex);
 	}
 
+	/* The last task is finished with the mutex locked, make sure it was released
+	 * before returning, since the pool may be freed right after. */
+	BLI_mutex_lock(&pool->num_mutex);
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
@@ -771,11 +926,25 @@ typedef struct ParallelRangeState {
 
 	TaskParallelRangeFunc func;
 	TaskParallelRangeFuncEx func_ex;
+	TaskParallelRangeFuncReduce func_reduce;
 
+	eTaskSchedulingMode scheduling_mode;
 	int iter;
+	/* Size of all chunks for static and dynamic scheduling, smallest chunk size otherwise. */
 	int chunk_size;
+	/* Guided and adaptive chunks take at most this fraction of the remaining iterations. */
+	int guided_divisor;
+
+	/* Finished chunk waiting to be joined with the one of the next finished task. */
+	void *reduce_chunk;
+	SpinLock reduce_lock;
 } ParallelRangeState;
 
+/* Adaptive scheduling aims for chunks taking about this long (in seconds):
+ * long enough to hide the cost of getting a chunk, short enough to keep all threads busy
+ * until the end of the range. */
+#define PARALLEL_RANGE_ADAPTIVE_CHUNK_TIME 50e-6
+
 BLI_INLINE bool parallel_range_next_iter_get(
         ParallelRangeState * __restrict state,
         int * __restrict iter, int * __restrict count)
@@ -789,6 +958,87 @@ BLI_INLINE bool parallel_range_next_iter_get(
 	return (previter < state->stop);
 }
 
+/* Get at most \a max_count iterations, and no more than a guided share of the remaining ones,
+ * so chunks get smaller towards the end of the range. */
+BLI_INLINE bool parallel_range_next_iter_get_guided(
+        ParallelRangeState * __restrict state, const int max_count,
+        int * __restrict iter, int * __restrict count)
+{
+	while (true) {
+		const int previter = *(volatile int *)&state->iter;
+		int chunk_size;
+
+		if (previter >= state->stop) {
+			return false;
+		}
+
+		chunk_size = min_ii(max_count, (state->stop - previter) / state->guided_divisor);
+		chunk_size = min_ii(max_ii(chunk_size, state->chunk_size), state->stop - previter);
+
+		if (atomic_cas_uint32((uint32_t *)&state->iter, (uint32_t)previter, (uint32_t)(previter + chunk_size)) ==
+		    (uint32_t)previter)
+		{
+			*iter = previter;
+			*count = chunk_size;
+			return true;
+		}
+	}
+}
+
+/* Size of the next adaptive chunk, from the time the last chunk of \a count iterations took. */
+BLI_INLINE int parallel_range_adaptive_count(ParallelRangeState * __restrict state, const int count, const double time)
+{
+	/* Grow slowly, a single fast chunk says little about the cost of the next ones. */
+	int max_count = (count < INT_MAX / 2) ? count * 2 : INT_MAX;
+
+	if (time > 0.0) {
+		const double estimate = (double)count * (PARALLEL_RANGE_ADAPTIVE_CHUNK_TIME / time);
+		if (estimate < (double)max_count) {
+			max_count = (int)estimate;
+		}
+	}
+
+	return max_ii(state->chunk_size, max_count);
+}
+
+BLI_INLINE void parallel_range_chunk_run(
+        ParallelRangeState * __restrict state,
+        void *userdata_chunk, const int iter, const int count, const int threadid)
+{
+	int i;
+
+	if (state->func_ex) {
+		for (i = 0; i < count; ++i) {
+			state->func_ex(state->userdata, userdata_chunk, iter + i, threadid);
+		}
+	}
+	else {
+		for (i = 0; i < count; ++i) {
+			state->func(state->userdata, iter + i);
+		}
+	}
+}
+
+/* Join the chunk of a finished task with the ones of already finished tasks.
+ * Reduction runs in parallel while other tasks are still busy, and leaves a single chunk in the end. */
+static void parallel_range_reduce(ParallelRangeState * __restrict state, void *userdata_chunk)
+{
+	while (true) {
+		void *userdata_chunk_other;
+
+		BLI_spin_lock(&state->reduce_lock);
+		userdata_chunk_other = state->reduce_chunk;
+		state->reduce_chunk = (userdata_chunk_other != NULL) ? NULL : userdata_chunk;
+		BLI_spin_unlock(&state->reduce_lock);
+
+		if (userdata_chunk_other == NULL) {
+			break;
+		}
+
+		state->func_reduce(state->userdata, userdata_chunk, userdata_chunk_other);
+	}
+}
+
 static void parallel_range_func(
         TaskPool * __restrict pool,
         void *userdata_chunk,
@@ -797,19 +1047,32 @@ static void parallel_range_func(
 	ParallelRangeState * __restrict state = BLI_task_pool_userdata(pool);
 	int iter, count;
 
-	while (parallel_range_next_iter_get(state, &iter, &count)) {
-		int i;
+	switch (state->scheduling_mode) {
+		case TASK_SCHEDULING_ADAPTIVE:
+		{
+			int max_count = state->chunk_size;
 
-		if (state->func_ex) {
-			for (i = 0; i < count; ++i) {
-				state->func_ex(state->userdata, userdata_chunk, iter + i, threadid);
+			while (parallel_range_next_iter_get_guided(state, max_count, &iter, &count)) {
+				const double time_start = PIL_check_seconds_timer();
+				parallel_range_chunk_run(state, userdata_chunk, iter, count, threadid);
+				max_count = parallel_range_adaptive_count(state, count, PIL_check_seconds_timer() - time_start);
 			}
+			break;
 		}
-		else {
-			for (i = 0; i < count; ++i) {
-				state->func(state->userdata, iter + i);
+		case TASK_SCHEDULING_GUIDED:
+			while (parallel_range_next_iter_get_guided(state, INT_MAX, &iter, &count)) {
+				parallel_range_chunk_run(state, userdata_chunk, iter, count, threadid);
 			}
-		}
+			break;
+		default:
+			while (parallel_range_next_iter_get(state, &iter, &count)) {
+				parallel_range_chunk_run(state, userdata_chunk, iter, count, threadid);
+			}
+			break;
+	}
+
+	if (state->func_reduce) {
+		parallel_range_reduce(state, userdata_chunk);
 	}
 }
 
@@ -826,13 +1089,13 @@ static void task_parallel_range_ex(
         TaskParallelRangeFunc func,
         TaskParallelRangeFuncEx func_ex,
         TaskParallelRangeFuncFinalize func_finalize,
-        const bool use_threading,
-        const bool use_dynamic_scheduling)
+        TaskParallelRangeFuncReduce func_reduce,
+        const ParallelRangeSettings *settings)
 {
-	TaskScheduler *task_scheduler;
+	TaskScheduler *task_scheduler = NULL;
 	TaskPool *task_pool;
 	ParallelRangeState state;
-	int i, num_threads, num_tasks;
+	int i, num_threads, num_tasks = 0, chunk_size = 1;
 
 	void *userdata_chunk_local = NULL;
 	void *userdata_chunk_array = NULL;
@@ -847,15 +1110,48 @@ static void task_parallel_range_ex(
 		BLI_assert(func_ex != NULL && func == NULL);
 		BLI_assert(userdata_chunk != NULL);
 	}
+	BLI_assert(func_reduce == NULL || use_userdata_chunk);
+
+	if (settings->use_threading) {
+		task_scheduler = BLI_task_scheduler_get();
+		num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+
+		/* The idea here is to prevent creating task for each of the loop iterations
+		 * and instead have tasks which are evenly distributed across CPU cores and
+		 * pull next iter to be crunched using the queue.
+		 */
+		num_tasks = num_threads * 2;
+
+		switch (settings->scheduling_mode) {
+			case TASK_SCHEDULING_DYNAMIC:
+				chunk_size = (settings->min_iter_per_chunk > 0) ? settings->min_iter_per_chunk : 32;
+				break;
+			case TASK_SCHEDULING_GUIDED:
+			case TASK_SCHEDULING_ADAPTIVE:
+				chunk_size = max_ii(1, settings->min_iter_per_chunk);
+				break;
+			default:
+				chunk_size = max_ii(max_ii(1, settings->min_iter_per_chunk), (stop - start) / num_tasks);
+				break;
+		}
+
+		num_tasks = min_ii(num_tasks, (stop - start) / chunk_size);
+	}
 
 	/* If it's not enough data to be crunched, don't bother with tasks at all,
 	 * do everything from the main thread.
 	 */
-	if (!use_threading) {
+	if (num_tasks <= 1) {
 		if (func_ex) {
 			if (use_userdata_chunk) {
-				userdata_chunk_local = MALLOCA(userdata_chunk_size);
-				memcpy(userdata_chunk_local, userdata_chunk, userdata_chunk_size);
+				/* Reduction result goes to userdata_chunk, no need for a copy. */
+				if (func_reduce) {
+					userdata_chunk_local = userdata_chunk;
+				}
+				else {
+					userdata_chunk_local = MALLOCA(userdata_chunk_size);
+					memcpy(userdata_chunk_local, userdata_chunk, userdata_chunk_size);
+				}
 			}
 
 			for (i = start; i < stop; ++i) {
@@ -866,7 +1162,9 @@ static void task_parallel_range_ex(
 				func_finalize(userdata, userdata_chunk_local);
 			}
 
-			MALLOCA_FREE(userdata_chunk_local, userdata_chunk_size);
+			if (!func_reduce) {
+				MALLOCA_FREE(userdata_chunk_local, userdata_chunk_size);
+			}
 		}
 		else {
 			for (i = start; i < stop; ++i) {
@@ -877,30 +1175,23 @@ static void task_parallel_range_ex(
 		return;
 	}
 
-	task_scheduler = BLI_task_scheduler_get();
 	task_pool = BLI_task_pool_create(task_scheduler, &state);
-	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
-
-	/* The idea here is to prevent creating task for each of the loop iterations
-	 * and instead have tasks which are evenly distributed across CPU cores and
-	 * pull next iter to be crunched using the queue.
-	 */
-	num_tasks = num_threads * 2;
 
 	state.start = start;
 	state.stop = stop;
 	state.userdata = userdata;
 	state.func = func;
 	state.func_ex = func_ex;
+	state.func_reduce = func_reduce;
+	state.scheduling_mode = settings->scheduling_mode;
 	state.iter = start;
-	if (use_dynamic_scheduling) {
-		state.chunk_size = 32;
-	}
-	else {
-		state.chunk_size = max_ii(1, (stop - start) / (num_tasks));
+	state.chunk_size = chunk_size;
+	state.guided_divisor = num_tasks;
+	state.reduce_chunk = NULL;
+	if (func_reduce) {
+		BLI_spin_init(&state.reduce_lock);
 	}
 
-	num_tasks = min_ii(num_tasks, (stop - start) / state.chunk_size);
 	atomic_fetch_and_add_uint32((uint32_t *)(&state.iter), 0);
 
 	if (use_userdata_chunk) {
@@ -922,6 +1213,12 @@ static void task_parallel_range_ex(
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+	if (func_reduce) {
+		BLI_assert(state.reduce_chunk != NULL);
+		memcpy(userdata_chunk, state.reduce_chunk, userdata_chunk_size);
+		BLI_spin_end(&state.reduce_lock);
+	}
+
 	if (use_userdata_chunk) {
 		if (func_finalize) {
 			for (i = 0; i < num_tasks; i++) {
@@ -933,6 +1230,16 @@ static void task_parallel_range_ex(
 	}
 }
 
+/**
+ * Initialize \a settings to the defaults of #BLI_task_parallel_range: threaded, static scheduling.
+ */
+void BLI_parallel_range_settings_defaults(ParallelRangeSettings *settings)
+{
+	memset(settings, 0, sizeof(*settings));
+	settings->use_threading = true;
+	settings->scheduling_mode = TASK_SCHEDULING_STATIC;
+}
+
 /**
  * This function allows to parallelize for loops in a similar way to OpenMP's 'parallel for' statement.
  *
@@ -957,9 +1264,14 @@ void BLI_task_parallel_range_ex(
         const bool use_threading,
         const bool use_dynamic_scheduling)
 {
+	const ParallelRangeSettings settings = {
+	    .use_threading = use_threading,
+	    .scheduling_mode = use_dynamic_scheduling ? TASK_SCHEDULING_DYNAMIC : TASK_SCHEDULING_STATIC,
+	};
+
 	task_parallel_range_ex(
-	            start, stop, userdata, userdata_chunk, userdata_chunk_size, NULL, func_ex, NULL,
-	            use_threading, use_dynamic_scheduling);
+	            start, stop, userdata, userdata_chunk, userdata_chunk_size, NULL, func_ex, NULL, NULL,
+	            &settings);
 }
 
 /**
@@ -979,7 +1291,12 @@ void BLI_task_parallel_range(
         TaskParallelRangeFunc func,
         const bool use_threading)
 {
-	task_parallel_range_ex(start, stop, userdata, NULL, 0, func, NULL, NULL, use_threading, false);
+	const ParallelRangeSettings settings = {
+	    .use_threading = use_threading,
+	    .scheduling_mode = TASK_SCHEDULING_STATIC,
+	};
+
+	task_parallel_range_ex(start, stop, userdata, NULL, 0, func, NULL, NULL, NULL, &settings);
 }
 
 /**
@@ -1009,10 +1326,64 @@ void BLI_task_parallel_range_finalize(
         TaskParallelRangeFuncFinalize func_finalize,
         const bool use_threading,
         const bool use_dynamic_scheduling)
+{
+	const ParallelRangeSettings settings = {
+	    .use_threading = use_threading,
+	    .scheduling_mode = use_dynamic_scheduling ? TASK_SCHEDULING_DYNAMIC : TASK_SCHEDULING_STATIC,
+	};
+
+	task_parallel_range_ex(
+	            start, stop, userdata, userdata_chunk, userdata_chunk_size, NULL, func_ex, func_finalize, NULL,
+	            &settings);
+}
+
+/**
+ * Same as #BLI_task_parallel_range, with scheduling controlled by \a settings.
+ *
+ * \param start First index to process.
+ * \param stop Index to stop looping (excluded).
+ * \param userdata Common userdata passed to all instances of \a func.
+ * \param func Callback function (simple version).
+ * \param settings Threading and scheduling options, see #BLI_parallel_range_settings_defaults.
+ */
+void BLI_task_parallel_range_with_settings(
+        int start, int stop,
+        void *userdata,
+        TaskParallelRangeFunc func,
+        const ParallelRangeSettings *settings)
+{
+	task_parallel_range_ex(start, stop, userdata, NULL, 0, func, NULL, NULL, NULL, settings);
+}
+
+/**
+ * This function allows to parallelize reductions in a similar way to OpenMP's 'reduction' clause.
+ *
+ * Each task accumulates into its own copy of \a userdata_chunk, finished copies are joined with
+ * \a func_reduce from the worker threads, and the final result is written back to \a userdata_chunk.
+ *
+ * \param start First index to process.
+ * \param stop Index to stop looping (excluded).
+ * \param userdata Common userdata passed to all instances of \a func_ex and \a func_reduce.
+ * \param userdata_chunk Initial value of the reduction, must be neutral for \a func_reduce
+ *                       (e.g. zero for sums), since every task starts from a copy of it.
+ * \param userdata_chunk_size Memory size of \a userdata_chunk.
+ * \param func_ex Callback function, accumulating iterations into its userdata_chunk.
+ * \param func_reduce Callback function, joining its last argument into userdata_chunk_join,
+ *                    may be called in any order, so it has to be associative and commutative.
+ * \param settings Threading and scheduling options, see #BLI_parallel_range_settings_defaults.
+ */
+void BLI_task_parallel_reduce(
+        int start, int stop,
+        void *userdata,
+        void *userdata_chunk,
+        const size_t userdata_chunk_size,
+        TaskParallelRangeFuncEx func_ex,
+        TaskParallelRangeFuncReduce func_reduce,
+        const ParallelRangeSettings *settings)
 {
 	task_parallel_range_ex(
-	            start, stop, userdata, userdata_chunk, userdata_chunk_size, NULL, func_ex, func_finalize,
-	            use_threading, use_dynamic_scheduling);
+	            start, stop, userdata, userdata_chunk, userdata_chunk_size, NULL, func_ex, NULL, func_reduce,
+	            settings);
 }
 
 #undef MALLOCA
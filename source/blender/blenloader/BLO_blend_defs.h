@@ -77,4 +77,14 @@ enum {
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (size_t)(2 + (_x) * (_y)))
 
+/**
+ * Compressed files are a series of independent gzip members (still a valid gzip stream),
+ * so blocks can be compressed and decompressed in parallel.
+ * Each member stores its total size in a 'BL' extra header field,
+ * so the next member can be found without inflating.
+ */
+#define BLEN_GZIP_BLOCK_SIZE (1 << 20)  /* uncompressed size of a member, 1mb */
+#define BLEN_GZIP_HEADER_SIZE 20  /* fixed header: 10 bytes, xlen: 2, 'BL' subfield: 8 */
+#define BLEN_GZIP_TRAILER_SIZE 8  /* crc32 and uncompressed size */
+
 #endif  /* __BLO_BLEND_DEFS_H__ */
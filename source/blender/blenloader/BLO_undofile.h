@@ -33,12 +33,14 @@
  *  \ingroup blenloader
  */
 
-typedef struct {
+typedef struct MemFileChunk {
 	void *next, *prev;
 	
 	char *buf;
-	unsigned int ident, size;
+	unsigned int size;
 	
+	/* reference counted storage of buf, shared by identical chunks of all undo steps */
+	struct MemFileChunkBuffer *shared;
 } MemFileChunk;
 
 typedef struct MemFile {
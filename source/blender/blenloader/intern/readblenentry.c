@@ -83,7 +83,8 @@ BlendHandle *BLO_blendhandle_from_file(const char *filepath, ReportList *reports
 {
 	BlendHandle *bh;
 
-	bh = (BlendHandle *)blo_openblenderfile(filepath, reports);
+	/* blend handles stay open, don't keep a mapping of the file */
+	bh = (BlendHandle *)blo_openblenderfile(filepath, reports, false);
 
 	return bh;
 }
@@ -210,11 +211,11 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 					if (prv) {
 						memcpy(new_prv, prv, sizeof(PreviewImage));
 						if (prv->rect[0] && prv->w[0] && prv->h[0]) {
-							unsigned int *rect = NULL;
+							const unsigned int *rect = NULL;
 							size_t len = new_prv->w[0] * new_prv->h[0] * sizeof(unsigned int);
 							new_prv->rect[0] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
+							rect = (const unsigned int *)blo_bhead_data(bhead);
 							BLI_assert(len == bhead->len);
 							memcpy(new_prv->rect[0], rect, len);
 						}
@@ -227,11 +228,11 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 						}
 						
 						if (prv->rect[1] && prv->w[1] && prv->h[1]) {
-							unsigned int *rect = NULL;
+							const unsigned int *rect = NULL;
 							size_t len = new_prv->w[1] * new_prv->h[1] * sizeof(unsigned int);
 							new_prv->rect[1] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
+							rect = (const unsigned int *)blo_bhead_data(bhead);
 							BLI_assert(len == bhead->len);
 							memcpy(new_prv->rect[1], rect, len);
 						}
@@ -322,7 +323,7 @@ BlendFileData *BLO_read_from_file(const char *filepath, ReportList *reports)
 	BlendFileData *bfd = NULL;
 	FileData *fd;
 		
-	fd = blo_openblenderfile(filepath, reports);
+	fd = blo_openblenderfile(filepath, reports, true);
 	if (fd) {
 		fd->reports = reports;
 		bfd = blo_read_file_internal(fd, filepath);
@@ -45,6 +45,13 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
+#  if defined(__linux__)
+#    include <sys/vfs.h> // for fstatfs
+#  elif defined(__APPLE__)
+#    include <sys/param.h>
+#    include <sys/mount.h> // for fstatfs
+#  endif
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -109,6 +116,7 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -223,14 +231,18 @@
 typedef struct OldNew {
 	const void *old;
 	void *newp;
+	/* user count for data, ID code for libdata */
 	int nr;
 } OldNew;
 
 typedef struct OldNewMap {
+	/* entries in insertion order */
 	OldNew *entries;
-	int nentries, entriessize;
-	bool sorted;
-	int lasthit;
+	int nentries;
+	/* open addressing hash table of indices into entries, -1 for empty slots */
+	int *map;
+	/* entries capacity is 2^capacity_exp, the map has twice as many slots */
+	int capacity_exp;
 } OldNewMap;
 
 
@@ -273,49 +285,96 @@ static const char *library_parent_filepath(Library *lib)
 	return lib->parent ? lib->parent->filepath : "<direct>";
 }
 
+#define OLDNEWMAP_DEFAULT_SIZE_EXP 10
+#define OLDNEWMAP_ENTRIES_CAPACITY(onm) (1 << (onm)->capacity_exp)
+#define OLDNEWMAP_MAP_CAPACITY(onm) (1 << ((onm)->capacity_exp + 1))
+#define OLDNEWMAP_PERTURB_SHIFT 5
+
+/**
+ * Iterate over the slots a key can be stored in, using perturbed probing like Python's dict,
+ * so clustered pointers (which share their low bits) still spread over the table.
+ */
+#define OLDNEWMAP_ITER_SLOTS(onm, key, slot, index) \
+	const unsigned int _hash = BLI_ghashutil_ptrhash(key); \
+	const unsigned int _mask = (unsigned int)OLDNEWMAP_MAP_CAPACITY(onm) - 1; \
+	unsigned int _perturb = _hash; \
+	unsigned int slot = _hash & _mask; \
+	int index = (onm)->map[slot]; \
+	for (;; \
+	     slot = _mask & ((5 * slot) + 1 + _perturb), \
+	     _perturb >>= OLDNEWMAP_PERTURB_SHIFT, \
+	     index = (onm)->map[slot])
+
+static void oldnewmap_clear_map(OldNewMap *onm)
+{
+	memset(onm->map, 0xff, sizeof(*onm->map) * OLDNEWMAP_MAP_CAPACITY(onm));
+}
+
+static void oldnewmap_alloc(OldNewMap *onm, int capacity_exp)
+{
+	onm->capacity_exp = capacity_exp;
+	onm->entries = MEM_mallocN(sizeof(*onm->entries) * OLDNEWMAP_ENTRIES_CAPACITY(onm), "OldNewMap.entries");
+	onm->map = MEM_mallocN(sizeof(*onm->map) * OLDNEWMAP_MAP_CAPACITY(onm), "OldNewMap.map");
+	oldnewmap_clear_map(onm);
+}
+
 static OldNewMap *oldnewmap_new(void) 
 {
 	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
 	
-	onm->entriessize = 1024;
-	onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
+	oldnewmap_alloc(onm, OLDNEWMAP_DEFAULT_SIZE_EXP);
 	
 	return onm;
 }
 
-static int verg_oldnewmap(const void *v1, const void *v2)
+static void oldnewmap_insert_index_in_map(OldNewMap *onm, const void *addr, int index)
 {
-	const struct OldNew *x1=v1, *x2=v2;
-	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
+	OLDNEWMAP_ITER_SLOTS(onm, addr, slot, stored_index) {
+		if (stored_index == -1) {
+			onm->map[slot] = index;
+			break;
+		}
+		else if (onm->entries[stored_index].old == addr) {
+			/* duplicate address, the first entry stays the one found by lookups */
+			break;
+		}
+	}
 }
 
-
-static void oldnewmap_sort(FileData *fd) 
+static void oldnewmap_increase_size(OldNewMap *onm)
 {
-	BLI_assert(fd->libmap->sorted == false);
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
+	int i;
+
+	onm->capacity_exp++;
+	onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * OLDNEWMAP_ENTRIES_CAPACITY(onm));
+	onm->map = MEM_reallocN(onm->map, sizeof(*onm->map) * OLDNEWMAP_MAP_CAPACITY(onm));
+	oldnewmap_clear_map(onm);
+
+	for (i = 0; i < onm->nentries; i++) {
+		oldnewmap_insert_index_in_map(onm, onm->entries[i].old, i);
+	}
 }
 
 /* nr is zero for data, and ID code for libdata */
 static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
 {
 	OldNew *entry;
-	
+
 	if (oldaddr==NULL || newaddr==NULL) return;
 	
-	if (UNLIKELY(onm->nentries == onm->entriessize)) {
-		onm->entriessize *= 2;
-		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+	if (UNLIKELY(onm->nentries == OLDNEWMAP_ENTRIES_CAPACITY(onm))) {
+		oldnewmap_increase_size(onm);
 	}
 
-	entry = &onm->entries[onm->nentries++];
+	/* An address stored again gets its own entry, so oldnewmap_free_unused() still frees it,
+	 * while lookups keep returning the first one. */
+	entry = &onm->entries[onm->nentries];
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+
+	oldnewmap_insert_index_in_map(onm, oldaddr, onm->nentries);
+	onm->nentries++;
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
@@ -323,114 +382,49 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
 	oldnewmap_insert(onm, oldaddr, newaddr, nr);
 }
 
-/**
- * Do a full search (no state).
- *
- * \param lasthit: Use as a reference position to avoid a full search
- * from either end of the array, giving more efficient lookups.
- *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
- */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
+static OldNew *oldnewmap_lookup_entry(const OldNewMap *onm, const void *addr)
 {
-	const int nentries = onm->nentries;
-	const OldNew *entries = onm->entries;
-	int i;
-
-	/* search relative to lasthit where possible */
-	if (lasthit >= 0 && lasthit < nentries) {
-
-		/* search forwards */
-		i = lasthit;
-		while (++i != nentries) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-
-		/* search backwards */
-		i = lasthit + 1;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
+	OLDNEWMAP_ITER_SLOTS(onm, addr, slot, index) {
+		if (index == -1) {
+			return NULL;
 		}
-	}
-	else {
-		/* search backwards (full) */
-		i = nentries;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
+		else if (onm->entries[index].old == addr) {
+			return &onm->entries[index];
 		}
 	}
-
-	return -1;
 }
 
 static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
 {
-	int i;
+	OldNew *entry;
 	
 	if (addr == NULL) return NULL;
 	
-	if (onm->lasthit < onm->nentries-1) {
-		OldNew *entry = &onm->entries[++onm->lasthit];
-		
-		if (entry->old == addr) {
-			if (increase_users)
-				entry->nr++;
-			return entry->newp;
-		}
-	}
-	
-	i = oldnewmap_lookup_entry_full(onm, addr, onm->lasthit);
-	if (i != -1) {
-		OldNew *entry = &onm->entries[i];
-		BLI_assert(entry->old == addr);
-		onm->lasthit = i;
-		if (increase_users)
-			entry->nr++;
-		return entry->newp;
+	entry = oldnewmap_lookup_entry(onm, addr);
+	if (entry == NULL) {
+		return NULL;
 	}
 	
-	return NULL;
+	if (increase_users)
+		entry->nr++;
+	return entry->newp;
 }
 
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *lib)
 {
+	OldNew *entry;
+
 	if (addr == NULL) {
 		return NULL;
 	}
 
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		const OldNew entry_s = {.old = addr};
-		OldNew *entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
-			ID *id = entry->newp;
+	entry = oldnewmap_lookup_entry(onm, addr);
+	if (entry) {
+		ID *id = entry->newp;
 
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
-		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		const int i = oldnewmap_lookup_entry_full(onm, addr, -1);
-		if (i != -1) {
-			OldNew *entry = &onm->entries[i];
-			ID *id = entry->newp;
-			BLI_assert(entry->old == addr);
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
+		if (id && (!lib || id->lib)) {
+			return id;
 		}
 	}
 
@@ -452,16 +446,31 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 
 static void oldnewmap_clear(OldNewMap *onm) 
 {
+	/* shrink back, so a map grown by one large file doesn't stay large */
+	if (onm->capacity_exp != OLDNEWMAP_DEFAULT_SIZE_EXP) {
+		MEM_freeN(onm->entries);
+		MEM_freeN(onm->map);
+		oldnewmap_alloc(onm, OLDNEWMAP_DEFAULT_SIZE_EXP);
+	}
+	else {
+		oldnewmap_clear_map(onm);
+	}
 	onm->nentries = 0;
-	onm->lasthit = 0;
 }
 
 static void oldnewmap_free(OldNewMap *onm) 
 {
 	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
 	MEM_freeN(onm);
 }
 
+#undef OLDNEWMAP_DEFAULT_SIZE_EXP
+#undef OLDNEWMAP_ENTRIES_CAPACITY
+#undef OLDNEWMAP_MAP_CAPACITY
+#undef OLDNEWMAP_PERTURB_SHIFT
+#undef OLDNEWMAP_ITER_SLOTS
+
 /***/
 
 static void read_libraries(FileData *basefd, ListBase *mainlist);
@@ -711,6 +720,16 @@ static void bh8_from_bh4(BHead *bhead, BHead4 *bhead4)
 	}
 }
 
+/**
+ * DATA blocks of memory mapped files are not copied when reading the file structure,
+ * so data of datablocks that are never read (e.g. when linking from a library) isn't touched.
+ * Endian switching modifies the data in place, so those files are always copied.
+ */
+#define BHEAD_USE_MAPPED_DATA(fd, bhead) \
+	(((fd)->flags & FD_FLAGS_BUFFER_IS_MMAP) && \
+	 !((fd)->flags & FD_FLAGS_SWITCH_ENDIAN) && \
+	 ((bhead)->code == DATA))
+
 static BHeadN *get_bhead(FileData *fd)
 {
 	BHeadN *new_bhead = NULL;
@@ -780,10 +799,27 @@ static BHeadN *get_bhead(FileData *fd)
 			/* bhead now contains the (converted) bhead structure. Now read
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
-			if (!fd->eof) {
+			if (fd->eof) {
+				/* pass */
+			}
+			else if (BHEAD_USE_MAPPED_DATA(fd, &bhead)) {
+				/* leave the data in the mapping, it's only paged in once read_struct() copies it */
+				if (bhead.len <= fd->buffersize - fd->seek) {
+					new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data_mapped = fd->buffer + fd->seek;
+					new_bhead->bhead = bhead;
+					fd->seek += bhead.len;
+				}
+				else {
+					fd->eof = 1;
+				}
+			}
+			else {
 				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
 				if (new_bhead) {
 					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data_mapped = NULL;
 					new_bhead->bhead = bhead;
 					
 					readsize = fd->read(fd, new_bhead + 1, bhead.len);
@@ -865,6 +901,14 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	return(bhead);
 }
 
+/* Data following the bhead, which may still be in the memory mapped file. */
+const void *blo_bhead_data(const BHead *bhead)
+{
+	const BHeadN *bheadn = (const BHeadN *)POINTER_OFFSET(bhead, -offsetof(BHeadN, bhead));
+
+	return bheadn->data_mapped ? (const void *)bheadn->data_mapped : (const void *)(bhead + 1);
+}
+
 /* Warning! Caller's responsability to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
@@ -1006,6 +1050,224 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, unsigned int
 	return (readsize);
 }
 
+/* Compressed files written as independent gzip members (see #BLEN_GZIP_BLOCK_SIZE),
+ * a batch of members is read and inflated in parallel, then read from in order. */
+
+typedef struct FileDataGzipBlock {
+	unsigned char *member;
+	char *data;
+	unsigned int member_len, member_alloc;
+	unsigned int data_len, data_alloc;
+	bool error;
+} FileDataGzipBlock;
+
+typedef struct FileDataGzipBlocks {
+	TaskPool *task_pool;
+	FileDataGzipBlock *blocks;
+	int blocks_len;
+	/* members read in the next batch, starts small so reading only the header stays cheap */
+	int blocks_batch;
+	int blocks_used;
+	/* current read position */
+	int block_index;
+	unsigned int block_offset;
+	bool eof, error;
+} FileDataGzipBlocks;
+
+static unsigned int gzip_read_uint32(const unsigned char *buf)
+{
+	return ((unsigned int)buf[0] |
+	        ((unsigned int)buf[1] << 8) |
+	        ((unsigned int)buf[2] << 16) |
+	        ((unsigned int)buf[3] << 24));
+}
+
+/* \return the size of the member starting with this header, zero when it's not a block */
+static unsigned int gzip_block_member_len(const unsigned char header[BLEN_GZIP_HEADER_SIZE])
+{
+	unsigned int member_len;
+
+	if ((header[0] != 0x1f) || (header[1] != 0x8b) || (header[2] != Z_DEFLATED) || (header[3] != 4) ||
+	    (header[10] != 8) || (header[11] != 0) ||
+	    (header[12] != 'B') || (header[13] != 'L') || (header[14] != 4) || (header[15] != 0))
+	{
+		return 0;
+	}
+
+	member_len = gzip_read_uint32(&header[16]);
+
+	if (member_len <= BLEN_GZIP_HEADER_SIZE + BLEN_GZIP_TRAILER_SIZE) {
+		return 0;
+	}
+
+	return member_len;
+}
+
+static void fd_gzip_block_inflate_task(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	FileDataGzipBlock *block = taskdata;
+	const unsigned char *trailer = block->member + block->member_len - BLEN_GZIP_TRAILER_SIZE;
+	z_stream strm;
+
+	memset(&strm, 0, sizeof(strm));
+
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+		block->error = true;
+		return;
+	}
+
+	strm.next_in = block->member + BLEN_GZIP_HEADER_SIZE;
+	strm.avail_in = block->member_len - BLEN_GZIP_HEADER_SIZE - BLEN_GZIP_TRAILER_SIZE;
+	strm.next_out = (Bytef *)block->data;
+	strm.avail_out = block->data_len;
+
+	block->error = ((inflate(&strm, Z_FINISH) != Z_STREAM_END) ||
+	                (strm.total_out != block->data_len) ||
+	                (crc32(0, (const Bytef *)block->data, block->data_len) != gzip_read_uint32(trailer)));
+
+	inflateEnd(&strm);
+}
+
+static FileDataGzipBlocks *fd_gzip_blocks_new(void)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+	FileDataGzipBlocks *gzblocks = MEM_callocN(sizeof(*gzblocks), __func__);
+
+	gzblocks->task_pool = BLI_task_pool_create(scheduler, NULL);
+	gzblocks->blocks_len = 2 * BLI_task_scheduler_num_threads(scheduler);
+	gzblocks->blocks = MEM_callocN(sizeof(*gzblocks->blocks) * gzblocks->blocks_len, __func__);
+	gzblocks->blocks_batch = 1;
+
+	return gzblocks;
+}
+
+static void fd_gzip_blocks_free(FileDataGzipBlocks *gzblocks)
+{
+	int i;
+
+	BLI_task_pool_free(gzblocks->task_pool);
+
+	for (i = 0; i < gzblocks->blocks_len; i++) {
+		MEM_SAFE_FREE(gzblocks->blocks[i].member);
+		MEM_SAFE_FREE(gzblocks->blocks[i].data);
+	}
+
+	MEM_freeN(gzblocks->blocks);
+	MEM_freeN(gzblocks);
+}
+
+/* read the next batch of members from the file and inflate them */
+static bool fd_gzip_blocks_read_batch(FileData *fd)
+{
+	FileDataGzipBlocks *gzblocks = fd->gzblocks;
+	int i;
+
+	gzblocks->blocks_used = 0;
+	gzblocks->block_index = 0;
+	gzblocks->block_offset = 0;
+
+	while (gzblocks->blocks_used < gzblocks->blocks_batch) {
+		FileDataGzipBlock *block = &gzblocks->blocks[gzblocks->blocks_used];
+		unsigned char header[BLEN_GZIP_HEADER_SIZE];
+		unsigned int member_len;
+		int readsize;
+
+		readsize = read(fd->filedes, header, sizeof(header));
+
+		if (readsize == 0) {
+			gzblocks->eof = true;
+			break;
+		}
+		else if ((readsize != sizeof(header)) || ((member_len = gzip_block_member_len(header)) == 0)) {
+			gzblocks->error = true;
+			break;
+		}
+
+		if (block->member_alloc < member_len) {
+			MEM_SAFE_FREE(block->member);
+			block->member = MEM_mallocN(member_len, "FileDataGzipBlock.member");
+			block->member_alloc = member_len;
+		}
+
+		memcpy(block->member, header, sizeof(header));
+		readsize = read(fd->filedes, block->member + sizeof(header), member_len - sizeof(header));
+
+		if (readsize != (int)(member_len - sizeof(header))) {
+			gzblocks->error = true;
+			break;
+		}
+
+		/* the uncompressed size is stored in the trailer, the writer never exceeds the block size */
+		block->member_len = member_len;
+		block->data_len = gzip_read_uint32(block->member + member_len - 4);
+
+		if ((block->data_len == 0) || (block->data_len > BLEN_GZIP_BLOCK_SIZE)) {
+			gzblocks->error = true;
+			break;
+		}
+
+		if (block->data_alloc < block->data_len) {
+			MEM_SAFE_FREE(block->data);
+			block->data = MEM_mallocN(block->data_len, "FileDataGzipBlock.data");
+			block->data_alloc = block->data_len;
+		}
+
+		gzblocks->blocks_used++;
+	}
+
+	for (i = 0; i < gzblocks->blocks_used; i++) {
+		BLI_task_pool_push(gzblocks->task_pool, fd_gzip_block_inflate_task, &gzblocks->blocks[i], false, TASK_PRIORITY_HIGH);
+	}
+
+	BLI_task_pool_work_and_wait(gzblocks->task_pool);
+
+	for (i = 0; i < gzblocks->blocks_used; i++) {
+		if (gzblocks->blocks[i].error) {
+			gzblocks->error = true;
+		}
+	}
+
+	gzblocks->blocks_batch = min_ii(gzblocks->blocks_batch * 2, gzblocks->blocks_len);
+
+	return (gzblocks->blocks_used != 0) && !gzblocks->error;
+}
+
+static int fd_read_gzip_blocks_from_file(FileData *filedata, void *buffer, unsigned int size)
+{
+	FileDataGzipBlocks *gzblocks = filedata->gzblocks;
+	unsigned int readsize = 0;
+
+	while (readsize < size) {
+		FileDataGzipBlock *block;
+		unsigned int len;
+
+		if (gzblocks->block_index == gzblocks->blocks_used) {
+			if (gzblocks->eof || gzblocks->error || !fd_gzip_blocks_read_batch(filedata)) {
+				break;
+			}
+		}
+
+		block = &gzblocks->blocks[gzblocks->block_index];
+		len = min_ii(size - readsize, block->data_len - gzblocks->block_offset);
+		memcpy((char *)buffer + readsize, block->data + gzblocks->block_offset, len);
+		readsize += len;
+		gzblocks->block_offset += len;
+
+		if (gzblocks->block_offset == block->data_len) {
+			gzblocks->block_index++;
+			gzblocks->block_offset = 0;
+		}
+	}
+
+	if (gzblocks->error) {
+		return EOF;
+	}
+
+	filedata->seek += readsize;
+
+	return (int)readsize;
+}
+
 static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
 	/* don't read more bytes then there are available in the buffer */
@@ -1115,24 +1377,132 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
-/* cannot be called with relative paths anymore! */
-/* on each new library added, it now checks for the current FileData and expands relativeness */
-FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+#ifndef WIN32
+/**
+ * Reading from a mapping crashes with SIGBUS once another process truncates the file,
+ * only map files on local file systems where this is unlikely during a file load.
+ */
+static bool file_descriptor_is_local(int file)
+{
+#  if defined(__linux__)
+	struct statfs disk;
+
+	if (fstatfs(file, &disk) != 0) {
+		return false;
+	}
+
+	switch ((unsigned long)disk.f_type) {
+		case 0x6969:      /* NFS */
+		case 0x517B:      /* SMB */
+		case 0xFF534D42:  /* CIFS */
+		case 0xFE534D42:  /* SMB2 */
+		case 0x65735546:  /* FUSE */
+		case 0x73757245:  /* CODA */
+		case 0x5346414F:  /* AFS */
+		case 0x01021997:  /* 9P */
+		case 0x00C36400:  /* CEPH */
+			return false;
+		default:
+			return true;
+	}
+#  elif defined(__APPLE__)
+	struct statfs disk;
+
+	return (fstatfs(file, &disk) == 0) && (disk.f_flags & MNT_LOCAL);
+#  else
+	(void)file;
+	return false;
+#  endif
+}
+#endif
+
+/**
+ * Open a file for reading, compressed files written in blocks are read in parallel,
+ * uncompressed local files are memory mapped when \a use_mmap is set,
+ * other files are read through zlib.
+ *
+ * Only use the mapping for a FileData that is freed right after reading, e.g. not
+ * for blend handles that stay open: the mapping is shared with the file on disk.
+ */
+static FileData *blo_filedata_from_file_open(const char *filepath, const bool use_mmap)
 {
+	unsigned char header[BLEN_GZIP_HEADER_SIZE];
 	gzFile gzfile;
+	int file;
+
+	errno = 0;
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	if (read(file, header, sizeof(header)) != sizeof(header)) {
+		/* too small for any blend file, let zlib report the error */
+		memset(header, 0, sizeof(header));
+	}
+	else if ((gzip_block_member_len(header) != 0) &&
+	         (lseek(file, 0, SEEK_SET) == 0))
+	{
+		FileData *fd = filedata_new();
+		fd->filedes = file;
+		fd->gzblocks = fd_gzip_blocks_new();
+		fd->read = fd_read_gzip_blocks_from_file;
+
+		return fd;
+	}
+
+#ifndef WIN32
+	/* uncompressed files are memory mapped, blocks are then copied straight from the mapping */
+	if (use_mmap && (memcmp(header, "BLENDER", 7) == 0) && file_descriptor_is_local(file)) {
+		const size_t size = BLI_file_descriptor_size(file);
+
+		if ((size != (size_t)-1) && (size <= INT_MAX)) {
+			void *mem = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+
+			if (mem != MAP_FAILED) {
+				FileData *fd = filedata_new();
+				fd->buffer = mem;
+				fd->buffersize = (int)size;
+				fd->flags |= FD_FLAGS_BUFFER_IS_MMAP;
+				fd->read = fd_read_from_memory;
+
+				close(file);
+				return fd;
+			}
+		}
+	}
+#endif
+
+	close(file);
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
-	
-	if (gzfile == (gzFile)Z_NULL) {
+
+	if (gzfile != (gzFile)Z_NULL) {
+		FileData *fd = filedata_new();
+		fd->gzfiledes = gzfile;
+		fd->read = fd_read_gzip_from_file;
+
+		return fd;
+	}
+
+	return NULL;
+}
+
+/* cannot be called with relative paths anymore! */
+/* on each new library added, it now checks for the current FileData and expands relativeness */
+/* use_mmap: see blo_filedata_from_file_open() */
+FileData *blo_openblenderfile(const char *filepath, ReportList *reports, const bool use_mmap)
+{
+	FileData *fd = blo_filedata_from_file_open(filepath, use_mmap);
+
+	if (fd == NULL) {
 		BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
 		            filepath, errno ? strerror(errno) : TIP_("unknown error reading file"));
 		return NULL;
 	}
 	else {
-		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
-		
 		/* needed for library_append and read_libraries */
 		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
 		
@@ -1146,15 +1516,9 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
  */
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
-	gzFile gzfile;
-	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
-
-	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
+	FileData *fd = blo_filedata_from_file_open(filepath, false);
 
+	if (fd != NULL) {
 		decode_blender_header(fd);
 
 		if (fd->flags & FD_FLAGS_FILE_OK) {
@@ -1175,14 +1539,19 @@ static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, unsigned i
 	filedata->strm.avail_out = size;
 
 	// Inflate another chunk.
-	err = inflate (&filedata->strm, Z_SYNC_FLUSH);
+	while (filedata->strm.avail_out != 0) {
+		err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
-	if (err == Z_STREAM_END) {
-		return 0;
-	}
-	else if (err != Z_OK) {
-		printf("fd_read_gzip_from_memory: zlib error\n");
-		return 0;
+		if (err == Z_STREAM_END) {
+			/* compressed files may consist of multiple gzip members */
+			if ((filedata->strm.avail_in == 0) || (inflateReset(&filedata->strm) != Z_OK)) {
+				return 0;
+			}
+		}
+		else if (err != Z_OK) {
+			printf("fd_read_gzip_from_memory: zlib error\n");
+			return 0;
+		}
 	}
 
 	filedata->seek += size;
@@ -1265,13 +1634,23 @@ void blo_freefiledata(FileData *fd)
 			gzclose(fd->gzfiledes);
 		}
 		
+		if (fd->gzblocks != NULL) {
+			fd_gzip_blocks_free(fd->gzblocks);
+		}
+		
 		if (fd->strm.next_in) {
 			if (inflateEnd(&fd->strm) != Z_OK) {
 				printf("close gzip stream error\n");
 			}
 		}
 		
-		if (fd->buffer && !(fd->flags & FD_FLAGS_NOT_MY_BUFFER)) {
+		if (fd->buffer && (fd->flags & FD_FLAGS_BUFFER_IS_MMAP)) {
+#ifndef WIN32
+			munmap((void *)fd->buffer, (size_t)fd->buffersize);
+#endif
+			fd->buffer = NULL;
+		}
+		else if (fd->buffer && !(fd->flags & FD_FLAGS_NOT_MY_BUFFER)) {
 			MEM_freeN((void *)fd->buffer);
 			fd->buffer = NULL;
 		}
@@ -1432,31 +1811,6 @@ static void *newdataadr(FileData *fd, const void *adr)		/* only direct databocks
 	return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
-/* This is a special version of newdataadr() which allows us to keep lasthit of
- * map unchanged. In certain cases this makes file loading time significantly
- * faster.
- *
- * Use this function in cases like restoring pointer from one list element to
- * another list element, but keep lasthit value so we can continue restoring
- * pointers efficiently.
- *
- * Example of this could be found in direct_link_fcurves() which restores the
- * fcurve group pointer and keeps lasthit optimal for linking all further
- * fcurves.
- */
-static void *newdataadr_ex(FileData *fd, const void *adr, bool increase_lasthit)		/* only direct databocks */
-{
-	if (increase_lasthit) {
-		return newdataadr(fd, adr);
-	}
-	else {
-		int lasthit = fd->datamap->lasthit;
-		void *newadr = newdataadr(fd, adr);
-		fd->datamap->lasthit = lasthit;
-		return newadr;
-	}
-}
-
 static void *newdataadr_no_us(FileData *fd, const void *adr)		/* only direct databocks */
 {
 	return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
@@ -1534,9 +1888,6 @@ static void change_idid_adr_fd(FileData *fd, const void *old, void *new)
 {
 	int i;
 	
-	/* use a binary search if we have a sorted libmap, for now it's not needed. */
-	BLI_assert(fd->libmap->sorted == false);
-
 	for (i = 0; i < fd->libmap->nentries; i++) {
 		OldNew *entry = &fd->libmap->entries[i];
 		
@@ -1878,12 +2229,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, blo_bhead_data(bh));
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, blo_bhead_data(bh), bh->len);
 			}
 		}
 	}
@@ -2451,7 +2802,7 @@ static void direct_link_fcurves(FileData *fd, ListBase *list)
 		fcu->rna_path = newdataadr(fd, fcu->rna_path);
 		
 		/* group */
-		fcu->grp = newdataadr_ex(fd, fcu->grp, false);
+		fcu->grp = newdataadr(fd, fcu->grp);
 		
 		/* clear disabled flag - allows disabled drivers to be tried again ([#32155]),
 		 * but also means that another method for "reviving disabled F-Curves" exists
@@ -8369,8 +8720,6 @@ static void do_versions_after_linking(FileData *fd, Library *lib, Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
-	
 	/* No load UI for undo memfiles */
 	if (fd->memfile == NULL) {
 		lib_link_windowmanager(fd, main);
@@ -10200,6 +10549,129 @@ static int mainvar_id_tag_any_check(Main *mainvar, const short tag)
 	return false;
 }
 
+/**
+ * Opening library files and reading their file structure is I/O bound (especially on network storage),
+ * so all libraries about to be read in a pass are opened in parallel first.
+ * Reading their datablocks, expanding and linking stays on the main thread.
+ */
+typedef struct LibraryOpenTask {
+	Main *mainptr;
+	FileData *fd;
+	/* reports of the worker thread, moved to the main reports in read order */
+	ReportList reports;
+} LibraryOpenTask;
+
+static bool read_libraries_needs_open(Main *mainptr)
+{
+	return ((mainptr->curlib->filedata == NULL) &&
+	        (mainptr->curlib->packedfile == NULL) &&
+	        mainvar_id_tag_any_check(mainptr, LIB_TAG_READ));
+}
+
+static void read_libraries_open_task(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	LibraryOpenTask *task = taskdata;
+	FileData *fd = blo_openblenderfile(task->mainptr->curlib->filepath, &task->reports, true);
+
+	if (fd) {
+		/* reads all BHeads, instead of on demand while linking */
+#ifdef USE_GHASH_BHEAD
+		read_file_bhead_idname_map_create(fd);
+#else
+		BHead *bhead;
+		for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+			/* pass */
+		}
+#endif
+	}
+
+	task->fd = fd;
+}
+
+/* \return NULL when there's nothing to do in parallel */
+static LibraryOpenTask *read_libraries_open_parallel(Main *mainl, int *r_tasks_len)
+{
+	LibraryOpenTask *tasks;
+	TaskPool *task_pool;
+	Main *mainptr;
+	int tasks_len = 0, i;
+
+	for (mainptr = mainl->next; mainptr; mainptr = mainptr->next) {
+		if (read_libraries_needs_open(mainptr)) {
+			tasks_len++;
+		}
+	}
+
+	*r_tasks_len = tasks_len;
+
+	if (tasks_len < 2) {
+		return NULL;
+	}
+
+	tasks = MEM_callocN(sizeof(*tasks) * tasks_len, __func__);
+	task_pool = BLI_task_pool_create(BLI_task_scheduler_get(), NULL);
+
+	for (mainptr = mainl->next, i = 0; mainptr; mainptr = mainptr->next) {
+		if (read_libraries_needs_open(mainptr)) {
+			LibraryOpenTask *task = &tasks[i++];
+			task->mainptr = mainptr;
+			BKE_reports_init(&task->reports, RPT_STORE);
+			BLI_task_pool_push(task_pool, read_libraries_open_task, task, false, TASK_PRIORITY_HIGH);
+		}
+	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	return tasks;
+}
+
+/* Take the file opened for this library, \a r_found is false when it wasn't opened in parallel. */
+static FileData *read_libraries_open_take(
+        LibraryOpenTask *tasks, int tasks_len, Main *mainptr, ReportList *reports, bool *r_found)
+{
+	int i;
+
+	for (i = 0; i < tasks_len; i++) {
+		LibraryOpenTask *task = &tasks[i];
+
+		if (task->mainptr == mainptr) {
+			FileData *fd = task->fd;
+			Report *report;
+
+			for (report = task->reports.list.first; report; report = report->next) {
+				BKE_report(reports, report->type, report->message);
+			}
+			BKE_reports_clear(&task->reports);
+
+			task->mainptr = NULL;
+			task->fd = NULL;
+
+			*r_found = true;
+			return fd;
+		}
+	}
+
+	*r_found = false;
+	return NULL;
+}
+
+static void read_libraries_open_free(LibraryOpenTask *tasks, int tasks_len)
+{
+	int i;
+
+	for (i = 0; i < tasks_len; i++) {
+		if (tasks[i].mainptr) {
+			if (tasks[i].fd) {
+				blo_freefiledata(tasks[i].fd);
+			}
+			BKE_reports_clear(&tasks[i].reports);
+		}
+	}
+
+	MEM_freeN(tasks);
+}
+
 static void read_libraries(FileData *basefd, ListBase *mainlist)
 {
 	Main *mainl = mainlist->first;
@@ -10212,8 +10684,13 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 	BLO_main_expander(expand_doit_library);
 	
 	while (do_it) {
+		LibraryOpenTask *open_tasks;
+		int open_tasks_len;
+		
 		do_it = false;
 		
+		open_tasks = read_libraries_open_parallel(mainl, &open_tasks_len);
+		
 		/* test 1: read libdata */
 		mainptr= mainl->next;
 		while (mainptr) {
@@ -10241,12 +10718,20 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						BLI_strncpy(fd->relabase, mainptr->curlib->filepath, sizeof(fd->relabase));
 					}
 					else {
+						bool is_open = false;
+						
 						blo_reportf_wrap(
 						        basefd->reports, RPT_INFO, TIP_("Read library:  '%s', '%s', parent '%s'"),
 						        mainptr->curlib->filepath,
 						        mainptr->curlib->name,
 						        library_parent_filepath(mainptr->curlib));
-						fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+						
+						if (open_tasks) {
+							fd = read_libraries_open_take(open_tasks, open_tasks_len, mainptr, basefd->reports, &is_open);
+						}
+						if (!is_open) {
+							fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports, true);
+						}
 					}
 					/* allow typing in a new lib path */
 					if (G.debug_value == -666) {
@@ -10263,7 +10748,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 								BLI_strncpy(mainptr->curlib->filepath, newlib_path, sizeof(mainptr->curlib->filepath));
 								BLI_cleanup_path(G.main->name, mainptr->curlib->filepath);
 								
-								fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+								fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports, true);
 
 								if (fd) {
 									fd->mainlist = mainlist;
@@ -10293,7 +10778,10 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						/* subversion */
 						read_file_version(fd, mainptr);
 #ifdef USE_GHASH_BHEAD
-						read_file_bhead_idname_map_create(fd);
+						/* already created when opened in parallel */
+						if (fd->bhead_idname_hash == NULL) {
+							read_file_bhead_idname_map_create(fd);
+						}
 #endif
 
 					}
@@ -10338,6 +10826,10 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 			
 			mainptr = mainptr->next;
 		}
+		
+		if (open_tasks) {
+			read_libraries_open_free(open_tasks, open_tasks_len);
+		}
 	}
 	
 	/* test if there are unread libblocks */
@@ -61,6 +61,8 @@ typedef struct FileData {
 	// variables needed for reading from file
 	int filedes;
 	gzFile gzfiledes;
+	// compressed members inflated in parallel, see BLEN_GZIP_BLOCK_SIZE
+	struct FileDataGzipBlocks *gzblocks;
 
 	// now only in use for library appending
 	char relabase[FILE_MAX];
@@ -107,6 +109,8 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* data of blocks left in a memory mapped file, NULL when it follows bhead */
+	const char *data_mapped;
 	struct BHead bhead;
 } BHeadN;
 
@@ -118,6 +122,7 @@ enum {
 	FD_FLAGS_FILE_OK               = 1 << 3,
 	FD_FLAGS_NOT_MY_BUFFER         = 1 << 4,
 	FD_FLAGS_NOT_MY_LIBMAP         = 1 << 5,  /* XXX Unused in practice (checked once but never set). */
+	FD_FLAGS_BUFFER_IS_MMAP        = 1 << 6,  /* buffer is a memory mapped file */
 };
 
 #define SIZEOFBLENDERHEADER 12
@@ -129,7 +134,7 @@ void blo_split_main(ListBase *mainlist, struct Main *main);
 
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath);
 
-FileData *blo_openblenderfile(const char *filepath, struct ReportList *reports);
+FileData *blo_openblenderfile(const char *filepath, struct ReportList *reports, const bool use_mmap);
 FileData *blo_openblendermemory(const void *buffer, int buffersize, struct ReportList *reports);
 FileData *blo_openblendermemfile(struct MemFile *memfile, struct ReportList *reports);
 
@@ -151,6 +156,7 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
 
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
+const void *blo_bhead_data(const BHead *bhead);
 
 /* do versions stuff */
 
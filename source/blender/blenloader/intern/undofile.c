@@ -40,19 +40,97 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* Chunk buffers are content addressed: all buffers alive in any undo step are
+ * kept in a table hashed by their contents, so a new chunk reuses an existing
+ * copy no matter where it was in an earlier step. Adding or removing a
+ * datablock only shifts the positions of following chunks, without this they
+ * would all have been copied again. */
+
+typedef struct MemFileChunkBuffer {
+	char *data;
+	unsigned int size;
+	unsigned int hash;
+	unsigned int users;
+} MemFileChunkBuffer;
+
+static GHash *memfile_buffers = NULL;
+
+static unsigned int memfile_buffer_hash(const void *key)
+{
+	return ((const MemFileChunkBuffer *)key)->hash;
+}
+
+static bool memfile_buffer_cmp(const void *a, const void *b)
+{
+	const MemFileChunkBuffer *buffer_a = a;
+	const MemFileChunkBuffer *buffer_b = b;
+	
+	return ((buffer_a->size != buffer_b->size) ||
+	        (memcmp(buffer_a->data, buffer_b->data, buffer_a->size) != 0));
+}
+
+/* returns a buffer with the given contents, r_is_new is set when it had to be copied */
+static MemFileChunkBuffer *memfile_buffer_ensure(const char *buf, unsigned int size, bool *r_is_new)
+{
+	MemFileChunkBuffer key, *buffer;
+	
+	key.data = (char *)buf;
+	key.size = size;
+	key.hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+	key.users = 0;
+	
+	if (memfile_buffers == NULL) {
+		memfile_buffers = BLI_ghash_new(memfile_buffer_hash, memfile_buffer_cmp, __func__);
+	}
+	
+	buffer = BLI_ghash_lookup(memfile_buffers, &key);
+	*r_is_new = (buffer == NULL);
+	
+	if (buffer == NULL) {
+		buffer = MEM_mallocN(sizeof(MemFileChunkBuffer), "MemFileChunkBuffer");
+		buffer->data = MEM_mallocN(size, "Chunk buffer");
+		memcpy(buffer->data, buf, size);
+		buffer->size = size;
+		buffer->hash = key.hash;
+		buffer->users = 0;
+		BLI_ghash_insert(memfile_buffers, buffer, buffer);
+	}
+	
+	buffer->users++;
+	return buffer;
+}
+
+static void memfile_buffer_release(MemFileChunkBuffer *buffer)
+{
+	BLI_assert(buffer->users > 0);
+	
+	if (--buffer->users == 0) {
+		BLI_ghash_remove(memfile_buffers, buffer, NULL, NULL);
+		MEM_freeN(buffer->data);
+		MEM_freeN(buffer);
+		
+		/* free the table along with the last undo step, so nothing is left on exit */
+		if (BLI_ghash_size(memfile_buffers) == 0) {
+			BLI_ghash_free(memfile_buffers, NULL, NULL);
+			memfile_buffers = NULL;
+		}
+	}
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ((chunk = BLI_pophead(&memfile->chunks))) {
-		if (chunk->ident == 0)
-			MEM_freeN(chunk->buf);
+		memfile_buffer_release(chunk->shared);
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
@@ -60,23 +138,9 @@ void BLO_memfile_free(MemFile *memfile)
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+void BLO_memfile_merge(MemFile *first, MemFile *UNUSED(second))
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
-		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
-	}
-	
+	/* buffers are reference counted, the ones still used by 'second' stay alive */
 	BLO_memfile_free(first);
 }
 
@@ -84,6 +148,7 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 {
 	static MemFileChunk *compchunk = NULL;
 	MemFileChunk *curchunk;
+	MemFileChunkBuffer *buffer = NULL;
 	
 	/* this function inits when compare != NULL or when current == NULL  */
 	if (compare) {
@@ -97,26 +162,29 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
-	curchunk->buf = NULL;
-	curchunk->ident = 0;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	/* fast path, compare with the chunk at the same position in the previous step */
 	if (compchunk) {
-		if (compchunk->size == curchunk->size) {
+		if (compchunk->size == size) {
 			if (memcmp(compchunk->buf, buf, size) == 0) {
-				curchunk->buf = compchunk->buf;
-				curchunk->ident = 1;
+				buffer = compchunk->shared;
+				buffer->users++;
 			}
 		}
 		compchunk = compchunk->next;
 	}
 	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
-		current->size += size;
+	/* otherwise look for identical contents anywhere in the undo stack */
+	if (buffer == NULL) {
+		bool is_new;
+		
+		buffer = memfile_buffer_ensure(buf, size, &is_new);
+		if (is_new) {
+			current->size += size;
+		}
 	}
+	
+	curchunk->shared = buffer;
+	curchunk->buf = buffer->data;
 }
-
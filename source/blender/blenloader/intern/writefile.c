@@ -154,6 +154,8 @@
 #include "BLI_blenlib.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -215,7 +217,7 @@ struct WriteWrap {
 	/* internal */
 	union {
 		int file_handle;
-		gzFile gz_handle;
+		struct WriteWrapZlib *zlib;
 	} _user_data;
 };
 
@@ -247,33 +249,197 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) \
-	(ww)->_user_data.gz_handle
+/* zlib, compressed in parallel as independent gzip members, see #BLEN_GZIP_BLOCK_SIZE */
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+typedef struct WriteWrapZlibBlock {
+	char *data;
+	size_t data_len;
+	unsigned char *member;
+	size_t member_len;
+	bool error;
+} WriteWrapZlibBlock;
+
+typedef struct WriteWrapZlib {
+	int file_handle;
+	TaskPool *task_pool;
+	/* blocks compressed together, the last used one may be partially filled */
+	WriteWrapZlibBlock *blocks;
+	int blocks_len, blocks_used;
+	size_t member_alloc;
+	bool error;
+} WriteWrapZlib;
+
+#define ZLIB_HANDLE(ww) \
+	(ww)->_user_data.zlib
+
+static void ww_zlib_write_uint32(unsigned char *buf, unsigned int value)
 {
-	gzFile file;
+	buf[0] = (unsigned char)(value);
+	buf[1] = (unsigned char)(value >> 8);
+	buf[2] = (unsigned char)(value >> 16);
+	buf[3] = (unsigned char)(value >> 24);
+}
 
-	file = BLI_gzopen(filepath, "wb1");
+static void ww_zlib_compress_block_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	const WriteWrapZlib *zlib = BLI_task_pool_userdata(pool);
+	WriteWrapZlibBlock *block = taskdata;
+	unsigned char *header = block->member;
+	unsigned char *trailer;
+	z_stream strm;
 
-	if (file != Z_NULL) {
-		FILE_HANDLE(ww) = file;
-		return true;
+	memset(&strm, 0, sizeof(strm));
+
+	/* raw deflate, the gzip header and trailer are written here */
+	if (deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		block->error = true;
+		return;
 	}
-	else {
+
+	strm.next_in = (Bytef *)block->data;
+	strm.avail_in = (uInt)block->data_len;
+	strm.next_out = block->member + BLEN_GZIP_HEADER_SIZE;
+	strm.avail_out = (uInt)(zlib->member_alloc - BLEN_GZIP_HEADER_SIZE - BLEN_GZIP_TRAILER_SIZE);
+
+	block->error = (deflate(&strm, Z_FINISH) != Z_STREAM_END);
+	block->member_len = BLEN_GZIP_HEADER_SIZE + strm.total_out + BLEN_GZIP_TRAILER_SIZE;
+	deflateEnd(&strm);
+
+	if (block->error) {
+		return;
+	}
+
+	/* id, deflate, FEXTRA flag, no mtime, xfl, unknown os */
+	header[0] = 0x1f;
+	header[1] = 0x8b;
+	header[2] = Z_DEFLATED;
+	header[3] = 4;
+	memset(&header[4], 0, 5);
+	header[9] = 255;
+	/* xlen, then the 'BL' subfield holding the size of this member */
+	header[10] = 8;
+	header[11] = 0;
+	header[12] = 'B';
+	header[13] = 'L';
+	header[14] = 4;
+	header[15] = 0;
+	ww_zlib_write_uint32(&header[16], (unsigned int)block->member_len);
+
+	trailer = block->member + block->member_len - BLEN_GZIP_TRAILER_SIZE;
+	ww_zlib_write_uint32(&trailer[0], (unsigned int)crc32(0, (const Bytef *)block->data, (uInt)block->data_len));
+	ww_zlib_write_uint32(&trailer[4], (unsigned int)block->data_len);
+}
+
+/* compress all used blocks and write them out in order */
+static void ww_zlib_flush(WriteWrapZlib *zlib)
+{
+	int i;
+
+	for (i = 0; i < zlib->blocks_used; i++) {
+		BLI_task_pool_push(zlib->task_pool, ww_zlib_compress_block_task, &zlib->blocks[i], false, TASK_PRIORITY_HIGH);
+	}
+
+	BLI_task_pool_work_and_wait(zlib->task_pool);
+
+	for (i = 0; i < zlib->blocks_used; i++) {
+		WriteWrapZlibBlock *block = &zlib->blocks[i];
+
+		if (!zlib->error) {
+			if (block->error || ((size_t)write(zlib->file_handle, block->member, block->member_len) != block->member_len)) {
+				zlib->error = true;
+			}
+		}
+		block->data_len = 0;
+	}
+
+	zlib->blocks_used = 0;
+}
+
+static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+{
+	TaskScheduler *scheduler;
+	WriteWrapZlib *zlib;
+	int file, i;
+
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+	if (file == -1) {
 		return false;
 	}
+
+	scheduler = BLI_task_scheduler_get();
+
+	zlib = MEM_callocN(sizeof(*zlib), __func__);
+	zlib->file_handle = file;
+	zlib->task_pool = BLI_task_pool_create(scheduler, zlib);
+	/* twice the number of threads, to even out blocks that compress slower */
+	zlib->blocks_len = 2 * BLI_task_scheduler_num_threads(scheduler);
+	zlib->blocks = MEM_callocN(sizeof(*zlib->blocks) * zlib->blocks_len, __func__);
+	/* compressBound() includes the zlib wrapper, enough for raw deflate too */
+	zlib->member_alloc = BLEN_GZIP_HEADER_SIZE + compressBound(BLEN_GZIP_BLOCK_SIZE) + BLEN_GZIP_TRAILER_SIZE;
+
+	for (i = 0; i < zlib->blocks_len; i++) {
+		zlib->blocks[i].data = MEM_mallocN(BLEN_GZIP_BLOCK_SIZE, "WriteWrapZlibBlock.data");
+		zlib->blocks[i].member = MEM_mallocN(zlib->member_alloc, "WriteWrapZlibBlock.member");
+	}
+
+	ZLIB_HANDLE(ww) = zlib;
+	return true;
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-	return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+	WriteWrapZlib *zlib = ZLIB_HANDLE(ww);
+	bool ok;
+	int i;
+
+	if (zlib->blocks_used) {
+		ww_zlib_flush(zlib);
+	}
+
+	ok = !zlib->error;
+	ok &= (close(zlib->file_handle) != -1);
+
+	BLI_task_pool_free(zlib->task_pool);
+	for (i = 0; i < zlib->blocks_len; i++) {
+		MEM_freeN(zlib->blocks[i].data);
+		MEM_freeN(zlib->blocks[i].member);
+	}
+	MEM_freeN(zlib->blocks);
+	MEM_freeN(zlib);
+
+	ZLIB_HANDLE(ww) = NULL;
+	return ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-	return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+	WriteWrapZlib *zlib = ZLIB_HANDLE(ww);
+	size_t written = 0;
+
+	/* only copy into blocks here, compression runs once all blocks are full */
+	while ((written < buf_len) && !zlib->error) {
+		WriteWrapZlibBlock *block;
+		size_t len;
+
+		if ((zlib->blocks_used == 0) ||
+		    (zlib->blocks[zlib->blocks_used - 1].data_len == BLEN_GZIP_BLOCK_SIZE))
+		{
+			if (zlib->blocks_used == zlib->blocks_len) {
+				ww_zlib_flush(zlib);
+				continue;
+			}
+			zlib->blocks_used++;
+		}
+
+		block = &zlib->blocks[zlib->blocks_used - 1];
+		len = MIN2(buf_len - written, BLEN_GZIP_BLOCK_SIZE - block->data_len);
+		memcpy(block->data + block->data_len, buf + written, len);
+		block->data_len += len;
+		written += len;
+	}
+
+	return zlib->error ? 0 : buf_len;
 }
-#undef FILE_HANDLE
+#undef ZLIB_HANDLE
 
 /* --- end compression types --- */
 
@@ -119,7 +119,9 @@ typedef struct ThreadInfo {
 KX_BlenderSceneConverter::KX_BlenderSceneConverter(
 							Main *maggie,
 							KX_KetsjiEngine *engine)
-							:m_maggie(maggie),
+							:m_mergemaxitems(0),
+							m_mergemaxtime(0.0),
+							m_maggie(maggie),
 							m_ketsjiEngine(engine),
 							m_alwaysUseExpandFraming(false),
 							m_usemat(false),
@@ -296,6 +298,9 @@ void KX_BlenderSceneConverter::ConvertScene(KX_Scene *destinationscene, RAS_IRas
 void KX_BlenderSceneConverter::RemoveScene(KX_Scene *scene)
 {
 	int i, size;
+
+	RemoveMergeScene(scene);
+
 	// delete the scene first as it will stop the use of entities
 	delete scene;
 	// delete the entities of this scene
@@ -779,32 +784,159 @@ Main *KX_BlenderSceneConverter::GetMainDynamicPath(const char *path)
 	return NULL;
 }
 
+// Scenes converted by async_convert and waiting to be merged by MergeAsyncLoads
+typedef struct MergeData {
+	vector<KX_Scene *> m_scenes;
+	// Index of the scene currently being merged
+	unsigned int m_index;
+} MergeData;
+
+void KX_BlenderSceneConverter::SetMergeBudget(unsigned int maxitems, double maxtime)
+{
+	m_mergemaxitems = maxitems;
+	m_mergemaxtime = maxtime;
+}
+
+unsigned int KX_BlenderSceneConverter::GetMergeMaxItems() const
+{
+	return m_mergemaxitems;
+}
+
+double KX_BlenderSceneConverter::GetMergeMaxTime() const
+{
+	return m_mergemaxtime;
+}
+
 void KX_BlenderSceneConverter::MergeAsyncLoads()
 {
-	vector<KX_Scene *> *merge_scenes;
+	MergeAsyncLoads(m_mergemaxitems, m_mergemaxtime);
+}
+
+void KX_BlenderSceneConverter::MergeAsyncLoads(unsigned int maxitems, double maxtime)
+{
+	MergeData *merge_data;
 
 	vector<KX_LibLoadStatus *>::iterator mit;
-	vector<KX_Scene *>::iterator sit;
+
+	const double starttime = PIL_check_seconds_timer();
+	bool outoftime = false;
+
+	// Scenes of cancelled loads, removed once the mutex is released since RemoveScene locks it.
+	vector<KX_Scene *> removed;
 
 	BLI_mutex_lock(&m_threadinfo->m_mutex);
 
-	for (mit = m_mergequeue.begin(); mit != m_mergequeue.end(); ++mit) {
-		merge_scenes = (vector<KX_Scene *> *)(*mit)->GetData();
+	for (mit = m_mergequeue.begin(); mit != m_mergequeue.end() && !outoftime;) {
+		KX_LibLoadStatus *status = *mit;
+		merge_data = (MergeData *)status->GetData();
+
+		const bool merging = (merge_data->m_index > 0) ||
+		                     (merge_data->m_index < merge_data->m_scenes.size() &&
+		                      merge_data->m_scenes[merge_data->m_index]->GetMergeProgress() > 0.0f);
+
+		if (status->IsCancelled() && !merging) {
+			// Nothing was merged yet, just drop the converted scenes.
+			removed.insert(removed.end(), merge_data->m_scenes.begin(), merge_data->m_scenes.end());
+			merge_data->m_index = merge_data->m_scenes.size();
+		}
+
+		while (merge_data->m_index < merge_data->m_scenes.size()) {
+			KX_Scene *scene = merge_data->m_scenes[merge_data->m_index];
+
+			const bool done = status->GetMergeScene()->MergeSceneStep(scene, maxitems);
+			if (done) {
+				delete scene;
+				merge_data->m_index++;
+			}
+
+			// Conversion is 90% of the progress and merging the last 10%.
+			const float merged = (done) ? (float)merge_data->m_index : merge_data->m_index + scene->GetMergeProgress();
+			status->SetProgress(0.9f + 0.1f * merged / merge_data->m_scenes.size());
 
-		for (sit=merge_scenes->begin(); sit!=merge_scenes->end(); ++sit) {
-			(*mit)->GetMergeScene()->MergeScene(*sit);
-			delete (*sit);
+			if (maxtime > 0.0 && PIL_check_seconds_timer() - starttime > maxtime) {
+				outoftime = true;
+			}
+			if (!done || outoftime) {
+				break;
+			}
+		}
+
+		if (merge_data->m_index < merge_data->m_scenes.size()) {
+			++mit;
+			continue;
 		}
 
-		delete merge_scenes;
-		(*mit)->SetData(NULL);
+		delete merge_data;
+		status->SetData(NULL);
+
+		status->Finish();
 
-		(*mit)->Finish();
+		mit = m_mergequeue.erase(mit);
 	}
 
-	m_mergequeue.clear();
+	BLI_mutex_unlock(&m_threadinfo->m_mutex);
+
+	for (unsigned int i = 0; i < removed.size(); ++i) {
+		RemoveScene(removed[i]);
+	}
+}
+
+void KX_BlenderSceneConverter::RemoveMergeScene(KX_Scene *scene)
+{
+	if (!m_threadinfo) {
+		return;
+	}
+
+	vector<KX_Scene *> removed;
+
+	BLI_mutex_lock(&m_threadinfo->m_mutex);
+
+	vector<KX_LibLoadStatus *>::iterator mit;
+	for (mit = m_mergequeue.begin(); mit != m_mergequeue.end();) {
+		KX_LibLoadStatus *status = *mit;
+		if (status->GetMergeScene() != scene) {
+			++mit;
+			continue;
+		}
+
+		MergeData *merge_data = (MergeData *)status->GetData();
+
+		if (merge_data->m_index < merge_data->m_scenes.size()) {
+			KX_Scene *other = merge_data->m_scenes[merge_data->m_index];
+
+			// A started merge already moved buckets into the removed scene, complete it
+			// so the objects are freed along with the scene.
+			if (other->GetMergeProgress() > 0.0f) {
+				scene->MergeSceneStep(other, 0);
+				delete other;
+				merge_data->m_index++;
+			}
+		}
+
+		removed.insert(removed.end(), merge_data->m_scenes.begin() + merge_data->m_index, merge_data->m_scenes.end());
+
+		delete merge_data;
+		status->SetData(NULL);
+
+		status->Finish();
+
+		mit = m_mergequeue.erase(mit);
+	}
+
+	// Loads still converting are cancelled, they never reach the removed scene.
+	map<char *, KX_LibLoadStatus *>::iterator sit;
+	for (sit = m_status_map.begin(); sit != m_status_map.end(); ++sit) {
+		KX_LibLoadStatus *status = sit->second;
+		if (status->GetMergeScene() == scene && !status->IsFinished()) {
+			status->Cancel();
+		}
+	}
 
 	BLI_mutex_unlock(&m_threadinfo->m_mutex);
+
+	for (unsigned int i = 0; i < removed.size(); ++i) {
+		RemoveScene(removed[i]);
+	}
 }
 
 void KX_BlenderSceneConverter::FinalizeAsyncLoads()
@@ -814,7 +946,7 @@ void KX_BlenderSceneConverter::FinalizeAsyncLoads()
 		BLI_task_pool_work_and_wait(m_threadinfo->m_pool);
 	}
 	// Merge all libraries data in the current scene, to avoid memory leak of unmerged scenes.
-	MergeAsyncLoads();
+	MergeAsyncLoads(0, 0.0);
 }
 
 void KX_BlenderSceneConverter::AddScenesToMergeQueue(KX_LibLoadStatus *status)
@@ -829,19 +961,24 @@ static void async_convert(TaskPool *pool, void *ptr, int UNUSED(threadid))
 	KX_Scene *new_scene = NULL;
 	KX_LibLoadStatus *status = (KX_LibLoadStatus *)ptr;
 	vector<Scene *> *scenes = (vector<Scene *> *)status->GetData();
-	vector<KX_Scene *> *merge_scenes = new vector<KX_Scene *>(); // Deleted in MergeAsyncLoads
+	MergeData *merge_data = new MergeData(); // Deleted in MergeAsyncLoads
+	merge_data->m_index = 0;
 
 	for (unsigned int i = 0; i < scenes->size(); ++i) {
+		// Stop converting the remaining scenes, MergeAsyncLoads frees the converted ones.
+		if (status->IsCancelled())
+			break;
+
 		new_scene = status->GetEngine()->CreateScene((*scenes)[i], true);
 
 		if (new_scene)
-			merge_scenes->push_back(new_scene);
+			merge_data->m_scenes.push_back(new_scene);
 
 		status->AddProgress((1.0f / scenes->size()) * 0.9f); // We'll call conversion 90% and merging 10% for now
 	}
 
 	delete scenes;
-	status->SetData(merge_scenes);
+	status->SetData(merge_data);
 
 	status->GetConverter()->AddScenesToMergeQueue(status);
 }
@@ -69,6 +69,10 @@ class KX_BlenderSceneConverter : public KX_ISceneConverter
 	vector<class KX_LibLoadStatus*> m_mergequeue;
 	ThreadInfo	*m_threadinfo;
 
+	// Per frame budget of MergeAsyncLoads, 0 for no limit
+	unsigned int m_mergemaxitems;
+	double m_mergemaxtime;
+
 	// Cached material conversions
 	MaterialCache m_mat_cache;
 	PolyMaterialCache m_polymat_cache;
@@ -97,6 +101,10 @@ class KX_BlenderSceneConverter : public KX_ISceneConverter
 	bool					m_useglslmat;
 	bool					m_use_mat_cache;
 
+	/* Finish or drop the asynchronous loads merging into scene, which is
+	 * about to be removed. */
+	void RemoveMergeScene(class KX_Scene *scene);
+
 public:
 	KX_BlenderSceneConverter(
 		Main* maggie,
@@ -186,6 +194,20 @@ public:
 	virtual void MergeAsyncLoads();
 	virtual void FinalizeAsyncLoads();
 	void AddScenesToMergeQueue(class KX_LibLoadStatus *status);
+
+	/**
+	 * Merge the pending asynchronous loads.
+	 * \param maxitems The number of objects and buckets merged per scene
+	 * and per call, 0 for no limit.
+	 * \param maxtime Stop merging after this many seconds, 0 for no limit.
+	 */
+	void MergeAsyncLoads(unsigned int maxitems, double maxtime);
+
+	/* Budget used by MergeAsyncLoads every logic frame, spreads the merge
+	 * of big libraries over several frames. */
+	void SetMergeBudget(unsigned int maxitems, double maxtime);
+	unsigned int GetMergeMaxItems() const;
+	double GetMergeMaxTime() const;
  
 	void PrintStats() {
 		printf("BGE STATS!\n");
@@ -37,7 +37,8 @@ KX_LibLoadStatus::KX_LibLoadStatus(class KX_BlenderSceneConverter* kx_converter,
 			m_data(NULL),
 			m_libname(path),
 			m_progress(0.0f),
-			m_finished(false)
+			m_finished(false),
+			m_cancelled(false)
 #ifdef WITH_PYTHON
 			,
 			m_finish_cb(NULL),
@@ -57,6 +58,11 @@ void KX_LibLoadStatus::Finish()
 	RunProgressCallback();
 }
 
+void KX_LibLoadStatus::Cancel()
+{
+	m_cancelled = true;
+}
+
 void KX_LibLoadStatus::RunFinishCallback()
 {
 #ifdef WITH_PYTHON
@@ -150,6 +156,7 @@ void KX_LibLoadStatus::AddProgress(float progress)
 
 PyMethodDef KX_LibLoadStatus::Methods[] = 
 {
+	KX_PYMETHODTABLE_NOARGS(KX_LibLoadStatus, cancel),
 	{NULL} //Sentinel
 };
 
@@ -160,6 +167,7 @@ PyAttributeDef KX_LibLoadStatus::Attributes[] = {
 	KX_PYATTRIBUTE_STRING_RO("libraryName", KX_LibLoadStatus, m_libname),
 	KX_PYATTRIBUTE_RO_FUNCTION("timeTaken", KX_LibLoadStatus, pyattr_get_timetaken),
 	KX_PYATTRIBUTE_BOOL_RO("finished", KX_LibLoadStatus, m_finished),
+	KX_PYATTRIBUTE_BOOL_RO("cancelled", KX_LibLoadStatus, m_cancelled),
 	{ NULL }	//Sentinel
 };
 
@@ -186,6 +194,18 @@ PyTypeObject KX_LibLoadStatus::Type = {
 };
 
 
+KX_PYMETHODDEF_DOC_NOARGS(KX_LibLoadStatus, cancel,
+"cancel()\n"
+"Aborts an asynchronous libload that is not merged yet\n")
+{
+	if (m_finished) {
+		Py_RETURN_FALSE;
+	}
+
+	Cancel();
+	Py_RETURN_TRUE;
+}
+
 PyObject* KX_LibLoadStatus::pyattr_get_onfinish(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef)
 {
 	KX_LibLoadStatus* self = static_cast<KX_LibLoadStatus*>(self_v);
@@ -45,6 +45,8 @@ private:
 
 	// The current status of this libload, used by the scene converter.
 	bool m_finished;
+	// Set when the libload was cancelled before its data was merged.
+	bool m_cancelled;
 
 #ifdef WITH_PYTHON
 	PyObject*	m_finish_cb;
@@ -76,11 +78,21 @@ public:
 		return m_finished;
 	}
 
+	/* Request to abort an asynchronous libload, conversion stops at the next scene
+	 * and nothing is merged. Has no effect once the merge started. */
+	void Cancel();
+	inline bool IsCancelled() const
+	{
+		return m_cancelled;
+	}
+
 	void SetProgress(float progress);
 	float GetProgress();
 	void AddProgress(float progress);
 
 #ifdef WITH_PYTHON
+	KX_PYMETHOD_DOC_NOARGS(KX_LibLoadStatus, cancel);
+
 	static PyObject*	pyattr_get_onfinish(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
 	static int			pyattr_set_onfinish(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef, PyObject *value);
 	static PyObject*	pyattr_get_onprogress(void *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
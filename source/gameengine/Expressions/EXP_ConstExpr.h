@@ -29,6 +29,7 @@ public:
 	virtual bool MergeExpression(CExpression* otherexpr);
 	
 	void BroadcastOperators(VALUE_OPERATOR op);
+	bool Compile(CExpressionProgram& program);
 
 	virtual unsigned char GetExpressionID();
 	CExpression*	CheckLink(std::vector<CBrokenLinkInfo*>& brokenlinks);
@@ -0,0 +1,187 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file EXP_ExpressionProgram.h
+ *  \ingroup expressions
+ */
+
+#ifndef __EXP_EXPRESSIONPROGRAM_H__
+#define __EXP_EXPRESSIONPROGRAM_H__
+
+#include <vector>
+
+#include "EXP_Value.h"
+#include "EXP_IntValue.h"
+
+class CExpression;
+
+/**
+ * Resolve the identifiers of an expression when it is compiled.
+ */
+class CExpressionSymbols
+{
+public:
+	virtual ~CExpressionSymbols() {}
+
+	/**
+	 * Find the symbol read by an identifier.
+	 * \param r_type Return the type of the symbol, only VALUE_BOOL_TYPE,
+	 * VALUE_INT_TYPE and VALUE_FLOAT_TYPE can be compiled.
+	 * \return The index of the symbol or -1 if the identifier can't be compiled.
+	 */
+	virtual int FindSymbol(const STR_String& name, VALUE_DATA_TYPE& r_type) = 0;
+};
+
+/**
+ * An expression tree compiled to a flat and statically typed bytecode.
+ *
+ * Only the boolean and numerical parts of the language are compiled, using the
+ * exact same rules as the CValue operators, constant sub-expressions are folded.
+ * Trees using other types, or operators producing an error value (i.e. type
+ * mismatch) aren't compiled, the caller must keep using CExpression::Calculate().
+ */
+class CExpressionProgram
+{
+public:
+	union Value {
+		cInt m_int;
+		float m_float;
+		bool m_bool;
+	};
+
+	CExpressionProgram();
+	~CExpressionProgram();
+
+	/**
+	 * Compile \a expr, identifiers are resolved by \a symbols.
+	 * \return False if the expression can't be compiled, the program is then empty.
+	 */
+	bool Compile(CExpression *expr, CExpressionSymbols *symbols);
+	bool IsEmpty() const { return m_code.empty(); }
+	void Clear();
+
+	/**
+	 * Run the program.
+	 * \param symbols The values of the symbols returned by CExpressionSymbols::FindSymbol().
+	 * \param r_number The result as returned by CValue::GetNumber().
+	 * \return False on a runtime error (division by zero), the expression
+	 * must then be calculated by the tree to report the error.
+	 */
+	bool Execute(const Value *symbols, double& r_number);
+
+	/// \name Emitters used by CExpression::Compile().
+	//@{
+	bool EmitConstant(CValue *value);
+	bool EmitSymbol(const STR_String& name);
+	bool EmitOperator(VALUE_OPERATOR op, unsigned int numoperands);
+	bool EmitCondition(CExpression *guard, CExpression *e1, CExpression *e2);
+	//@}
+
+private:
+	enum Opcode {
+		OP_PUSH = 0,
+		OP_LOAD,
+		OP_JUMP,
+		OP_JUMP_IF_FALSE,
+		/// Convert the top of the stack.
+		OP_INT_TO_FLOAT,
+		/// Convert the value under the top of the stack.
+		OP_INT_TO_FLOAT_LHS,
+
+		OP_INT_MOD,
+		OP_INT_ADD,
+		OP_INT_SUB,
+		OP_INT_MUL,
+		OP_INT_DIV,
+		OP_INT_EQL,
+		OP_INT_NEQ,
+		OP_INT_GRE,
+		OP_INT_LES,
+		OP_INT_GEQ,
+		OP_INT_LEQ,
+		OP_INT_NEG,
+		OP_INT_NOT,
+
+		OP_FLOAT_MOD,
+		OP_FLOAT_ADD,
+		OP_FLOAT_SUB,
+		OP_FLOAT_MUL,
+		OP_FLOAT_DIV,
+		OP_FLOAT_EQL,
+		OP_FLOAT_NEQ,
+		OP_FLOAT_GRE,
+		OP_FLOAT_LES,
+		OP_FLOAT_GEQ,
+		OP_FLOAT_LEQ,
+		OP_FLOAT_NEG,
+		OP_FLOAT_NOT,
+		/// fmod() of mixed operands, computed in double precision like CValue.
+		OP_INT_FLOAT_MOD,
+		OP_FLOAT_INT_MOD,
+
+		OP_BOOL_AND,
+		OP_BOOL_OR,
+		OP_BOOL_EQL,
+		OP_BOOL_NEQ,
+		OP_BOOL_NOT
+	};
+
+	struct Instruction {
+		Opcode m_opcode;
+		/// Symbol index or jump target.
+		int m_operand;
+		Value m_value;
+	};
+
+	/// Padding slots before the stack.
+	enum { STACK_OFFSET = 2 };
+
+	/// Compile time description of a stack entry.
+	struct StackEntry {
+		VALUE_DATA_TYPE m_type;
+		/// First instruction computing this entry.
+		unsigned int m_start;
+		bool m_constant;
+	};
+
+	std::vector<Instruction> m_code;
+	std::vector<Value> m_stack;
+	VALUE_DATA_TYPE m_resultType;
+
+	/// Compilation state.
+	CExpressionSymbols *m_symbols;
+	std::vector<StackEntry> m_entries;
+	unsigned int m_maxDepth;
+
+	void Emit(Opcode opcode, int operand = 0);
+	void PushEntry(VALUE_DATA_TYPE type, unsigned int start, bool constant);
+	/// Replace the code of a constant entry on the top of the stack by its value.
+	bool FoldConstant(unsigned int start);
+	bool Run(unsigned int begin, unsigned int end, const Value *symbols, Value *stack, unsigned int& r_depth) const;
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:CExpressionProgram")
+#endif
+};
+
+#endif  /* __EXP_EXPRESSIONPROGRAM_H__ */
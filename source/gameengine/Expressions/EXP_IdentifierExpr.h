@@ -49,6 +49,7 @@ public:
 	virtual CExpression*	CheckLink(std::vector<CBrokenLinkInfo*>& brokenlinks);
 	virtual void			ClearModified();
 	virtual void			BroadcastOperators(VALUE_OPERATOR op);
+	virtual bool			Compile(CExpressionProgram& program);
 
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -30,6 +30,7 @@ class COperator1Expr : public CExpression
 public:
 	virtual bool MergeExpression(CExpression* otherexpr);
 	virtual void BroadcastOperators(VALUE_OPERATOR op);
+	virtual bool Compile(CExpressionProgram& program);
 
 	virtual unsigned char GetExpressionID() { return COPERATOR1EXPRESSIONID; }
 	CExpression* CheckLink(std::vector<CBrokenLinkInfo*>& brokenlinks);
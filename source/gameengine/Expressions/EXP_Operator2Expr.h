@@ -31,6 +31,7 @@ public:
 	virtual bool MergeExpression(CExpression* otherexpr);
 	virtual unsigned char GetExpressionID() { return COPERATOR2EXPRESSIONID; }
 	virtual void BroadcastOperators(VALUE_OPERATOR op);
+	virtual bool Compile(CExpressionProgram& program);
 	CExpression* CheckLink(std::vector<CBrokenLinkInfo*>& brokenlinks);
 	//virtual bool IsInside(float x,float y,float z,bool bBorderInclude=true);
 	//virtual bool IsLeftInside(float x,float y,float z,bool bBorderInclude);
@@ -18,6 +18,7 @@
 
 #include "EXP_Value.h" // for precompiled header
 #include "EXP_ConstExpr.h"
+#include "EXP_ExpressionProgram.h"
 #include "EXP_VectorValue.h"
 
 //////////////////////////////////////////////////////////////////////
@@ -124,6 +125,13 @@ void CConstExpr::BroadcastOperators(VALUE_OPERATOR op)
 
 
 
+bool CConstExpr::Compile(CExpressionProgram& program)
+{
+	return program.EmitConstant(m_value);
+}
+
+
+
 bool CConstExpr::MergeExpression(CExpression *otherexpr)
 {
 	assertd(false);
@@ -16,6 +16,7 @@
  */
 
 #include "EXP_Expression.h"
+#include "EXP_ExpressionProgram.h"
 #include "EXP_ErrorValue.h"
 
 //////////////////////////////////////////////////////////////////////
@@ -32,6 +33,11 @@ CExpression::CExpression()// : m_cached_calculate(NULL)
 #endif
 }
 
+bool CExpression::Compile(CExpressionProgram&)
+{
+	return false;
+}
+
 CExpression::~CExpression()
 {
 	assert (m_refcount == 0);
@@ -0,0 +1,442 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Expressions/ExpressionProgram.cpp
+ *  \ingroup expressions
+ */
+
+#include <math.h>
+
+#include "EXP_ExpressionProgram.h"
+#include "EXP_Expression.h"
+#include "EXP_BoolValue.h"
+#include "EXP_FloatValue.h"
+
+CExpressionProgram::CExpressionProgram()
+	:m_resultType(VALUE_NO_TYPE),
+	m_symbols(NULL),
+	m_maxDepth(0)
+{
+}
+
+CExpressionProgram::~CExpressionProgram()
+{
+}
+
+void CExpressionProgram::Clear()
+{
+	m_code.clear();
+	m_stack.clear();
+	m_entries.clear();
+	m_resultType = VALUE_NO_TYPE;
+	m_maxDepth = 0;
+}
+
+bool CExpressionProgram::Compile(CExpression *expr, CExpressionSymbols *symbols)
+{
+	Clear();
+	m_symbols = symbols;
+
+	const bool compiled = expr->Compile(*this) && m_entries.size() == 1;
+	if (compiled) {
+		m_resultType = m_entries.back().m_type;
+		m_stack.resize(m_maxDepth + STACK_OFFSET);
+	}
+	else {
+		Clear();
+	}
+
+	m_entries.clear();
+	m_symbols = NULL;
+
+	return compiled;
+}
+
+bool CExpressionProgram::Execute(const Value *symbols, double& r_number)
+{
+	unsigned int depth;
+	if (!Run(0, m_code.size(), symbols, &m_stack[STACK_OFFSET], depth))
+		return false;
+
+	const Value& result = m_stack[STACK_OFFSET];
+	switch (m_resultType) {
+		case VALUE_BOOL_TYPE:
+			r_number = (double)result.m_bool;
+			break;
+		case VALUE_INT_TYPE:
+			r_number = (double)result.m_int;
+			break;
+		default:
+			r_number = result.m_float;
+			break;
+	}
+	return true;
+}
+
+void CExpressionProgram::Emit(Opcode opcode, int operand)
+{
+	Instruction instruction;
+	instruction.m_opcode = opcode;
+	instruction.m_operand = operand;
+	instruction.m_value.m_int = 0;
+	m_code.push_back(instruction);
+}
+
+void CExpressionProgram::PushEntry(VALUE_DATA_TYPE type, unsigned int start, bool constant)
+{
+	StackEntry entry;
+	entry.m_type = type;
+	entry.m_start = start;
+	entry.m_constant = constant;
+	m_entries.push_back(entry);
+
+	if (m_entries.size() > m_maxDepth)
+		m_maxDepth = m_entries.size();
+}
+
+bool CExpressionProgram::FoldConstant(unsigned int start)
+{
+	std::vector<Value> stack(m_maxDepth + STACK_OFFSET);
+	unsigned int depth;
+
+	if (!Run(start, m_code.size(), NULL, &stack[STACK_OFFSET], depth)) {
+		// Keep the code, the error is reported when the expression is executed.
+		m_entries.back().m_constant = false;
+		return true;
+	}
+
+	m_code.resize(start);
+	Emit(OP_PUSH);
+	m_code.back().m_value = stack[STACK_OFFSET];
+	return true;
+}
+
+bool CExpressionProgram::EmitConstant(CValue *value)
+{
+	Value constant;
+
+	const VALUE_DATA_TYPE type = (VALUE_DATA_TYPE)value->GetValueType();
+	switch (type) {
+		case VALUE_BOOL_TYPE:
+			constant.m_bool = ((CBoolValue *)value)->GetBool();
+			break;
+		case VALUE_INT_TYPE:
+			constant.m_int = ((CIntValue *)value)->GetInt();
+			break;
+		case VALUE_FLOAT_TYPE:
+			constant.m_float = ((CFloatValue *)value)->GetFloat();
+			break;
+		default:
+			return false;
+	}
+
+	const unsigned int start = m_code.size();
+	Emit(OP_PUSH);
+	m_code.back().m_value = constant;
+	PushEntry(type, start, true);
+	return true;
+}
+
+bool CExpressionProgram::EmitSymbol(const STR_String& name)
+{
+	if (!m_symbols)
+		return false;
+
+	VALUE_DATA_TYPE type = VALUE_NO_TYPE;
+	const int index = m_symbols->FindSymbol(name, type);
+	if (index < 0 || (type != VALUE_BOOL_TYPE && type != VALUE_INT_TYPE && type != VALUE_FLOAT_TYPE))
+		return false;
+
+	const unsigned int start = m_code.size();
+	Emit(OP_LOAD, index);
+	PushEntry(type, start, false);
+	return true;
+}
+
+bool CExpressionProgram::EmitOperator(VALUE_OPERATOR op, unsigned int numoperands)
+{
+	if (numoperands == 1) {
+		if (m_entries.empty())
+			return false;
+
+		const StackEntry operand = m_entries.back();
+		VALUE_DATA_TYPE type = operand.m_type;
+		const unsigned int size = m_code.size();
+
+		switch (operand.m_type) {
+			case VALUE_INT_TYPE:
+			case VALUE_FLOAT_TYPE:
+			{
+				const bool isint = (operand.m_type == VALUE_INT_TYPE);
+				switch (op) {
+					case VALUE_POS_OPERATOR:
+						break;
+					case VALUE_NEG_OPERATOR:
+						Emit(isint ? OP_INT_NEG : OP_FLOAT_NEG);
+						break;
+					case VALUE_NOT_OPERATOR:
+						Emit(isint ? OP_INT_NOT : OP_FLOAT_NOT);
+						type = VALUE_BOOL_TYPE;
+						break;
+					default:
+						return false;
+				}
+				break;
+			}
+			case VALUE_BOOL_TYPE:
+			{
+				// +bool and -bool are errors.
+				if (op != VALUE_NOT_OPERATOR)
+					return false;
+				Emit(OP_BOOL_NOT);
+				break;
+			}
+			default:
+				return false;
+		}
+
+		m_entries.pop_back();
+		PushEntry(type, operand.m_start, operand.m_constant);
+		if (operand.m_constant && m_code.size() != size)
+			return FoldConstant(operand.m_start);
+		return true;
+	}
+
+	if (numoperands != 2 || m_entries.size() < 2)
+		return false;
+
+	const StackEntry lhs = m_entries[m_entries.size() - 2];
+	const StackEntry rhs = m_entries.back();
+	VALUE_DATA_TYPE type;
+
+	if (lhs.m_type == VALUE_BOOL_TYPE || rhs.m_type == VALUE_BOOL_TYPE) {
+		// Booleans can't be mixed with numbers.
+		if (lhs.m_type != rhs.m_type)
+			return false;
+
+		switch (op) {
+			case VALUE_AND_OPERATOR: Emit(OP_BOOL_AND); break;
+			case VALUE_OR_OPERATOR: Emit(OP_BOOL_OR); break;
+			case VALUE_EQL_OPERATOR: Emit(OP_BOOL_EQL); break;
+			case VALUE_NEQ_OPERATOR: Emit(OP_BOOL_NEQ); break;
+			default:
+				return false;
+		}
+		type = VALUE_BOOL_TYPE;
+	}
+	else if (lhs.m_type == VALUE_INT_TYPE && rhs.m_type == VALUE_INT_TYPE) {
+		type = VALUE_BOOL_TYPE;
+		switch (op) {
+			case VALUE_MOD_OPERATOR: Emit(OP_INT_MOD); type = VALUE_INT_TYPE; break;
+			case VALUE_ADD_OPERATOR: Emit(OP_INT_ADD); type = VALUE_INT_TYPE; break;
+			case VALUE_SUB_OPERATOR: Emit(OP_INT_SUB); type = VALUE_INT_TYPE; break;
+			case VALUE_MUL_OPERATOR: Emit(OP_INT_MUL); type = VALUE_INT_TYPE; break;
+			case VALUE_DIV_OPERATOR: Emit(OP_INT_DIV); type = VALUE_INT_TYPE; break;
+			case VALUE_EQL_OPERATOR: Emit(OP_INT_EQL); break;
+			case VALUE_NEQ_OPERATOR: Emit(OP_INT_NEQ); break;
+			case VALUE_GRE_OPERATOR: Emit(OP_INT_GRE); break;
+			case VALUE_LES_OPERATOR: Emit(OP_INT_LES); break;
+			case VALUE_GEQ_OPERATOR: Emit(OP_INT_GEQ); break;
+			case VALUE_LEQ_OPERATOR: Emit(OP_INT_LEQ); break;
+			default:
+				return false;
+		}
+	}
+	else if ((lhs.m_type == VALUE_INT_TYPE || lhs.m_type == VALUE_FLOAT_TYPE) &&
+	         (rhs.m_type == VALUE_INT_TYPE || rhs.m_type == VALUE_FLOAT_TYPE))
+	{
+		if (op == VALUE_MOD_OPERATOR) {
+			// The modulo of mixed operands doesn't round the integer to a float.
+			if (lhs.m_type == VALUE_INT_TYPE)
+				Emit(OP_INT_FLOAT_MOD);
+			else if (rhs.m_type == VALUE_INT_TYPE)
+				Emit(OP_FLOAT_INT_MOD);
+			else
+				Emit(OP_FLOAT_MOD);
+			type = VALUE_FLOAT_TYPE;
+		}
+		else {
+			Opcode opcode;
+			type = VALUE_BOOL_TYPE;
+			switch (op) {
+				case VALUE_ADD_OPERATOR: opcode = OP_FLOAT_ADD; type = VALUE_FLOAT_TYPE; break;
+				case VALUE_SUB_OPERATOR: opcode = OP_FLOAT_SUB; type = VALUE_FLOAT_TYPE; break;
+				case VALUE_MUL_OPERATOR: opcode = OP_FLOAT_MUL; type = VALUE_FLOAT_TYPE; break;
+				case VALUE_DIV_OPERATOR: opcode = OP_FLOAT_DIV; type = VALUE_FLOAT_TYPE; break;
+				case VALUE_EQL_OPERATOR: opcode = OP_FLOAT_EQL; break;
+				case VALUE_NEQ_OPERATOR: opcode = OP_FLOAT_NEQ; break;
+				case VALUE_GRE_OPERATOR: opcode = OP_FLOAT_GRE; break;
+				case VALUE_LES_OPERATOR: opcode = OP_FLOAT_LES; break;
+				case VALUE_GEQ_OPERATOR: opcode = OP_FLOAT_GEQ; break;
+				case VALUE_LEQ_OPERATOR: opcode = OP_FLOAT_LEQ; break;
+				default:
+					return false;
+			}
+			if (lhs.m_type == VALUE_INT_TYPE)
+				Emit(OP_INT_TO_FLOAT_LHS);
+			if (rhs.m_type == VALUE_INT_TYPE)
+				Emit(OP_INT_TO_FLOAT);
+			Emit(opcode);
+		}
+	}
+	else {
+		return false;
+	}
+
+	const bool constant = lhs.m_constant && rhs.m_constant;
+	m_entries.pop_back();
+	m_entries.pop_back();
+	PushEntry(type, lhs.m_start, constant);
+
+	if (constant)
+		return FoldConstant(lhs.m_start);
+	return true;
+}
+
+bool CExpressionProgram::EmitCondition(CExpression *guard, CExpression *e1, CExpression *e2)
+{
+	const unsigned int start = m_code.size();
+
+	if (!guard->Compile(*this) || m_entries.back().m_type != VALUE_BOOL_TYPE)
+		return false;
+
+	const StackEntry guardentry = m_entries.back();
+	m_entries.pop_back();
+
+	if (guardentry.m_constant) {
+		// Only the selected branch is ever calculated.
+		const bool value = m_code.back().m_value.m_bool;
+		m_code.resize(start);
+		return (value) ? e1->Compile(*this) : e2->Compile(*this);
+	}
+
+	const unsigned int jumpfalse = m_code.size();
+	Emit(OP_JUMP_IF_FALSE);
+
+	if (!e1->Compile(*this))
+		return false;
+	const VALUE_DATA_TYPE type = m_entries.back().m_type;
+	m_entries.pop_back();
+
+	const unsigned int jumpend = m_code.size();
+	Emit(OP_JUMP);
+	m_code[jumpfalse].m_operand = m_code.size();
+
+	// Both branches must have the same type to keep the program statically typed.
+	if (!e2->Compile(*this) || m_entries.back().m_type != type)
+		return false;
+	m_entries.pop_back();
+
+	m_code[jumpend].m_operand = m_code.size();
+	PushEntry(type, start, false);
+	return true;
+}
+
+bool CExpressionProgram::Run(unsigned int begin, unsigned int end, const Value *symbols, Value *stack,
+                             unsigned int& r_depth) const
+{
+	// sp points to the next free slot, the stack has STACK_OFFSET slots
+	// before its start so the operands can be addressed before each opcode.
+	Value *sp = stack;
+
+	for (unsigned int pc = begin; pc < end; ++pc) {
+		const Instruction& instruction = m_code[pc];
+		Value& lhs = sp[-2];
+		Value& top = sp[-1];
+
+		switch (instruction.m_opcode) {
+			case OP_PUSH:
+				*(sp++) = instruction.m_value;
+				break;
+			case OP_LOAD:
+				*(sp++) = symbols[instruction.m_operand];
+				break;
+			case OP_JUMP:
+				pc = instruction.m_operand - 1;
+				break;
+			case OP_JUMP_IF_FALSE:
+				if (!(--sp)->m_bool)
+					pc = instruction.m_operand - 1;
+				break;
+			case OP_INT_TO_FLOAT:
+				top.m_float = (float)top.m_int;
+				break;
+			case OP_INT_TO_FLOAT_LHS:
+				lhs.m_float = (float)lhs.m_int;
+				break;
+
+			case OP_INT_MOD:
+				if (top.m_int == 0)
+					return false;
+				lhs.m_int = lhs.m_int % top.m_int;
+				--sp;
+				break;
+			case OP_INT_ADD: lhs.m_int = lhs.m_int + top.m_int; --sp; break;
+			case OP_INT_SUB: lhs.m_int = lhs.m_int - top.m_int; --sp; break;
+			case OP_INT_MUL: lhs.m_int = lhs.m_int * top.m_int; --sp; break;
+			case OP_INT_DIV:
+				if (top.m_int == 0)
+					return false;
+				lhs.m_int = lhs.m_int / top.m_int;
+				--sp;
+				break;
+			case OP_INT_EQL: lhs.m_bool = (lhs.m_int == top.m_int); --sp; break;
+			case OP_INT_NEQ: lhs.m_bool = (lhs.m_int != top.m_int); --sp; break;
+			case OP_INT_GRE: lhs.m_bool = (lhs.m_int > top.m_int); --sp; break;
+			case OP_INT_LES: lhs.m_bool = (lhs.m_int < top.m_int); --sp; break;
+			case OP_INT_GEQ: lhs.m_bool = (lhs.m_int >= top.m_int); --sp; break;
+			case OP_INT_LEQ: lhs.m_bool = (lhs.m_int <= top.m_int); --sp; break;
+			case OP_INT_NEG: top.m_int = -top.m_int; break;
+			case OP_INT_NOT: top.m_bool = (top.m_int == 0); break;
+
+			case OP_FLOAT_MOD: lhs.m_float = fmod(lhs.m_float, top.m_float); --sp; break;
+			case OP_FLOAT_ADD: lhs.m_float = lhs.m_float + top.m_float; --sp; break;
+			case OP_FLOAT_SUB: lhs.m_float = lhs.m_float - top.m_float; --sp; break;
+			case OP_FLOAT_MUL: lhs.m_float = lhs.m_float * top.m_float; --sp; break;
+			case OP_FLOAT_DIV:
+				if (top.m_float == 0.0f)
+					return false;
+				lhs.m_float = lhs.m_float / top.m_float;
+				--sp;
+				break;
+			case OP_FLOAT_EQL: lhs.m_bool = (lhs.m_float == top.m_float); --sp; break;
+			case OP_FLOAT_NEQ: lhs.m_bool = (lhs.m_float != top.m_float); --sp; break;
+			case OP_FLOAT_GRE: lhs.m_bool = (lhs.m_float > top.m_float); --sp; break;
+			case OP_FLOAT_LES: lhs.m_bool = (lhs.m_float < top.m_float); --sp; break;
+			case OP_FLOAT_GEQ: lhs.m_bool = (lhs.m_float >= top.m_float); --sp; break;
+			case OP_FLOAT_LEQ: lhs.m_bool = (lhs.m_float <= top.m_float); --sp; break;
+			case OP_FLOAT_NEG: top.m_float = -top.m_float; break;
+			case OP_FLOAT_NOT: top.m_bool = (top.m_float == 0.0f); break;
+			case OP_INT_FLOAT_MOD: lhs.m_float = fmod((double)lhs.m_int, (double)top.m_float); --sp; break;
+			case OP_FLOAT_INT_MOD: lhs.m_float = fmod((double)lhs.m_float, (double)top.m_int); --sp; break;
+
+			case OP_BOOL_AND: lhs.m_bool = (lhs.m_bool && top.m_bool); --sp; break;
+			case OP_BOOL_OR: lhs.m_bool = (lhs.m_bool || top.m_bool); --sp; break;
+			case OP_BOOL_EQL: lhs.m_bool = (lhs.m_bool == top.m_bool); --sp; break;
+			case OP_BOOL_NEQ: lhs.m_bool = (lhs.m_bool != top.m_bool); --sp; break;
+			case OP_BOOL_NOT: top.m_bool = !top.m_bool; break;
+		}
+	}
+
+	r_depth = sp - stack;
+	return true;
+}
@@ -31,6 +31,7 @@
 
 
 #include "EXP_IdentifierExpr.h"
+#include "EXP_ExpressionProgram.h"
 
 CIdentifierExpr::CIdentifierExpr(const STR_String& identifier,CValue* id_context)
 :m_identifier(identifier)
@@ -101,3 +102,10 @@ void CIdentifierExpr::BroadcastOperators(VALUE_OPERATOR op)
 {
 	assertd(false); // not implemented yet
 }
+
+
+
+bool CIdentifierExpr::Compile(CExpressionProgram& program)
+{
+	return program.EmitSymbol(m_identifier);
+}
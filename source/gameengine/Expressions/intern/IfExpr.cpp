@@ -16,6 +16,7 @@
  */
 
 #include "EXP_IfExpr.h"
+#include "EXP_ExpressionProgram.h"
 #include "EXP_EmptyValue.h"
 #include "EXP_ErrorValue.h"
 #include "EXP_BoolValue.h"
@@ -138,6 +139,13 @@ void CIfExpr::BroadcastOperators(VALUE_OPERATOR op)
 
 
 
+bool CIfExpr::Compile(CExpressionProgram& program)
+{
+	return program.EmitCondition(m_guard, m_e1, m_e2);
+}
+
+
+
 unsigned char CIfExpr::GetExpressionID()
 {
 	return CIFEXPRESSIONID;
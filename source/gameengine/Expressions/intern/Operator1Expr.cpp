@@ -16,6 +16,7 @@
  */
 
 #include "EXP_Operator1Expr.h"
+#include "EXP_ExpressionProgram.h"
 #include "EXP_EmptyValue.h"
 
 //////////////////////////////////////////////////////////////////////
@@ -140,6 +141,13 @@ void COperator1Expr::BroadcastOperators(VALUE_OPERATOR op)
 
 
 
+bool COperator1Expr::Compile(CExpressionProgram& program)
+{
+	return m_lhs->Compile(program) && program.EmitOperator(m_op, 1);
+}
+
+
+
 
 bool COperator1Expr::MergeExpression(CExpression *otherexpr)
 {
@@ -20,6 +20,7 @@
 // when expression is cached, there will be a call to UpdateCalc() instead of Calc()
 
 #include "EXP_Operator2Expr.h"
+#include "EXP_ExpressionProgram.h"
 #include "EXP_StringValue.h"
 #include "EXP_VoidValue.h"
 
@@ -274,3 +275,10 @@ void COperator2Expr::BroadcastOperators(VALUE_OPERATOR op)
 	if (m_rhs)
 		m_rhs->BroadcastOperators(m_op);
 }
+
+
+
+bool COperator2Expr::Compile(CExpressionProgram& program)
+{
+	return m_lhs->Compile(program) && m_rhs->Compile(program) && program.EmitOperator(m_op, 2);
+}
@@ -37,6 +37,8 @@
 #include "SCA_ISensor.h"
 #include "SCA_LogicManager.h"
 #include "EXP_BoolValue.h"
+#include "EXP_IntValue.h"
+#include "EXP_FloatValue.h"
 #include "EXP_InputParser.h"
 #include "MT_Transform.h" // for fuzzyZero
 
@@ -51,7 +53,9 @@ SCA_ExpressionController::SCA_ExpressionController(SCA_IObject* gameobj,
 												   const STR_String& exprtext)
 	:SCA_IController(gameobj),
 	m_exprText(exprtext),
-	m_exprCache(NULL)
+	m_exprCache(NULL),
+	m_programState(PROGRAM_NONE),
+	m_programRevision(0)
 {
 }
 
@@ -70,6 +74,9 @@ CValue* SCA_ExpressionController::GetReplica()
 	SCA_ExpressionController* replica = new SCA_ExpressionController(*this);
 	replica->m_exprText = m_exprText;
 	replica->m_exprCache = NULL;
+	replica->m_exprProgram.Clear();
+	replica->m_programState = PROGRAM_NONE;
+	replica->m_symbols.clear();
 	// this will copy properties and so on...
 	replica->ProcessReplica();
 
@@ -100,7 +107,12 @@ void SCA_ExpressionController::Trigger(SCA_LogicManager* logicmgr)
 		parser.SetContext(this->AddRef());
 		m_exprCache = parser.ProcessText(m_exprText);
 	}
-	if (m_exprCache)
+	double number;
+	if (m_exprCache && ExecuteProgram(number))
+	{
+		expressionresult = !MT_fuzzyZero((float)number);
+	}
+	else if (m_exprCache)
 	{
 		CValue* value = m_exprCache->Calculate();
 		if (value)
@@ -157,3 +169,112 @@ CValue* SCA_ExpressionController::FindIdentifier(const STR_String& identifiernam
 	return  GetParent()->FindIdentifier(identifiername);
 
 }
+
+
+
+bool SCA_ExpressionController::ExecuteProgram(double& r_number)
+{
+	// Sensors referenced by index may have moved.
+	if (m_programState == PROGRAM_COMPILED && m_programRevision != m_linkRevision)
+		m_programState = PROGRAM_NONE;
+
+	if (m_programState == PROGRAM_NONE)
+	{
+		m_symbols.clear();
+		if (m_exprProgram.Compile(m_exprCache, this))
+		{
+			m_programState = PROGRAM_COMPILED;
+			m_programRevision = m_linkRevision;
+			m_symbolValues.resize(m_symbols.size());
+		}
+		else
+		{
+			m_programState = PROGRAM_FAILED;
+		}
+	}
+
+	if (m_programState != PROGRAM_COMPILED)
+		return false;
+
+	for (unsigned int i = 0; i < m_symbols.size(); i++)
+	{
+		const Symbol& symbol = m_symbols[i];
+		CExpressionProgram::Value& value = m_symbolValues[i];
+
+		if (symbol.m_sensor >= 0)
+		{
+			value.m_bool = m_linkedsensors[symbol.m_sensor]->GetState();
+			continue;
+		}
+
+		CValue* prop = GetParent()->GetProperty(symbol.m_property);
+		if (!prop || prop->GetValueType() != symbol.m_type)
+		{
+			// The property was removed or replaced since the compilation.
+			m_programState = PROGRAM_NONE;
+			return false;
+		}
+
+		switch (symbol.m_type)
+		{
+			case VALUE_BOOL_TYPE:
+				value.m_bool = ((CBoolValue*)prop)->GetBool();
+				break;
+			case VALUE_INT_TYPE:
+				value.m_int = ((CIntValue*)prop)->GetInt();
+				break;
+			default:
+				value.m_float = ((CFloatValue*)prop)->GetFloat();
+				break;
+		}
+	}
+
+	return m_exprProgram.Execute((m_symbolValues.empty()) ? NULL : &m_symbolValues[0], r_number);
+}
+
+
+
+int SCA_ExpressionController::FindSymbol(const STR_String& name, VALUE_DATA_TYPE& r_type)
+{
+	Symbol symbol;
+	symbol.m_sensor = -1;
+
+	// Same lookup order than FindIdentifier(), sensors hide the properties.
+	for (unsigned int i = 0; i < m_linkedsensors.size(); i++)
+	{
+		if (m_linkedsensors[i]->GetName() == name)
+		{
+			symbol.m_sensor = i;
+			symbol.m_type = VALUE_BOOL_TYPE;
+			break;
+		}
+	}
+
+	if (symbol.m_sensor < 0)
+	{
+		// Sub-contexts aren't compiled.
+		if (name.Find('.') >= 0)
+			return -1;
+
+		CValue* prop = GetParent()->GetProperty(name);
+		if (!prop)
+			return -1;
+
+		symbol.m_property = name;
+		symbol.m_type = (VALUE_DATA_TYPE)prop->GetValueType();
+	}
+
+	for (unsigned int i = 0; i < m_symbols.size(); i++)
+	{
+		const Symbol& other = m_symbols[i];
+		if (other.m_sensor == symbol.m_sensor && other.m_property == symbol.m_property)
+		{
+			r_type = other.m_type;
+			return i;
+		}
+	}
+
+	m_symbols.push_back(symbol);
+	r_type = symbol.m_type;
+	return m_symbols.size() - 1;
+}
@@ -36,13 +36,41 @@
 #define __SCA_EXPRESSIONCONTROLLER_H__
 
 #include "SCA_IController.h"
+#include "EXP_ExpressionProgram.h"
 
-class SCA_ExpressionController : public SCA_IController
+class SCA_ExpressionController : public SCA_IController, public CExpressionSymbols
 {
 //	Py_Header
 	STR_String			m_exprText;
 	CExpression*		m_exprCache;
 
+	/// A value read by the compiled expression, a linked sensor or a property of the parent.
+	struct Symbol {
+		int m_sensor;
+		STR_String m_property;
+		VALUE_DATA_TYPE m_type;
+	};
+
+	enum ProgramState {
+		PROGRAM_NONE = 0,
+		PROGRAM_COMPILED,
+		PROGRAM_FAILED
+	};
+
+	/// The expression compiled to bytecode, used instead of m_exprCache when possible.
+	CExpressionProgram	m_exprProgram;
+	ProgramState		m_programState;
+	/// Link revision of the controller when the program was compiled.
+	unsigned int		m_programRevision;
+	std::vector<Symbol>	m_symbols;
+	std::vector<CExpressionProgram::Value> m_symbolValues;
+
+	/**
+	 * Compile the expression if needed and execute it.
+	 * \return False if the expression must be calculated by m_exprCache.
+	 */
+	bool ExecuteProgram(double& r_number);
+
 public:
 	SCA_ExpressionController(SCA_IObject* gameobj,
 							 const STR_String& exprtext);
@@ -51,6 +79,7 @@ public:
 	virtual CValue* GetReplica();
 	virtual void Trigger(SCA_LogicManager* logicmgr);
 	virtual CValue*		FindIdentifier(const STR_String& identifiername);
+	virtual int			FindSymbol(const STR_String& name, VALUE_DATA_TYPE& r_type);
 	/** 
 	 *  used to release the expression cache
 	 *  so that self references are removed before the controller itself is released
@@ -45,7 +45,8 @@ SCA_IController::SCA_IController(SCA_IObject* gameobj)
 	:
 	SCA_ILogicBrick(gameobj),
 	m_statemask(0),
-	m_justActivated(false)
+	m_justActivated(false),
+	m_linkRevision(0)
 {
 }
 	
@@ -84,6 +85,7 @@ void SCA_IController::UnlinkAllSensors()
 		(*sensit)->UnlinkController(this);
 	}
 	m_linkedsensors.clear();
+	m_linkRevision++;
 }
 
 
@@ -135,6 +137,7 @@ void	SCA_IController::UnlinkActuator(class SCA_IActuator* actua)
 void SCA_IController::LinkToSensor(SCA_ISensor* sensor)
 {
 	m_linkedsensors.push_back(sensor);
+	m_linkRevision++;
 	if (IsActive())
 	{
 		sensor->IncLink();
@@ -154,6 +157,7 @@ void SCA_IController::UnlinkSensor(class SCA_ISensor* sensor)
 			}
 			*sensit = m_linkedsensors.back();
 			m_linkedsensors.pop_back();
+			m_linkRevision++;
 			return;
 		}
 	}
@@ -49,6 +49,8 @@ protected:
 	unsigned int						m_statemask;
 	bool								m_justActivated;
 	bool								m_bookmark;
+	/// Incremented each time the linked sensors change.
+	unsigned int						m_linkRevision;
 public:
 	SCA_IController(SCA_IObject* gameobj);
 	virtual ~SCA_IController();
@@ -36,6 +36,7 @@
 #include <stddef.h>
 
 #include "SCA_ISensor.h"
+#include "SCA_Profiler.h"
 #include "SCA_EventManager.h"
 #include "SCA_LogicManager.h"
 // needed for IsTriggered()
@@ -241,6 +242,7 @@ void SCA_ISensor::Activate(class SCA_LogicManager* logicmgr)
 	// calculate if a __triggering__ is wanted
 	// don't evaluate a sensor that is not connected to any controller
 	if (m_links && !m_suspended) {
+		SCA_PROFILE_SCOPE("sensor", GetParent()->GetName().ReadPtr(), GetName().ReadPtr());
 		bool result = this->Evaluate();
 		// store the state for the rest of the logic system
 		m_prev_state = m_state;
@@ -37,6 +37,7 @@
 #include "SCA_IActuator.h"
 #include "SCA_EventManager.h"
 #include "SCA_PythonController.h"
+#include "SCA_Profiler.h"
 #include <set>
 
 
@@ -197,6 +198,7 @@ void SCA_LogicManager::BeginFrame(double curtime, double fixedtime)
 			contr != NULL;
 			contr = (SCA_IController*)obj->QRemove())
 		{
+			SCA_PROFILE_SCOPE("controller", contr->GetParent()->GetName().ReadPtr(), contr->GetName().ReadPtr());
 			contr->Trigger(this);
 			contr->ClrJustActivated();
 		}
@@ -222,6 +224,7 @@ void SCA_LogicManager::UpdateFrame(double curtime, bool frame)
 			SCA_IActuator* actua = *ia;
 			// increment first to allow removal of inactive actuators.
 			++ia;
+			SCA_PROFILE_SCOPE("actuator", actua->GetParent()->GetName().ReadPtr(), actua->GetName().ReadPtr());
 			if (!actua->Update(curtime, frame))
 			{
 				// this actuator is not active anymore, remove
@@ -0,0 +1,200 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/GameLogic/SCA_Profiler.cpp
+ *  \ingroup gamelogic
+ */
+
+#include <stdio.h>
+
+#include "SCA_Profiler.h"
+
+#include "BLI_threads.h"
+#include "BLI_string.h"
+#include "PIL_time.h"
+
+class SCA_Profiler::ThreadBuffer
+{
+public:
+	std::vector<Event> m_events;
+	/// Index of the next event to write.
+	unsigned int m_head;
+	bool m_full;
+	unsigned int m_threadid;
+
+	ThreadBuffer(unsigned int numevents, unsigned int threadid)
+		:m_events(numevents),
+		m_head(0),
+		m_full(false),
+		m_threadid(threadid)
+	{
+	}
+};
+
+bool SCA_Profiler::s_enabled = false;
+unsigned int SCA_Profiler::s_numEvents = SCA_PROFILER_DEFAULT_EVENTS;
+double SCA_Profiler::s_startTime = 0.0;
+std::vector<SCA_Profiler::ThreadBuffer *> SCA_Profiler::s_buffers;
+
+static ThreadMutex profiler_lock = BLI_MUTEX_INITIALIZER;
+static ThreadLocal(void *) profiler_thread_buffer;
+
+void SCA_Profiler::Enable(unsigned int numevents)
+{
+	BLI_mutex_lock(&profiler_lock);
+	if (s_buffers.empty()) {
+		BLI_thread_local_create(profiler_thread_buffer);
+		s_startTime = PIL_check_seconds_timer();
+	}
+	s_numEvents = (numevents > 0) ? numevents : 1;
+	BLI_mutex_unlock(&profiler_lock);
+
+	// The thread enabling the profiler gets the first buffer.
+	GetThreadBuffer();
+	s_enabled = true;
+}
+
+void SCA_Profiler::Disable()
+{
+	s_enabled = false;
+}
+
+void SCA_Profiler::Exit()
+{
+	s_enabled = false;
+
+	BLI_mutex_lock(&profiler_lock);
+	if (!s_buffers.empty()) {
+		for (std::vector<ThreadBuffer *>::iterator it = s_buffers.begin(); it != s_buffers.end(); ++it) {
+			delete *it;
+		}
+		s_buffers.clear();
+
+		BLI_thread_local_set(profiler_thread_buffer, NULL);
+		BLI_thread_local_delete(profiler_thread_buffer);
+	}
+	BLI_mutex_unlock(&profiler_lock);
+}
+
+double SCA_Profiler::GetTime()
+{
+	return PIL_check_seconds_timer() - s_startTime;
+}
+
+SCA_Profiler::ThreadBuffer *SCA_Profiler::GetThreadBuffer()
+{
+	ThreadBuffer *buffer = (ThreadBuffer *)BLI_thread_local_get(profiler_thread_buffer);
+	if (!buffer) {
+		// First event of this thread.
+		BLI_mutex_lock(&profiler_lock);
+		buffer = new ThreadBuffer(s_numEvents, s_buffers.size());
+		s_buffers.push_back(buffer);
+		BLI_mutex_unlock(&profiler_lock);
+
+		BLI_thread_local_set(profiler_thread_buffer, buffer);
+	}
+	return buffer;
+}
+
+void SCA_Profiler::AddEvent(const char *category, const char *name, const char *detail, double begin, double end)
+{
+	if (!s_enabled)
+		return;
+
+	ThreadBuffer *buffer = GetThreadBuffer();
+	Event& event = buffer->m_events[buffer->m_head];
+
+	event.m_category = category;
+	if (detail)
+		BLI_snprintf(event.m_name, sizeof(event.m_name), "%s:%s", name, detail);
+	else
+		BLI_strncpy(event.m_name, name, sizeof(event.m_name));
+	event.m_begin = begin;
+	event.m_duration = end - begin;
+
+	if (++buffer->m_head == buffer->m_events.size()) {
+		buffer->m_head = 0;
+		buffer->m_full = true;
+	}
+}
+
+static void write_json_string(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (const char *c = str; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			fprintf(file, "\\%c", *c);
+		else if ((unsigned char)*c < 0x20)
+			fprintf(file, "\\u%04x", *c);
+		else
+			fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+bool SCA_Profiler::WriteChromeTrace(const char *filepath)
+{
+	FILE *file = fopen(filepath, "w");
+	if (!file)
+		return false;
+
+	BLI_mutex_lock(&profiler_lock);
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+
+	for (std::vector<ThreadBuffer *>::const_iterator it = s_buffers.begin(); it != s_buffers.end(); ++it) {
+		const ThreadBuffer *buffer = *it;
+
+		char threadname[32];
+		if (buffer->m_threadid == 0)
+			BLI_strncpy(threadname, "Main", sizeof(threadname));
+		else
+			BLI_snprintf(threadname, sizeof(threadname), "Thread %u", buffer->m_threadid);
+
+		fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+		        (first) ? "" : ",\n", buffer->m_threadid, threadname);
+		first = false;
+
+		// Oldest events first.
+		const unsigned int numevents = (buffer->m_full) ? buffer->m_events.size() : buffer->m_head;
+		const unsigned int start = (buffer->m_full) ? buffer->m_head : 0;
+		for (unsigned int i = 0; i < numevents; ++i) {
+			const Event& event = buffer->m_events[(start + i) % buffer->m_events.size()];
+
+			fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"cat\":",
+			        buffer->m_threadid, event.m_begin * 1.0e6, event.m_duration * 1.0e6);
+			write_json_string(file, event.m_category);
+			fprintf(file, ",\"name\":");
+			write_json_string(file, event.m_name);
+			fputc('}', file);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+
+	BLI_mutex_unlock(&profiler_lock);
+
+	const bool success = (ferror(file) == 0);
+	fclose(file);
+	return success;
+}
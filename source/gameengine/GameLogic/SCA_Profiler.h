@@ -0,0 +1,144 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file SCA_Profiler.h
+ *  \ingroup gamelogic
+ */
+
+#ifndef __SCA_PROFILER_H__
+#define __SCA_PROFILER_H__
+
+#include <stddef.h>
+#include <vector>
+
+#define SCA_PROFILER_NAME_SIZE 64
+#define SCA_PROFILER_DEFAULT_EVENTS (1 << 18)
+
+/**
+ * Hierarchical scoped timers.
+ *
+ * Each thread records the scopes it leaves in its own ring buffer, so the
+ * last events of every frame are kept and the spikes can be inspected in a
+ * timeline. The buffers are exported to the Chrome trace event format
+ * (chrome://tracing or Perfetto), nested scopes are displayed as children.
+ *
+ * When disabled a scope only costs the test of a static flag.
+ */
+class SCA_Profiler
+{
+public:
+	struct Event {
+		/// Static string, the "cat" field of the trace.
+		const char *m_category;
+		char m_name[SCA_PROFILER_NAME_SIZE];
+		/// Time in seconds since the profiler was enabled.
+		double m_begin;
+		double m_duration;
+	};
+
+	/**
+	 * Start recording.
+	 * \param numevents The number of events kept per thread.
+	 */
+	static void Enable(unsigned int numevents = SCA_PROFILER_DEFAULT_EVENTS);
+	/// Stop recording, the recorded events are kept until Exit().
+	static void Disable();
+	/// Free all the buffers, no other thread must use the profiler.
+	static void Exit();
+
+	static bool IsEnabled()
+	{
+		return s_enabled;
+	}
+
+	static double GetTime();
+
+	/**
+	 * Record a scope of the current thread.
+	 * \param detail Optional, appended to \a name.
+	 */
+	static void AddEvent(const char *category, const char *name, const char *detail, double begin, double end);
+
+	/**
+	 * Write the events of all the threads in the Chrome trace event JSON format.
+	 * \return False if the file can't be written.
+	 */
+	static bool WriteChromeTrace(const char *filepath);
+
+private:
+	class ThreadBuffer;
+
+	static bool s_enabled;
+	static unsigned int s_numEvents;
+	static double s_startTime;
+	static std::vector<ThreadBuffer *> s_buffers;
+
+	static ThreadBuffer *GetThreadBuffer();
+};
+
+/**
+ * Record the time spent between Begin() and the destruction of the scope,
+ * use it through #SCA_PROFILE_SCOPE.
+ */
+class SCA_ProfileScope
+{
+private:
+	const char *m_category;
+	const char *m_name;
+	const char *m_detail;
+	double m_begin;
+
+public:
+	SCA_ProfileScope()
+		:m_category(NULL)
+	{
+	}
+
+	~SCA_ProfileScope()
+	{
+		if (m_category)
+			SCA_Profiler::AddEvent(m_category, m_name, m_detail, m_begin, SCA_Profiler::GetTime());
+	}
+
+	/// \a name and \a detail must stay valid until the end of the scope.
+	void Begin(const char *category, const char *name, const char *detail)
+	{
+		m_category = category;
+		m_name = name;
+		m_detail = detail;
+		m_begin = SCA_Profiler::GetTime();
+	}
+};
+
+#define _SCA_PROFILE_CONCAT(a, b) a##b
+#define _SCA_PROFILE_VAR(line) _SCA_PROFILE_CONCAT(_sca_profile_scope_, line)
+
+/**
+ * Time the rest of the current block, the arguments are only evaluated when
+ * the profiler is enabled. \a detail can be NULL.
+ */
+#define SCA_PROFILE_SCOPE(category, name, detail)                             \
+	SCA_ProfileScope _SCA_PROFILE_VAR(__LINE__);                              \
+	if (SCA_Profiler::IsEnabled())                                            \
+		_SCA_PROFILE_VAR(__LINE__).Begin(category, name, detail)
+
+#endif  /* __SCA_PROFILER_H__ */
@@ -78,6 +78,8 @@ extern "C"
 #include "RAS_MeshObject.h"
 #include "RAS_OpenGLRasterizer.h"
 #include "RAS_ListRasterizer.h"
+#include "RAS_NullCanvas.h"
+#include "RAS_NullRasterizer.h"
 #include "KX_PythonInit.h"
 #include "KX_PyConstraintBinding.h"
 #include "BL_Material.h" // MAXTEX
@@ -120,6 +122,7 @@ GPG_Application::GPG_Application(GHOST_ISystem* system)
 	  m_engineInitialized(0), 
 	  m_engineRunning(0), 
 	  m_isEmbedded(false),
+	  m_isHeadless(false),
 	  m_ketsjiengine(0),
 	  m_kxsystem(0), 
 	  m_keyboard(0), 
@@ -147,7 +150,8 @@ GPG_Application::~GPG_Application(void)
 	}
 
 	exitEngine();
-	fSystem->disposeWindow(m_mainWindow);
+	if (fSystem)
+		fSystem->disposeWindow(m_mainWindow);
 }
 
 
@@ -429,6 +433,20 @@ bool GPG_Application::startFullScreen(
 
 
 
+bool GPG_Application::startHeadless()
+{
+	m_isHeadless = true;
+
+	bool success = initEngine(NULL, RAS_IRasterizer::RAS_STEREO_NOSTEREO);
+
+	if (success)
+		success = startEngine();
+
+	return success;
+}
+
+
+
 bool GPG_Application::StartGameEngine(int stereoMode)
 {
 	bool success = initEngine(m_mainWindow, stereoMode);
@@ -529,7 +547,7 @@ bool GPG_Application::processEvent(GHOST_IEvent* event)
 			if (m_canvas) {
 				GHOST_Rect bnds;
 				window->getClientBounds(bnds);
-				m_canvas->Resize(bnds.getWidth(), bnds.getHeight());
+				static_cast<GPG_Canvas *>(m_canvas)->Resize(bnds.getWidth(), bnds.getHeight());
 				m_ketsjiengine->Resize();
 			}
 			}
@@ -568,7 +586,10 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 {
 	if (!m_engineInitialized)
 	{
-		GPU_init();
+		/* Without OpenGL context GPU stays uninitialized, so the GLSL and
+		 * multitexture checks below fail and no material touches OpenGL. */
+		if (!m_isHeadless)
+			GPU_init();
 
 		// get and set the preferences
 		SYS_SystemHandle syshandle = SYS_GetSystem();
@@ -586,7 +607,7 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 
 		bool fixed_framerate= (SYS_GetCommandLineInt(syshandle, "fixedtime", (gm->flag & GAME_ENABLE_ALL_FRAMES)) != 0);
 		bool frameRate = (SYS_GetCommandLineInt(syshandle, "show_framerate", 0) != 0);
-		bool useLists = (SYS_GetCommandLineInt(syshandle, "displaylists", gm->flag & GAME_DISPLAY_LISTS) != 0) && GPU_display_list_support();
+		bool useLists = (SYS_GetCommandLineInt(syshandle, "displaylists", gm->flag & GAME_DISPLAY_LISTS) != 0) && !m_isHeadless && GPU_display_list_support();
 		bool nodepwarnings = (SYS_GetCommandLineInt(syshandle, "ignore_deprecation_warnings", 1) != 0);
 		bool restrictAnimFPS = (gm->flag & GAME_RESTRICT_ANIM_UPDATES) != 0;
 
@@ -599,7 +620,10 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 			m_blendermat = false;
 
 		// create the canvas, rasterizer and rendertools
-		m_canvas = new GPG_Canvas(window);
+		if (m_isHeadless)
+			m_canvas = new RAS_NullCanvas(gm->xplay, gm->yplay);
+		else
+			m_canvas = new GPG_Canvas(window);
 		if (!m_canvas)
 			return false;
 
@@ -622,7 +646,9 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 		}
 		//Don't use displaylists with VBOs
 		//If auto starts using VBOs, make sure to check for that here
-		if (useLists && raster_storage != RAS_VBO)
+		if (m_isHeadless)
+			m_rasterizer = new RAS_NullRasterizer(m_canvas);
+		else if (useLists && raster_storage != RAS_VBO)
 			m_rasterizer = new RAS_ListRasterizer(m_canvas, true, raster_storage);
 		else
 			m_rasterizer = new RAS_OpenGLRasterizer(m_canvas, raster_storage);
@@ -675,6 +701,12 @@ bool GPG_Application::initEngine(GHOST_IWindow* window, const int stereoMode)
 #endif
 
 		m_ketsjiengine->SetUseFixedTime(fixed_framerate);
+		/* Headless runs advance the clock one logic tic per frame from zero,
+		 * see EngineNextFrame(), so they don't depend on the system time. */
+		if (m_isHeadless) {
+			m_ketsjiengine->SetUseExternalClock(true);
+			m_ketsjiengine->SetClockTime(0.0);
+		}
 		m_ketsjiengine->SetTimingDisplay(frameRate, profile, properties);
 		m_ketsjiengine->SetRestrictAnimationFPS(restrictAnimFPS);
 
@@ -757,7 +789,7 @@ bool GPG_Application::startEngine(void)
 #endif // WITH_PYTHON
 
 		//initialize Dome Settings
-		if (m_startScene->gm.stereoflag == STEREO_DOME)
+		if (m_startScene->gm.stereoflag == STEREO_DOME && !m_isHeadless)
 			m_ketsjiengine->InitDome(m_startScene->gm.dome.res, m_startScene->gm.dome.mode, m_startScene->gm.dome.angle, m_startScene->gm.dome.resbuf, m_startScene->gm.dome.tilt, m_startScene->gm.dome.warptext);
 
 		// initialize 3D Audio Settings
@@ -778,7 +810,7 @@ bool GPG_Application::startEngine(void)
 		m_ketsjiengine->AddScene(m_kxStartScene);
 		
 		// Create a timer that is used to kick the engine
-		if (!m_frameTimer) {
+		if (m_system && !m_frameTimer) {
 			m_frameTimer = m_system->installTimer(0, kTimerFreq, frameTimerProc, m_mainWindow);
 		}
 		m_rasterizer->Init();
@@ -838,6 +870,8 @@ void GPG_Application::EngineNextFrame()
 		// Proceed to next frame
 		if (m_mainWindow)
 			m_mainWindow->activateDrawingContext();
+		else if (m_isHeadless)
+			m_ketsjiengine->SetClockTime(m_ketsjiengine->GetClockTime() + m_ketsjiengine->GetTimeScale() / KX_KetsjiEngine::GetTicRate());
 
 		// first check if we want to exit
 		m_exitRequested = m_ketsjiengine->GetExitCode();
@@ -897,7 +931,8 @@ void GPG_Application::exitEngine()
 		m_canvas = 0;
 	}
 
-	GPU_exit();
+	if (!m_isHeadless)
+		GPU_exit();
 
 #ifdef WITH_PYTHON
 	// Call this after we're sure nothing needs Python anymore (e.g., destructors)
@@ -49,7 +49,7 @@ class GHOST_ISystem;
 class GHOST_ITimerTask;
 class GHOST_IWindow;
 class GPC_MouseDevice;
-class GPG_Canvas;
+class RAS_ICanvas;
 class GPG_KeyboardDevice;
 class GPG_System;
 struct Main;
@@ -90,6 +90,17 @@ public:
 		return m_kxStartScene;
 	}
 
+	inline KX_KetsjiEngine *GetEngine() const
+	{
+		return m_ketsjiengine;
+	}
+
+	/**
+	 * Starts the engine without window and OpenGL context, see initEngine().
+	 * Logic and physics run with a fixed time step and frames are never rendered.
+	 */
+	bool startHeadless();
+
 	bool StartGameEngine(int stereoMode);
 	void StopGameEngine();
 	void EngineNextFrame();
@@ -101,7 +112,7 @@ protected:
 	bool	handleKey(GHOST_IEvent* event, bool isDown);
 
 	/**
-	 * Initializes the game engine.
+	 * Initializes the game engine, \a window is NULL when running headless.
 	 */
 	bool initEngine(GHOST_IWindow* window, int stereoMode);
 
@@ -147,6 +158,8 @@ protected:
 	bool m_engineRunning;
 	/** Running on embedded window */
 	bool m_isEmbedded;
+	/** Running without window, canvas and rasterizer draw nothing */
+	bool m_isHeadless;
 
 	/** the gameengine itself */
 	KX_KetsjiEngine* m_ketsjiengine;
@@ -157,7 +170,7 @@ protected:
 	/** The game engine's mouse abstraction. */
 	GPC_MouseDevice* m_mouse;
 	/** The game engine's canvas abstraction. */
-	GPG_Canvas* m_canvas;
+	RAS_ICanvas* m_canvas;
 	/** the rasterizer */
 	RAS_IRasterizer* m_rasterizer;
 	/** Converts Blender data files. */
@@ -44,6 +44,8 @@
 #include "KX_PythonInit.h"
 #include "KX_PythonMain.h"
 #include "KX_PyConstraintBinding.h" // for PHY_SetActiveEnvironment
+#include "KX_Scene.h"
+#include "SCA_Profiler.h"
 
 /**********************************
  * Begin Blender include block
@@ -59,6 +61,8 @@ extern "C"
 #include "BLI_mempool.h"
 #include "BLI_blenlib.h"
 
+#include "PIL_time.h"
+
 #include "DNA_scene_types.h"
 #include "DNA_userdef_types.h"
 #include "DNA_genfile.h"
@@ -275,6 +279,17 @@ static void usage(const char* program, bool isBlenderPlayer)
 	printf("  -c: keep console window open\n\n");
 #endif
 	printf("  -d: turn debugging on\n\n");
+	printf("  -p: write a profiling timeline of the game to a file\n");
+	printf("       --Parameters--\n");
+	printf("       file   = the Chrome trace JSON file, open it with chrome://tracing\n");
+	printf("       events = (optional) number of scopes kept per thread (default: %d)\n", SCA_PROFILER_DEFAULT_EVENTS);
+	printf("       Example: -p /tmp/profile.json  or  -p /tmp/profile.json 1000000\n\n");
+	printf("  -b: benchmark, run the game without window for a number of logic frames\n");
+	printf("       with a fixed time step, then print the time spent in each part of the\n");
+	printf("       engine and a hash of the scenes state (equal for identical runs)\n");
+	printf("       --Parameters--\n");
+	printf("       frames = number of logic frames to run\n");
+	printf("       Example: -b 1000\n\n");
 	printf("  -g: game engine options:\n\n");
 	printf("       Name                       Default      Description\n");
 	printf("       ------------------------------------------------------------------------\n");
@@ -385,6 +400,78 @@ static bool GPG_NextFrame(GHOST_ISystem* system, GPG_Application *app, int &exit
 	return run;
 }
 
+/**
+ * Run the game of \a filename headless for \a numframes logic frames and print the
+ * time spent in each engine category and the state hash of every scene.
+ */
+static bool GPG_RunBenchmark(char *filename, int numframes, int argc, char **argv)
+{
+	BlendFileData *bfd = load_game_data(BKE_appdir_program_path(), filename[0]? filename: NULL);
+	bool success = false;
+
+	if (!bfd)
+		return false;
+
+	Main *maggie = bfd->main;
+	Scene *scene = bfd->curscene;
+	GlobalSettings gs;
+
+	G.main = maggie;
+	G.fileflags = bfd->fileflags;
+	gs.matmode = scene->gm.matmode;
+	gs.glslflag = scene->gm.flag;
+
+	BKE_icons_init(1);
+
+	// this bracket is needed for app to get out of scope before the file data is freed
+	{
+		GPG_Application app(NULL);
+
+		app.SetGameEngineData(maggie, scene, &gs, argc, argv);
+#ifdef WITH_PYTHON
+		setGamePythonPath(G.main->name);
+#endif
+		if (app.startHeadless()) {
+			KX_KetsjiEngine *engine = app.GetEngine();
+			double starttime = PIL_check_seconds_timer();
+			int frame;
+
+			for (frame = 0; frame < numframes && !app.getExitRequested(); frame++)
+				app.EngineNextFrame();
+
+			double totaltime = PIL_check_seconds_timer() - starttime;
+
+			printf("Benchmark: %d frames in %.3f s, %.3f ms per frame\n",
+			       frame, totaltime, (frame) ? totaltime * 1000.0 / frame : 0.0);
+			for (int i = 0; i < KX_KetsjiEngine::GetNumProfileCategories(); i++) {
+				double time = engine->GetProfileTotal(i);
+				printf("  %-14s %10.3f ms  %6.2f %%\n", KX_KetsjiEngine::GetProfileLabel(i),
+				       time * 1000.0, (totaltime > 0.0) ? time / totaltime * 100.0 : 0.0);
+			}
+
+			KX_SceneList *scenes = engine->CurrentScenes();
+			for (KX_SceneList::iterator it = scenes->begin(); it != scenes->end(); ++it) {
+				printf("  Scene %s: state hash %08x\n", (*it)->GetName().ReadPtr(), (*it)->GetStateHash());
+			}
+
+			success = true;
+		}
+		else {
+			printf("error: couldn't start the game engine headless\n");
+		}
+
+		app.StopGameEngine();
+	}
+
+	BLO_blendfiledata_free(bfd);
+	/* G.main == bfd->main, it gets referenced in free_nodesystem so we can't have a dangling pointer */
+	G.main = NULL;
+
+	BKE_icons_free();
+
+	return success;
+}
+
 struct GPG_NextFrameState {
 	GHOST_ISystem* system;
 	GPG_Application *app;
@@ -447,6 +534,9 @@ int main(
 	bool samplesParFound = false;
 	GHOST_TUns16 aasamples = 0;
 	int alphaBackground = 0;
+	const char *profilePath = NULL;
+	unsigned int profileEvents = SCA_PROFILER_DEFAULT_EVENTS;
+	int benchmarkFrames = 0;
 	
 #ifdef WIN32
 	char **argv;
@@ -849,6 +939,32 @@ int main(
 				alphaBackground = 1;
 				break;
 			}
+			case 'p': //profiling timeline
+			{
+				i++;
+				if ((i + 1) <= validArguments) {
+					profilePath = argv[i++];
+					if ((i + 1) <= validArguments && argv[i][0] != '-')
+						profileEvents = atoi(argv[i++]);
+				}
+				else {
+					error = true;
+					printf("error: No file supplied for -p\n");
+				}
+				break;
+			}
+			case 'b': //headless benchmark
+			{
+				i++;
+				if ((i + 1) <= validArguments) {
+					benchmarkFrames = atoi(argv[i++]);
+				}
+				if (benchmarkFrames <= 0) {
+					error = true;
+					printf("error: No number of frames supplied for -b\n");
+				}
+				break;
+			}
 			default:  //not recognized
 			{
 				printf("Unknown argument: %s\n", argv[i++]);
@@ -874,6 +990,24 @@ int main(
 		return 0;
 	}
 
+	if (profilePath) {
+		SCA_Profiler::Enable(profileEvents);
+	}
+
+	if (benchmarkFrames) {
+		char filename[FILE_MAX];
+
+		get_filename(argc_py_clamped, argv, filename);
+		if (filename[0])
+			BLI_path_cwd(filename, sizeof(filename));
+
+		/* this argc cant be argc_py_clamped, since python uses it */
+		if (!GPG_RunBenchmark(filename, benchmarkFrames, argc, argv)) {
+			usage(argv[0], isBlenderPlayer);
+			error = true;
+		}
+	}
+	else
 #ifdef WIN32
 	if (scr_saver_mode != SCREEN_SAVER_MODE_CONFIGURATION)
 #endif
@@ -1182,6 +1316,14 @@ int main(
 		}
 	}
 
+	if (profilePath) {
+		if (SCA_Profiler::WriteChromeTrace(profilePath))
+			printf("Profile written to %s\n", profilePath);
+		else
+			printf("error: can't write the profile to %s\n", profilePath);
+		SCA_Profiler::Exit();
+	}
+
 	/* refer to WM_exit_ext() and BKE_blender_free(),
 	 * these are not called in the player but we need to match some of there behavior here,
 	 * if the order of function calls or blenders state isn't matching that of blender proper,
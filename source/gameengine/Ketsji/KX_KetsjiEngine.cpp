@@ -68,6 +68,7 @@
 #include "KX_WorldInfo.h"
 #include "KX_ISceneConverter.h"
 #include "KX_TimeCategoryLogger.h"
+#include "SCA_Profiler.h"
 
 #include "RAS_FramingManager.h"
 #include "DNA_world_types.h"
@@ -412,9 +413,12 @@ void KX_KetsjiEngine::RenderDome()
  */
 void KX_KetsjiEngine::StartEngine(bool clearIpo)
 {
-	m_clockTime = m_kxsystem->GetTimeInSeconds();
-	m_frameTime = m_kxsystem->GetTimeInSeconds();
-	m_previousClockTime = m_kxsystem->GetTimeInSeconds();
+	/* With an external clock the game time starts at the time set by the owner
+	 * of the clock, this keeps fixed step runs independent of the system time. */
+	if (!m_useExternalClock)
+		m_clockTime = m_kxsystem->GetTimeInSeconds();
+	m_frameTime = m_clockTime;
+	m_previousClockTime = m_clockTime;
 	m_previousRealTime = m_kxsystem->GetTimeInSeconds();
 
 	m_firstframe = true;
@@ -558,6 +562,8 @@ void KX_KetsjiEngine::EndFrame()
 
 bool KX_KetsjiEngine::NextFrame()
 {
+	SCA_PROFILE_SCOPE("frame", "NextFrame", NULL);
+
 	double timestep =  m_timescale / m_ticrate;
 	double framestep = timestep;
 	//	static hidden::Clock sClock;
@@ -643,7 +649,7 @@ bool KX_KetsjiEngine::NextFrame()
 
 	while (frames)
 	{
-	
+		SCA_PROFILE_SCOPE("frame", "LogicFrame", NULL);
 
 		m_frameTime += framestep;
 		
@@ -653,6 +659,7 @@ bool KX_KetsjiEngine::NextFrame()
 		// for each scene, call the proceed functions
 		{
 			KX_Scene* scene = *sceneit;
+			SCA_PROFILE_SCOPE("scene", scene->GetName().ReadPtr(), NULL);
 	
 			/* Suspension holds the physics and logic processing for an
 			 * entire scene. Objects can be suspended individually, and
@@ -676,6 +683,7 @@ bool KX_KetsjiEngine::NextFrame()
 				m_logger->StartLog(tc_network, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_NETWORK);
 				scene->GetNetworkScene()->proceed(m_frameTime);
+				scene->UpdateNetworkReplication();
 	
 				//m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				//SG_SetActiveStage(SG_STAGE_NETWORK_UPDATE);
@@ -782,6 +790,8 @@ bool KX_KetsjiEngine::NextFrame()
 
 void KX_KetsjiEngine::Render()
 {
+	SCA_PROFILE_SCOPE("frame", "Render", NULL);
+
 	if (m_usedome) {
 		RenderDome();
 		return;
@@ -1087,6 +1097,8 @@ void KX_KetsjiEngine::UpdateAnimations(KX_Scene *scene)
 
 void KX_KetsjiEngine::RenderShadowBuffers(KX_Scene *scene)
 {
+	SCA_PROFILE_SCOPE("render", "RenderShadowBuffers", scene->GetName().ReadPtr());
+
 	CListValue *lightlist = scene->GetLightList();
 	int i, drawmode;
 
@@ -1144,6 +1156,8 @@ void KX_KetsjiEngine::RenderShadowBuffers(KX_Scene *scene)
 // update graphics
 void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 {
+	SCA_PROFILE_SCOPE("render", "RenderFrame", scene->GetName().ReadPtr());
+
 	bool override_camera;
 	RAS_Rect viewport, area;
 	float nearfrust, farfrust, focallength;
@@ -1997,6 +2011,21 @@ void KX_KetsjiEngine::GetTimingDisplay(bool& frameRate, bool& profile, bool& pro
 	properties = m_show_debug_properties;
 }
 
+int KX_KetsjiEngine::GetNumProfileCategories()
+{
+	return tc_numCategories;
+}
+
+const char *KX_KetsjiEngine::GetProfileLabel(int category)
+{
+	return m_profileLabels[category];
+}
+
+double KX_KetsjiEngine::GetProfileTotal(int category)
+{
+	return m_logger->GetTotal((KX_TimeCategory)category);
+}
+
 
 
 void KX_KetsjiEngine::ProcessScheduledScenes(void)
@@ -470,6 +470,21 @@ public:
 	 */ 
 	void GetTimingDisplay(bool& frameRate, bool& profile, bool& properties) const;
 
+	/**
+	 * Returns the number of profiling categories, see GetProfileTotal().
+	 */
+	static int GetNumProfileCategories();
+
+	/**
+	 * Returns the label of a profiling category, as shown in the profile display.
+	 */
+	static const char *GetProfileLabel(int category);
+
+	/**
+	 * Returns the time in seconds spent in a profiling category since the engine was created.
+	 */
+	double GetProfileTotal(int category);
+
 	/** 
 	 * Sets cursor hiding on every frame.
 	 * \param hideCursor Turns hiding on or off.
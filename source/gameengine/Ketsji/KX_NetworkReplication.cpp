@@ -0,0 +1,162 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KX_NetworkReplication.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_NetworkReplication.h"
+#include "KX_GameObject.h"
+#include "KX_Camera.h"
+#include "KX_Scene.h"
+
+#include "EXP_FloatValue.h"
+#include "STR_HashedString.h"
+#include "NG_NetworkDeviceInterface.h"
+
+KX_NetworkReplication::KX_NetworkReplication(KX_Scene *scene, NG_NetworkReplicator::Role role, unsigned int peerid,
+                                             float radius, const std::vector<STR_String>& properties)
+	:m_scene(scene),
+	m_replicator(role, peerid, radius),
+	m_properties(properties),
+	m_appliedSequence(0)
+{
+}
+
+KX_NetworkReplication::~KX_NetworkReplication()
+{
+}
+
+unsigned int KX_NetworkReplication::GetObjectId(KX_GameObject *gameobj)
+{
+	return (unsigned int)STR_HashedString(gameobj->GetName()).hash();
+}
+
+bool KX_NetworkReplication::AddObject(KX_GameObject *gameobj, unsigned int id)
+{
+	std::map<unsigned int, KX_GameObject *>::iterator it = m_objects.find(id);
+
+	if (it != m_objects.end())
+		return (it->second == gameobj);
+
+	RemoveObject(gameobj);
+
+	m_objects[id] = gameobj;
+	m_objectIds[gameobj] = id;
+	return true;
+}
+
+void KX_NetworkReplication::RemoveObject(KX_GameObject *gameobj)
+{
+	std::map<KX_GameObject *, unsigned int>::iterator it = m_objectIds.find(gameobj);
+
+	if (it != m_objectIds.end()) {
+		m_objects.erase(it->second);
+		m_objectIds.erase(it);
+	}
+}
+
+void KX_NetworkReplication::CaptureObjects()
+{
+	NG_NetworkSnapshot::ObjectMap& states = m_world.GetObjects();
+	states.clear();
+
+	for (std::map<unsigned int, KX_GameObject *>::iterator it = m_objects.begin(); it != m_objects.end(); ++it) {
+		KX_GameObject *gameobj = it->second;
+		NG_NetworkObjectState& state = states.insert(states.end(), std::make_pair(it->first, NG_NetworkObjectState()))->second;
+
+		float position[3];
+		gameobj->NodeGetWorldPosition().getValue(position);
+		state.SetPosition(position);
+
+		const MT_Quaternion orn = gameobj->NodeGetWorldOrientation().getRotation();
+		const float quat[4] = {(float)orn.w(), (float)orn.x(), (float)orn.y(), (float)orn.z()};
+		state.SetOrientation(quat);
+
+		for (unsigned int i = 0; i < m_properties.size(); i++) {
+			CValue *prop = gameobj->GetProperty(m_properties[i]);
+			state.SetProperty(i, prop ? prop->GetNumber() : 0.0);
+		}
+	}
+}
+
+void KX_NetworkReplication::ApplySnapshot(const NG_NetworkSnapshot *snapshot)
+{
+	const NG_NetworkSnapshot::ObjectMap& states = snapshot->GetObjects();
+
+	for (NG_NetworkSnapshot::ObjectMap::const_iterator it = states.begin(); it != states.end(); ++it) {
+		std::map<unsigned int, KX_GameObject *>::iterator objit = m_objects.find(it->first);
+		if (objit == m_objects.end())
+			continue;
+
+		KX_GameObject *gameobj = objit->second;
+		const NG_NetworkObjectState& state = it->second;
+
+		float position[3];
+		state.GetPosition(position);
+		gameobj->NodeSetWorldPosition(MT_Point3(position));
+
+		float quat[4];
+		state.GetOrientation(quat);
+		gameobj->NodeSetGlobalOrientation(MT_Matrix3x3(MT_Quaternion(quat[1], quat[2], quat[3], quat[0])));
+
+		for (unsigned int i = 0; i < m_properties.size(); i++) {
+			CValue *prop = gameobj->GetProperty(m_properties[i]);
+			if (prop) {
+				CValue *newval = new CFloatValue((float)state.GetProperty(i));
+				prop->SetValue(newval);
+				newval->Release();
+			}
+		}
+
+		gameobj->NodeUpdateGS(0.0);
+	}
+}
+
+void KX_NetworkReplication::Update(NG_NetworkDeviceInterface *device)
+{
+	if (!device || !device->IsOnline())
+		return;
+
+	m_replicator.ReceivePackets(device);
+
+	if (m_replicator.GetRole() == NG_NetworkReplicator::NG_REPLICATION_SERVER) {
+		CaptureObjects();
+		m_replicator.SendSnapshot(device, m_world);
+	}
+	else {
+		const NG_NetworkSnapshot *snapshot = m_replicator.GetLatestSnapshot();
+		if (snapshot && snapshot->GetSequence() != m_appliedSequence) {
+			ApplySnapshot(snapshot);
+			m_appliedSequence = snapshot->GetSequence();
+		}
+
+		KX_Camera *camera = m_scene->GetActiveCamera();
+		if (camera) {
+			float viewer[3];
+			camera->NodeGetWorldPosition().getValue(viewer);
+			m_replicator.SetViewerPosition(viewer);
+		}
+
+		m_replicator.SendAck(device);
+	}
+}
@@ -0,0 +1,93 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_NetworkReplication.h
+ *  \ingroup ketsji
+ *  \brief Replicates game object transforms and properties with NG_NetworkReplicator
+ */
+
+#ifndef __KX_NETWORKREPLICATION_H__
+#define __KX_NETWORKREPLICATION_H__
+
+#include <map>
+#include <vector>
+
+#include "STR_String.h"
+#include "NG_NetworkReplicator.h"
+
+class KX_Scene;
+class KX_GameObject;
+class NG_NetworkDeviceInterface;
+
+/**
+ * Glue between a KX_Scene and NG_NetworkReplicator. Objects are identified
+ * by an id given when they are registered, by default the hash of their name,
+ * so the server and the clients must register objects with the same ids. The properties are replicated by index in
+ * the property name list, which must be the same on all peers.
+ */
+class KX_NetworkReplication
+{
+	KX_Scene *m_scene;
+	NG_NetworkReplicator m_replicator;
+	std::vector<STR_String> m_properties;
+	std::map<unsigned int, KX_GameObject *> m_objects;
+	/// Id of every registered object, needed since ids don't follow from the objects.
+	std::map<KX_GameObject *, unsigned int> m_objectIds;
+
+	/// Server: the state of all the registered objects, captured every frame.
+	NG_NetworkSnapshot m_world;
+	/// Client: sequence of the last applied snapshot.
+	unsigned int m_appliedSequence;
+
+	void CaptureObjects();
+	void ApplySnapshot(const NG_NetworkSnapshot *snapshot);
+
+public:
+	KX_NetworkReplication(KX_Scene *scene, NG_NetworkReplicator::Role role, unsigned int peerid,
+	                      float radius, const std::vector<STR_String>& properties);
+	~KX_NetworkReplication();
+
+	/// Default id of an object, the hash of its name.
+	static unsigned int GetObjectId(KX_GameObject *gameobj);
+
+	/**
+	 * Register an object, registering it again changes its id.
+	 * \return False if another object with the same id is registered.
+	 */
+	bool AddObject(KX_GameObject *gameobj, unsigned int id);
+	void RemoveObject(KX_GameObject *gameobj);
+
+	/**
+	 * Exchange the replication packets of this frame, on a server the objects state
+	 * is sent and on a client the last received state is applied to the objects.
+	 */
+	void Update(NG_NetworkDeviceInterface *device);
+
+	const NG_NetworkReplicator& GetReplicator() const { return m_replicator; }
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:KX_NetworkReplication")
+#endif
+};
+
+#endif  /* __KX_NETWORKREPLICATION_H__ */
@@ -867,6 +867,30 @@ static PyObject *gLibFree(PyObject *, PyObject *args)
 	}
 }
 
+static PyObject *gLibSetMergeBudget(PyObject *, PyObject *args)
+{
+	KX_Scene *kx_scene= gp_KetsjiScene;
+	int max_items;
+	float max_time;
+
+	if (!PyArg_ParseTuple(args,"if:setLibLoadBudget",&max_items, &max_time))
+		return NULL;
+
+	if (max_items < 0 || max_time < 0.0f) {
+		PyErr_SetString(PyExc_ValueError, "setLibLoadBudget(max_items, max_time): expected positive values or 0 for no limit");
+		return NULL;
+	}
+
+	kx_scene->GetSceneConverter()->SetMergeBudget(max_items, max_time);
+	Py_RETURN_NONE;
+}
+
+static PyObject *gLibGetMergeBudget(PyObject *)
+{
+	KX_BlenderSceneConverter *converter = gp_KetsjiScene->GetSceneConverter();
+	return Py_BuildValue("(id)", (int)converter->GetMergeMaxItems(), converter->GetMergeMaxTime());
+}
+
 static PyObject *gLibList(PyObject *, PyObject *args)
 {
 	vector<Main*> &dynMaggie = gp_KetsjiScene->GetSceneConverter()->GetMainDynamic();
@@ -950,6 +974,8 @@ static struct PyMethodDef game_methods[] = {
 	{"LibNew", (PyCFunction)gLibNew, METH_VARARGS, (const char *)""},
 	{"LibFree", (PyCFunction)gLibFree, METH_VARARGS, (const char *)""},
 	{"LibList", (PyCFunction)gLibList, METH_VARARGS, (const char *)""},
+	{"setLibLoadBudget", (PyCFunction)gLibSetMergeBudget, METH_VARARGS, (const char *)"Sets the per frame budget used to merge asynchronous libloads"},
+	{"getLibLoadBudget", (PyCFunction)gLibGetMergeBudget, METH_NOARGS, (const char *)"Gets the per frame budget used to merge asynchronous libloads"},
 	
 	{NULL, (PyCFunction) NULL, 0, NULL }
 };
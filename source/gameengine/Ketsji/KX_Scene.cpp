@@ -46,6 +46,7 @@
 #include "RAS_IPolygonMaterial.h"
 #include "EXP_ListValue.h"
 #include "SCA_LogicManager.h"
+#include "SCA_Profiler.h"
 #include "SCA_TimeEventManager.h"
 //#include "SCA_AlwaysEventManager.h"
 //#include "SCA_RandomEventManager.h"
@@ -84,6 +85,7 @@
 
 #include "KX_NetworkEventManager.h"
 #include "NG_NetworkScene.h"
+#include "KX_NetworkReplication.h"
 #include "PHY_IPhysicsEnvironment.h"
 #include "PHY_IGraphicController.h"
 #include "PHY_IPhysicsController.h"
@@ -105,6 +107,7 @@
 
 #include "KX_Light.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_task.h"
 
 static void *KX_SceneReplicationFunc(SG_IObject* node,void* gameobj,void* scene)
@@ -158,11 +161,16 @@ KX_Scene::KX_Scene(class SCA_IInputDevice* keyboarddevice,
 	m_physicsEnvironment(0),
 	m_sceneName(sceneName),
 	m_networkDeviceInterface(ndi),
+	m_networkReplication(NULL),
 	m_active_camera(NULL),
 	m_ueberExecutionPriority(0),
 	m_blenderScene(scene),
 	m_isActivedHysteresis(false),
-	m_lodHysteresisValue(0)
+	m_lodHysteresisValue(0),
+	m_mergeStage(MERGE_BEGIN),
+	m_mergeIndex(0),
+	m_mergeItemsDone(0),
+	m_mergeItemsTotal(0)
 {
 	m_suspendedtime = 0.0;
 	m_suspendeddelta = 0.0;
@@ -293,6 +301,9 @@ KX_Scene::~KX_Scene()
 
 	if (m_networkScene)
 		delete m_networkScene;
+
+	if (m_networkReplication)
+		delete m_networkReplication;
 	
 	if (m_bucketmanager)
 	{
@@ -1050,6 +1061,9 @@ int KX_Scene::NewRemoveObject(class CValue* gameobj)
 	// as only the deletion of the original object must be recorded
 	m_logicmgr->UnregisterGameObj(newobj->GetBlenderObject(), gameobj);
 
+	if (m_networkReplication)
+		m_networkReplication->RemoveObject(newobj);
+
 	//todo: look at this
 	//GetPhysicsEnvironment()->RemovePhysicsController(gameobj->getPhysicsController());
 
@@ -1533,6 +1547,8 @@ void KX_Scene::PhysicsCullingCallback(KX_ClientObjectInfo *objectInfo, void* cul
 
 void KX_Scene::CalculateVisibleMeshes(RAS_IRasterizer* rasty,KX_Camera* cam, int layer)
 {
+	SCA_PROFILE_SCOPE("render", "CalculateVisibleMeshes", m_sceneName.ReadPtr());
+
 	bool dbvt_culling = false;
 	if (m_dbvt_culling) 
 	{
@@ -1579,6 +1595,8 @@ void KX_Scene::CalculateVisibleMeshes(RAS_IRasterizer* rasty,KX_Camera* cam, int
 // logic stuff
 void KX_Scene::LogicBeginFrame(double curtime)
 {
+	SCA_PROFILE_SCOPE("logic", "LogicBeginFrame", m_sceneName.ReadPtr());
+
 	// have a look at temp objects ...
 	int lastobj = m_tempObjectList->GetCount() - 1;
 	
@@ -1624,6 +1642,8 @@ static void update_anim_thread_func(TaskPool *pool, void *taskdata, int UNUSED(t
 
 	gameobj = (KX_GameObject*)taskdata;
 
+	SCA_PROFILE_SCOPE("animation", gameobj->GetName().ReadPtr(), NULL);
+
 	// Non-armature updates are fast enough, so just update them
 	needs_update = gameobj->GetGameObjectType() != SCA_IObject::OBJ_ARMATURE;
 
@@ -1682,6 +1702,8 @@ static void update_anim_thread_func(TaskPool *pool, void *taskdata, int UNUSED(t
 
 void KX_Scene::UpdateAnimations(double curtime)
 {
+	SCA_PROFILE_SCOPE("animation", "UpdateAnimations", m_sceneName.ReadPtr());
+
 	TaskPool *pool = BLI_task_pool_create(KX_GetActiveEngine()->GetTaskScheduler(), &curtime);
 
 	for (int i=0; i<m_animatedlist->GetCount(); ++i) {
@@ -1694,6 +1716,7 @@ void KX_Scene::UpdateAnimations(double curtime)
 
 void KX_Scene::LogicUpdateFrame(double curtime, bool frame)
 {
+	SCA_PROFILE_SCOPE("logic", "LogicUpdateFrame", m_sceneName.ReadPtr());
 	m_logicmgr->UpdateFrame(curtime, frame);
 }
 
@@ -1701,6 +1724,8 @@ void KX_Scene::LogicUpdateFrame(double curtime, bool frame)
 
 void KX_Scene::LogicEndFrame()
 {
+	SCA_PROFILE_SCOPE("logic", "LogicEndFrame", m_sceneName.ReadPtr());
+
 	m_logicmgr->EndFrame();
 	int numobj;
 
@@ -1727,6 +1752,8 @@ void KX_Scene::LogicEndFrame()
  */
 void KX_Scene::UpdateParents(double curtime)
 {
+	SCA_PROFILE_SCOPE("scenegraph", "UpdateParents", m_sceneName.ReadPtr());
+
 	// we use the SG dynamic list
 	SG_Node* node;
 
@@ -1761,6 +1788,8 @@ RAS_MaterialBucket* KX_Scene::FindBucket(class RAS_IPolyMaterial* polymat, bool
 void KX_Scene::RenderBuckets(const MT_Transform & cameratransform,
                              class RAS_IRasterizer* rasty)
 {
+	SCA_PROFILE_SCOPE("render", "RenderBuckets", m_sceneName.ReadPtr());
+
 	m_bucketmanager->Renderbuckets(cameratransform,rasty);
 	KX_BlenderMaterial::EndFrame();
 }
@@ -1869,6 +1898,49 @@ void KX_Scene::SetNetworkScene(NG_NetworkScene *newScene)
 	m_networkScene = newScene;
 }
 
+void KX_Scene::SetNetworkReplication(KX_NetworkReplication *replication)
+{
+	if (m_networkReplication)
+		delete m_networkReplication;
+
+	m_networkReplication = replication;
+}
+
+void KX_Scene::UpdateNetworkReplication()
+{
+	if (m_networkReplication)
+		m_networkReplication->Update(m_networkDeviceInterface);
+}
+
+unsigned int KX_Scene::GetStateHash()
+{
+	BLI_HashMurmur2A mm2;
+	BLI_hash_mm2a_init(&mm2, 0);
+
+	for (int i = 0; i < m_objectlist->GetCount(); i++) {
+		KX_GameObject *gameobj = (KX_GameObject *)m_objectlist->GetValue(i);
+		const STR_String& name = gameobj->GetName();
+		float mat[16];
+
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)name.ReadPtr(), name.Length());
+
+		gameobj->GetSGNode()->GetWorldTransform().getValue(mat);
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)mat, sizeof(mat));
+
+		/* properties are stored sorted by name */
+		for (int j = 0; j < gameobj->GetPropertyCount(); j++) {
+			CValue *prop = gameobj->GetProperty(j);
+			const STR_String& propname = prop->GetName();
+			const STR_String& text = prop->GetText();
+
+			BLI_hash_mm2a_add(&mm2, (const unsigned char *)propname.ReadPtr(), propname.Length());
+			BLI_hash_mm2a_add(&mm2, (const unsigned char *)text.ReadPtr(), text.Length());
+		}
+	}
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
 
 void	KX_Scene::SetGravity(const MT_Vector3& gravity)
 {
@@ -1922,20 +1994,10 @@ short KX_Scene::GetAnimationFPS()
 
 static void MergeScene_LogicBrick(SCA_ILogicBrick* brick, KX_Scene *from, KX_Scene *to)
 {
-	SCA_LogicManager *logicmgr= to->GetLogicManager();
-
 	brick->Replace_IScene(to);
 	brick->Replace_NetworkScene(to->GetNetworkScene());
 	brick->SetLogicManager(to->GetLogicManager());
 
-	// If we end up replacing a KX_TouchEventManager, we need to make sure
-	// physics controllers are properly in place. In other words, do this
-	// after merging physics controllers!
-	SCA_ISensor *sensor=  dynamic_cast<class SCA_ISensor *>(brick);
-	if (sensor) {
-		sensor->Replace_EventManager(logicmgr);
-	}
-
 	SCA_2DFilterActuator *filter_actuator = dynamic_cast<class SCA_2DFilterActuator*>(brick);
 	if (filter_actuator) {
 		filter_actuator->SetScene(to);
@@ -1955,6 +2017,8 @@ static void MergeScene_LogicBrick(SCA_ILogicBrick* brick, KX_Scene *from, KX_Sce
 #endif
 }
 
+/* Only touches data of the object itself, the object is not seen by the
+ * logic, physics or event managers of \a to until MergeScene_GameObjectRegister(). */
 static void MergeScene_GameObject(KX_GameObject* gameobj, KX_Scene *to, KX_Scene *from)
 {
 	{
@@ -1989,6 +2053,23 @@ static void MergeScene_GameObject(KX_GameObject* gameobj, KX_Scene *to, KX_Scene
 		}
 	}
 
+	/* SG_Node can hold a scene reference */
+	SG_Node *sg= gameobj->GetSGNode();
+	if (sg) {
+		if (sg->GetSGClientInfo() == from) {
+			sg->SetSGClientInfo(to);
+
+			/* Make sure to grab the children too since they might not be tied to a game object */
+			NodeList children = sg->GetSGChildren();
+			for (int i=0; i<children.size(); i++)
+					children[i]->SetSGClientInfo(to);
+		}
+	}
+}
+
+/* Move the physics controllers of the object into \a to. */
+static void MergeScene_GameObjectPhysics(KX_GameObject* gameobj, KX_Scene *to)
+{
 	/* graphics controller */
 	PHY_IController *ctrl = gameobj->GetGraphicController();
 	if (ctrl) {
@@ -2000,19 +2081,21 @@ static void MergeScene_GameObject(KX_GameObject* gameobj, KX_Scene *to, KX_Scene
 	if (ctrl) {
 		ctrl->SetPhysicsEnvironment(to->GetPhysicsEnvironment());
 	}
+}
 
-	/* SG_Node can hold a scene reference */
-	SG_Node *sg= gameobj->GetSGNode();
-	if (sg) {
-		if (sg->GetSGClientInfo() == from) {
-			sg->SetSGClientInfo(to);
+/* Make the object known to the managers of \a to, after this its logic runs in \a to. */
+static void MergeScene_GameObjectRegister(KX_GameObject* gameobj, KX_Scene *to)
+{
+	SCA_LogicManager *logicmgr = to->GetLogicManager();
 
-			/* Make sure to grab the children too since they might not be tied to a game object */
-			NodeList children = sg->GetSGChildren();
-			for (int i=0; i<children.size(); i++)
-					children[i]->SetSGClientInfo(to);
-		}
+	// If we end up replacing a KX_TouchEventManager, we need to make sure
+	// physics controllers are properly in place. In other words, do this
+	// after merging physics controllers!
+	SCA_SensorList& sensors= gameobj->GetSensors();
+	for (SCA_SensorList::iterator its = sensors.begin(); !(its==sensors.end()); ++its) {
+		(*its)->Replace_EventManager(logicmgr);
 	}
+
 	/* If the object is a light, update it's scene */
 	if (gameobj->GetGameObjectType() == SCA_IObject::OBJ_LIGHT)
 		((KX_LightObject*)gameobj)->UpdateScene(to);
@@ -2025,18 +2108,24 @@ static void MergeScene_GameObject(KX_GameObject* gameobj, KX_Scene *to, KX_Scene
 		to->AddAnimatedObject(gameobj);
 
 	/* Add the object to the scene's logic manager */
-	to->GetLogicManager()->RegisterGameObjectName(gameobj->GetName(), gameobj);
-	to->GetLogicManager()->RegisterGameObj(gameobj->GetBlenderObject(), gameobj);
+	logicmgr->RegisterGameObjectName(gameobj->GetName(), gameobj);
+	logicmgr->RegisterGameObj(gameobj->GetBlenderObject(), gameobj);
 
 	for (int i = 0; i < gameobj->GetMeshCount(); ++i) {
 		RAS_MeshObject *meshobj = gameobj->GetMesh(i);
 		// Register the mesh object by name and blender object.
-		to->GetLogicManager()->RegisterGameMeshName(meshobj->GetName(), gameobj->GetBlenderObject());
-		to->GetLogicManager()->RegisterMeshName(meshobj->GetName(), meshobj);
+		logicmgr->RegisterGameMeshName(meshobj->GetName(), gameobj->GetBlenderObject());
+		logicmgr->RegisterMeshName(meshobj->GetName(), meshobj);
 	}
 }
 
 bool KX_Scene::MergeScene(KX_Scene *other)
+{
+	MergeSceneStep(other, 0);
+	return (other->m_mergeStage == MERGE_DONE);
+}
+
+bool KX_Scene::MergeSceneBegin(KX_Scene *other)
 {
 	PHY_IPhysicsEnvironment *env = this->GetPhysicsEnvironment();
 	PHY_IPhysicsEnvironment *env_other = other->GetPhysicsEnvironment();
@@ -2053,34 +2142,131 @@ bool KX_Scene::MergeScene(KX_Scene *other)
 		return false;
 	}
 
+	RAS_BucketManager *bucketmgr_other = other->GetBucketManager();
+	other->m_mergeItemsDone = 0;
+	other->m_mergeItemsTotal = other->GetObjectList()->GetCount() + other->GetInactiveList()->GetCount() +
+	                           bucketmgr_other->GetSolidBuckets().size() + bucketmgr_other->GetAlphaBuckets().size();
 
-	GetBucketManager()->MergeBucketManager(other->GetBucketManager(), this);
+	return true;
+}
 
+bool KX_Scene::MergeSceneStep(KX_Scene *other, unsigned int maxitems)
+{
+	/* number of items left for this call, unused when maxitems is 0 */
+	unsigned int budget = maxitems;
 
-	/* active + inactive == all ??? - lets hope so */
-	for (int i = 0; i < other->GetObjectList()->GetCount(); i++)
-	{
-		KX_GameObject* gameobj = (KX_GameObject*)other->GetObjectList()->GetValue(i);
-		MergeScene_GameObject(gameobj, this, other);
+	while (other->m_mergeStage != MERGE_DONE && other->m_mergeStage != MERGE_FAILED) {
+		if (maxitems && budget == 0)
+			return false;
+
+		switch (other->m_mergeStage) {
+			case MERGE_BEGIN:
+			{
+				other->m_mergeStage = MergeSceneBegin(other) ? MERGE_OBJECTS : MERGE_FAILED;
+				other->m_mergeIndex = 0;
+				break;
+			}
+			/* active + inactive == all ??? - lets hope so
+			 * Objects stay out of the logic and physics of this scene until
+			 * MERGE_FINISH, so their logic can't run while they are only
+			 * half merged. */
+			case MERGE_OBJECTS:
+			case MERGE_INACTIVE_OBJECTS:
+			{
+				const bool active = (other->m_mergeStage == MERGE_OBJECTS);
+				CListValue *objects = active ? other->GetObjectList() : other->GetInactiveList();
+
+				while (other->m_mergeIndex < (unsigned int)objects->GetCount() && !(maxitems && budget == 0)) {
+					KX_GameObject* gameobj = (KX_GameObject*)objects->GetValue(other->m_mergeIndex++);
+					MergeScene_GameObject(gameobj, this, other);
+
+					if (active) {
+						gameobj->UpdateBuckets(false); /* only for active objects */
+					}
+
+					other->m_mergeItemsDone++;
+					if (maxitems)
+						budget--;
+				}
+
+				if (other->m_mergeIndex == (unsigned int)objects->GetCount()) {
+					other->m_mergeStage = active ? MERGE_INACTIVE_OBJECTS : MERGE_BUCKETS;
+					other->m_mergeIndex = 0;
+				}
+				break;
+			}
+			case MERGE_BUCKETS:
+			{
+				RAS_BucketManager *bucketmgr_other = other->GetBucketManager();
+				const unsigned int before = bucketmgr_other->GetSolidBuckets().size() + bucketmgr_other->GetAlphaBuckets().size();
+				const bool finished = GetBucketManager()->MergeBucketManager(bucketmgr_other, this, budget);
+				const unsigned int merged = before - (bucketmgr_other->GetSolidBuckets().size() + bucketmgr_other->GetAlphaBuckets().size());
+
+				other->m_mergeItemsDone += merged;
+				if (maxitems)
+					budget -= merged;
+				if (finished)
+					other->m_mergeStage = MERGE_FINISH;
+				break;
+			}
+			case MERGE_FINISH:
+			{
+				MergeSceneFinish(other);
+				other->m_mergeItemsDone = other->m_mergeItemsTotal;
+				other->m_mergeStage = MERGE_DONE;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	return true;
+}
+
+float KX_Scene::GetMergeProgress() const
+{
+	if (m_mergeStage == MERGE_BEGIN)
+		return 0.0f;
+	if (m_mergeStage == MERGE_DONE || m_mergeStage == MERGE_FAILED || m_mergeItemsTotal == 0)
+		return 1.0f;
+
+	return (float)m_mergeItemsDone / (float)m_mergeItemsTotal;
+}
+
+void KX_Scene::MergeSceneFinish(KX_Scene *other)
+{
+	PHY_IPhysicsEnvironment *env = this->GetPhysicsEnvironment();
+	CListValue *otherObjects = other->GetObjectList();
+	CListValue *otherInactive = other->GetInactiveList();
+
+	/* Physics and logic registration are done in one go with the list merge
+	 * below, once the objects enter this scene they are complete. */
+	for (int i = 0; i < otherObjects->GetCount(); ++i) {
+		MergeScene_GameObjectPhysics((KX_GameObject *)otherObjects->GetValue(i), this);
+	}
+	for (int i = 0; i < otherInactive->GetCount(); ++i) {
+		MergeScene_GameObjectPhysics((KX_GameObject *)otherInactive->GetValue(i), this);
+	}
+
+	if (env) {
+		env->MergeEnvironment(other->GetPhysicsEnvironment());
+	}
+
+	for (int i = 0; i < otherObjects->GetCount(); ++i) {
+		KX_GameObject *gameobj = (KX_GameObject *)otherObjects->GetValue(i);
+		MergeScene_GameObjectRegister(gameobj, this);
 
 		/* add properties to debug list for LibLoad objects */
 		if (KX_GetActiveEngine()->GetAutoAddDebugProperties()) {
 			AddObjectDebugProperties(gameobj);
 		}
-
-		gameobj->UpdateBuckets(false); /* only for active objects */
 	}
-
-	for (int i = 0; i < other->GetInactiveList()->GetCount(); i++)
-	{
-		KX_GameObject* gameobj = (KX_GameObject*)other->GetInactiveList()->GetValue(i);
-		MergeScene_GameObject(gameobj, this, other);
+	for (int i = 0; i < otherInactive->GetCount(); ++i) {
+		MergeScene_GameObjectRegister((KX_GameObject *)otherInactive->GetValue(i), this);
 	}
 
 	if (env) {
-		env->MergeEnvironment(env_other);
-		CListValue *otherObjects = other->GetObjectList();
-
 		// List of all physics objects to merge (needed by ReplicateConstraints).
 		std::vector<KX_GameObject *> physicsObjects;
 		for (unsigned int i = 0; i < otherObjects->GetCount(); ++i) {
@@ -2149,7 +2335,6 @@ bool KX_Scene::MergeScene(KX_Scene *other)
 		}
 		
 	}
-	return true;
 }
 
 void KX_Scene::Update2DFilter(vector<STR_String>& propNames, void* gameObj, RAS_2DFilterManager::RAS_2DFILTER_MODE filtermode, int pass, STR_String& text)
@@ -2208,6 +2393,9 @@ PyMethodDef KX_Scene::Methods[] = {
 	KX_PYMETHODTABLE(KX_Scene, suspend),
 	KX_PYMETHODTABLE(KX_Scene, resume),
 	KX_PYMETHODTABLE(KX_Scene, drawObstacleSimulation),
+	KX_PYMETHODTABLE_KEYWORDS(KX_Scene, startReplication),
+	KX_PYMETHODTABLE(KX_Scene, stopReplication),
+	KX_PYMETHODTABLE(KX_Scene, replicateObject),
 
 	
 	/* dict style access */
@@ -2622,6 +2810,94 @@ KX_PYMETHODDEF_DOC(KX_Scene, drawObstacleSimulation,
 	Py_RETURN_NONE;
 }
 
+KX_PYMETHODDEF_DOC(KX_Scene, startReplication,
+                   "startReplication(peer_id, server, radius=0.0, properties=[])\n"
+                   "Starts replicating the objects added with replicateObject between this scene and the other peers.\n")
+{
+	int peerid;
+	int server;
+	float radius = 0.0f;
+	PyObject *pyprops = NULL;
+
+	static const char *kwlist[] = {"peer_id", "server", "radius", "properties", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii|fO!:startReplication", const_cast<char**>(kwlist),
+	                                 &peerid, &server, &radius, &PyList_Type, &pyprops))
+		return NULL;
+
+	if (peerid <= 0) {
+		PyErr_SetString(PyExc_ValueError, "scene.startReplication(peer_id, server, radius, properties): KX_Scene, expected a positive peer_id");
+		return NULL;
+	}
+
+	std::vector<STR_String> properties;
+	if (pyprops) {
+		for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pyprops); i++) {
+			const char *name = _PyUnicode_AsString(PyList_GET_ITEM(pyprops, i));
+			if (!name) {
+				PyErr_SetString(PyExc_TypeError, "scene.startReplication(peer_id, server, radius, properties): KX_Scene, expected a list of property names");
+				return NULL;
+			}
+			properties.push_back(name);
+		}
+	}
+
+	NG_NetworkReplicator::Role role = server ? NG_NetworkReplicator::NG_REPLICATION_SERVER : NG_NetworkReplicator::NG_REPLICATION_CLIENT;
+	SetNetworkReplication(new KX_NetworkReplication(this, role, peerid, radius, properties));
+
+	Py_RETURN_NONE;
+}
+
+KX_PYMETHODDEF_DOC(KX_Scene, stopReplication,
+                   "stopReplication()\n"
+                   "Stops the replication started by startReplication.\n")
+{
+	SetNetworkReplication(NULL);
+
+	Py_RETURN_NONE;
+}
+
+KX_PYMETHODDEF_DOC(KX_Scene, replicateObject,
+                   "replicateObject(object, id=None)\n"
+                   "Adds an object to the replicated objects, it must be added with the same id on all peers.\n"
+                   "Without an id the hash of the object name is used.\n")
+{
+	PyObject *pyob;
+	PyObject *pyid = Py_None;
+	KX_GameObject *ob;
+	unsigned int id;
+
+	if (!PyArg_ParseTuple(args, "O|O:replicateObject", &pyob, &pyid))
+		return NULL;
+
+	if (!ConvertPythonToGameObject(m_logicmgr, pyob, &ob, false, "scene.replicateObject(object, id): KX_Scene"))
+		return NULL;
+
+	if (!m_networkReplication) {
+		PyErr_SetString(PyExc_RuntimeError, "scene.replicateObject(object, id): KX_Scene, replication is not started");
+		return NULL;
+	}
+
+	if (pyid == Py_None) {
+		id = KX_NetworkReplication::GetObjectId(ob);
+	}
+	else {
+		id = (unsigned int)PyLong_AsUnsignedLong(pyid);
+		if (id == (unsigned int)-1 && PyErr_Occurred()) {
+			PyErr_SetString(PyExc_TypeError, "scene.replicateObject(object, id): KX_Scene, expected a positive integer id or None");
+			return NULL;
+		}
+	}
+
+	if (!m_networkReplication->AddObject(ob, id)) {
+		PyErr_Format(PyExc_ValueError, "scene.replicateObject(object, id): KX_Scene, the id %u of \"%s\" is already used by another object",
+		             id, ob->GetName().ReadPtr());
+		return NULL;
+	}
+
+	Py_RETURN_NONE;
+}
+
 /* Matches python dict.get(key, [default]) */
 KX_PYMETHODDEF_DOC(KX_Scene, get, "")
 {
@@ -196,6 +196,11 @@ protected:
 	NG_NetworkDeviceInterface*	m_networkDeviceInterface;
 	NG_NetworkScene* m_networkScene;
 
+	/**
+	 * State replication, NULL when disabled.
+	 */
+	class KX_NetworkReplication* m_networkReplication;
+
 	/**
 	 * A temporary variable used to parent objects together on
 	 * replication. Don't get confused by the name it is not
@@ -307,6 +312,27 @@ protected:
 	bool m_isActivedHysteresis;
 	int m_lodHysteresisValue;
 
+	/**
+	 * Progress of an incremental merge, only used when this scene
+	 * is the source of MergeSceneStep().
+	 */
+	enum MergeStage {
+		MERGE_BEGIN = 0,
+		MERGE_OBJECTS,
+		MERGE_INACTIVE_OBJECTS,
+		MERGE_BUCKETS,
+		MERGE_FINISH,
+		MERGE_DONE,
+		MERGE_FAILED
+	};
+	MergeStage m_mergeStage;
+	unsigned int m_mergeIndex;
+	unsigned int m_mergeItemsDone;
+	unsigned int m_mergeItemsTotal;
+
+	bool MergeSceneBegin(KX_Scene *other);
+	void MergeSceneFinish(KX_Scene *other);
+
 public:
 	KX_Scene(class SCA_IInputDevice* keyboarddevice,
 		class SCA_IInputDevice* mousedevice,
@@ -542,6 +568,23 @@ public:
 	NG_NetworkScene* GetNetworkScene();
 	KX_BlenderSceneConverter *GetSceneConverter() { return m_sceneConverter; }
 
+	/**
+	 * Replace the state replication of this scene, \a replication
+	 * is owned by the scene and can be NULL to disable it.
+	 */
+	void SetNetworkReplication(class KX_NetworkReplication *replication);
+	class KX_NetworkReplication *GetNetworkReplication() { return m_networkReplication; }
+	/**
+	 * Send or receive the replicated objects state of this frame.
+	 */
+	void UpdateNetworkReplication();
+
+	/**
+	 * Hash of the world transform and the properties of every active object,
+	 * two runs of the same scene with a fixed time step give the same hash.
+	 */
+	unsigned int GetStateHash();
+
 	/**
 	 * Replicate the logic bricks associated to this object.
 	 */
@@ -625,6 +668,9 @@ public:
 	KX_PYMETHOD_DOC(KX_Scene, resume);
 	KX_PYMETHOD_DOC(KX_Scene, get);
 	KX_PYMETHOD_DOC(KX_Scene, drawObstacleSimulation);
+	KX_PYMETHOD_DOC(KX_Scene, startReplication);
+	KX_PYMETHOD_DOC(KX_Scene, stopReplication);
+	KX_PYMETHOD_DOC(KX_Scene, replicateObject);
 
 
 	/* attributes */
@@ -686,6 +732,18 @@ public:
 
 	bool MergeScene(KX_Scene *other);
 
+	/**
+	 * Incremental version of MergeScene(), each call prepares at most \a maxitems
+	 * game objects and material buckets from \a other. Physics, logic and the
+	 * scene lists only get the objects in the last call, so their logic never
+	 * runs in this scene before they are fully merged.
+	 * \param maxitems The number of items to merge, 0 merges everything at once.
+	 * \return True when the merge is done (or failed), \a other can then be deleted.
+	 */
+	bool MergeSceneStep(KX_Scene *other, unsigned int maxitems);
+	/// Returns the fraction of \a this scene merged into another one, in [0, 1].
+	float GetMergeProgress() const;
+
 
 	//void PrintStats(int verbose_level) {
 	//	m_bucketmanager->PrintStats(verbose_level)
@@ -131,6 +131,13 @@ double KX_TimeCategoryLogger::GetAverage(void)
 }
 
 
+double KX_TimeCategoryLogger::GetTotal(TimeCategory tc)
+{
+	//assert(m_loggers[tc] != m_loggers.end());
+	return m_loggers[tc]->GetTotal();
+}
+
+
 void KX_TimeCategoryLogger::DisposeLoggers(void)
 {
 	KX_TimeLoggerMap::iterator it;
@@ -115,6 +115,11 @@ public:
 	 */
 	virtual double GetAverage(void);
 
+	/**
+	 * Returns the time logged in a category since the logger was created.
+	 */
+	virtual double GetTotal(TimeCategory tc);
+
 protected:
 	/**  
 	 * Disposes loggers.
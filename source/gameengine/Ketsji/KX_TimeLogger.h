@@ -92,6 +92,12 @@ public:
 	 */
 	virtual double GetAverage(void) const;
 
+	/**
+	 * Returns the time logged since the logger was created.
+	 * \return The sum of all measurements, including the dropped ones.
+	 */
+	virtual double GetTotal(void) const;
+
 protected:
 	/** Storage for the measurements. */
 	std::deque<double> m_measurements;
@@ -102,6 +108,9 @@ protected:
 	/** Time at start of logging. */
 	double m_logStart;
 
+	/** Sum of all logged time. */
+	double m_total;
+
 	/** State of logging. */
 	bool m_logging;
 
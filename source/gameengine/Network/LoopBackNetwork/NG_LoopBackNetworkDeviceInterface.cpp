@@ -49,6 +49,12 @@ NG_LoopBackNetworkDeviceInterface::NG_LoopBackNetworkDeviceInterface()
 
 NG_LoopBackNetworkDeviceInterface::~NG_LoopBackNetworkDeviceInterface()
 {
+	for (int i = 0; i < 2; i++) {
+		while (m_packets[i].size() > 0) {
+			m_packets[i].front()->Release();
+			m_packets[i].pop_front();
+		}
+	}
 }
 
 // perhaps this should go to the shared/common implementation too
@@ -65,6 +71,11 @@ void NG_LoopBackNetworkDeviceInterface::NextFrame()
 	}
 	//m_messages[m_currentQueue].clear();
 
+	while (m_packets[m_currentQueue].size() > 0) {
+		m_packets[m_currentQueue].front()->Release();
+		m_packets[m_currentQueue].pop_front();
+	}
+
 	m_currentQueue=1-m_currentQueue;
 }
 
@@ -110,3 +121,16 @@ vector<NG_NetworkMessage*> NG_LoopBackNetworkDeviceInterface::RetrieveNetworkMes
 	return messages;
 }
 
+void NG_LoopBackNetworkDeviceInterface::SendNetworkPacket(NG_NetworkPacket *packet)
+{
+	int backqueue = 1-m_currentQueue;
+
+	packet->AddRef();
+	m_packets[backqueue].push_back(packet);
+}
+
+vector<NG_NetworkPacket*> NG_LoopBackNetworkDeviceInterface::RetrieveNetworkPackets()
+{
+	// Like messages, the packets are owned by the queue until NextFrame().
+	return vector<NG_NetworkPacket*>(m_packets[m_currentQueue].begin(), m_packets[m_currentQueue].end());
+}
@@ -38,6 +38,7 @@
 class NG_LoopBackNetworkDeviceInterface : public NG_NetworkDeviceInterface
 {
 	std::deque<NG_NetworkMessage*> m_messages[2];
+	std::deque<NG_NetworkPacket*> m_packets[2];
 	int		m_currentQueue;
 
 public:
@@ -58,6 +59,9 @@ public:
 
 	virtual void SendNetworkMessage(class NG_NetworkMessage* msg);
 	virtual std::vector<NG_NetworkMessage*>		RetrieveNetworkMessages();
+
+	virtual void SendNetworkPacket(NG_NetworkPacket *packet);
+	virtual std::vector<NG_NetworkPacket*>		RetrieveNetworkPackets();
 };
 
 #endif  /* __NG_LOOPBACKNETWORKDEVICEINTERFACE_H__ */
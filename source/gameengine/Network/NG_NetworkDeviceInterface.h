@@ -35,6 +35,7 @@
 #define __NG_NETWORKDEVICEINTERFACE_H__
 
 #include "NG_NetworkMessage.h"
+#include "NG_NetworkPacket.h"
 #include <vector>
 
 class NG_NetworkDeviceInterface
@@ -72,6 +73,20 @@ public:
 	 */
 	
 	virtual std::vector<NG_NetworkMessage*> RetrieveNetworkMessages()=0;
+
+	/**
+	 * Send a binary packet, used by the state replication.
+	 * Devices without packet support drop them.
+	 */
+	virtual void SendNetworkPacket(NG_NetworkPacket *) {}
+	/**
+	 * Read the binary packets received since the last frame, the
+	 * packets are released by the device in NextFrame().
+	 */
+	virtual std::vector<NG_NetworkPacket*> RetrieveNetworkPackets()
+	{
+		return std::vector<NG_NetworkPacket*>();
+	}
 	
 	
 #ifdef WITH_CXX_GUARDEDALLOC
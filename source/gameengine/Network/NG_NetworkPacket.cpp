@@ -0,0 +1,122 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Network/NG_NetworkPacket.cpp
+ *  \ingroup bgenet
+ */
+
+#include <string.h>
+
+#include "NG_NetworkPacket.h"
+
+NG_NetworkPacket::NG_NetworkPacket(unsigned int from, unsigned int to)
+	:m_refcount(1),
+	m_from(from),
+	m_to(to)
+{
+}
+
+NG_NetworkPacket::~NG_NetworkPacket()
+{
+}
+
+void NG_NetworkPacket::WriteByte(unsigned char value)
+{
+	m_data.push_back(value);
+}
+
+void NG_NetworkPacket::WriteUInt(unsigned int value)
+{
+	while (value >= 0x80) {
+		m_data.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	m_data.push_back((unsigned char)value);
+}
+
+void NG_NetworkPacket::WriteInt(int value)
+{
+	WriteUInt(((unsigned int)value << 1) ^ (unsigned int)(value >> 31));
+}
+
+void NG_NetworkPacket::WriteFloat(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	/* fixed size, in little endian order */
+	for (int i = 0; i < 4; i++) {
+		m_data.push_back((unsigned char)(bits >> (i * 8)));
+	}
+}
+
+NG_NetworkPacketReader::NG_NetworkPacketReader(const NG_NetworkPacket *packet)
+	:m_packet(packet),
+	m_pos(0),
+	m_valid(true)
+{
+}
+
+unsigned char NG_NetworkPacketReader::ReadByte()
+{
+	if (m_pos >= m_packet->GetSize()) {
+		m_valid = false;
+		return 0;
+	}
+
+	return m_packet->GetData()[m_pos++];
+}
+
+unsigned int NG_NetworkPacketReader::ReadUInt()
+{
+	unsigned int value = 0;
+
+	for (unsigned int shift = 0; shift < 35; shift += 7) {
+		const unsigned char byte = ReadByte();
+		value |= (unsigned int)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+
+	/* more than 5 bytes, corrupted packet */
+	m_valid = false;
+	return 0;
+}
+
+int NG_NetworkPacketReader::ReadInt()
+{
+	const unsigned int value = ReadUInt();
+	return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+float NG_NetworkPacketReader::ReadFloat()
+{
+	unsigned int bits = 0;
+	for (int i = 0; i < 4; i++) {
+		bits |= (unsigned int)ReadByte() << (i * 8);
+	}
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
@@ -0,0 +1,113 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file NG_NetworkPacket.h
+ *  \ingroup bgenet
+ *  \brief Binary network packet, used for state replication
+ */
+
+#ifndef __NG_NETWORKPACKET_H__
+#define __NG_NETWORKPACKET_H__
+
+#include <vector>
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#include "MEM_guardedalloc.h"
+#endif
+
+/**
+ * A binary packet sent between two peers, unlike NG_NetworkMessage the
+ * content is not routed by name. Integers are stored as variable length
+ * integers so small values (deltas) only use one byte.
+ */
+class NG_NetworkPacket
+{
+	int						m_refcount;
+	unsigned int			m_from;		// sender peer id
+	unsigned int			m_to;		// receiver peer id, NG_NETWORK_BROADCAST for all peers
+	std::vector<unsigned char>	m_data;
+
+protected:
+	~NG_NetworkPacket();
+
+public:
+	NG_NetworkPacket(unsigned int from, unsigned int to);
+
+	void AddRef() {
+		m_refcount++;
+	}
+
+	void Release()
+	{
+		if (! --m_refcount)
+		{
+			delete this;
+		}
+	}
+
+	unsigned int GetSender() const { return m_from; }
+	unsigned int GetDestination() const { return m_to; }
+
+	const std::vector<unsigned char>& GetData() const { return m_data; }
+	unsigned int GetSize() const { return m_data.size(); }
+
+	void WriteByte(unsigned char value);
+	/// Write an unsigned integer using 1 to 5 bytes.
+	void WriteUInt(unsigned int value);
+	/// Write a signed integer, zigzag encoded so small negative values stay small.
+	void WriteInt(int value);
+	void WriteFloat(float value);
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:NG_NetworkPacket")
+#endif
+};
+
+/**
+ * Read cursor in a NG_NetworkPacket, a packet can be shared by several
+ * readers. Reading past the end of the packet returns zeros and marks
+ * the reader as invalid.
+ */
+class NG_NetworkPacketReader
+{
+	const NG_NetworkPacket *m_packet;
+	unsigned int m_pos;
+	bool m_valid;
+
+public:
+	NG_NetworkPacketReader(const NG_NetworkPacket *packet);
+
+	unsigned char ReadByte();
+	unsigned int ReadUInt();
+	int ReadInt();
+	float ReadFloat();
+
+	bool IsValid() const { return m_valid; }
+	bool IsAtEnd() const { return m_pos == m_packet->GetSize(); }
+	unsigned int GetRemaining() const { return m_packet->GetSize() - m_pos; }
+};
+
+/// Destination of packets sent to every peer.
+#define NG_NETWORK_BROADCAST 0
+
+#endif  /* __NG_NETWORKPACKET_H__ */
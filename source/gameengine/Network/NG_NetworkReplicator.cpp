@@ -0,0 +1,233 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Network/NG_NetworkReplicator.cpp
+ *  \ingroup bgenet
+ */
+
+#include "NG_NetworkReplicator.h"
+#include "NG_NetworkDeviceInterface.h"
+#include "NG_NetworkPacket.h"
+
+/* First byte of the replication packets */
+enum {
+	NG_PACKET_SNAPSHOT = 1,
+	NG_PACKET_ACK = 2,
+};
+
+static void free_history(std::deque<NG_NetworkSnapshot *>& history)
+{
+	while (!history.empty()) {
+		delete history.front();
+		history.pop_front();
+	}
+}
+
+static const NG_NetworkSnapshot *find_snapshot(const std::deque<NG_NetworkSnapshot *>& history, unsigned int sequence)
+{
+	for (std::deque<NG_NetworkSnapshot *>::const_iterator it = history.begin(); it != history.end(); ++it) {
+		if ((*it)->GetSequence() == sequence)
+			return *it;
+	}
+	return NULL;
+}
+
+NG_NetworkReplicator::NG_NetworkReplicator(Role role, unsigned int peerid, float radius)
+	:m_role(role),
+	m_peerid(peerid),
+	m_radius(radius),
+	m_sequence(0),
+	m_serverid(NG_NETWORK_BROADCAST),
+	m_bytesSent(0),
+	m_bytesReceived(0)
+{
+	m_viewer[0] = m_viewer[1] = m_viewer[2] = 0.0f;
+}
+
+NG_NetworkReplicator::~NG_NetworkReplicator()
+{
+	for (std::map<unsigned int, PeerState>::iterator it = m_peers.begin(); it != m_peers.end(); ++it) {
+		free_history(it->second.m_history);
+	}
+	free_history(m_received);
+}
+
+void NG_NetworkReplicator::ReceivePackets(NG_NetworkDeviceInterface *device)
+{
+	std::vector<NG_NetworkPacket *> packets = device->RetrieveNetworkPackets();
+
+	for (std::vector<NG_NetworkPacket *>::iterator it = packets.begin(); it != packets.end(); ++it) {
+		NG_NetworkPacket *packet = *it;
+
+		if (packet->GetSender() == m_peerid)
+			continue;
+		if (packet->GetDestination() != m_peerid && packet->GetDestination() != NG_NETWORK_BROADCAST)
+			continue;
+
+		NG_NetworkPacketReader reader(packet);
+		const unsigned char type = reader.ReadByte();
+
+		if (type == NG_PACKET_ACK && m_role == NG_REPLICATION_SERVER) {
+			ReceiveAck(packet->GetSender(), reader);
+		}
+		else if (type == NG_PACKET_SNAPSHOT && m_role == NG_REPLICATION_CLIENT) {
+			ReceiveSnapshot(packet->GetSender(), reader);
+		}
+		else {
+			continue;
+		}
+
+		m_bytesReceived += packet->GetSize();
+	}
+}
+
+void NG_NetworkReplicator::ReceiveAck(unsigned int from, NG_NetworkPacketReader& reader)
+{
+	const unsigned int sequence = reader.ReadUInt();
+	float viewer[3];
+	for (int i = 0; i < 3; i++) {
+		viewer[i] = reader.ReadFloat();
+	}
+
+	if (!reader.IsValid())
+		return;
+
+	/* a new client joins with its first ack */
+	std::map<unsigned int, PeerState>::iterator it = m_peers.find(from);
+	if (it == m_peers.end()) {
+		PeerState peer;
+		peer.m_ackedSequence = 0;
+		it = m_peers.insert(std::make_pair(from, peer)).first;
+	}
+
+	PeerState& peer = it->second;
+	for (int i = 0; i < 3; i++) {
+		peer.m_viewer[i] = viewer[i];
+	}
+
+	if (sequence <= peer.m_ackedSequence)
+		return;
+
+	peer.m_ackedSequence = sequence;
+
+	/* snapshots older than the acked one will never be used as baseline */
+	while (!peer.m_history.empty() && peer.m_history.front()->GetSequence() < sequence) {
+		delete peer.m_history.front();
+		peer.m_history.pop_front();
+	}
+}
+
+void NG_NetworkReplicator::ReceiveSnapshot(unsigned int from, NG_NetworkPacketReader& reader)
+{
+	const unsigned int sequence = reader.ReadUInt();
+	const unsigned int basesequence = reader.ReadUInt();
+
+	if (!reader.IsValid())
+		return;
+
+	/* late or duplicated packet */
+	if (!m_received.empty() && sequence <= m_received.back()->GetSequence())
+		return;
+
+	const NG_NetworkSnapshot *baseline = NULL;
+	if (basesequence != 0) {
+		baseline = find_snapshot(m_received, basesequence);
+		if (!baseline)
+			return;
+	}
+
+	NG_NetworkSnapshot *snapshot = new NG_NetworkSnapshot(sequence);
+	if (!snapshot->Decode(baseline, reader)) {
+		delete snapshot;
+		return;
+	}
+
+	m_serverid = from;
+	m_received.push_back(snapshot);
+	if (m_received.size() > NG_REPLICATION_HISTORY) {
+		delete m_received.front();
+		m_received.pop_front();
+	}
+}
+
+void NG_NetworkReplicator::SendSnapshot(NG_NetworkDeviceInterface *device, const NG_NetworkSnapshot& world)
+{
+	if (m_role != NG_REPLICATION_SERVER || m_peers.empty())
+		return;
+
+	m_sequence++;
+
+	for (std::map<unsigned int, PeerState>::iterator it = m_peers.begin(); it != m_peers.end(); ++it) {
+		PeerState& peer = it->second;
+
+		NG_NetworkSnapshot *snapshot = new NG_NetworkSnapshot(m_sequence);
+		world.FilterByDistance(peer.m_viewer, m_radius, *snapshot);
+
+		/* without a known baseline the full snapshot is sent */
+		const NG_NetworkSnapshot *baseline = find_snapshot(peer.m_history, peer.m_ackedSequence);
+
+		NG_NetworkPacket *packet = new NG_NetworkPacket(m_peerid, it->first);
+		packet->WriteByte(NG_PACKET_SNAPSHOT);
+		packet->WriteUInt(m_sequence);
+		packet->WriteUInt(baseline ? baseline->GetSequence() : 0);
+		snapshot->Encode(baseline, packet);
+
+		device->SendNetworkPacket(packet);
+		m_bytesSent += packet->GetSize();
+		packet->Release();
+
+		peer.m_history.push_back(snapshot);
+		if (peer.m_history.size() > NG_REPLICATION_HISTORY) {
+			delete peer.m_history.front();
+			peer.m_history.pop_front();
+		}
+	}
+}
+
+void NG_NetworkReplicator::SendAck(NG_NetworkDeviceInterface *device)
+{
+	if (m_role != NG_REPLICATION_CLIENT)
+		return;
+
+	NG_NetworkPacket *packet = new NG_NetworkPacket(m_peerid, m_serverid);
+	packet->WriteByte(NG_PACKET_ACK);
+	packet->WriteUInt(m_received.empty() ? 0 : m_received.back()->GetSequence());
+	for (int i = 0; i < 3; i++) {
+		packet->WriteFloat(m_viewer[i]);
+	}
+
+	device->SendNetworkPacket(packet);
+	m_bytesSent += packet->GetSize();
+	packet->Release();
+}
+
+void NG_NetworkReplicator::SetViewerPosition(const float position[3])
+{
+	for (int i = 0; i < 3; i++) {
+		m_viewer[i] = position[i];
+	}
+}
+
+const NG_NetworkSnapshot *NG_NetworkReplicator::GetLatestSnapshot() const
+{
+	return m_received.empty() ? NULL : m_received.back();
+}
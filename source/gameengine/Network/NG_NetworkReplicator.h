@@ -0,0 +1,126 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file NG_NetworkReplicator.h
+ *  \ingroup bgenet
+ *  \brief Snapshot replication between a server and its clients
+ */
+
+#ifndef __NG_NETWORKREPLICATOR_H__
+#define __NG_NETWORKREPLICATOR_H__
+
+#include <deque>
+#include <map>
+
+#include "NG_NetworkSnapshot.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#include "MEM_guardedalloc.h"
+#endif
+
+class NG_NetworkDeviceInterface;
+
+/// Number of snapshots kept as possible baselines, per client on the server.
+#define NG_REPLICATION_HISTORY 32
+
+/**
+ * The server sends every frame a snapshot of the replicated objects to each
+ * client, delta encoded against the last snapshot the client acknowledged.
+ * Clients send back an acknowledgement with their viewer position, the server
+ * only sends the objects within the interest radius of this position.
+ */
+class NG_NetworkReplicator
+{
+public:
+	enum Role {
+		NG_REPLICATION_SERVER = 0,
+		NG_REPLICATION_CLIENT
+	};
+
+private:
+	typedef std::deque<NG_NetworkSnapshot *> SnapshotHistory;
+
+	struct PeerState {
+		unsigned int m_ackedSequence;
+		float m_viewer[3];
+		SnapshotHistory m_history;
+	};
+
+	Role m_role;
+	unsigned int m_peerid;
+	float m_radius;
+
+	/// Server: sequence of the last sent snapshot.
+	unsigned int m_sequence;
+	/// Server: connected clients, by peer id.
+	std::map<unsigned int, PeerState> m_peers;
+
+	/// Client: received snapshots, the newest at the back.
+	SnapshotHistory m_received;
+	/// Client: id of the server, 0 until the first snapshot is received.
+	unsigned int m_serverid;
+	float m_viewer[3];
+
+	unsigned int m_bytesSent;
+	unsigned int m_bytesReceived;
+
+	void ReceiveAck(unsigned int from, class NG_NetworkPacketReader& reader);
+	void ReceiveSnapshot(unsigned int from, class NG_NetworkPacketReader& reader);
+
+public:
+	/**
+	 * \param peerid The unique id of this peer, can't be 0 (NG_NETWORK_BROADCAST).
+	 * \param radius The interest radius used by a server, 0 sends all objects.
+	 */
+	NG_NetworkReplicator(Role role, unsigned int peerid, float radius);
+	~NG_NetworkReplicator();
+
+	Role GetRole() const { return m_role; }
+	unsigned int GetPeerId() const { return m_peerid; }
+	unsigned int GetNumPeers() const { return m_peers.size(); }
+
+	/**
+	 * Read the replication packets addressed to this peer,
+	 * acknowledgements on a server and snapshots on a client.
+	 */
+	void ReceivePackets(NG_NetworkDeviceInterface *device);
+
+	/// Server: send \a world to every client that acknowledged at least once.
+	void SendSnapshot(NG_NetworkDeviceInterface *device, const NG_NetworkSnapshot& world);
+
+	/// Client: acknowledge the last received snapshot, also used to join a server.
+	void SendAck(NG_NetworkDeviceInterface *device);
+	/// Client: the position used by the server for interest management.
+	void SetViewerPosition(const float position[3]);
+	/// Client: the last received snapshot, NULL until one is received.
+	const NG_NetworkSnapshot *GetLatestSnapshot() const;
+
+	unsigned int GetBytesSent() const { return m_bytesSent; }
+	unsigned int GetBytesReceived() const { return m_bytesReceived; }
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:NG_NetworkReplicator")
+#endif
+};
+
+#endif  /* __NG_NETWORKREPLICATOR_H__ */
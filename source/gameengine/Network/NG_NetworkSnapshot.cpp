@@ -0,0 +1,340 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Network/NG_NetworkSnapshot.cpp
+ *  \ingroup bgenet
+ */
+
+#include <math.h>
+#include <limits.h>
+
+#include "NG_NetworkSnapshot.h"
+#include "NG_NetworkPacket.h"
+
+/* Bits of the per object change mask */
+enum {
+	NG_STATE_POSITION = (1 << 0),
+	NG_STATE_ORIENTATION = (1 << 1),
+	NG_STATE_PROPERTIES = (1 << 2),
+	/* Not in the baseline, fields are written as a delta against zero */
+	NG_STATE_NEW = (1 << 3),
+};
+
+/* Orientation components are stored on 10 bits */
+#define ORIENTATION_BITS 10
+#define ORIENTATION_MAX ((1 << ORIENTATION_BITS) - 1)
+#define ORIENTATION_RANGE 0.70710678118654752440f /* 1 / sqrt(2) */
+
+static int quantize(double value, double precision)
+{
+	const double scaled = floor(value * precision + 0.5);
+
+	if (scaled >= (double)INT_MAX)
+		return INT_MAX;
+	if (scaled <= (double)INT_MIN)
+		return INT_MIN;
+
+	return (int)scaled;
+}
+
+NG_NetworkObjectState::NG_NetworkObjectState()
+	:m_orientation(0)
+{
+	m_position[0] = m_position[1] = m_position[2] = 0;
+	/* identity quaternion, w is the largest component */
+	const float identity[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+	SetOrientation(identity);
+}
+
+void NG_NetworkObjectState::SetPosition(const float position[3])
+{
+	for (int i = 0; i < 3; i++) {
+		m_position[i] = quantize(position[i], NG_POSITION_PRECISION);
+	}
+}
+
+void NG_NetworkObjectState::GetPosition(float r_position[3]) const
+{
+	for (int i = 0; i < 3; i++) {
+		r_position[i] = (float)m_position[i] / NG_POSITION_PRECISION;
+	}
+}
+
+/* "Smallest three" encoding: the largest component is dropped and rebuilt
+ * from the unit length, the three others are in [-1/sqrt(2), 1/sqrt(2)]. */
+void NG_NetworkObjectState::SetOrientation(const float quat[4])
+{
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (fabsf(quat[i]) > fabsf(quat[largest]))
+			largest = i;
+	}
+
+	/* q and -q are the same rotation, keep the dropped component positive */
+	const float sign = (quat[largest] < 0.0f) ? -1.0f : 1.0f;
+
+	unsigned int packed = (unsigned int)largest;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+
+		float value = sign * quat[i] / ORIENTATION_RANGE * 0.5f + 0.5f;
+		if (value < 0.0f)
+			value = 0.0f;
+		else if (value > 1.0f)
+			value = 1.0f;
+
+		packed = (packed << ORIENTATION_BITS) | (unsigned int)(value * ORIENTATION_MAX + 0.5f);
+	}
+
+	m_orientation = packed;
+}
+
+void NG_NetworkObjectState::GetOrientation(float r_quat[4]) const
+{
+	const int largest = (int)(m_orientation >> (ORIENTATION_BITS * 3));
+	float sum = 0.0f;
+	int shift = ORIENTATION_BITS * 2;
+
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+
+		const unsigned int value = (m_orientation >> shift) & ORIENTATION_MAX;
+		r_quat[i] = ((float)value / ORIENTATION_MAX - 0.5f) * 2.0f * ORIENTATION_RANGE;
+		sum += r_quat[i] * r_quat[i];
+		shift -= ORIENTATION_BITS;
+	}
+
+	r_quat[largest] = (sum < 1.0f) ? sqrtf(1.0f - sum) : 0.0f;
+}
+
+void NG_NetworkObjectState::SetProperty(unsigned int index, double value)
+{
+	if (index >= m_properties.size())
+		m_properties.resize(index + 1, 0);
+
+	m_properties[index] = quantize(value, NG_PROPERTY_PRECISION);
+}
+
+double NG_NetworkObjectState::GetProperty(unsigned int index) const
+{
+	if (index >= m_properties.size())
+		return 0.0;
+
+	return (double)m_properties[index] / NG_PROPERTY_PRECISION;
+}
+
+bool NG_NetworkObjectState::operator==(const NG_NetworkObjectState& other) const
+{
+	return (m_position[0] == other.m_position[0] &&
+	        m_position[1] == other.m_position[1] &&
+	        m_position[2] == other.m_position[2] &&
+	        m_orientation == other.m_orientation &&
+	        m_properties == other.m_properties);
+}
+
+NG_NetworkSnapshot::NG_NetworkSnapshot(unsigned int sequence)
+	:m_sequence(sequence)
+{
+}
+
+void NG_NetworkSnapshot::FilterByDistance(const float position[3], float radius, NG_NetworkSnapshot& r_snapshot) const
+{
+	r_snapshot.Clear();
+
+	for (ObjectMap::const_iterator it = m_objects.begin(); it != m_objects.end(); ++it) {
+		if (radius > 0.0f) {
+			float objpos[3];
+			it->second.GetPosition(objpos);
+
+			const float dx = objpos[0] - position[0];
+			const float dy = objpos[1] - position[1];
+			const float dz = objpos[2] - position[2];
+			if (dx * dx + dy * dy + dz * dz > radius * radius)
+				continue;
+		}
+
+		r_snapshot.m_objects.insert(r_snapshot.m_objects.end(), *it);
+	}
+}
+
+static void write_state_delta(const NG_NetworkObjectState& state, const NG_NetworkObjectState *base,
+                              unsigned char mask, NG_NetworkPacket *packet)
+{
+	static const NG_NetworkObjectState zero_state;
+	if (!base)
+		base = &zero_state;
+
+	if (mask & NG_STATE_POSITION) {
+		for (int i = 0; i < 3; i++) {
+			packet->WriteInt((int)((unsigned int)state.m_position[i] - (unsigned int)base->m_position[i]));
+		}
+	}
+
+	if (mask & NG_STATE_ORIENTATION) {
+		packet->WriteUInt(state.m_orientation);
+	}
+
+	if (mask & NG_STATE_PROPERTIES) {
+		packet->WriteUInt(state.m_properties.size());
+		for (unsigned int i = 0; i < state.m_properties.size(); i++) {
+			const int baseval = (i < base->m_properties.size()) ? base->m_properties[i] : 0;
+			packet->WriteInt((int)((unsigned int)state.m_properties[i] - (unsigned int)baseval));
+		}
+	}
+}
+
+void NG_NetworkSnapshot::Encode(const NG_NetworkSnapshot *baseline, NG_NetworkPacket *packet) const
+{
+	/* Objects are sorted by id in both maps, so the changes and removals are found
+	 * in one pass and ids are written as (small) deltas from the previous id. */
+	std::vector<std::pair<unsigned int, unsigned char> > changed;
+	std::vector<unsigned int> removed;
+
+	ObjectMap::const_iterator it = m_objects.begin();
+	ObjectMap::const_iterator baseit;
+	if (baseline)
+		baseit = baseline->m_objects.begin();
+
+	while (it != m_objects.end() || (baseline && baseit != baseline->m_objects.end())) {
+		if (baseline && baseit != baseline->m_objects.end() &&
+		    (it == m_objects.end() || baseit->first < it->first))
+		{
+			removed.push_back(baseit->first);
+			++baseit;
+			continue;
+		}
+
+		const NG_NetworkObjectState& state = it->second;
+		unsigned char mask;
+
+		if (baseline && baseit != baseline->m_objects.end() && baseit->first == it->first) {
+			const NG_NetworkObjectState& base = baseit->second;
+			mask = 0;
+			if (state.m_position[0] != base.m_position[0] ||
+			    state.m_position[1] != base.m_position[1] ||
+			    state.m_position[2] != base.m_position[2])
+			{
+				mask |= NG_STATE_POSITION;
+			}
+			if (state.m_orientation != base.m_orientation)
+				mask |= NG_STATE_ORIENTATION;
+			if (state.m_properties != base.m_properties)
+				mask |= NG_STATE_PROPERTIES;
+			++baseit;
+		}
+		else {
+			mask = NG_STATE_NEW | NG_STATE_POSITION | NG_STATE_ORIENTATION | NG_STATE_PROPERTIES;
+		}
+
+		if (mask)
+			changed.push_back(std::make_pair(it->first, mask));
+		++it;
+	}
+
+	unsigned int previd = 0;
+
+	packet->WriteUInt(changed.size());
+	for (unsigned int i = 0; i < changed.size(); i++) {
+		const unsigned int id = changed[i].first;
+		const unsigned char mask = changed[i].second;
+
+		packet->WriteUInt(id - previd);
+		packet->WriteByte(mask);
+
+		const NG_NetworkObjectState *base = NULL;
+		if (!(mask & NG_STATE_NEW))
+			base = &baseline->m_objects.find(id)->second;
+
+		write_state_delta(m_objects.find(id)->second, base, mask, packet);
+		previd = id;
+	}
+
+	previd = 0;
+	packet->WriteUInt(removed.size());
+	for (unsigned int i = 0; i < removed.size(); i++) {
+		packet->WriteUInt(removed[i] - previd);
+		previd = removed[i];
+	}
+}
+
+bool NG_NetworkSnapshot::Decode(const NG_NetworkSnapshot *baseline, NG_NetworkPacketReader& reader)
+{
+	static const NG_NetworkObjectState zero_state;
+
+	if (baseline)
+		m_objects = baseline->m_objects;
+	else
+		m_objects.clear();
+
+	unsigned int id = 0;
+	const unsigned int numchanged = reader.ReadUInt();
+
+	for (unsigned int i = 0; i < numchanged && reader.IsValid(); i++) {
+		id += reader.ReadUInt();
+		const unsigned char mask = reader.ReadByte();
+
+		ObjectMap::iterator it = m_objects.find(id);
+		if (mask & NG_STATE_NEW) {
+			it = m_objects.insert(std::make_pair(id, zero_state)).first;
+			it->second = zero_state;
+		}
+		else if (it == m_objects.end()) {
+			/* delta against an object the baseline doesn't have */
+			return false;
+		}
+
+		NG_NetworkObjectState& state = it->second;
+
+		if (mask & NG_STATE_POSITION) {
+			for (int j = 0; j < 3; j++) {
+				state.m_position[j] = (int)((unsigned int)state.m_position[j] + (unsigned int)reader.ReadInt());
+			}
+		}
+
+		if (mask & NG_STATE_ORIENTATION) {
+			state.m_orientation = reader.ReadUInt();
+		}
+
+		if (mask & NG_STATE_PROPERTIES) {
+			const unsigned int numprops = reader.ReadUInt();
+			/* every property takes at least one byte */
+			if (!reader.IsValid() || numprops > reader.GetRemaining())
+				return false;
+
+			state.m_properties.resize(numprops, 0);
+			for (unsigned int j = 0; j < numprops; j++) {
+				state.m_properties[j] = (int)((unsigned int)state.m_properties[j] + (unsigned int)reader.ReadInt());
+			}
+		}
+	}
+
+	id = 0;
+	const unsigned int numremoved = reader.ReadUInt();
+	for (unsigned int i = 0; i < numremoved && reader.IsValid(); i++) {
+		id += reader.ReadUInt();
+		m_objects.erase(id);
+	}
+
+	return reader.IsValid();
+}
@@ -0,0 +1,123 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file NG_NetworkSnapshot.h
+ *  \ingroup bgenet
+ *  \brief Quantized object states and their delta encoding
+ */
+
+#ifndef __NG_NETWORKSNAPSHOT_H__
+#define __NG_NETWORKSNAPSHOT_H__
+
+#include <map>
+#include <vector>
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#include "MEM_guardedalloc.h"
+#endif
+
+class NG_NetworkPacket;
+class NG_NetworkPacketReader;
+
+/// Positions are stored in fixed point with this many steps per unit.
+#define NG_POSITION_PRECISION 1024.0f
+/// Numeric properties are stored in fixed point with this many steps per unit.
+#define NG_PROPERTY_PRECISION 1000.0f
+
+/**
+ * The state of one replicated object. All values are quantized so that
+ * both peers compare and delta encode exactly the same numbers.
+ */
+struct NG_NetworkObjectState
+{
+	int m_position[3];
+	/// Orientation quaternion, "smallest three" packed in 32 bits.
+	unsigned int m_orientation;
+	std::vector<int> m_properties;
+
+	NG_NetworkObjectState();
+
+	void SetPosition(const float position[3]);
+	void GetPosition(float r_position[3]) const;
+	/// \param quat The orientation as (w, x, y, z), must be normalized.
+	void SetOrientation(const float quat[4]);
+	void GetOrientation(float r_quat[4]) const;
+	void SetProperty(unsigned int index, double value);
+	double GetProperty(unsigned int index) const;
+
+	bool operator==(const NG_NetworkObjectState& other) const;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:NG_NetworkObjectState")
+#endif
+};
+
+/**
+ * The state of all replicated objects at one point in time, indexed
+ * by object id. Snapshots are sent as a delta against an older snapshot
+ * (the baseline) the receiver acknowledged, only changed objects and
+ * fields are written.
+ */
+class NG_NetworkSnapshot
+{
+public:
+	typedef std::map<unsigned int, NG_NetworkObjectState> ObjectMap;
+
+private:
+	unsigned int m_sequence;
+	ObjectMap m_objects;
+
+public:
+	NG_NetworkSnapshot(unsigned int sequence = 0);
+
+	unsigned int GetSequence() const { return m_sequence; }
+	void SetSequence(unsigned int sequence) { m_sequence = sequence; }
+
+	ObjectMap& GetObjects() { return m_objects; }
+	const ObjectMap& GetObjects() const { return m_objects; }
+
+	void Clear() { m_objects.clear(); }
+
+	/**
+	 * Copy in \a r_snapshot the objects closer than \a radius to \a position,
+	 * a radius of 0 copies every object.
+	 */
+	void FilterByDistance(const float position[3], float radius, NG_NetworkSnapshot& r_snapshot) const;
+
+	/**
+	 * Write this snapshot in \a packet as a delta against \a baseline,
+	 * \a baseline can be NULL to write a full snapshot.
+	 */
+	void Encode(const NG_NetworkSnapshot *baseline, NG_NetworkPacket *packet) const;
+	/**
+	 * Read a snapshot written by Encode() with the same \a baseline.
+	 * \return False if the packet is corrupted.
+	 */
+	bool Decode(const NG_NetworkSnapshot *baseline, NG_NetworkPacketReader& reader);
+
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:NG_NetworkSnapshot")
+#endif
+};
+
+#endif  /* __NG_NETWORKSNAPSHOT_H__ */
@@ -46,6 +46,7 @@ subject to the following restrictions:
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
 #include "RAS_TexVert.h"
+#include "SCA_Profiler.h"
 
 #include "DNA_scene_types.h"
 #include "DNA_world_types.h"
@@ -410,6 +411,7 @@ m_ccdMode(0),
 m_solverType(-1),
 m_profileTimings(0),
 m_enableSatCollisionDetection(false),
+m_subStepBeginTime(0.0),
 m_deactivationTime(2.0f),
 m_linearDeactivationThreshold(0.8f),
 m_angularDeactivationThreshold(1.0f),
@@ -713,10 +715,18 @@ void CcdPhysicsEnvironment::SimulationSubtickCallback(btScalar timeStep)
 	for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
 		(*it)->SimulationTick(timeStep);
 	}
+
+	if (SCA_Profiler::IsEnabled()) {
+		const double time = SCA_Profiler::GetTime();
+		SCA_Profiler::AddEvent("physics", "SubStep", NULL, m_subStepBeginTime, time);
+		m_subStepBeginTime = time;
+	}
 }
 
 bool	CcdPhysicsEnvironment::ProceedDeltaTime(double curTime,float timeStep,float interval)
 {
+	SCA_PROFILE_SCOPE("physics", "ProceedDeltaTime", NULL);
+
 	std::set<CcdPhysicsController*>::iterator it;
 	int i;
 
@@ -730,6 +740,8 @@ bool	CcdPhysicsEnvironment::ProceedDeltaTime(double curTime,float timeStep,float
 	}
 
 	float subStep = timeStep / float(m_numTimeSubSteps);
+	if (SCA_Profiler::IsEnabled())
+		m_subStepBeginTime = SCA_Profiler::GetTime();
 	i = m_dynamicsWorld->stepSimulation(interval,25,subStep);//perform always a full simulation step
 //uncomment next line to see where Bullet spend its time (printf in console)
 //CProfileManager::dumpAll();
@@ -90,6 +90,8 @@ protected:
 	int	m_solverType;
 	int	m_profileTimings;
 	bool m_enableSatCollisionDetection;
+	/// Profiler time of the beginning of the current simulation substep.
+	double m_subStepBeginTime;
 
 	float m_deactivationTime;
 	float m_linearDeactivationThreshold;
@@ -365,16 +365,35 @@ void RAS_BucketManager::RemoveMaterial(RAS_IPolyMaterial * mat)
 
 //#include <stdio.h>
 
-void RAS_BucketManager::MergeBucketManager(RAS_BucketManager *other, SCA_IScene *scene)
+/* Move at most 'maxbuckets' buckets from the front of 'from' to the end of 'to',
+ * maxbuckets is decremented by the number of moved buckets. */
+static void merge_bucket_list(RAS_BucketManager::BucketList& to, RAS_BucketManager::BucketList& from, unsigned int& maxbuckets)
+{
+	RAS_BucketManager::BucketList::iterator end = from.end();
+	if (maxbuckets && maxbuckets < from.size())
+		end = from.begin() + maxbuckets;
+
+	const unsigned int count = end - from.begin();
+	to.insert(to.end(), from.begin(), end);
+	from.erase(from.begin(), end);
+
+	if (maxbuckets)
+		maxbuckets -= count;
+}
+
+bool RAS_BucketManager::MergeBucketManager(RAS_BucketManager *other, SCA_IScene *scene, unsigned int maxbuckets)
 {
 	/* concatenate lists */
 	// printf("BEFORE %d %d\n", GetSolidBuckets().size(), GetAlphaBuckets().size());
+	const bool limited = (maxbuckets != 0);
 
-	GetSolidBuckets().insert( GetSolidBuckets().end(), other->GetSolidBuckets().begin(), other->GetSolidBuckets().end() );
-	other->GetSolidBuckets().clear();
+	merge_bucket_list(GetSolidBuckets(), other->GetSolidBuckets(), maxbuckets);
+	if (limited && maxbuckets == 0)
+		return (other->GetSolidBuckets().empty() && other->GetAlphaBuckets().empty());
 
-	GetAlphaBuckets().insert( GetAlphaBuckets().end(), other->GetAlphaBuckets().begin(), other->GetAlphaBuckets().end() );
-	other->GetAlphaBuckets().clear();
+	merge_bucket_list(GetAlphaBuckets(), other->GetAlphaBuckets(), maxbuckets);
 	//printf("AFTER %d %d\n", GetSolidBuckets().size(), GetAlphaBuckets().size());
+
+	return (other->GetSolidBuckets().empty() && other->GetAlphaBuckets().empty());
 }
 
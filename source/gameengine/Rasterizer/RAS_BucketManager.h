@@ -63,8 +63,9 @@ public:
 
 	void RemoveMaterial(RAS_IPolyMaterial *mat); // freeing scenes only
 
-	/* for merging */
-	void MergeBucketManager(RAS_BucketManager *other, SCA_IScene *scene);
+	/* for merging, moves at most maxbuckets buckets (0 for all of them),
+	 * returns true when other has no buckets left */
+	bool MergeBucketManager(RAS_BucketManager *other, SCA_IScene *scene, unsigned int maxbuckets = 0);
 	BucketList & GetSolidBuckets() {return m_SolidBuckets;}
 	BucketList & GetAlphaBuckets() {return m_AlphaBuckets;}
 
@@ -0,0 +1,89 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Rasterizer/RAS_NullCanvas.cpp
+ *  \ingroup bgerast
+ */
+
+#include "RAS_NullCanvas.h"
+
+RAS_NullCanvas::RAS_NullCanvas(int width, int height)
+	:m_width(width),
+	m_height(height)
+{
+	m_displayarea.SetLeft(0);
+	m_displayarea.SetBottom(0);
+	m_displayarea.SetRight(width);
+	m_displayarea.SetTop(height);
+
+	m_viewport[0] = 0;
+	m_viewport[1] = 0;
+	m_viewport[2] = width;
+	m_viewport[3] = height;
+
+	m_mousestate = MOUSE_INVISIBLE;
+	m_frame = 1;
+}
+
+RAS_NullCanvas::~RAS_NullCanvas()
+{
+}
+
+float RAS_NullCanvas::GetMouseNormalizedX(int x)
+{
+	return float(x) / m_width;
+}
+
+float RAS_NullCanvas::GetMouseNormalizedY(int y)
+{
+	return float(y) / m_height;
+}
+
+void RAS_NullCanvas::SetViewPort(int x1, int y1, int x2, int y2)
+{
+	UpdateViewPort(x1, y1, x2, y2);
+}
+
+void RAS_NullCanvas::UpdateViewPort(int x1, int y1, int x2, int y2)
+{
+	m_viewport[0] = x1;
+	m_viewport[1] = y1;
+	m_viewport[2] = x2;
+	m_viewport[3] = y2;
+}
+
+void RAS_NullCanvas::GetDisplayDimensions(int &width, int &height)
+{
+	width = m_width;
+	height = m_height;
+}
+
+void RAS_NullCanvas::ResizeWindow(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+
+	m_displayarea.SetLeft(0);
+	m_displayarea.SetBottom(0);
+	m_displayarea.SetRight(width);
+	m_displayarea.SetTop(height);
+}
@@ -0,0 +1,87 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file RAS_NullCanvas.h
+ *  \ingroup bgerast
+ *
+ * Canvas of a fixed size that is never drawn to, see RAS_NullRasterizer.
+ */
+
+#ifndef __RAS_NULLCANVAS_H__
+#define __RAS_NULLCANVAS_H__
+
+#include "RAS_ICanvas.h"
+#include "RAS_Rect.h"
+
+class RAS_NullCanvas : public RAS_ICanvas
+{
+	int m_width;
+	int m_height;
+	RAS_Rect m_displayarea;
+	int m_viewport[4];
+
+public:
+	RAS_NullCanvas(int width, int height);
+	virtual ~RAS_NullCanvas();
+
+	virtual void Init() {}
+	virtual void BeginFrame() {}
+	virtual void EndFrame() {}
+	virtual bool BeginDraw() { return true; }
+	virtual void EndDraw() {}
+	virtual void SwapBuffers() {}
+	virtual void SetSwapInterval(int) {}
+	virtual bool GetSwapInterval(int&) { return false; }
+	virtual void ClearBuffer(int) {}
+	virtual void ClearColor(float, float, float, float) {}
+
+	virtual int GetWidth() const { return m_width; }
+	virtual int GetHeight() const { return m_height; }
+
+	virtual int GetMouseX(int x) { return x; }
+	virtual int GetMouseY(int y) { return y; }
+	virtual float GetMouseNormalizedX(int x);
+	virtual float GetMouseNormalizedY(int y);
+
+	virtual const RAS_Rect &GetDisplayArea() const { return m_displayarea; }
+	virtual void SetDisplayArea(RAS_Rect *rect) { m_displayarea = *rect; }
+	virtual RAS_Rect &GetWindowArea() { return m_displayarea; }
+
+	virtual void SetViewPort(int x1, int y1, int x2, int y2);
+	virtual void UpdateViewPort(int x1, int y1, int x2, int y2);
+	virtual const int *GetViewPort() { return m_viewport; }
+
+	virtual void SetMouseState(RAS_MouseState mousestate) { m_mousestate = mousestate; }
+	virtual void SetMousePosition(int, int) {}
+	virtual void MakeScreenShot(const char *) {}
+
+	virtual void GetDisplayDimensions(int &width, int &height);
+	virtual void ResizeWindow(int width, int height);
+	virtual void SetFullScreen(bool) {}
+	virtual bool GetFullScreen() { return false; }
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_NullCanvas")
+#endif
+};
+
+#endif  /* __RAS_NULLCANVAS_H__ */
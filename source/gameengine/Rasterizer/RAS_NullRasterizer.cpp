@@ -0,0 +1,207 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Rasterizer/RAS_NullRasterizer.cpp
+ *  \ingroup bgerast
+ */
+
+#include <stdio.h>
+
+#include "RAS_NullRasterizer.h"
+#include "RAS_ICanvas.h"
+#include "RAS_Rect.h"
+
+#include "MT_CmMatrix4x4.h"
+#include "MT_Matrix3x3.h"
+#include "MT_Transform.h"
+
+#include "BLI_utildefines.h"
+
+RAS_NullLight::RAS_NullLight()
+{
+}
+
+RAS_NullLight::~RAS_NullLight()
+{
+}
+
+RAS_ILightObject *RAS_NullLight::Clone()
+{
+	return new RAS_NullLight(*this);
+}
+
+bool RAS_NullLight::HasShadowBuffer()
+{
+	return false;
+}
+
+int RAS_NullLight::GetShadowBindCode()
+{
+	return -1;
+}
+
+MT_Matrix4x4 RAS_NullLight::GetShadowMatrix()
+{
+	MT_Matrix4x4 mat;
+	mat.setIdentity();
+	return mat;
+}
+
+int RAS_NullLight::GetShadowLayer()
+{
+	return 0;
+}
+
+void RAS_NullLight::BindShadowBuffer(RAS_ICanvas *UNUSED(canvas), KX_Camera *UNUSED(cam), MT_Transform& UNUSED(camtrans))
+{
+}
+
+void RAS_NullLight::UnbindShadowBuffer()
+{
+}
+
+Image *RAS_NullLight::GetTextureImage(short UNUSED(texslot))
+{
+	return NULL;
+}
+
+void RAS_NullLight::Update()
+{
+}
+
+RAS_NullRasterizer::RAS_NullRasterizer(RAS_ICanvas *canvas)
+	:RAS_IRasterizer(canvas),
+	m_2DCanvas(canvas),
+	m_camortho(false),
+	m_stereomode(RAS_STEREO_NOSTEREO),
+	m_curreye(RAS_STEREO_LEFTEYE),
+	m_eyeseparation(0.0f),
+	m_focallength(0.0f),
+	m_drawingmode(KX_TEXTURED),
+	m_motionblur(0),
+	m_motionblurvalue(-1.0f),
+	m_anisotropic(0),
+	m_mipmap(RAS_MIPMAP_NONE),
+	m_usingoverrideshader(false)
+{
+	m_viewmatrix.setIdentity();
+	m_viewinvmatrix.setIdentity();
+	m_campos.setValue(0.0f, 0.0f, 0.0f);
+}
+
+RAS_NullRasterizer::~RAS_NullRasterizer()
+{
+}
+
+void RAS_NullRasterizer::SetRenderArea()
+{
+	RAS_Rect area;
+
+	area.SetLeft(0);
+	area.SetBottom(0);
+	area.SetRight(m_2DCanvas->GetWidth());
+	area.SetTop(m_2DCanvas->GetHeight());
+	m_2DCanvas->SetDisplayArea(&area);
+}
+
+void RAS_NullRasterizer::SetProjectionMatrix(MT_CmMatrix4x4 &mat)
+{
+	m_camortho = (mat(3, 3) != 0.0f);
+}
+
+void RAS_NullRasterizer::SetProjectionMatrix(const MT_Matrix4x4 &mat)
+{
+	m_camortho = (mat[3][3] != 0.0f);
+}
+
+void RAS_NullRasterizer::SetViewMatrix(const MT_Matrix4x4 &mat, const MT_Matrix3x3 &UNUSED(ori),
+                                       const MT_Point3 &pos, const MT_Vector3 &scale, bool UNUSED(perspective))
+{
+	m_viewmatrix = mat;
+
+	/* same (odd) negative scale test as the OpenGL rasterizer */
+	bool negX = (scale[0] < 0.0f);
+	bool negY = (scale[0] < 0.0f);
+	bool negZ = (scale[0] < 0.0f);
+	if (negX || negY || negZ) {
+		m_viewmatrix.tscale((negX) ? -1.0f : 1.0f, (negY) ? -1.0f : 1.0f, (negZ) ? -1.0f : 1.0f, 1.0);
+	}
+	m_viewinvmatrix = m_viewmatrix;
+	m_viewinvmatrix.invert();
+
+	m_campos = pos;
+}
+
+/* glFrustum() and glOrtho() written out, stereo is never enabled here */
+MT_Matrix4x4 RAS_NullRasterizer::GetFrustumMatrix(
+	float left, float right, float bottom, float top,
+	float frustnear, float frustfar,
+	float UNUSED(focallength), bool UNUSED(perspective))
+{
+	MT_Matrix4x4 result;
+
+	result.setValue(
+	        2.0f * frustnear / (right - left), 0.0f, (right + left) / (right - left), 0.0f,
+	        0.0f, 2.0f * frustnear / (top - bottom), (top + bottom) / (top - bottom), 0.0f,
+	        0.0f, 0.0f, -(frustfar + frustnear) / (frustfar - frustnear), -2.0f * frustfar * frustnear / (frustfar - frustnear),
+	        0.0f, 0.0f, -1.0f, 0.0f);
+
+	return result;
+}
+
+MT_Matrix4x4 RAS_NullRasterizer::GetOrthoMatrix(
+	float left, float right, float bottom, float top,
+	float frustnear, float frustfar)
+{
+	MT_Matrix4x4 result;
+
+	result.setValue(
+	        2.0f / (right - left), 0.0f, 0.0f, -(right + left) / (right - left),
+	        0.0f, 2.0f / (top - bottom), 0.0f, -(top + bottom) / (top - bottom),
+	        0.0f, 0.0f, -2.0f / (frustfar - frustnear), -(frustfar + frustnear) / (frustfar - frustnear),
+	        0.0f, 0.0f, 0.0f, 1.0f);
+
+	return result;
+}
+
+void RAS_NullRasterizer::EnableMotionBlur(float motionblurvalue)
+{
+	if (m_motionblur == 0)
+		m_motionblur = 1;
+	m_motionblurvalue = motionblurvalue;
+}
+
+void RAS_NullRasterizer::DisableMotionBlur()
+{
+	m_motionblur = 0;
+	m_motionblurvalue = -1.0f;
+}
+
+RAS_ILightObject *RAS_NullRasterizer::CreateLight()
+{
+	return new RAS_NullLight();
+}
+
+void RAS_NullRasterizer::PrintHardwareInfo()
+{
+	printf("Null rasterizer: no OpenGL context, nothing is drawn\n");
+}
@@ -0,0 +1,219 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file RAS_NullRasterizer.h
+ *  \ingroup bgerast
+ *
+ * Rasterizer that keeps the state the engine queries but never touches OpenGL,
+ * used to run the game engine without a window (headless benchmarks, servers).
+ */
+
+#ifndef __RAS_NULLRASTERIZER_H__
+#define __RAS_NULLRASTERIZER_H__
+
+#include "RAS_IRasterizer.h"
+#include "RAS_ILightObject.h"
+
+#include "MT_Matrix4x4.h"
+#include "MT_Point3.h"
+
+class RAS_ICanvas;
+
+/**
+ * Light without shadow buffer or GPU lamp.
+ */
+class RAS_NullLight : public RAS_ILightObject
+{
+public:
+	RAS_NullLight();
+	virtual ~RAS_NullLight();
+
+	virtual RAS_ILightObject *Clone();
+
+	virtual bool HasShadowBuffer();
+	virtual int GetShadowBindCode();
+	virtual MT_Matrix4x4 GetShadowMatrix();
+	virtual int GetShadowLayer();
+	virtual void BindShadowBuffer(RAS_ICanvas *canvas, KX_Camera *cam, MT_Transform& camtrans);
+	virtual void UnbindShadowBuffer();
+	virtual Image *GetTextureImage(short texslot);
+	virtual void Update();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_NullLight")
+#endif
+};
+
+/**
+ * Rasterizer doing no drawing at all.
+ *
+ * Matrices are still computed so that cameras, culling and the python API
+ * return the same values as with the OpenGL rasterizer.
+ */
+class RAS_NullRasterizer : public RAS_IRasterizer
+{
+	RAS_ICanvas *m_2DCanvas;
+
+	MT_Matrix4x4 m_viewmatrix;
+	MT_Matrix4x4 m_viewinvmatrix;
+	MT_Point3 m_campos;
+	bool m_camortho;
+
+	StereoMode m_stereomode;
+	StereoEye m_curreye;
+	float m_eyeseparation;
+	float m_focallength;
+
+	int m_drawingmode;
+	int m_motionblur;
+	float m_motionblurvalue;
+	short m_anisotropic;
+	MipmapOption m_mipmap;
+	bool m_usingoverrideshader;
+
+public:
+	RAS_NullRasterizer(RAS_ICanvas *canvas);
+	virtual ~RAS_NullRasterizer();
+
+	virtual void SetDepthMask(DepthMask) {}
+	virtual bool SetMaterial(const RAS_IPolyMaterial &) { return true; }
+	virtual bool Init() { return true; }
+	virtual void Exit() {}
+	virtual bool BeginFrame(double) { return true; }
+	virtual void ClearColorBuffer() {}
+	virtual void ClearDepthBuffer() {}
+	virtual void ClearCachingInfo(void) {}
+	virtual void EndFrame() {}
+	virtual void SetRenderArea();
+
+	virtual void SetStereoMode(const StereoMode stereomode) { m_stereomode = stereomode; }
+	virtual bool Stereo() { return false; }
+	virtual StereoMode GetStereoMode() { return m_stereomode; }
+	virtual bool InterlacedStereo() { return false; }
+	virtual void SetEye(const StereoEye eye) { m_curreye = eye; }
+	virtual StereoEye GetEye() { return m_curreye; }
+	virtual void SetEyeSeparation(const float eyeseparation) { m_eyeseparation = eyeseparation; }
+	virtual float GetEyeSeparation() { return m_eyeseparation; }
+	virtual void SetFocalLength(const float focallength) { m_focallength = focallength; }
+	virtual float GetFocalLength() { return m_focallength; }
+
+	virtual RAS_IOffScreen *CreateOffScreen(int, int, int, int) { return NULL; }
+	virtual RAS_ISync *CreateSync(int) { return NULL; }
+	virtual void SwapBuffers() {}
+
+	virtual void IndexPrimitives(class RAS_MeshSlot &) {}
+	virtual void IndexPrimitives_3DText(class RAS_MeshSlot &, class RAS_IPolyMaterial *) {}
+
+	virtual void SetProjectionMatrix(MT_CmMatrix4x4 &mat);
+	virtual void SetProjectionMatrix(const MT_Matrix4x4 &mat);
+	virtual void SetViewMatrix(const MT_Matrix4x4 &mat, const MT_Matrix3x3 &ori,
+	                           const MT_Point3 &pos, const MT_Vector3 &scale, bool perspective);
+
+	virtual const MT_Point3& GetCameraPosition() { return m_campos; }
+	virtual bool GetCameraOrtho() { return m_camortho; }
+
+	virtual void SetFog(short, float, float, float, float[3]) {}
+	virtual void DisplayFog() {}
+	virtual void EnableFog(bool) {}
+	virtual void SetBackColor(float[3]) {}
+
+	virtual void SetDrawingMode(int drawingmode) { m_drawingmode = drawingmode; }
+	virtual int GetDrawingMode() { return m_drawingmode; }
+	virtual void SetCullFace(bool) {}
+	virtual void SetLines(bool) {}
+
+	virtual double GetTime() { return 0.0; }
+
+	virtual MT_Matrix4x4 GetFrustumMatrix(
+	        float left, float right, float bottom, float top,
+	        float frustnear, float frustfar,
+	        float focallength = 0.0f, bool perspective = true);
+	virtual MT_Matrix4x4 GetOrthoMatrix(
+	        float left, float right, float bottom, float top,
+	        float frustnear, float frustfar);
+
+	virtual void SetSpecularity(float, float, float, float) {}
+	virtual void SetShinyness(float) {}
+	virtual void SetDiffuse(float, float, float, float) {}
+	virtual void SetEmissive(float, float, float, float) {}
+	virtual void SetAmbientColor(float[3]) {}
+	virtual void SetAmbient(float) {}
+	virtual void SetPolygonOffset(float, float) {}
+
+	virtual void DrawDebugLine(SCA_IScene *, const MT_Vector3 &, const MT_Vector3 &, const MT_Vector3&) {}
+	virtual void DrawDebugCircle(SCA_IScene *, const MT_Vector3 &, const MT_Scalar,
+	                             const MT_Vector3 &, const MT_Vector3 &, int) {}
+	virtual void FlushDebugShapes(SCA_IScene *) {}
+
+	virtual void SetTexCoordNum(int) {}
+	virtual void SetAttribNum(int) {}
+	virtual void SetTexCoord(TexCoGen, int) {}
+	virtual void SetAttrib(TexCoGen, int, int = 0) {}
+
+	virtual const MT_Matrix4x4 &GetViewMatrix() const { return m_viewmatrix; }
+	virtual const MT_Matrix4x4 &GetViewInvMatrix() const { return m_viewinvmatrix; }
+
+	virtual void EnableMotionBlur(float motionblurvalue);
+	virtual void DisableMotionBlur();
+	virtual float GetMotionBlurValue() { return m_motionblurvalue; }
+	virtual int GetMotionBlurState() { return m_motionblur; }
+	virtual void SetMotionBlurState(int newstate) { m_motionblur = newstate; }
+
+	virtual void SetAlphaBlend(int) {}
+	virtual void SetFrontFace(bool) {}
+
+	virtual void SetAnisotropicFiltering(short level) { m_anisotropic = level; }
+	virtual short GetAnisotropicFiltering() { return m_anisotropic; }
+	virtual void SetMipmapping(MipmapOption val) { m_mipmap = val; }
+	virtual MipmapOption GetMipmapping() { return m_mipmap; }
+	virtual void SetUsingOverrideShader(bool val) { m_usingoverrideshader = val; }
+	virtual bool GetUsingOverrideShader() { return m_usingoverrideshader; }
+
+	virtual void applyTransform(float *, int) {}
+
+	virtual void RenderBox2D(int, int, int, int, float) {}
+	virtual void RenderText3D(
+	        int, const char *, int, int,
+	        const float[4], const float[16], float) {}
+	virtual void RenderText2D(
+	        RAS_TEXT_RENDER_MODE, const char *,
+	        int, int, int, int) {}
+
+	virtual void ProcessLighting(bool, const MT_Transform &) {}
+	virtual void PushMatrix() {}
+	virtual void PopMatrix() {}
+
+	virtual RAS_ILightObject *CreateLight();
+	virtual void AddLight(RAS_ILightObject *) {}
+	virtual void RemoveLight(RAS_ILightObject *) {}
+
+	virtual void MotionBlur() {}
+	virtual void SetClientObject(void *) {}
+	virtual void SetAuxilaryClientInfo(void *) {}
+	virtual void PrintHardwareInfo();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:RAS_NullRasterizer")
+#endif
+};
+
+#endif  /* __RAS_NULLRASTERIZER_H__ */
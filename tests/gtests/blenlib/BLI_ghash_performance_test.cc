@@ -163,6 +163,13 @@ TEST(ghash, TextMurmur2a)
 	str_ghash_tests(ghash, "StrGHash - Murmur");
 }
 
+TEST(ghash, TextFlat)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, __func__);
+
+	str_ghash_tests(ghash, "StrGHash - Flat");
+}
+
 
 /* Int: uniform 100M first integers. */
 
@@ -253,6 +260,22 @@ TEST(ghash, IntMurmur2a100000000)
 }
 #endif
 
+TEST(ghash, IntFlat12000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	int_ghash_tests(ghash, "IntGHash - Flat - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntFlat100000000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	int_ghash_tests(ghash, "IntGHash - Flat - 100000000", 100000000);
+}
+#endif
+
 /* Int: random 50M integers. */
 
 static void randint_ghash_tests(GHash *ghash, const char *id, const unsigned int nbr)
@@ -335,6 +358,22 @@ TEST(ghash, IntRandMurmur2a50000000)
 }
 #endif
 
+TEST(ghash, IntRandFlat12000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	randint_ghash_tests(ghash, "RandIntGHash - Flat - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntRandFlat50000000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	randint_ghash_tests(ghash, "RandIntGHash - Flat - 50000000", 50000000);
+}
+#endif
+
 static unsigned int ghashutil_tests_nohash_p(const void *p)
 {
 	return GET_UINT_FROM_POINTER(p);
@@ -447,6 +486,22 @@ TEST(ghash, Int4Murmur2a20000000)
 }
 #endif
 
+TEST(ghash, Int4Flat2000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_uinthash_v4_p, BLI_ghashutil_uinthash_v4_cmp, __func__);
+
+	int4_ghash_tests(ghash, "Int4GHash - Flat - 2000", 2000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, Int4Flat20000000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_uinthash_v4_p, BLI_ghashutil_uinthash_v4_cmp, __func__);
+
+	int4_ghash_tests(ghash, "Int4GHash - Flat - 20000000", 20000000);
+}
+#endif
+
 /* MultiSmall: create and manipulate a lot of very small ghashes (90% < 10 items, 9% < 100 items, 1% < 1000 items). */
 
 static void multi_small_ghash_tests_one(GHash *ghash, RNG *rng, const unsigned int nbr)
@@ -534,3 +589,17 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+TEST(ghash, MultiRandIntFlat2000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Flat - 2000", 2000);
+}
+
+TEST(ghash, MultiRandIntFlat200000)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Flat - 200000", 200000);
+}
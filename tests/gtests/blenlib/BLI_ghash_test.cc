@@ -198,3 +198,211 @@ TEST(ghash, Pop)
 
 	BLI_ghash_free(ghash, NULL, NULL);
 }
+
+/* Flat storage. */
+
+TEST(ghash, FlatInsertLookup)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 0);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_ghash_size(ghash));
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(*k, GET_UINT_FROM_POINTER(v));
+	}
+
+	EXPECT_FALSE(BLI_ghash_haskey(ghash, SET_UINT_IN_POINTER(keys[0] + 1)));
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+/* Insert and remove all keys twice, removed slots must be reused without growing. */
+TEST(ghash, FlatInsertRemove)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i, pass, bkt_size = 0;
+
+	init_keys(keys, 10);
+
+	for (pass = 0; pass < 2; pass++) {
+		for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+			BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+		}
+
+		EXPECT_EQ(TESTCASE_SIZE, BLI_ghash_size(ghash));
+		if (pass == 0) {
+			bkt_size = BLI_ghash_buckets_size(ghash);
+		}
+		EXPECT_EQ(bkt_size, BLI_ghash_buckets_size(ghash));
+
+		for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+			void *v = BLI_ghash_popkey(ghash, SET_UINT_IN_POINTER(*k), NULL);
+			EXPECT_EQ(*k, GET_UINT_FROM_POINTER(v));
+		}
+
+		EXPECT_EQ(0, BLI_ghash_size(ghash));
+	}
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+/* Random insertions and removals, checked against a regular GHash. */
+TEST(ghash, FlatChurn)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	GHash *ghash_ref = BLI_ghash_int_new(__func__);
+	RNG *rng = BLI_rng_new(40);
+	GHashIterator gh_iter;
+	int i;
+
+	for (i = 0; i < TESTCASE_SIZE * 10; i++) {
+		/* Small key range, so keys get removed and added again a lot. */
+		void *key = SET_UINT_IN_POINTER(BLI_rng_get_uint(rng) % (TESTCASE_SIZE / 4));
+		const bool haskey = BLI_ghash_haskey(ghash_ref, key);
+
+		EXPECT_EQ(haskey, BLI_ghash_haskey(ghash, key));
+		if (haskey) {
+			EXPECT_EQ(BLI_ghash_remove(ghash_ref, key, NULL, NULL), BLI_ghash_remove(ghash, key, NULL, NULL));
+		}
+		else {
+			EXPECT_EQ(BLI_ghash_reinsert(ghash_ref, key, key, NULL, NULL), BLI_ghash_reinsert(ghash, key, key, NULL, NULL));
+		}
+	}
+
+	EXPECT_EQ(BLI_ghash_size(ghash_ref), BLI_ghash_size(ghash));
+
+	i = 0;
+	GHASH_ITER (gh_iter, ghash) {
+		void *key = BLI_ghashIterator_getKey(&gh_iter);
+		EXPECT_EQ(key, BLI_ghashIterator_getValue(&gh_iter));
+		EXPECT_TRUE(BLI_ghash_haskey(ghash_ref, key));
+		i++;
+	}
+	EXPECT_EQ(BLI_ghash_size(ghash_ref), i);
+
+	BLI_rng_free(rng);
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_ghash_free(ghash_ref, NULL, NULL);
+}
+
+TEST(ghash, FlatEnsure)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 50);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void **val_p;
+		EXPECT_FALSE(BLI_ghash_ensure_p(ghash, SET_UINT_IN_POINTER(*k), &val_p));
+		*val_p = SET_UINT_IN_POINTER(*k);
+	}
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void **val_p;
+		EXPECT_TRUE(BLI_ghash_ensure_p(ghash, SET_UINT_IN_POINTER(*k), &val_p));
+		EXPECT_EQ(*k, GET_UINT_FROM_POINTER(*val_p));
+	}
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_ghash_size(ghash));
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+TEST(ghash, FlatCopy)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	GHash *ghash_copy;
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 30);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	ghash_copy = BLI_ghash_copy(ghash, NULL, NULL);
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_ghash_size(ghash_copy));
+	EXPECT_EQ(BLI_ghash_buckets_size(ghash), BLI_ghash_buckets_size(ghash_copy));
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ghash_lookup(ghash_copy, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(*k, GET_UINT_FROM_POINTER(v));
+	}
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_ghash_free(ghash_copy, NULL, NULL);
+}
+
+TEST(ghash, FlatPop)
+{
+	GHash *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 30);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	GHashIterState pop_state = {0};
+
+	{
+		void *k, *v;
+		for (i = 0; BLI_ghash_pop(ghash, &pop_state, &k, &v); i++) {
+			EXPECT_EQ(k, v);
+		}
+	}
+	EXPECT_EQ(TESTCASE_SIZE, i);
+	EXPECT_EQ(0, BLI_ghash_size(ghash));
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+TEST(ghash, FlatGSet)
+{
+	GSet *gset = BLI_gset_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	GSetIterator gs_iter;
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 60);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_TRUE(BLI_gset_add(gset, SET_UINT_IN_POINTER(*k)));
+	}
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_FALSE(BLI_gset_add(gset, SET_UINT_IN_POINTER(*k)));
+	}
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_gset_size(gset));
+
+	i = 0;
+	GSET_ITER (gs_iter, gset) {
+		EXPECT_TRUE(BLI_gset_haskey(gset, BLI_gsetIterator_getKey(&gs_iter)));
+		i++;
+	}
+	EXPECT_EQ(TESTCASE_SIZE, i);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_TRUE(BLI_gset_remove(gset, SET_UINT_IN_POINTER(*k), NULL));
+	}
+
+	EXPECT_EQ(0, BLI_gset_size(gset));
+
+	BLI_gset_free(gset, NULL);
+}
@@ -0,0 +1,209 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define TASK_RUN_BIG
+
+#ifdef TASK_RUN_BIG
+#  define NUM_ITEMS 100000000
+#else
+#  define NUM_ITEMS 10000000
+#endif
+
+/* Iterations of the 'heavy' loop get this much more expensive over the range. */
+#define HEAVY_ITER_COST 64
+
+typedef struct TaskPerfChunk {
+	double sum;
+	float min[3], max[3];
+} TaskPerfChunk;
+
+typedef struct TaskPerfData {
+	float (*vecs)[3];
+	int num;
+	/* Result of the finalize based reduction. */
+	TaskPerfChunk finalize_join;
+} TaskPerfData;
+
+static const char *scheduling_mode_names[] = {"static", "dynamic", "guided", "adaptive"};
+
+/* Cheap iterations, as when computing normals. */
+static void task_perf_normalize(void *userdata, const int iter)
+{
+	TaskPerfData *data = (TaskPerfData *)userdata;
+	normalize_v3(data->vecs[iter]);
+}
+
+/* Iterations getting more expensive towards the end of the range, bad case for static scheduling. */
+static void task_perf_heavy(void *userdata, const int iter)
+{
+	TaskPerfData *data = (TaskPerfData *)userdata;
+	const int steps = 1 + (int)(((int64_t)iter * HEAVY_ITER_COST) / data->num);
+	float *v = data->vecs[iter];
+
+	for (int i = 0; i < steps; i++) {
+		v[0] = v[1] * 0.5f + v[2];
+		v[1] = v[2] * 0.5f + v[0];
+		v[2] = v[0] * 0.5f + v[1];
+		normalize_v3(v);
+	}
+}
+
+static void task_perf_minmax(void *userdata, void *userdata_chunk, const int iter, const int UNUSED(threadid))
+{
+	TaskPerfData *data = (TaskPerfData *)userdata;
+	TaskPerfChunk *chunk = (TaskPerfChunk *)userdata_chunk;
+	const float *v = data->vecs[iter];
+
+	minmax_v3v3_v3(chunk->min, chunk->max, v);
+	chunk->sum += (double)v[0];
+}
+
+static void task_perf_minmax_reduce(void *UNUSED(userdata), void *userdata_chunk_join, void *userdata_chunk)
+{
+	TaskPerfChunk *join = (TaskPerfChunk *)userdata_chunk_join;
+	TaskPerfChunk *chunk = (TaskPerfChunk *)userdata_chunk;
+
+	for (int i = 0; i < 3; i++) {
+		join->min[i] = min_ff(join->min[i], chunk->min[i]);
+		join->max[i] = max_ff(join->max[i], chunk->max[i]);
+	}
+	join->sum += chunk->sum;
+}
+
+static ThreadMutex task_perf_minmax_mutex = BLI_MUTEX_INITIALIZER;
+
+static void task_perf_minmax_finalize(void *userdata, void *userdata_chunk)
+{
+	TaskPerfChunk *join = &((TaskPerfData *)userdata)->finalize_join;
+
+	BLI_mutex_lock(&task_perf_minmax_mutex);
+	task_perf_minmax_reduce(NULL, join, userdata_chunk);
+	BLI_mutex_unlock(&task_perf_minmax_mutex);
+}
+
+static void task_perf_data_init(TaskPerfData *data, const int num)
+{
+	data->num = num;
+	data->vecs = (float (*)[3])MEM_mallocN(sizeof(*data->vecs) * (size_t)num, __func__);
+
+	for (int i = 0; i < num; i++) {
+		data->vecs[i][0] = (float)(i % 113) - 56.0f;
+		data->vecs[i][1] = (float)(i % 127) + 1.0f;
+		data->vecs[i][2] = (float)(i % 131) - 65.0f;
+	}
+}
+
+static void task_perf_range_tests(TaskParallelRangeFunc func, const int num, const char *id)
+{
+	TaskPerfData data;
+	ParallelRangeSettings settings;
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	BLI_threadapi_init();
+	task_perf_data_init(&data, num);
+
+	{
+		TIMEIT_START(serial);
+		for (int i = 0; i < num; i++) {
+			func(&data, i);
+		}
+		TIMEIT_END(serial);
+	}
+
+	BLI_parallel_range_settings_defaults(&settings);
+
+	for (int mode = TASK_SCHEDULING_STATIC; mode <= TASK_SCHEDULING_ADAPTIVE; mode++) {
+		settings.scheduling_mode = (eTaskSchedulingMode)mode;
+
+		printf("%s:\n", scheduling_mode_names[mode]);
+		TIMEIT_START(parallel_range);
+		BLI_task_parallel_range_with_settings(0, num, &data, func, &settings);
+		TIMEIT_END(parallel_range);
+	}
+
+	MEM_freeN(data.vecs);
+	BLI_threadapi_exit();
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(task, RangeCheap)
+{
+	task_perf_range_tests(task_perf_normalize, NUM_ITEMS, "Parallel range - cheap iterations");
+}
+
+TEST(task, RangeHeavy)
+{
+	task_perf_range_tests(task_perf_heavy, NUM_ITEMS / 16, "Parallel range - increasingly heavy iterations");
+}
+
+TEST(task, Reduce)
+{
+	TaskPerfData data_buf;
+	TaskPerfData *data = &data_buf;
+	TaskPerfChunk chunk_init = {0.0};
+	ParallelRangeSettings settings;
+
+	printf("\n========== STARTING Parallel reduce ==========\n");
+
+	BLI_threadapi_init();
+	task_perf_data_init(data, NUM_ITEMS);
+	INIT_MINMAX(chunk_init.min, chunk_init.max);
+
+	{
+		TaskPerfChunk chunk = chunk_init;
+
+		TIMEIT_START(serial);
+		for (int i = 0; i < NUM_ITEMS; i++) {
+			task_perf_minmax(data, &chunk, i, 0);
+		}
+		TIMEIT_END(serial);
+	}
+
+	{
+		TaskPerfChunk chunk = chunk_init;
+
+		data->finalize_join = chunk_init;
+
+		TIMEIT_START(parallel_range_finalize);
+		BLI_task_parallel_range_finalize(0, NUM_ITEMS, data, &chunk, sizeof(chunk),
+		                                 task_perf_minmax, task_perf_minmax_finalize, true, true);
+		TIMEIT_END(parallel_range_finalize);
+	}
+
+	BLI_parallel_range_settings_defaults(&settings);
+
+	for (int mode = TASK_SCHEDULING_STATIC; mode <= TASK_SCHEDULING_ADAPTIVE; mode++) {
+		TaskPerfChunk chunk = chunk_init;
+
+		settings.scheduling_mode = (eTaskSchedulingMode)mode;
+
+		printf("%s:\n", scheduling_mode_names[mode]);
+		TIMEIT_START(parallel_reduce);
+		BLI_task_parallel_reduce(0, NUM_ITEMS, data, &chunk, sizeof(chunk),
+		                         task_perf_minmax, task_perf_minmax_reduce, &settings);
+		TIMEIT_END(parallel_reduce);
+
+		EXPECT_EQ(data->finalize_join.sum, chunk.sum);
+		EXPECT_EQ_ARRAY(data->finalize_join.min, chunk.min, 3);
+		EXPECT_EQ_ARRAY(data->finalize_join.max, chunk.max, 3);
+	}
+
+	MEM_freeN(data->vecs);
+	BLI_threadapi_exit();
+
+	printf("========== ENDED Parallel reduce ==========\n\n");
+}
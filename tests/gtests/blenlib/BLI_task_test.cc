@@ -0,0 +1,296 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "MEM_guardedalloc.h"
+};
+
+#define NUM_TASKS 10000
+#define NUM_NESTED_TASKS 100
+
+/* use more threads than cores, to expose scheduling bugs on small machines */
+#define NUM_THREADS 8
+
+typedef struct TaskTestData {
+	TaskScheduler *scheduler;
+	size_t counter;
+	size_t running;
+	size_t running_max;
+} TaskTestData;
+
+static void task_count(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	atomic_add_z(&data->counter, 1);
+}
+
+static TaskScheduler *task_test_scheduler_create(void)
+{
+	BLI_threadapi_init();
+	return BLI_task_scheduler_create(NUM_THREADS);
+}
+
+static void task_test_scheduler_free(TaskScheduler *scheduler)
+{
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+TEST(task, PoolPushAndWait)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create();
+	TaskTestData data = {0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	for (int i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_count, NULL, false, (i % 2) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ(NUM_TASKS, data.counter);
+	EXPECT_EQ(NUM_TASKS, BLI_task_pool_tasks_done(pool));
+
+	/* the pool can be reused after waiting */
+	BLI_task_pool_push(pool, task_count, NULL, false, TASK_PRIORITY_HIGH);
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ(NUM_TASKS + 1, data.counter);
+
+	BLI_task_pool_free(pool);
+	task_test_scheduler_free(scheduler);
+}
+
+static void task_push_more(TaskPool *__restrict pool, void *UNUSED(taskdata), int threadid)
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+
+	for (int i = 0; i < NUM_NESTED_TASKS; i++) {
+		BLI_task_pool_push_from_thread(pool, task_count, NULL, false, TASK_PRIORITY_HIGH, threadid);
+	}
+
+	atomic_add_z(&data->counter, 1);
+}
+
+TEST(task, PoolPushFromThread)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create();
+	TaskTestData data = {0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	for (int i = 0; i < NUM_NESTED_TASKS; i++) {
+		BLI_task_pool_push(pool, task_push_more, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ(NUM_NESTED_TASKS * (NUM_NESTED_TASKS + 1), data.counter);
+
+	BLI_task_pool_free(pool);
+	task_test_scheduler_free(scheduler);
+}
+
+static void task_nested_pool(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	TaskTestData nested_data = {0};
+	TaskPool *nested_pool = BLI_task_pool_create(data->scheduler, &nested_data);
+
+	for (int i = 0; i < NUM_NESTED_TASKS; i++) {
+		BLI_task_pool_push(nested_pool, task_count, NULL, false, TASK_PRIORITY_HIGH);
+	}
+
+	BLI_task_pool_work_and_wait(nested_pool);
+	BLI_task_pool_free(nested_pool);
+
+	atomic_add_z(&data->counter, nested_data.counter);
+}
+
+TEST(task, PoolNested)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create();
+	TaskTestData data = {0};
+	TaskPool *pool;
+
+	data.scheduler = scheduler;
+	pool = BLI_task_pool_create(scheduler, &data);
+
+	for (int i = 0; i < NUM_NESTED_TASKS; i++) {
+		BLI_task_pool_push(pool, task_nested_pool, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ(NUM_NESTED_TASKS * NUM_NESTED_TASKS, data.counter);
+
+	BLI_task_pool_free(pool);
+	task_test_scheduler_free(scheduler);
+}
+
+static void task_count_running(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	const size_t running = atomic_add_z(&data->running, 1);
+	size_t running_max;
+
+	while ((running_max = data->running_max) < running) {
+		atomic_cas_z(&data->running_max, running_max, running);
+	}
+
+	atomic_add_z(&data->counter, 1);
+	atomic_sub_z(&data->running, 1);
+}
+
+TEST(task, PoolNumThreads)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create();
+	TaskTestData data = {0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	BLI_pool_set_num_threads(pool, 2);
+
+	for (int i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_count_running, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ(NUM_TASKS, data.counter);
+	EXPECT_LE(data.running_max, 2);
+
+	BLI_task_pool_free(pool);
+	task_test_scheduler_free(scheduler);
+}
+
+TEST(task, PoolCancel)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create();
+	TaskTestData data = {0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	for (int i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_count, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_cancel(pool);
+
+	/* tasks removed from the queue count as done */
+	EXPECT_LE(data.counter, NUM_TASKS);
+	EXPECT_EQ(NUM_TASKS, BLI_task_pool_tasks_done(pool));
+
+	BLI_task_pool_free(pool);
+	task_test_scheduler_free(scheduler);
+}
+
+/* Parallel range. */
+
+#define NUM_ITEMS 100000
+
+static void task_range_iter(void *userdata, const int iter)
+{
+	int *data = (int *)userdata;
+	data[iter] += iter;
+}
+
+static void task_range_test(const eTaskSchedulingMode scheduling_mode, const int min_iter_per_chunk)
+{
+	int *data = (int *)MEM_callocN(sizeof(*data) * NUM_ITEMS, __func__);
+	ParallelRangeSettings settings;
+
+	BLI_threadapi_init();
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = scheduling_mode;
+	settings.min_iter_per_chunk = min_iter_per_chunk;
+
+	BLI_task_parallel_range_with_settings(0, NUM_ITEMS, data, task_range_iter, &settings);
+
+	/* every iteration runs exactly once */
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		EXPECT_EQ(i, data[i]);
+	}
+
+	MEM_freeN(data);
+	BLI_threadapi_exit();
+}
+
+TEST(task, RangeStatic)
+{
+	task_range_test(TASK_SCHEDULING_STATIC, 0);
+}
+
+TEST(task, RangeDynamic)
+{
+	task_range_test(TASK_SCHEDULING_DYNAMIC, 0);
+}
+
+TEST(task, RangeGuided)
+{
+	task_range_test(TASK_SCHEDULING_GUIDED, 0);
+	task_range_test(TASK_SCHEDULING_GUIDED, 1000);
+}
+
+TEST(task, RangeAdaptive)
+{
+	task_range_test(TASK_SCHEDULING_ADAPTIVE, 0);
+	task_range_test(TASK_SCHEDULING_ADAPTIVE, 7);
+}
+
+typedef struct TaskReduceChunk {
+	int64_t sum;
+	int min, max;
+} TaskReduceChunk;
+
+static void task_reduce_iter(void *UNUSED(userdata), void *userdata_chunk, const int iter, const int UNUSED(threadid))
+{
+	TaskReduceChunk *chunk = (TaskReduceChunk *)userdata_chunk;
+	chunk->sum += iter;
+	chunk->min = min_ii(chunk->min, iter);
+	chunk->max = max_ii(chunk->max, iter);
+}
+
+static void task_reduce_join(void *UNUSED(userdata), void *userdata_chunk_join, void *userdata_chunk)
+{
+	TaskReduceChunk *join = (TaskReduceChunk *)userdata_chunk_join;
+	TaskReduceChunk *chunk = (TaskReduceChunk *)userdata_chunk;
+	join->sum += chunk->sum;
+	join->min = min_ii(join->min, chunk->min);
+	join->max = max_ii(join->max, chunk->max);
+}
+
+static void task_reduce_test(const eTaskSchedulingMode scheduling_mode, const bool use_threading)
+{
+	TaskReduceChunk chunk = {0, INT_MAX, INT_MIN};
+	ParallelRangeSettings settings;
+
+	BLI_threadapi_init();
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading;
+	settings.scheduling_mode = scheduling_mode;
+
+	BLI_task_parallel_reduce(10, NUM_ITEMS, NULL, &chunk, sizeof(chunk), task_reduce_iter, task_reduce_join, &settings);
+
+	EXPECT_EQ((int64_t)(NUM_ITEMS - 1) * NUM_ITEMS / 2 - 45, chunk.sum);
+	EXPECT_EQ(10, chunk.min);
+	EXPECT_EQ(NUM_ITEMS - 1, chunk.max);
+
+	BLI_threadapi_exit();
+}
+
+TEST(task, Reduce)
+{
+	task_reduce_test(TASK_SCHEDULING_STATIC, true);
+	task_reduce_test(TASK_SCHEDULING_DYNAMIC, true);
+	task_reduce_test(TASK_SCHEDULING_GUIDED, true);
+	task_reduce_test(TASK_SCHEDULING_ADAPTIVE, true);
+	task_reduce_test(TASK_SCHEDULING_ADAPTIVE, false);
+}
@@ -0,0 +1,105 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "DNA_genfile.h"
+#include "DNA_object_types.h"
+#include "DNA_text_types.h"
+#include "BKE_appdir.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+#include "BKE_text.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define READFILE_RUN_BIG
+
+/* Synthetic files: every text line is stored as two blocks (the line and its string),
+ * every object as one ID, so reading stresses the old to new address maps. */
+
+static void readfile_tests(const char *id, const unsigned int nbr_lines, const unsigned int nbr_objects)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	char filepath[FILE_MAX];
+	DNA_sdna_current_init();
+	BKE_tempdir_init(NULL);
+	BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "readfile_performance.blend");
+
+	{
+		Main *bmain = BKE_main_new();
+		Text *text = BKE_text_add(bmain, "Text");
+
+		{
+			const size_t line_len = 16;
+			char *buf = (char *)MEM_mallocN(nbr_lines * line_len + 1, __func__);
+			char *buf_p = buf;
+
+			for (unsigned int i = 0; i < nbr_lines; i++) {
+				buf_p += BLI_snprintf(buf_p, line_len + 1, "line %10u\n", i);
+			}
+
+			BKE_text_write(text, buf);
+			MEM_freeN(buf);
+		}
+
+		for (unsigned int i = 0; i < nbr_objects; i++) {
+			char name[MAX_ID_NAME - 2];
+			BLI_snprintf(name, sizeof(name), "Empty%u", i);
+			BKE_object_add_only_object(bmain, OB_EMPTY, name);
+		}
+
+		TIMEIT_START(write);
+
+		EXPECT_TRUE(BLO_write_file(bmain, filepath, 0, NULL, NULL));
+
+		TIMEIT_END(write);
+
+		BKE_main_free(bmain);
+	}
+
+	{
+		BlendFileData *bfd;
+
+		TIMEIT_START(read);
+
+		bfd = BLO_read_from_file(filepath, NULL);
+
+		TIMEIT_END(read);
+
+		ASSERT_TRUE(bfd != NULL);
+		EXPECT_EQ((int)nbr_objects, BLI_listbase_count(&bfd->main->object));
+		ASSERT_TRUE(bfd->main->text.first != NULL);
+		/* the text ends with a newline, which leaves an empty last line */
+		EXPECT_EQ((int)nbr_lines + 1, BLI_listbase_count(&((Text *)bfd->main->text.first)->lines));
+
+		BLO_blendfiledata_free(bfd);
+	}
+
+	BKE_tempdir_session_purge();
+	DNA_sdna_current_free();
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(readfile, Lines100000Objects1000)
+{
+	readfile_tests("Read 100000 text lines, 1000 objects", 100000, 1000);
+}
+
+#ifdef READFILE_RUN_BIG
+TEST(readfile, Lines10000000Objects100000)
+{
+	readfile_tests("Read 10000000 text lines, 100000 objects", 10000000, 100000);
+}
+#endif